@@ -7,18 +7,296 @@
 #include "geometry.hpp"
 #include "loop.hpp"
 #include "MeshModel.hpp"
+#include "meshStream.hpp"
 #include "objReader.hpp"
+#include "plyReader.hpp"
+#include "stlReader.hpp"
+#include "profiler.hpp"
+#include "repair.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
-bool MeshModel::load(const std::string& filename)
+namespace {
+
+/**
+ * Return true if the file has the given extension, in lower or upper case
+ * @param[in] filename the name of the file
+ * @param[in] extension the extension in lower case, with the dot
+ * @return true if the file has this extension
+ */
+bool hasExtension(const std::string& filename, std::string extension)
+{
+    if(filename.size() <= extension.size())
+    {
+        return false;
+    }
+    const std::size_t start = filename.size() - extension.size();
+    if(filename.compare(start, extension.size(), extension) == 0)
+    {
+        return true;
+    }
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+    return filename.compare(start, extension.size(), extension) == 0;
+}
+
+} // namespace
+
+bool MeshModel::read(const std::string& filename, float weldEpsilon, std::vector<point3d>& vertices,
+                     std::vector<face>& mesh, std::vector<vec3d>& normals)
+{
+    const bool isPly = hasExtension(filename, ".ply");
+    const bool isStl = hasExtension(filename, ".stl");
+    if(!isPly && !isStl && !hasExtension(filename, ".bmesh"))
+    {
+        BoundingBox bb;
+        return ::load(filename, vertices, mesh, normals, bb);
+    }
+
+    // the binary formats may store the normals, they are computed when they do not
+    bool loaded{false};
+    if(isStl)
+    {
+        normals.clear();
+        loaded = loadStl(filename, vertices, mesh, weldEpsilon);
+    }
+    else
+    {
+        loaded = isPly ? loadPly(filename, vertices, mesh, normals) : loadBinaryMesh(filename, vertices, mesh, normals);
+    }
+    if(!loaded || vertices.empty())
+    {
+        return false;
+    }
+    if(normals.empty())
+    {
+        computeVertexNormals(vertices, mesh, normals);
+    }
+    return true;
+}
+
+bool MeshModel::load(const std::string& filename, float weldEpsilon)
+{
+    // the loaders produce 32-bit indices, they are narrowed afterwards if possible
+    MeshBatch batch;
+    if(!read(filename, weldEpsilon, batch.vertices, batch.faces, batch.normals))
+    {
+        return false;
+    }
+    clear();
+    append(std::move(batch));
+    LOG_INFO(Loader, "Indices stored in " << (_base.faces.is16() ? 16 : 32) << " bits (" << _base.faces.bytes() << " bytes)");
+    return true;
+}
+
+bool MeshModel::save(const std::string& filename, unsigned short subdivLevel, unsigned numThreads)
+{
+    const MeshLevel& mesh = level(subdivLevel);
+    const auto start = std::chrono::steady_clock::now();
+    const bool saved = write(filename, mesh.vertices, mesh.normals, mesh.faces, numThreads);
+    if(saved)
+    {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO(Loader, "Model saved in " << filename << " with " << mesh.vertices.size() << " vertices and "
+                                           << mesh.faces.size() << " faces in " << ms << " ms");
+    }
+    return saved;
+}
+
+bool MeshModel::write(const std::string& filename, const std::vector<point3d>& vertices,
+                      const std::vector<vec3d>& normals, const FaceList& mesh, unsigned numThreads)
+{
+    bool saved{false};
+    if(hasExtension(filename, ".bmesh"))
+    {
+        saved = writeBinaryMesh(filename, vertices, normals, mesh);
+    }
+    else if(hasExtension(filename, ".ply") || hasExtension(filename, ".stl"))
+    {
+        // the other formats go through the streaming sinks
+        std::unique_ptr<MeshSink> sink;
+        if(hasExtension(filename, ".ply"))
+        {
+            sink = std::make_unique<PlySink>(filename, true);
+        }
+        else
+        {
+            sink = std::make_unique<StlSink>(filename);
+        }
+        saved = sink->begin(vertices.size(), mesh.size());
+        if(saved)
+        {
+            for(const auto& v : vertices)
+            {
+                sink->vertex(v);
+            }
+            mesh.visit([&sink](const auto& faces) {
+                for(const auto& f : faces)
+                {
+                    sink->face(face(f.v1, f.v2, f.v3));
+                }
+            });
+            saved = sink->end();
+        }
+    }
+    else
+    {
+        saved = writeObj(filename, vertices, mesh, numThreads);
+    }
+    return saved;
+}
+
+void MeshModel::clear()
+{
+    _base = MeshLevel{};
+    _bb = BoundingBox{};
+    resetSubdivision();
+}
+
+void MeshModel::append(MeshBatch&& batch)
+{
+    for(const auto& v : batch.vertices)
+    {
+        if(_base.vertices.empty())
+        {
+            _bb.set(v);
+        }
+        else
+        {
+            _bb.add(v);
+        }
+        _base.vertices.push_back(v);
+    }
+    const std::size_t numVertices = _base.vertices.size();
+    _base.faces.append(batch.faces, numVertices);
+    if(batch.normals.size() == batch.vertices.size() && !batch.normals.empty())
+    {
+        _base.normals.insert(_base.normals.end(), batch.normals.begin(), batch.normals.end());
+    }
+    else
+    {
+        // the faces can use the vertices of the previous batches, whose normals are updated too
+        _base.normals.resize(numVertices, vec3d{0, 0, 0});
+        accumulateVertexNormals(_base.vertices, Span(batch.faces), _base.normals);
+    }
+    // the subdivisions have to be recomputed with the new faces
+    resetSubdivision();
+}
+
+bool MeshModel::update(MeshBatch&& batch)
 {
-    return ::load(filename, _vertices, _mesh, _normals, _bb);
+    const bool sameFaces = batch.vertices.size() == _base.vertices.size() && _base.faces.visit([&batch](const auto& faces) {
+        return std::equal(faces.begin(), faces.end(), batch.faces.begin(), batch.faces.end(), [](const auto& a, const face& b) {
+            return a.v1 == b.v1 && a.v2 == b.v2 && a.v3 == b.v3;
+        });
+    });
+    if(!sameFaces)
+    {
+        clear();
+        append(std::move(batch));
+        return false;
+    }
+
+    _base.vertices = std::move(batch.vertices);
+    if(batch.normals.size() == _base.vertices.size())
+    {
+        _base.normals = std::move(batch.normals);
+    }
+    else
+    {
+        computeVertexNormals(_base.vertices, batch.faces, _base.normals);
+    }
+    if(!_base.vertices.empty())
+    {
+        _bb.set(_base.vertices.front());
+        for(const auto& v : _base.vertices)
+        {
+            _bb.add(v);
+        }
+    }
+    // the subdivision keeps its faces, its positions are recomputed when it is rendered
+    _positionsChanged = _currentSubdivLevel != 0;
+    return true;
+}
+
+const MeshLevel& MeshModel::level(unsigned short subdivLevel)
+{
+    if(subdivLevel == 0)
+    {
+        return _base;
+    }
+    RenderingParameters params;
+    params.subdivision = true;
+    params.subdivLevel = subdivLevel;
+    updateSubdivision(params);
+    return _subdivided;
+}
+
+MeshModel::Unitization MeshModel::unitization() const
+{
+    //****************************************
+    // calculate model width, height, and
+    // depth using the bounding box
+    //****************************************
+    const float w = std::fabs( _bb.pmax.x - _bb.pmin.x );
+    const float h = std::fabs( _bb.pmax.y - _bb.pmin.y );
+    const float d = std::fabs( _bb.pmax.z - _bb.pmin.z );
+
+    LOG_DEBUG(Loader, "size: w: " << w << " h " << h << " d " << d);
+    //****************************************
+    // calculate center of the bounding box of the model
+    // and the unitizing scale factor as the
+    // maximum of the 3 dimensions
+    //****************************************
+    const float size = std::max(std::max(w, h), d);
+    return {(_bb.pmax + _bb.pmin) * 0.5, (size > 0.f) ? 2.f / size : 1.f};
+}
+
+RepairReport MeshModel::repair(MeshBatch& batch, float weldEpsilon)
+{
+    const RepairReport report = repairMesh(batch.vertices, batch.faces, weldEpsilon);
+    LOG_INFO(Loader, "Model repaired: " << report);
+
+    // the welded vertices may have had different normals
+    computeVertexNormals(batch.vertices, batch.faces, batch.normals);
+    return report;
+}
+
+RepairReport MeshModel::repair(float weldEpsilon)
+{
+    MeshBatch batch;
+    _base.faces.visit([&batch](const auto& faces) {
+        batch.faces.reserve(faces.size());
+        for(const auto& f : faces)
+        {
+            batch.faces.emplace_back(f.v1, f.v2, f.v3);
+        }
+    });
+    batch.vertices = std::move(_base.vertices);
+    const RepairReport report = repair(batch, weldEpsilon);
+    _base.vertices = std::move(batch.vertices);
+    _base.normals = std::move(batch.normals);
+    _base.faces.assign(batch.faces, _base.vertices.size());
+    if(!_base.vertices.empty())
+    {
+        _bb.set(_base.vertices.front());
+        for(const auto& v : _base.vertices)
+        {
+            _bb.add(v);
+        }
+    }
+    // the subdivisions have to be recomputed from the repaired model
+    resetSubdivision();
+    return report;
 }
 
 
@@ -28,66 +306,153 @@ bool MeshModel::load(const std::string& filename)
 */
 void MeshModel::render( const RenderingParameters &params )
 {
-    // if we need to draw the original model
-    if ( !params.subdivision )
+    PROFILE_SCOPE("MeshModel::render");
+    // draw either the original model or the subdivided one
+    if ( params.subdivision )
+    {
+        updateSubdivision( params );
+    }
+    const MeshLevel &level = params.subdivision ? _subdivided : _base;
+
+    level.faces.visit( [&]( const auto &faces ) { draw( level.vertices, Span( faces ), level.normals, params ); } );
+    // draw the normals
+    if ( params.normals )
     {
-        // draw it
-        draw( _vertices, _mesh, _normals, params );
-        // draw the normals
-        if ( params.normals )
+        drawNormals( level.vertices, level.normals );
+    }
+}
+
+/**
+* Render the model with the software rasterizer according to the provided parameters
+* @param target The software rasterizer to draw into
+* @param params The rendering parameters
+*/
+void MeshModel::render( SoftwareRasterizer &target, const RenderingParameters &params )
+{
+    PROFILE_SCOPE("MeshModel::render");
+    if ( params.subdivision )
+    {
+        updateSubdivision( params );
+    }
+    const MeshLevel &level = params.subdivision ? _subdivided : _base;
+
+    level.faces.visit( [&]( const auto &faces ) { draw( level.vertices, Span( faces ), level.normals, params, target ); } );
+    if ( params.normals )
+    {
+        drawNormals( level.vertices, level.normals, target );
+    }
+}
+
+/**
+* Apply the subdivision steps needed to reach the level required by the parameters
+* @param params The rendering parameters
+*/
+void MeshModel::updateSubdivision( const RenderingParameters &params )
+{
+    LOG_TRACE(Subdivision, "params.subdivLevel = " << params.subdivLevel << ", _currentSubdivLevel = " << _currentSubdivLevel);
+    if ( _positionsChanged )
+    {
+        // the faces of the current level are still valid, only the positions are recomputed, unless
+        // the level has to be lowered
+        _positionsChanged = false;
+        if ( ( _currentSubdivLevel <= params.subdivLevel ) && ( _currentSubdivLevel <= _stencils.size( ) ) )
+        {
+            refreshSubdivision( );
+        }
+        else
         {
-            drawNormals( _vertices, _normals );
+            _currentSubdivLevel = 0;
         }
     }
-    else
+    // before drawing check the current level of subdivision and the required one
+    if ( ( _currentSubdivLevel == 0 ) || ( _currentSubdivLevel != params.subdivLevel ) )
     {
-        PRINTVAR(params.subdivLevel);
-        PRINTVAR(_currentSubdivLevel);
-        // before drawing check the current level of subdivision and the required one
-        if ( ( _currentSubdivLevel == 0 ) || ( _currentSubdivLevel != params.subdivLevel ) )
+        // if they are different apply the missing steps: either restart from the beginning
+        // if the required level is less than the current one or apply the missing
+        // steps starting from the current one. No array is copied: each step writes into the
+        // buffers of _spare, which then becomes the current level while the previous one
+        // becomes the spare buffers of the next step
+        if(( _currentSubdivLevel == 0 ) || ( _currentSubdivLevel > params.subdivLevel ) )
         {
-            // if they are different apply the missing steps: either restart from the beginning
-            // if the required level is less than the current one or apply the missing
-            // steps starting from the current one
-            std::vector<point3d> tmpVert;        //!< a temporary list of vertices used in the iterations
-            std::vector<face> tmpMesh;           //!< a temporary mesh used in the iterations
-
-            if(( _currentSubdivLevel == 0 ) || ( _currentSubdivLevel > params.subdivLevel ) )
-            {
-                // start from the beginning
-                _currentSubdivLevel = 0;
-                tmpVert = _vertices;
-                tmpMesh = _mesh;
-            }
-            else
-            {
-                // start from the current level
-                tmpVert = _subVert;
-                tmpMesh = _subMesh;
-            }
+            // start from the beginning
+            _currentSubdivLevel = 0;
+        }
 
-            // apply the proper subdivision iterations
-            for( ; _currentSubdivLevel < params.subdivLevel; ++_currentSubdivLevel)
+        // the levels are cached by the geometry of the model and the level
+        const std::uint64_t geometry = ( _cache && _currentSubdivLevel < params.subdivLevel ) ? hashMesh( _base.vertices, _base.faces ) : 0;
+        const auto levelKey = [geometry]( unsigned level ) {
+            return MeshCache::key( geometry, LOOP_CACHE_OPERATION, level );
+        };
+        if( _cache )
+        {
+            // only the deepest cached level is read, the next ones are subdivided from it
+            for( unsigned level = params.subdivLevel; level > _currentSubdivLevel; --level )
             {
-                std::cerr << "[Loop subdivision] iteration " << _currentSubdivLevel << std::endl;
-                loopSubdivision( tmpVert, tmpMesh, _subVert, _subMesh, _subNorm );
-                // swap unless it's the last iteration
-                if( _currentSubdivLevel < ( params.subdivLevel - 1) )
+                if( _cache->contains( levelKey( level ) ) )
                 {
-                    tmpVert = _subVert;
-                    tmpMesh = _subMesh;
+                    _currentSubdivLevel = static_cast<unsigned short>( level - 1 );
+                    break;
                 }
             }
         }
 
-        draw( _subVert, _subMesh, _subNorm, params );
-        if ( params.normals )
+        // apply the proper subdivision iterations
+        for( ; _currentSubdivLevel < params.subdivLevel; ++_currentSubdivLevel)
         {
-            drawNormals( _subVert, _subNorm );
+            const std::uint64_t key = _cache ? levelKey( _currentSubdivLevel + 1U ) : 0;
+            if( _cache && _cache->load( key, _spare ) )
+            {
+                // no stencil: if the vertices move, the levels from this one are subdivided again
+                LOG_INFO(Subdivision, "Level " << _currentSubdivLevel + 1 << " read from the cache " << _cache->directory( ));
+                std::swap( _subdivided, _spare );
+                continue;
+            }
+            LOG_INFO(Subdivision, "[Loop subdivision] iteration " << _currentSubdivLevel);
+            const MeshLevel &source = ( _currentSubdivLevel == 0 ) ? _base : _subdivided;
+            const PageFaults faultsBefore = PageFaults::now( );
+            const std::size_t blocksBefore = _subdivisionArena.upstreamAllocations( );
+            loopSubdivision( source, _spare, _subdivisionArena );
+            if ( _stencils.size( ) == _currentSubdivLevel )
+            {
+                // the topology of the step, to recompute it quickly if the vertices move
+                _stencils.emplace_back( );
+                loopStencil( source, _spare, _stencils.back( ) );
+            }
+            const PageFaults faultsAfter = PageFaults::now( );
+            LOG_INFO(Subdivision, "Scratch memory: " << _subdivisionArena.allocations( ) << " allocations, "
+                                  << _subdivisionArena.used( ) << " bytes in an arena of " << _subdivisionArena.capacity( )
+                                  << " (" << _subdivisionArena.upstreamAllocations( ) - blocksBefore << " new blocks), "
+                                  << faultsAfter.minor - faultsBefore.minor << " minor page faults");
+            std::swap( _subdivided, _spare );
+            if( _cache )
+            {
+                _cache->store( key, _subdivided );
+            }
         }
     }
 }
 
+void MeshModel::resetSubdivision( )
+{
+    _currentSubdivLevel = 0;
+    _stencils.clear( );
+    _positionsChanged = false;
+}
+
+void MeshModel::refreshSubdivision( )
+{
+    PROFILE_SCOPE("MeshModel::refreshSubdivision");
+    // like the subdivision steps, each level is written into the vertices of _spare, which are then
+    // swapped with the ones of _subdivided
+    for ( unsigned short level = 0; level < _currentSubdivLevel; ++level )
+    {
+        applyLoopStencil( _stencils[level], ( level == 0 ) ? _base.vertices : _subdivided.vertices, _spare.vertices );
+        std::swap( _subdivided.vertices, _spare.vertices );
+    }
+    loopNormals( _subdivided.vertices, _subdivided.faces, _subdivided.normals );
+    LOG_INFO(Subdivision, "Level " << _currentSubdivLevel << " recomputed from the cached topology");
+}
+
 /**
  * It scales the model to unitary size by translating it to the origin and
  * scaling it to fit in a unit cube around the origin.
@@ -96,35 +461,19 @@ void MeshModel::render( const RenderingParameters &params )
  */
 float MeshModel::unitizeModel( )
 {
-    if ( _vertices.empty( ) || _mesh.empty( ) )
+    if ( _base.vertices.empty( ) || _base.faces.empty( ) )
     {
         return .0f;
     }
 
-    //****************************************
-    // calculate model width, height, and
-    // depth using the bounding box
-    //****************************************
-    const float w = std::fabs( _bb.pmax.x - _bb.pmin.x );
-    const float h = std::fabs( _bb.pmax.y - _bb.pmin.y );
-    const float d = std::fabs( _bb.pmax.z - _bb.pmin.z );
-
-    std::cout << "size: w: " << w << " h " << h << " d " << d << std::endl;
-    //****************************************
-    // calculate center of the bounding box of the model
-    //****************************************
-    const point3d c = (_bb.pmax + _bb.pmin) * 0.5;
+    const Unitization u = unitization();
+    const point3d& c = u.center;
+    const float scale = u.scale;
 
-    //****************************************
-    // calculate the unitizing scale factor as the
-    // maximum of the 3 dimensions
-    //****************************************
-    const auto scale = 2.f / std::max(std::max(w, h), d);
-
-    std::cout << "scale: " << scale << " cx " << c.x << " cy " << c.y << " cz " << c.z << std::endl;
+    LOG_DEBUG(Loader, "scale: " << scale << " cx " << c.x << " cy " << c.y << " cz " << c.z);
 
     // translate each vertex wrt to the center and then apply the scaling to the coordinate
-    for(auto& v : _vertices)
+    for(auto& v : _base.vertices)
     {
         //****************************************
         // translate the vertex
@@ -144,7 +493,7 @@ float MeshModel::unitizeModel( )
     _bb.pmin = (_bb.pmin - c) * scale;
 
 
-    std::cout << "New bounding box : pmax=" << _bb.pmax << "  pmin=" << _bb.pmin << std::endl;
+    LOG_DEBUG(Loader, "New bounding box : pmax=" << _bb.pmax << "  pmin=" << _bb.pmin);
 
     return scale;
 }
@@ -161,28 +510,30 @@ void MeshModel::flatDraw( ) const
     glShadeModel( GL_SMOOTH );
 
     // for each triangle draw the vertices and the normals
-    for(const auto &face : _mesh)
-    {
-        glBegin( GL_TRIANGLES );
-        //compute the normal of the triangle
-        const vec3d n = computeNormal( _vertices[face.v1], _vertices[face.v2], _vertices[face.v3]);
-        glNormal3fv( (float*) &n );
+    _base.faces.visit( [this]( const auto &faces ) {
+        for(const auto &f : faces)
+        {
+            glBegin( GL_TRIANGLES );
+            //compute the normal of the triangle
+            const vec3d n = computeNormal( _base.vertices[f.v1], _base.vertices[f.v2], _base.vertices[f.v3]);
+            glNormal3fv( (float*) &n );
 
-        glVertex3fv( (float*) &_vertices[face.v1] );
+            glVertex3fv( (float*) &_base.vertices[f.v1] );
 
-        glVertex3fv( (float*) &_vertices[face.v2] );
+            glVertex3fv( (float*) &_base.vertices[f.v2] );
 
-        glVertex3fv( (float*) &_vertices[face.v3] );
+            glVertex3fv( (float*) &_base.vertices[f.v3] );
 
-        glEnd( );
-    }
+            glEnd( );
+        }
+    } );
 }
 
 // to be deprecated
 
 void MeshModel::drawWireframe( ) const
 {
-    ::drawWireframe( _vertices, _mesh, RenderingParameters( ) );
+    _base.faces.visit( [this]( const auto &faces ) { ::drawWireframe( _base.vertices, Span( faces ), RenderingParameters( ) ); } );
 }
 
 // to be deprecated
@@ -208,17 +559,20 @@ void MeshModel::indexDraw( ) const
     //****************************************
     // Normal pointer to normal array
     //****************************************
-    glNormalPointer( GL_FLOAT, 0, (float*) &_normals[0] );
+    glNormalPointer( GL_FLOAT, 0, (float*) &_base.normals[0] );
 
     //****************************************
     // Index pointer to normal array
     //****************************************
-    glVertexPointer( COORD_PER_VERTEX, GL_FLOAT, 0, (float*) &_vertices[0] );
+    glVertexPointer( COORD_PER_VERTEX, GL_FLOAT, 0, (float*) &_base.vertices[0] );
 
     //****************************************
     // Draw the triangles
     //****************************************
-    glDrawElements( GL_TRIANGLES, static_cast<GLsizei>(_mesh.size( )) * VERTICES_PER_TRIANGLE, GL_UNSIGNED_INT, (idxtype*) & _mesh[0] );
+    _base.faces.visit( []( const auto &faces ) {
+        using Index = typename std::decay_t<decltype( faces )>::value_type::index_type;
+        glDrawElements( GL_TRIANGLES, static_cast<GLsizei>( faces.size( ) ) * VERTICES_PER_TRIANGLE, glIndexType<Index>( ), faces.data( ) );
+    } );
 
     //****************************************
     // Disable vertex arrays
@@ -234,9 +588,9 @@ void MeshModel::indexDraw( ) const
 // to be deprecated
 void MeshModel::drawSubdivision( )
 {
-    if ( _subMesh.empty( ) || _subNorm.empty( ) || _subVert.empty( ) )
+    if ( _subdivided.faces.empty( ) || _subdivided.normals.empty( ) || _subdivided.vertices.empty( ) )
     {
-        loopSubdivision( _vertices, _mesh, _subVert, _subMesh, _subNorm );
+        loopSubdivision( _base.vertices, _base.faces, _subdivided.vertices, _subdivided.faces, _subdivided.normals );
     }
 
     glShadeModel( GL_SMOOTH );
@@ -244,14 +598,17 @@ void MeshModel::drawSubdivision( )
     glEnableClientState( GL_NORMAL_ARRAY );
     glEnableClientState( GL_VERTEX_ARRAY );
 
-    glNormalPointer( GL_FLOAT, 0, (float*) &_subNorm[0] );
-    glVertexPointer( COORD_PER_VERTEX, GL_FLOAT, 0, (float*) &_subVert[0] );
+    glNormalPointer( GL_FLOAT, 0, (float*) &_subdivided.normals[0] );
+    glVertexPointer( COORD_PER_VERTEX, GL_FLOAT, 0, (float*) &_subdivided.vertices[0] );
 
-    glDrawElements( GL_TRIANGLES, static_cast<GLsizei>(_subMesh.size( )) * VERTICES_PER_TRIANGLE, GL_UNSIGNED_SHORT, (idxtype*) & _subMesh[0] );
+    _subdivided.faces.visit( []( const auto &faces ) {
+        using Index = typename std::decay_t<decltype( faces )>::value_type::index_type;
+        glDrawElements( GL_TRIANGLES, static_cast<GLsizei>( faces.size( ) ) * VERTICES_PER_TRIANGLE, glIndexType<Index>( ), faces.data( ) );
+    } );
 
 
     glDisableClientState( GL_VERTEX_ARRAY ); // disable vertex arrays
     glDisableClientState( GL_NORMAL_ARRAY );
 
-    ::drawWireframe( _subVert, _subMesh, RenderingParameters( ) );
+    _subdivided.faces.visit( [this]( const auto &faces ) { ::drawWireframe( _subdivided.vertices, Span( faces ), RenderingParameters( ) ); } );
 }
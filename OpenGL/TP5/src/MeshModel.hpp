@@ -7,36 +7,49 @@
 
 #pragma once
 
+#include "arena.hpp"
 #include "core.hpp"
+#include "loop.hpp"
+#include "meshCache.hpp"
 #include "objReader.hpp"
 #include "rendering.hpp"
+#include "repair.hpp"
 
 #include <cmath>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <vector>
 
+/**
+ * A part of a model: the vertices and the faces read since the previous batch, eg while the model
+ * is loaded in the background
+ */
+struct MeshBatch
+{
+    /// the new vertices
+    std::vector<point3d> vertices{};
+    /// the new faces, they can use the vertices of the previous batches
+    std::vector<face> faces{};
+    /// the normals of the new vertices, or empty to compute them from the faces
+    std::vector<vec3d> normals{};
+};
+
 /**
  * The class containing and managing the 3D model 
  */
 class MeshModel
 {
 private:
-    /// Stores the vertex indices for the triangles
-    std::vector<face> _mesh{};
-    /// Stores the vertices
-    std::vector<point3d> _vertices{};
-    /// Stores the normals for the triangles
-    std::vector<vec3d> _normals{};
+    /// Stores the loaded model
+    MeshLevel _base{};
 
     // Subdivision
-    /// Stores the vertex indices for the triangles
-    std::vector<face> _subMesh{};
-    /// Stores the vertices
-    std::vector<point3d> _subVert{};
-    /// Stores the normals for the triangles
-    std::vector<vec3d> _subNorm{};
+    /// Stores the subdivided model at the current level
+    MeshLevel _subdivided{};
+    /// The buffers of the previous level, the next step is written there and swapped with _subdivided
+    MeshLevel _spare{};
 
     /// the current bounding box of the model
     BoundingBox _bb{};
@@ -44,15 +57,134 @@ private:
     /// the current subdivision level
     unsigned short _currentSubdivLevel{};   
 
+    /// the temporary data of the subdivision steps, kept between the steps and the frames
+    Arena _subdivisionArena{};
+
+    /// the topology of the subdivision steps computed so far, kept as long as the faces do not change
+    std::vector<LoopStencil> _stencils{};
+    /// true when the vertices moved since _subdivided was computed, which is refreshed from the stencils
+    bool _positionsChanged{false};
+
+    /// if set the levels of subdivision are read from this cache, and written there once computed
+    std::shared_ptr<MeshCache> _cache{};
+
 public:
+    /**
+     * The transformation that brings the model into the unit cube: v' = (v - center) * scale
+     */
+    struct Unitization
+    {
+        /// the center of the bounding box
+        point3d center{};
+        /// the scale factor
+        float scale{1.f};
+    };
+
   MeshModel() = default;
 
     /**
-     * Load the OBJ data from file
-      * @param[in] filename The name of the OBJ file
+     * Read a model file without storing it, the format is chosen from the extension (.obj, .ply,
+     * .stl, .bmesh) and the normals are computed if the file has none
+     * @param[in] filename The name of the file
+     * @param[in] weldEpsilon The distance under which the vertices of the STL triangle soups are merged
+     * @param[out] vertices The list of vertices
+     * @param[out] mesh The list of faces
+     * @param[out] normals The normal of each vertex
+     * @return true if everything went well, false otherwise
+     */
+    static bool read(const std::string& filename, float weldEpsilon, std::vector<point3d>& vertices,
+                     std::vector<face>& mesh, std::vector<vec3d>& normals);
+
+    /**
+     * Load the model from file, the format is chosen from the extension (.obj, .ply, .stl, .bmesh)
+      * @param[in] filename The name of the file
+      * @param[in] weldEpsilon The distance under which the vertices of the STL triangle soups are merged
       * @return true if everything went well, false otherwise
      */
-    bool load(const std::string& filename);
+    bool load(const std::string& filename, float weldEpsilon = 0.f);
+
+    /**
+     * Save the model, eg once unitized or subdivided, the format is chosen from the extension: the
+     * binary mesh container with the normals (.bmesh), binary PLY (.ply), binary STL (.stl) or OBJ
+     * (any other extension)
+     * @param[in] filename The name of the file
+     * @param[in] subdivLevel The subdivision level to save, it is computed if needed, 0 for the loaded model
+     * @param[in] numThreads The number of blocks of the OBJ files formatted concurrently, 0 for one
+     * per worker of the shared pool, 1 to format them on the calling thread
+     * @return true if everything went well, false otherwise
+     */
+    bool save(const std::string& filename, unsigned short subdivLevel = 0, unsigned numThreads = 1);
+
+    /**
+     * Write a mesh without storing it, in the format chosen from the extension as by save
+     * @param[in] filename The name of the file
+     * @param[in] vertices The list of vertices
+     * @param[in] normals The normal of each vertex, only written in the binary mesh container, or empty
+     * @param[in] mesh The list of faces
+     * @param[in] numThreads The number of blocks of the OBJ files formatted concurrently, as by save
+     * @return true if everything went well, false otherwise
+     */
+    static bool write(const std::string& filename, const std::vector<point3d>& vertices,
+                      const std::vector<vec3d>& normals, const FaceList& mesh, unsigned numThreads = 1);
+
+    /**
+     * Repair the loaded model: weld the vertices closer than epsilon, remove the degenerate, null
+     * area and duplicated faces and the unreferenced vertices, then recompute the normals. The
+     * report, with the number of non-manifold edges, is logged.
+     * @param[in] weldEpsilon the distance under which the vertices are merged, 0 to merge only the
+     * vertices with the same coordinates
+     * @return what has been changed
+     */
+    RepairReport repair(float weldEpsilon = 0.f);
+
+    /**
+     * Repair a model that is not loaded yet, eg a new version read in the background, the same way
+     * as the loaded one
+     * @param[in,out] batch the whole model
+     * @param[in] weldEpsilon the distance under which the vertices are merged, 0 to merge only the
+     * vertices with the same coordinates
+     * @return what has been changed
+     */
+    static RepairReport repair(MeshBatch& batch, float weldEpsilon = 0.f);
+
+    /**
+     * Remove the model, eg before loading another one
+     */
+    void clear();
+
+    /**
+     * Append a batch to the model, eg while it is loaded: the bounding box is extended and the
+     * normals of the vertices used by the new faces are updated. Appending all the batches of a file
+     * gives the same model as load.
+     * @param[in] batch the batch, its vectors are consumed
+     */
+    void append(MeshBatch&& batch);
+
+    /**
+     * Replace the model by a new version of it, eg after its file has been modified. If the new
+     * version has the same faces, only the positions and the normals are replaced, and the current
+     * subdivision is recomputed from the topology of its steps instead of being subdivided again.
+     * Otherwise the model is replaced as by load.
+     * @param[in] batch the whole new version of the model, its vectors are consumed
+     * @return true if the faces were the same, false if the model has been replaced
+     */
+    bool update(MeshBatch&& batch);
+
+    /// true if the model has no face
+    [[nodiscard]] bool empty() const { return _base.empty(); }
+
+    /**
+     * Return the model at a subdivision level, the missing steps are applied as by render
+     * @param[in] subdivLevel the subdivision level, 0 for the loaded model
+     * @return the vertices, faces and normals of the level
+     */
+    const MeshLevel& level(unsigned short subdivLevel);
+
+    /**
+     * Return the transformation that unitizeModel would apply, eg to display the model unitized while it is loaded
+     * @return the center and the scale factor from the current bounding box
+     */
+    [[nodiscard]] Unitization unitization() const;
 
     /**
      * Render the model according to the provided parameters
@@ -60,6 +192,13 @@ public:
      */
     void render(const RenderingParameters &params = RenderingParameters());
 
+    /**
+     * Render the model with the software rasterizer according to the provided parameters
+     * @param target The software rasterizer to draw into
+     * @param params The rendering parameters
+     */
+    void render(SoftwareRasterizer &target, const RenderingParameters &params = RenderingParameters());
+
 
     /**
      * It scales the model to unitary size by translating it to the origin and
@@ -69,9 +208,34 @@ public:
      */
     float unitizeModel();
 
+    /**
+     * Use a cache for the levels of subdivision: each missing level is looked up by the hash of the
+     * model and the level before being computed, and stored once computed. The cache can be
+     * shared by several models.
+     * @param[in] cache the cache, nullptr to compute every level
+     */
+    void setCache(std::shared_ptr<MeshCache> cache) { _cache = std::move(cache); }
+
 
 private:
 
+    /**
+     * Apply the subdivision steps needed to reach the level required by the parameters
+     * @param params The rendering parameters
+     */
+    void updateSubdivision(const RenderingParameters &params);
+
+    /**
+     * Forget the subdivisions and their topology, when the faces change
+     */
+    void resetSubdivision();
+
+    /**
+     * Recompute the positions and the normals of the current subdivision after the vertices moved,
+     * applying the stencils of the steps level by level
+     */
+    void refreshSubdivision();
+
     /////////////////////////////
     // DEPRECATED METHODS
     [[deprecated]] void drawSubdivision();
@@ -0,0 +1,52 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "adjacency.hpp"
+#include "profiler.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+template<typename Index>
+void buildVertexCorners(Span<const basicFace<Index>> mesh, std::size_t numVertices, VertexCorners& adjacency)
+{
+    PROFILE_SCOPE("buildVertexCorners");
+    assert(3 * mesh.size() <= std::uint64_t{1} << 32U);
+    auto& offsets = adjacency.offsets;
+    auto& corners = adjacency.corners;
+
+    // the number of corners of the vertex v is counted in offsets[v + 1]
+    offsets.assign(numVertices + 1, 0);
+    for(const auto& f : mesh)
+    {
+        ++offsets[f.v1 + 1U];
+        ++offsets[f.v2 + 1U];
+        ++offsets[f.v3 + 1U];
+    }
+    for(std::size_t v = 1; v <= numVertices; ++v)
+    {
+        offsets[v] += offsets[v - 1];
+    }
+
+    // offsets[v] is the cursor of the vertex v, it ends at the first corner of v + 1
+    corners.resize(3 * mesh.size());
+    for(std::size_t i = 0; i < mesh.size(); ++i)
+    {
+        const auto c = static_cast<idxtype>(3 * i);
+        corners[offsets[mesh[i].v1]++] = c;
+        corners[offsets[mesh[i].v2]++] = c + 1;
+        corners[offsets[mesh[i].v3]++] = c + 2;
+    }
+    // shift the cursors back to the first corners
+    for(std::size_t v = numVertices; v > 0; --v)
+    {
+        offsets[v] = offsets[v - 1];
+    }
+    offsets[0] = 0;
+}
+
+template void buildVertexCorners(Span<const face16>, std::size_t, VertexCorners&);
+template void buildVertexCorners(Span<const face>, std::size_t, VertexCorners&);
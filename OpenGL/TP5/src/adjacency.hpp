@@ -0,0 +1,73 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+#include "span.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * The corners of the faces around each vertex, in compressed sparse row form: the corners of the
+ * vertex v are corners[offsets[v]] to corners[offsets[v + 1] - 1], in the order of the faces. The
+ * corner 3f + k is the k-th vertex of the face f (v1, v2 then v3). The arrays come from a memory
+ * resource, eg the arena of the subdivision.
+ */
+struct VertexCorners
+{
+    /**
+     * Create an empty index
+     * @param[in] resource where the arrays are allocated
+     */
+    explicit VertexCorners(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : offsets(resource), corners(resource)
+    {
+    }
+
+    /// the first corner of each vertex, and the number of corners at the end
+    std::pmr::vector<idxtype> offsets;
+    /// the corners, grouped by vertex
+    std::pmr::vector<idxtype> corners;
+
+    /// the number of vertices
+    [[nodiscard]] std::size_t vertices() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /**
+     * Return the corners of a vertex
+     * @param[in] v the vertex
+     * @return the corners, in the order of the faces
+     */
+    [[nodiscard]] Span<const idxtype> of(std::size_t v) const
+    {
+        return {corners.data() + offsets[v], offsets[v + 1] - offsets[v]};
+    }
+};
+
+/**
+ * Return the bytes allocated by buildVertexCorners from the memory resource of the index
+ * @param[in] numVertices the number of vertices of the mesh
+ * @param[in] numFaces the number of faces of the mesh
+ * @return the size in bytes, without the alignment of the allocations
+ */
+constexpr std::size_t vertexCornersBytes(std::size_t numVertices, std::size_t numFaces)
+{
+    return (numVertices + 1 + 3 * numFaces) * sizeof(idxtype);
+}
+
+/**
+ * Build the corners of each vertex with a counting sort: the corners are counted per vertex, the
+ * counts become the offsets by a prefix sum, then the corners are placed in the order of the faces.
+ * It makes two linear passes over the faces and does not allocate anything but the index.
+ *
+ * @param[in] mesh the faces
+ * @param[in] numVertices the number of vertices, all the indices are lower
+ * @param[out] adjacency the corners of each vertex
+ */
+template<typename Index>
+void buildVertexCorners(Span<const basicFace<Index>> mesh, std::size_t numVertices, VertexCorners& adjacency);
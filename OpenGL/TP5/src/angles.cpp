@@ -0,0 +1,315 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "angles.hpp"
+#include "geometry.hpp"
+#include "soaVertices.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ANGLES_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ANGLES_TARGET_AVX
+#else
+// AVX is enough for the float operations, FMA is left out so that the results are the same as
+// the ones of the scalar kernel
+#define ANGLES_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace {
+
+/// the number of faces whose corners are copied in the arrays of cornerAngles at once
+constexpr std::size_t FACE_BLOCK{256};
+
+constexpr float PI{3.14159265358979f};
+constexpr float HALF_PI{1.57079632679490f};
+
+/// the odd minimax polynomial t * (c0 + c1 t^2 + ...) approximating atan(t) on [0, 1]
+struct AtanPolynomial
+{
+    /// the coefficients, c0 first
+    const float* coefficients;
+    /// the number of coefficients
+    std::size_t size;
+};
+
+/// degree 15, at most 1.2e-7 from atan in float
+constexpr float ACCURATE_COEFFICIENTS[]{9.999993443e-01f, -3.332986236e-01f, 1.994656771e-01f, -1.390863955e-01f,
+                                        9.642223269e-02f, -5.591269955e-02f, 2.186322771e-02f, -4.054644611e-03f};
+/// degree 9, at most 1.2e-5 from atan
+constexpr float FAST_COEFFICIENTS[]{9.998663664e-01f, -3.303050101e-01f, 1.801602244e-01f, -8.515779674e-02f,
+                                    2.084584907e-02f};
+
+AtanPolynomial polynomialOf(AngleWeighting weighting)
+{
+    if(weighting == AngleWeighting::Fast)
+    {
+        return {FAST_COEFFICIENTS, std::size(FAST_COEFFICIENTS)};
+    }
+    return {ACCURATE_COEFFICIENTS, std::size(ACCURATE_COEFFICIENTS)};
+}
+
+/**
+ * The angle between two vectors as atan2(|a x b|, a . b): the ratio of the smallest to the largest
+ * of the two, in [0, 1], is given to the polynomial, and the result is reflected around pi/4 and pi/2
+ * @param[in] a the first vector
+ * @param[in] b the second vector
+ * @param[in] p the polynomial
+ * @return the angle in radians
+ */
+float approximateAngle(float ax, float ay, float az, float bx, float by, float bz, const AtanPolynomial& p)
+{
+    const float cx = ay * bz - az * by;
+    const float cy = az * bx - ax * bz;
+    const float cz = ax * by - ay * bx;
+    const float sine = std::sqrt(cx * cx + cy * cy + cz * cz);
+    const float cosine = ax * bx + ay * by + az * bz;
+    const float absCosine = std::fabs(cosine);
+    const float t = std::min(sine, absCosine) / std::max(std::max(sine, absCosine), std::numeric_limits<float>::min());
+    const float t2 = t * t;
+    float r = p.coefficients[p.size - 1];
+    for(std::size_t k = p.size - 1; k > 0; --k)
+    {
+        r = r * t2 + p.coefficients[k - 1];
+    }
+    r = r * t;
+    r = (sine > absCosine) ? HALF_PI - r : r;
+    return (cosine < 0.f) ? PI - r : r;
+}
+
+/// the angle between two vectors as angleAtVertex computes it
+float exactAngle(const vec3d& e1, const vec3d& e2)
+{
+    const float cosine = e1.dot(e2) / (e1.norm() * e2.norm());
+    return (std::fabs(cosine) >= 1.f) ? std::acos(1.f) : std::acos(cosine);
+}
+
+/**
+ * The kernel of one instruction set
+ * @param[in] a the x, y and z arrays of the first vectors
+ * @param[in] b the x, y and z arrays of the second vectors
+ * @param[out] angles the angles
+ * @param[in] n the number of pairs
+ * @param[in] p the polynomial
+ */
+using AngleKernel = void (*)(const float* const a[3], const float* const b[3], float* angles, std::size_t n, const AtanPolynomial& p);
+
+// the scalar kernel, also used for the last elements by the SIMD ones
+
+void anglesScalar(const float* const a[3], const float* const b[3], float* angles, std::size_t n, const AtanPolynomial& p)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        angles[i] = approximateAngle(a[0][i], a[1][i], a[2][i], b[0][i], b[1][i], b[2][i], p);
+    }
+}
+
+#ifdef ANGLES_X86
+
+// SSE kernel, 4 floats at a time, SSE2 has no blend
+
+__m128 selectSSE(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+    return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+void anglesSSE(const float* const a[3], const float* const b[3], float* angles, std::size_t n, const AtanPolynomial& p)
+{
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 tiny = _mm_set1_ps(std::numeric_limits<float>::min());
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        const __m128 ax = _mm_loadu_ps(a[0] + i);
+        const __m128 ay = _mm_loadu_ps(a[1] + i);
+        const __m128 az = _mm_loadu_ps(a[2] + i);
+        const __m128 bx = _mm_loadu_ps(b[0] + i);
+        const __m128 by = _mm_loadu_ps(b[1] + i);
+        const __m128 bz = _mm_loadu_ps(b[2] + i);
+        const __m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        const __m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        const __m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        const __m128 sine =
+            _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+        const __m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        const __m128 absCosine = _mm_andnot_ps(signMask, cosine);
+        const __m128 t = _mm_div_ps(_mm_min_ps(absCosine, sine), _mm_max_ps(_mm_max_ps(absCosine, sine), tiny));
+        const __m128 t2 = _mm_mul_ps(t, t);
+        __m128 r = _mm_set1_ps(p.coefficients[p.size - 1]);
+        for(std::size_t k = p.size - 1; k > 0; --k)
+        {
+            r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(p.coefficients[k - 1]));
+        }
+        r = _mm_mul_ps(r, t);
+        r = selectSSE(_mm_cmpgt_ps(sine, absCosine), _mm_sub_ps(_mm_set1_ps(HALF_PI), r), r);
+        r = selectSSE(_mm_cmplt_ps(cosine, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+        _mm_storeu_ps(angles + i, r);
+    }
+    const float* const ta[3]{a[0] + i, a[1] + i, a[2] + i};
+    const float* const tb[3]{b[0] + i, b[1] + i, b[2] + i};
+    anglesScalar(ta, tb, angles + i, n - i, p);
+}
+
+// AVX kernel, 8 floats at a time
+
+ANGLES_TARGET_AVX void anglesAVX(const float* const a[3], const float* const b[3], float* angles, std::size_t n, const AtanPolynomial& p)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.f);
+    const __m256 tiny = _mm256_set1_ps(std::numeric_limits<float>::min());
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m256 ax = _mm256_loadu_ps(a[0] + i);
+        const __m256 ay = _mm256_loadu_ps(a[1] + i);
+        const __m256 az = _mm256_loadu_ps(a[2] + i);
+        const __m256 bx = _mm256_loadu_ps(b[0] + i);
+        const __m256 by = _mm256_loadu_ps(b[1] + i);
+        const __m256 bz = _mm256_loadu_ps(b[2] + i);
+        const __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by));
+        const __m256 cy = _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz));
+        const __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx));
+        const __m256 sine = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz)));
+        const __m256 cosine =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+        const __m256 absCosine = _mm256_andnot_ps(signMask, cosine);
+        const __m256 t =
+            _mm256_div_ps(_mm256_min_ps(absCosine, sine), _mm256_max_ps(_mm256_max_ps(absCosine, sine), tiny));
+        const __m256 t2 = _mm256_mul_ps(t, t);
+        __m256 r = _mm256_set1_ps(p.coefficients[p.size - 1]);
+        for(std::size_t k = p.size - 1; k > 0; --k)
+        {
+            r = _mm256_add_ps(_mm256_mul_ps(r, t2), _mm256_set1_ps(p.coefficients[k - 1]));
+        }
+        r = _mm256_mul_ps(r, t);
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(HALF_PI), r), _mm256_cmp_ps(sine, absCosine, _CMP_GT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), _mm256_cmp_ps(cosine, _mm256_setzero_ps(), _CMP_LT_OQ));
+        _mm256_storeu_ps(angles + i, r);
+    }
+    const float* const ta[3]{a[0] + i, a[1] + i, a[2] + i};
+    const float* const tb[3]{b[0] + i, b[1] + i, b[2] + i};
+    anglesScalar(ta, tb, angles + i, n - i, p);
+}
+
+#endif // ANGLES_X86
+
+AngleKernel kernelOf(soa::SimdLevel level)
+{
+    switch(level)
+    {
+#ifdef ANGLES_X86
+    case soa::SimdLevel::AVX2:
+        return anglesAVX;
+    case soa::SimdLevel::SSE:
+        return anglesSSE;
+#endif
+    default:
+        return anglesScalar;
+    }
+}
+
+} // namespace
+
+const char* toString(AngleWeighting weighting)
+{
+    switch(weighting)
+    {
+    case AngleWeighting::Exact:
+        return "exact";
+    case AngleWeighting::Accurate:
+        return "accurate";
+    case AngleWeighting::Fast:
+        return "fast";
+    }
+    return "";
+}
+
+bool parseAngleWeighting(const std::string& name, AngleWeighting& weighting)
+{
+    for(const auto w : {AngleWeighting::Exact, AngleWeighting::Accurate, AngleWeighting::Fast})
+    {
+        if(name == toString(w))
+        {
+            weighting = w;
+            return true;
+        }
+    }
+    return false;
+}
+
+float angleAtVertex(const point3d& baseV, const point3d& v2, const point3d& v3, AngleWeighting weighting)
+{
+    if(weighting == AngleWeighting::Exact)
+    {
+        return angleAtVertex(baseV, v2, v3);
+    }
+    const vec3d e1 = baseV - v2;
+    const vec3d e2 = baseV - v3;
+    return approximateAngle(e1.x, e1.y, e1.z, e2.x, e2.y, e2.z, polynomialOf(weighting));
+}
+
+void edgeAngles(const float* const a[3], const float* const b[3], float* angles, std::size_t n, AngleWeighting weighting)
+{
+    if(weighting == AngleWeighting::Exact)
+    {
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            angles[i] = exactAngle({a[0][i], a[1][i], a[2][i]}, {b[0][i], b[1][i], b[2][i]});
+        }
+        return;
+    }
+    kernelOf(soa::simdLevel())(a, b, angles, n, polynomialOf(weighting));
+}
+
+template<typename Index>
+void cornerAngles(const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, float* angles, AngleWeighting weighting)
+{
+    if(weighting == AngleWeighting::Exact)
+    {
+        for(std::size_t f = 0; f < faces.size(); ++f)
+        {
+            const auto& t = faces[f];
+            angles[3 * f] = angleAtVertex(vertices[t.v1], vertices[t.v2], vertices[t.v3]);
+            angles[3 * f + 1] = angleAtVertex(vertices[t.v2], vertices[t.v1], vertices[t.v3]);
+            angles[3 * f + 2] = angleAtVertex(vertices[t.v3], vertices[t.v2], vertices[t.v1]);
+        }
+        return;
+    }
+
+    // the edges baseV-v2 and baseV-v3 of each corner, in the order of the arguments of angleAtVertex
+    alignas(32) float edges[6][3 * FACE_BLOCK];
+    const float* const a[3]{edges[0], edges[1], edges[2]};
+    const float* const b[3]{edges[3], edges[4], edges[5]};
+    for(std::size_t first = 0; first < faces.size(); first += FACE_BLOCK)
+    {
+        const std::size_t count = std::min(FACE_BLOCK, faces.size() - first);
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const auto& t = faces[first + i];
+            const idxtype corners[3][3]{{t.v1, t.v2, t.v3}, {t.v2, t.v1, t.v3}, {t.v3, t.v2, t.v1}};
+            for(std::size_t k = 0; k < 3; ++k)
+            {
+                const vec3d e1 = vertices[corners[k][0]] - vertices[corners[k][1]];
+                const vec3d e2 = vertices[corners[k][0]] - vertices[corners[k][2]];
+                edges[0][3 * i + k] = e1.x;
+                edges[1][3 * i + k] = e1.y;
+                edges[2][3 * i + k] = e1.z;
+                edges[3][3 * i + k] = e2.x;
+                edges[4][3 * i + k] = e2.y;
+                edges[5][3 * i + k] = e2.z;
+            }
+        }
+        edgeAngles(a, b, angles + 3 * first, 3 * count, weighting);
+    }
+}
+
+template void cornerAngles(const std::vector<point3d>&, Span<const face16>, float*, AngleWeighting);
+template void cornerAngles(const std::vector<point3d>&, Span<const face>, float*, AngleWeighting);
@@ -0,0 +1,82 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+#include "span.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * How the angle of a face at a vertex is computed, eg to weight its normal. The errors are the
+ * maximum differences with the angle between the same float vectors computed in double.
+ */
+enum class AngleWeighting
+{
+    /// std::acos of the cosine, as angleAtVertex: the normals do not change, but the angles close
+    /// to 0 or pi lose precision (up to about 5e-4 rad)
+    Exact,
+    /// atan2(|e1 x e2|, e1 . e2) with a minimax polynomial of degree 15 for atan, at most 1e-6 rad
+    Accurate,
+    /// the same with a polynomial of degree 9, at most 2e-5 rad (0.001 degree)
+    Fast
+};
+
+/**
+ * Return the name of a weighting, as parsed by parseAngleWeighting
+ * @param[in] weighting the weighting
+ * @return exact, accurate or fast
+ */
+const char* toString(AngleWeighting weighting);
+
+/**
+ * Parse the name of a weighting
+ * @param[in] name exact, accurate or fast
+ * @param[out] weighting the weighting
+ * @return false if the name is not valid
+ */
+bool parseAngleWeighting(const std::string& name, AngleWeighting& weighting);
+
+/**
+ * Compute the angle at vertex baseV formed by the edges baseV-v2 and baseV-v3, as angleAtVertex
+ * for AngleWeighting::Exact and as one element of edgeAngles otherwise (the results are the same)
+ *
+ * @param[in] baseV the vertex at which to compute the angle
+ * @param[in] v2 the other vertex of the first edge
+ * @param[in] v3 the other vertex of the second edge
+ * @param[in] weighting how the angle is computed
+ * @return the angle in radians, 0 if an edge has a null length and the angle is approximated
+ */
+[[nodiscard]] float angleAtVertex(const point3d& baseV, const point3d& v2, const point3d& v3, AngleWeighting weighting);
+
+/**
+ * Compute the angles between pairs of vectors stored as structures of arrays, without branches,
+ * with the instruction set selected by soa::setSimdLevel. The approximations are computed with
+ * additions, multiplications, divisions and square roots only, so the result does not depend on
+ * the instruction set.
+ *
+ * @param[in] a the x, y and z arrays of the first vectors
+ * @param[in] b the x, y and z arrays of the second vectors
+ * @param[out] angles the angle of each pair in radians
+ * @param[in] n the number of pairs
+ * @param[in] weighting how the angles are computed
+ */
+void edgeAngles(const float* const a[3], const float* const b[3], float* angles, std::size_t n, AngleWeighting weighting);
+
+/**
+ * Compute the angles of faces at their corners by blocks: the edges of the corners of a block are
+ * copied in structures of arrays and their angles computed by edgeAngles
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the faces
+ * @param[out] angles the angle at each corner: 3f at v1, 3f+1 at v2 and 3f+2 at v3 of the face f
+ * @param[in] weighting how the angles are computed
+ */
+template<typename Index>
+void cornerAngles(const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, float* angles, AngleWeighting weighting);
@@ -0,0 +1,118 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+/// the alignment of the blocks, enough for any type and for the SIMD loads
+constexpr std::size_t BLOCK_ALIGNMENT{64};
+/// the minimum size of a block, so that small unplanned allocations do not take one block each
+constexpr std::size_t MIN_BLOCK_SIZE{64 * 1024};
+
+} // namespace
+
+Arena::Arena(std::size_t capacity, std::pmr::memory_resource* upstream) : _upstream(upstream)
+{
+    if(capacity > 0)
+    {
+        grow(capacity);
+    }
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+void Arena::reserve(std::size_t bytes)
+{
+    assert(used() == 0);
+    if(capacity() < bytes || _blocks.size() > 1)
+    {
+        release();
+        grow(bytes);
+    }
+}
+
+void Arena::reset()
+{
+    if(_blocks.size() > 1)
+    {
+        // the run did not fit: replace the blocks by one holding all of them
+        const std::size_t total = capacity();
+        release();
+        grow(total);
+    }
+    _offset = 0;
+    _used = 0;
+    _allocations = 0;
+}
+
+std::size_t Arena::capacity() const
+{
+    return std::accumulate(_blocks.begin(), _blocks.end(), std::size_t{0},
+                           [](std::size_t s, const Block& b) { return s + b.size; });
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    assert(alignment <= BLOCK_ALIGNMENT);
+    std::size_t start = (_offset + alignment - 1) & ~(alignment - 1);
+    if(_blocks.empty() || start + bytes > _blocks.back().size)
+    {
+        grow(bytes);
+        start = 0;
+    }
+    _offset = start + bytes;
+    ++_allocations;
+    return _blocks.back().data + start;
+}
+
+void Arena::grow(std::size_t bytes)
+{
+    if(!_blocks.empty())
+    {
+        _used += _offset;
+    }
+    const std::size_t size = std::max(bytes, MIN_BLOCK_SIZE);
+    _blocks.push_back({static_cast<std::byte*>(_upstream->allocate(size, BLOCK_ALIGNMENT)), size});
+    _offset = 0;
+    ++_upstreamAllocations;
+}
+
+void Arena::release()
+{
+    for(const auto& b : _blocks)
+    {
+        _upstream->deallocate(b.data, b.size, BLOCK_ALIGNMENT);
+    }
+    _blocks.clear();
+    _offset = 0;
+    _used = 0;
+}
+
+PageFaults PageFaults::now()
+{
+    PageFaults res;
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        res.minor = static_cast<std::size_t>(usage.ru_minflt);
+        res.major = static_cast<std::size_t>(usage.ru_majflt);
+    }
+#endif
+    return res;
+}
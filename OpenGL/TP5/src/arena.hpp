@@ -0,0 +1,99 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * A monotonic arena: the memory is handed out by bumping a pointer in a block reserved up front,
+ * deallocating does nothing and reset() releases everything at once by rewinding the pointer. It
+ * is a std::pmr::memory_resource, so that the std::pmr containers can use it.
+ *
+ * If a run needs more than the reserved size, new blocks are taken from the upstream resource and
+ * the next reset() merges them into a single block large enough for the whole run, so that the
+ * following runs of the same size do not allocate anything.
+ */
+class Arena : public std::pmr::memory_resource
+{
+public:
+    /**
+     * Create the arena
+     * @param[in] capacity the size of the first block in bytes, 0 to allocate it on the first use
+     * @param[in] upstream the resource providing the blocks
+     */
+    explicit Arena(std::size_t capacity = 0,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Make sure that the next allocations of a total of at least bytes are served from a single
+     * block, the arena must be empty (ie just created or reset)
+     * @param[in] bytes the number of bytes
+     */
+    void reserve(std::size_t bytes);
+
+    /**
+     * Release all the allocations at once, the memory is kept for the next run
+     */
+    void reset();
+
+    /// the number of bytes handed out since the last reset, including the padding
+    [[nodiscard]] std::size_t used() const { return _used + _offset; }
+    /// the total size of the blocks
+    [[nodiscard]] std::size_t capacity() const;
+    /// the number of allocations served since the last reset
+    [[nodiscard]] std::size_t allocations() const { return _allocations; }
+    /// the number of blocks taken from the upstream resource since the creation of the arena
+    [[nodiscard]] std::size_t upstreamAllocations() const { return _upstreamAllocations; }
+
+private:
+    struct Block
+    {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* /*p*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override { }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    /// add a block of at least the given size and make it the current one
+    void grow(std::size_t bytes);
+    /// give all the blocks back to the upstream resource
+    void release();
+
+    std::pmr::memory_resource* _upstream;
+    std::vector<Block> _blocks{};
+    /// the position of the next allocation in the last block
+    std::size_t _offset{0};
+    /// the bytes used in the blocks before the last one
+    std::size_t _used{0};
+    std::size_t _allocations{0};
+    std::size_t _upstreamAllocations{0};
+};
+
+/**
+ * The number of page faults of the process so far, to measure the cost of touching new memory
+ */
+struct PageFaults
+{
+    /// the faults served without I/O, eg the first touch of a freshly allocated page
+    std::size_t minor{0};
+    /// the faults that required I/O
+    std::size_t major{0};
+
+    /**
+     * Return the current counts of the process, 0 on the platforms without getrusage
+     * @return the counts
+     */
+    static PageFaults now();
+};
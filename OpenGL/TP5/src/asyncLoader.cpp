@@ -0,0 +1,100 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "asyncLoader.hpp"
+#include "logger.hpp"
+
+#include <exception>
+#include <utility>
+
+AsyncLoader::~AsyncLoader()
+{
+    wait();
+}
+
+void AsyncLoader::start(const std::string& filename, float weldEpsilon, std::size_t batchSize)
+{
+    wait();
+    _pending.clear();
+    _state = State::Loading;
+    _busy = true;
+    _start = std::chrono::steady_clock::now();
+    _thread = std::thread(&AsyncLoader::run, this, filename, weldEpsilon, batchSize);
+}
+
+AsyncLoader::State AsyncLoader::poll(MeshModel& model)
+{
+    std::vector<MeshBatch> batches;
+    State state;
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        batches.swap(_pending);
+        state = _state;
+    }
+    for(auto& batch : batches)
+    {
+        model.append(std::move(batch));
+    }
+    // the batches are published before the end of the loading, none is left
+    if(state == State::Loaded || state == State::Failed)
+    {
+        wait();
+        _state = State::Idle;
+        _busy = false;
+    }
+    return state;
+}
+
+void AsyncLoader::wait()
+{
+    if(_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+double AsyncLoader::elapsedMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void AsyncLoader::run(const std::string& filename, float weldEpsilon, std::size_t batchSize)
+{
+    bool loaded{false};
+    try
+    {
+        const bool isObj = filename.size() > 4 && (filename.compare(filename.size() - 4, 4, ".obj") == 0
+                                                   || filename.compare(filename.size() - 4, 4, ".OBJ") == 0);
+        if(isObj)
+        {
+            loaded = loadBatches(filename, batchSize, [this](std::vector<point3d>& vertices, std::vector<face>& faces) {
+                publish({std::move(vertices), std::move(faces), {}});
+            });
+        }
+        else
+        {
+            MeshBatch batch;
+            loaded = MeshModel::read(filename, weldEpsilon, batch.vertices, batch.faces, batch.normals);
+            if(loaded)
+            {
+                publish(std::move(batch));
+            }
+        }
+    }
+    catch(const std::exception& e)
+    {
+        // eg a line of the OBJ file that cannot be parsed
+        LOG_ERROR(Loader, filename << ": " << e.what());
+    }
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _state = loaded ? State::Loaded : State::Failed;
+}
+
+void AsyncLoader::publish(MeshBatch&& batch)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _pending.push_back(std::move(batch));
+}
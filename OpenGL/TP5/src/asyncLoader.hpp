@@ -0,0 +1,97 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "MeshModel.hpp"
+#include "objReader.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Load a model in a background thread, so that it can be displayed while it is read. The OBJ files
+ * are published batch by batch, the other formats, which are read much faster, in one batch. The
+ * background thread never touches the model: the batches are appended to it by poll, from the
+ * thread that renders it.
+ */
+class AsyncLoader
+{
+public:
+    /// the state of the loading
+    enum class State
+    {
+        /// no loading in progress
+        Idle,
+        /// the file is being read
+        Loading,
+        /// the whole file has been appended to the model
+        Loaded,
+        /// the file could not be read, the model may contain some of its batches
+        Failed
+    };
+
+    AsyncLoader() = default;
+    ~AsyncLoader();
+
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+    /**
+     * Start loading a model in the background, a previous loading is waited for
+     * @param[in] filename the name of the file
+     * @param[in] weldEpsilon the distance under which the vertices of the STL triangle soups are merged
+     * @param[in] batchSize the number of elements (vertices and faces) of an OBJ batch
+     */
+    void start(const std::string& filename, float weldEpsilon = 0.f, std::size_t batchSize = OBJ_BATCH_SIZE);
+
+    /**
+     * Append the batches read since the previous call to the model
+     * @param[in,out] model the model
+     * @return Loading while the file is read; Loaded or Failed once at the end, the loader is then Idle
+     */
+    State poll(MeshModel& model);
+
+    /**
+     * Wait until the whole file has been read, the batches still have to be appended by poll
+     */
+    void wait();
+
+    /// true from start until poll returns Loaded or Failed
+    [[nodiscard]] bool busy() const { return _busy; }
+
+    /// the time elapsed since start in milliseconds
+    [[nodiscard]] double elapsedMs() const;
+
+private:
+    /**
+     * Read the file, executed by the background thread
+     */
+    void run(const std::string& filename, float weldEpsilon, std::size_t batchSize);
+
+    /**
+     * Make a batch available to poll
+     * @param[in] batch the batch
+     */
+    void publish(MeshBatch&& batch);
+
+    /// the background thread
+    std::thread _thread{};
+    /// protects the batches and the state
+    std::mutex _mutex{};
+    /// the batches not appended to the model yet
+    std::vector<MeshBatch> _pending{};
+    /// the state of the background thread
+    State _state{State::Idle};
+    /// true from start until poll returns Loaded or Failed, only used by the thread calling poll
+    bool _busy{false};
+    /// when the loading started
+    std::chrono::steady_clock::time_point _start{};
+};
@@ -0,0 +1,79 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+// The global operator new is replaced to count the heap allocations of the benchmarks. The other
+// forms (new[], nothrow) call this one, the aligned ones are replaced as well.
+
+#include "benchmark.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+void* countedAlloc(std::size_t size, std::size_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size = (size == 0) ? 1 : size;
+    void* p{nullptr};
+    if(alignment <= alignof(std::max_align_t))
+    {
+        p = std::malloc(size);
+    }
+    else if(posix_memalign(&p, alignment, size) != 0)
+    {
+        p = nullptr;
+    }
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+namespace bench {
+
+std::size_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace bench
+
+void* operator new(std::size_t size)
+{
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
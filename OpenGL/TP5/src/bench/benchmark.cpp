@@ -0,0 +1,526 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark.hpp"
+
+#include "arena.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+
+#ifndef RENDERER_BUILD_TYPE
+#define RENDERER_BUILD_TYPE ""
+#endif
+
+namespace bench {
+
+double Result::median() const
+{
+    if(samplesNs.empty())
+    {
+        return 0;
+    }
+    std::vector<double> sorted(samplesNs);
+    std::sort(sorted.begin(), sorted.end());
+    const auto n = sorted.size();
+    return (n % 2 == 1) ? sorted[n / 2] : .5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+double Result::mean() const
+{
+    if(samplesNs.empty())
+    {
+        return 0;
+    }
+    return std::accumulate(samplesNs.begin(), samplesNs.end(), .0) / static_cast<double>(samplesNs.size());
+}
+
+double Result::stddev() const
+{
+    if(samplesNs.size() < 2)
+    {
+        return 0;
+    }
+    const double m = mean();
+    double sum{0};
+    for(const auto s : samplesNs)
+    {
+        sum += (s - m) * (s - m);
+    }
+    return std::sqrt(sum / static_cast<double>(samplesNs.size() - 1));
+}
+
+double Result::min() const
+{
+    return samplesNs.empty() ? 0 : *std::min_element(samplesNs.begin(), samplesNs.end());
+}
+
+double Result::gigabytesPerSecond() const
+{
+    // bytes per nanosecond are GB/s
+    const double m = median();
+    return (m > 0) ? static_cast<double>(bytesPerIteration) / m : 0;
+}
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double timeMs(const Body& body, std::size_t iterations)
+{
+    const auto start = clock::now();
+    body(iterations);
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+/**
+ * The JSON values needed to read back the results: numbers, strings, arrays and objects
+ */
+struct JsonValue
+{
+    enum class Type
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object
+    };
+    Type type{Type::Null};
+    double number{0};
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+
+    [[nodiscard]] const JsonValue* find(const std::string& key) const
+    {
+        const auto it = object.find(key);
+        return (it == object.end()) ? nullptr : &it->second;
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text) : _text(text) { }
+
+    bool parse(JsonValue& value)
+    {
+        return parseValue(value) && (skipSpaces(), _pos == _text.size());
+    }
+
+private:
+    void skipSpaces()
+    {
+        while(_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos])))
+        {
+            ++_pos;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpaces();
+        if(_pos < _text.size() && _text[_pos] == c)
+        {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeWord(const std::string& word)
+    {
+        if(_text.compare(_pos, word.size(), word) == 0)
+        {
+            _pos += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string& res)
+    {
+        if(!consume('"'))
+        {
+            return false;
+        }
+        res.clear();
+        while(_pos < _text.size() && _text[_pos] != '"')
+        {
+            char c = _text[_pos++];
+            if(c == '\\' && _pos < _text.size())
+            {
+                c = _text[_pos++];
+                c = (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+            }
+            res.push_back(c);
+        }
+        return consume('"');
+    }
+
+    bool parseValue(JsonValue& value)
+    {
+        skipSpaces();
+        if(_pos >= _text.size())
+        {
+            return false;
+        }
+        const char c = _text[_pos];
+        if(c == '{')
+        {
+            value.type = JsonValue::Type::Object;
+            ++_pos;
+            if(consume('}'))
+            {
+                return true;
+            }
+            do
+            {
+                std::string key;
+                JsonValue element;
+                if(!parseString(key) || !consume(':') || !parseValue(element))
+                {
+                    return false;
+                }
+                value.object.emplace(std::move(key), std::move(element));
+            } while(consume(','));
+            return consume('}');
+        }
+        if(c == '[')
+        {
+            value.type = JsonValue::Type::Array;
+            ++_pos;
+            if(consume(']'))
+            {
+                return true;
+            }
+            do
+            {
+                value.array.emplace_back();
+                if(!parseValue(value.array.back()))
+                {
+                    return false;
+                }
+            } while(consume(','));
+            return consume(']');
+        }
+        if(c == '"')
+        {
+            value.type = JsonValue::Type::String;
+            return parseString(value.string);
+        }
+        if(consumeWord("true") || consumeWord("false"))
+        {
+            value.type = JsonValue::Type::Boolean;
+            return true;
+        }
+        if(consumeWord("null"))
+        {
+            return true;
+        }
+        const char* begin = _text.c_str() + _pos;
+        char* end = nullptr;
+        value.type = JsonValue::Type::Number;
+        value.number = std::strtod(begin, &end);
+        _pos += static_cast<std::size_t>(end - begin);
+        return end != begin;
+    }
+
+    const std::string& _text;
+    std::size_t _pos{0};
+};
+
+std::string escape(const std::string& s)
+{
+    std::string res;
+    for(const char c : s)
+    {
+        if(c == '"' || c == '\\')
+        {
+            res.push_back('\\');
+        }
+        res.push_back(c);
+    }
+    return res;
+}
+
+} // namespace
+
+std::vector<Result> run(const std::vector<Benchmark>& benchmarks, const RunOptions& options)
+{
+    std::vector<Result> results;
+    for(const auto& benchmark : benchmarks)
+    {
+        if(!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        const Body body = benchmark.setup();
+
+        // calibration, it also warms up the caches and the branch predictors
+        std::size_t iterations{1};
+        for(double elapsed = timeMs(body, iterations); elapsed < options.minSampleMs;
+            elapsed = timeMs(body, iterations))
+        {
+            const double factor = (elapsed > 0) ? 1.2 * options.minSampleMs / elapsed : 10.;
+            iterations = static_cast<std::size_t>(static_cast<double>(iterations) * std::clamp(factor, 1.5, 10.));
+        }
+
+        Result result{benchmark.name, benchmark.itemsPerIteration, benchmark.bytesPerIteration, iterations, {}};
+        result.samplesNs.reserve(options.samples);
+        for(std::size_t i = 0; i < options.samples; ++i)
+        {
+            result.samplesNs.push_back(1e6 * timeMs(body, iterations) / static_cast<double>(iterations));
+        }
+        // the counters are read on a separate sample so that they do not disturb the timings
+        const std::size_t allocationsBefore = allocationCount();
+        const PageFaults faultsBefore = PageFaults::now();
+        body(iterations);
+        const PageFaults faultsAfter = PageFaults::now();
+        result.allocationsPerIteration =
+            static_cast<double>(allocationCount() - allocationsBefore) / static_cast<double>(iterations);
+        result.pageFaultsPerIteration =
+            static_cast<double>(faultsAfter.minor + faultsAfter.major - faultsBefore.minor - faultsBefore.major)
+            / static_cast<double>(iterations);
+        std::cout << std::left << std::setw(48) << result.name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << result.median() << " ns  +- " << std::setw(5) << std::setprecision(1)
+                  << 100. * result.stddev() / result.mean() << "%  " << std::setw(8) << result.iterations
+                  << " iterations";
+        if(result.bytesPerIteration > 0)
+        {
+            std::cout << std::setw(9) << std::setprecision(2) << result.gigabytesPerSecond() << " GB/s";
+        }
+        std::cout << std::setw(11) << std::setprecision(1) << result.allocationsPerIteration << " allocs"
+                  << std::setw(9) << result.pageFaultsPerIteration << " faults";
+        std::cout << std::endl;
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+bool writeJSON(const std::string& filename, const std::vector<Result>& results, const RunOptions& options)
+{
+    std::ofstream out(filename);
+    if(!out.is_open())
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    const std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << std::setprecision(10) << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"compiler\": \"" << escape(__VERSION__) << "\",\n"
+        << "    \"build_type\": \"" << RENDERER_BUILD_TYPE << "\",\n"
+        << "    \"samples\": " << options.samples << ",\n"
+        << "    \"min_sample_ms\": " << options.minSampleMs << "\n"
+        << "  },\n"
+        << "  \"benchmarks\": [";
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        const double median = r.median();
+        out << ((i == 0) ? "\n" : ",\n") << "    {\n"
+            << "      \"name\": \"" << escape(r.name) << "\",\n"
+            << "      \"iterations\": " << r.iterations << ",\n"
+            << "      \"items_per_iteration\": " << r.itemsPerIteration << ",\n"
+            << "      \"bytes_per_iteration\": " << r.bytesPerIteration << ",\n"
+            << "      \"median_ns\": " << median << ",\n"
+            << "      \"mean_ns\": " << r.mean() << ",\n"
+            << "      \"stddev_ns\": " << r.stddev() << ",\n"
+            << "      \"min_ns\": " << r.min() << ",\n"
+            << "      \"items_per_second\": "
+            << ((median > 0) ? 1e9 * static_cast<double>(r.itemsPerIteration) / median : 0) << ",\n"
+            << "      \"gigabytes_per_second\": " << r.gigabytesPerSecond() << ",\n"
+            << "      \"allocations_per_iteration\": " << r.allocationsPerIteration << ",\n"
+            << "      \"page_faults_per_iteration\": " << r.pageFaultsPerIteration << ",\n"
+            << "      \"samples_ns\": [";
+        for(std::size_t s = 0; s < r.samplesNs.size(); ++s)
+        {
+            out << ((s == 0) ? "" : ", ") << r.samplesNs[s];
+        }
+        out << "]\n    }";
+    }
+    out << "\n  ]\n}" << std::endl;
+    return out.good();
+}
+
+bool readJSON(const std::string& filename, std::vector<Result>& results)
+{
+    std::ifstream in(filename);
+    if(!in.is_open())
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    JsonValue root;
+    const JsonValue* benchmarks{nullptr};
+    if(!JsonParser(text).parse(root) || (benchmarks = root.find("benchmarks")) == nullptr
+       || benchmarks->type != JsonValue::Type::Array)
+    {
+        LOG_ERROR(General, "Invalid benchmark results in " << filename);
+        return false;
+    }
+    results.clear();
+    for(const auto& b : benchmarks->array)
+    {
+        const auto* name = b.find("name");
+        const auto* samples = b.find("samples_ns");
+        if(name == nullptr || samples == nullptr)
+        {
+            LOG_ERROR(General, "Invalid benchmark results in " << filename);
+            return false;
+        }
+        Result r;
+        r.name = name->string;
+        if(const auto* iterations = b.find("iterations"))
+        {
+            r.iterations = static_cast<std::size_t>(iterations->number);
+        }
+        if(const auto* items = b.find("items_per_iteration"))
+        {
+            r.itemsPerIteration = static_cast<std::size_t>(items->number);
+        }
+        if(const auto* bytes = b.find("bytes_per_iteration"))
+        {
+            r.bytesPerIteration = static_cast<std::size_t>(bytes->number);
+        }
+        if(const auto* allocs = b.find("allocations_per_iteration"))
+        {
+            r.allocationsPerIteration = allocs->number;
+        }
+        if(const auto* faults = b.find("page_faults_per_iteration"))
+        {
+            r.pageFaultsPerIteration = faults->number;
+        }
+        for(const auto& s : samples->array)
+        {
+            r.samplesNs.push_back(s.number);
+        }
+        results.push_back(std::move(r));
+    }
+    return true;
+}
+
+double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b)
+{
+    const auto n1 = static_cast<double>(a.size());
+    const auto n2 = static_cast<double>(b.size());
+    if(a.empty() || b.empty())
+    {
+        return 1;
+    }
+
+    // rank the union of the samples, ties get the average of their ranks
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(a.size() + b.size());
+    for(const auto v : a)
+    {
+        all.emplace_back(v, true);
+    }
+    for(const auto v : b)
+    {
+        all.emplace_back(v, false);
+    }
+    std::sort(all.begin(), all.end());
+
+    double rankSumA{0};
+    double tieCorrection{0};
+    for(std::size_t i = 0; i < all.size();)
+    {
+        std::size_t j = i;
+        while(j < all.size() && !(all[j].first > all[i].first))
+        {
+            ++j;
+        }
+        const auto ties = static_cast<double>(j - i);
+        const double rank = .5 * static_cast<double>(i + j + 1);
+        for(std::size_t k = i; k < j; ++k)
+        {
+            rankSumA += all[k].second ? rank : 0;
+        }
+        tieCorrection += ties * ties * ties - ties;
+        i = j;
+    }
+
+    const double n = n1 + n2;
+    const double u = rankSumA - n1 * (n1 + 1) / 2;
+    const double mu = n1 * n2 / 2;
+    const double sigma = std::sqrt(n1 * n2 / 12 * ((n + 1) - tieCorrection / (n * (n - 1))));
+    if(!(sigma > 0))
+    {
+        return 1;
+    }
+    // continuity correction
+    const double z = std::max(std::fabs(u - mu) - .5, .0) / sigma;
+    return std::erfc(z / std::sqrt(2.));
+}
+
+std::size_t compare(const std::vector<Result>& base, const std::vector<Result>& current, double threshold, double alpha)
+{
+    std::size_t regressions{0};
+    std::cout << std::left << std::setw(48) << "benchmark" << std::right << std::setw(14) << "base (ns)" << std::setw(14)
+              << "new (ns)" << std::setw(10) << "change" << std::setw(10) << "p-value" << "\n";
+    for(const auto& cur : current)
+    {
+        const auto it =
+            std::find_if(base.begin(), base.end(), [&cur](const Result& r) { return r.name == cur.name; });
+        std::cout << std::left << std::setw(48) << cur.name << std::right << std::fixed;
+        if(it == base.end())
+        {
+            std::cout << std::setw(14) << "-" << std::setw(14) << std::setprecision(1) << cur.median() << "  (new)\n";
+            continue;
+        }
+        const double oldMedian = it->median();
+        const double newMedian = cur.median();
+        const double change = (oldMedian > 0) ? newMedian / oldMedian - 1 : 0;
+        const double p = mannWhitneyPValue(it->samplesNs, cur.samplesNs);
+        const bool significant = (p < alpha) && (std::fabs(change) > threshold);
+        std::cout << std::setw(14) << std::setprecision(1) << oldMedian << std::setw(14) << newMedian << std::setw(9)
+                  << std::showpos << std::setprecision(1) << 100 * change << std::noshowpos << "%" << std::setw(10)
+                  << std::setprecision(4) << p;
+        if(significant && change > 0)
+        {
+            std::cout << "  REGRESSION";
+            ++regressions;
+        }
+        else if(significant)
+        {
+            std::cout << "  improvement";
+        }
+        if(std::fabs(it->allocationsPerIteration - cur.allocationsPerIteration) >= .05)
+        {
+            std::cout << "  allocs " << std::setprecision(1) << it->allocationsPerIteration << " -> "
+                      << cur.allocationsPerIteration;
+        }
+        std::cout << "\n";
+    }
+    std::cout << regressions << " significant regression(s) (threshold " << std::setprecision(1) << 100 * threshold
+              << "%, alpha " << std::setprecision(3) << alpha << ")" << std::endl;
+    return regressions;
+}
+
+} // namespace bench
@@ -0,0 +1,142 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Prevent the compiler from optimizing away the computation of a value
+ * @param[in] value the value that must be computed
+ */
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * The code measured by a benchmark: it runs the given number of iterations
+ */
+using Body = std::function<void(std::size_t iterations)>;
+
+/**
+ * A benchmark: the setup (loading a model, generating the input data...) is not measured, it
+ * returns the body that is timed
+ */
+struct Benchmark
+{
+    /// the name of the benchmark, eg "micro/v3f/cross"
+    std::string name;
+    /// the number of items (vectors, lines, triangles...) processed by one iteration
+    std::size_t itemsPerIteration{1};
+    /// prepare the data and return the body to measure
+    std::function<Body()> setup;
+    /// the number of bytes read and written by one iteration, 0 if the throughput is not meaningful
+    std::size_t bytesPerIteration{0};
+};
+
+/**
+ * The options of a run
+ */
+struct RunOptions
+{
+    /// the number of measured samples of each benchmark
+    std::size_t samples{15};
+    /// the minimum duration of a sample in milliseconds, the number of iterations is chosen accordingly
+    double minSampleMs{20};
+    /// run only the benchmarks whose name contains this string
+    std::string filter;
+};
+
+/**
+ * The measures of a benchmark
+ */
+struct Result
+{
+    std::string name;
+    std::size_t itemsPerIteration{1};
+    std::size_t bytesPerIteration{0};
+    /// the number of iterations of each sample
+    std::size_t iterations{0};
+    /// the time per iteration of each sample in nanoseconds
+    std::vector<double> samplesNs;
+    /// the number of heap allocations per iteration, measured on an extra sample
+    double allocationsPerIteration{0};
+    /// the number of page faults per iteration, measured on the same sample
+    double pageFaultsPerIteration{0};
+
+    [[nodiscard]] double median() const;
+    [[nodiscard]] double mean() const;
+    [[nodiscard]] double stddev() const;
+    [[nodiscard]] double min() const;
+    /// the throughput of the median sample in GB/s, 0 if bytesPerIteration is 0
+    [[nodiscard]] double gigabytesPerSecond() const;
+};
+
+/**
+ * Return the number of heap allocations (calls to operator new) since the start of the program
+ * @return the number of allocations
+ */
+std::size_t allocationCount();
+
+/**
+ * Run the benchmarks: each one is warmed up, the number of iterations per sample is calibrated so
+ * that a sample lasts at least minSampleMs, then the samples are measured
+ * @param[in] benchmarks the benchmarks
+ * @param[in] options the options of the run
+ * @return the results, in the order of the benchmarks
+ */
+std::vector<Result> run(const std::vector<Benchmark>& benchmarks, const RunOptions& options);
+
+/**
+ * Write the results in JSON
+ * @param[in] filename the name of the file
+ * @param[in] results the results
+ * @param[in] options the options used for the run
+ * @return true if everything went well, false otherwise
+ */
+bool writeJSON(const std::string& filename, const std::vector<Result>& results, const RunOptions& options);
+
+/**
+ * Read the results written by writeJSON
+ * @param[in] filename the name of the file
+ * @param[out] results the results
+ * @return true if everything went well, false otherwise
+ */
+bool readJSON(const std::string& filename, std::vector<Result>& results);
+
+/**
+ * Return the two-sided p-value of the Mann-Whitney U test (normal approximation with tie correction):
+ * the probability that the two sets of samples come from the same distribution
+ * @param[in] a the first set of samples
+ * @param[in] b the second set of samples
+ * @return the p-value
+ */
+double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b);
+
+/**
+ * Compare two sets of results and print a table of the differences. A benchmark is flagged as a
+ * regression if its median time increased by more than threshold and the increase is significant
+ * @param[in] base the reference results
+ * @param[in] current the new results
+ * @param[in] threshold the relative change under which differences are ignored, eg 0.05
+ * @param[in] alpha the significance level of the test, eg 0.01
+ * @return the number of regressions
+ */
+std::size_t compare(const std::vector<Result>& base, const std::vector<Result>& current, double threshold, double alpha);
+
+} // namespace bench
@@ -0,0 +1,1166 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark.hpp"
+
+#include "angles.hpp"
+#include "core.hpp"
+#include "edges.hpp"
+#include "geometry.hpp"
+#include "logger.hpp"
+#include "loop.hpp"
+#include "MeshModel.hpp"
+#include "meshGenerator.hpp"
+#include "meshStream.hpp"
+#include "objReader.hpp"
+#include "plyReader.hpp"
+#include "quantization.hpp"
+#include "repair.hpp"
+#include "scene.hpp"
+#include "soaVertices.hpp"
+#include "stlReader.hpp"
+#include "weld.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef RENDERER_MODELS_DIR
+#define RENDERER_MODELS_DIR "data/models"
+#endif
+
+namespace {
+
+/// the size of the input of the microbenchmarks
+constexpr std::size_t MICRO_SIZE{4096};
+/// the size of the input of the SoA kernels that does not fit in the cache, to measure the memory bandwidth
+constexpr std::size_t SOA_LARGE_SIZE{1U << 20U};
+/// the seed of all the random inputs, so that two runs measure the same data
+constexpr unsigned SEED{42};
+/// the models with more faces are not subdivided, to keep the duration of a run reasonable
+constexpr std::size_t MAX_SUBDIVISION_FACES{500000};
+/// the number of cells along each side of the grid written in each format by the loader benchmarks
+constexpr std::size_t FORMAT_GRID_SIZE{256};
+
+std::vector<point3d> randomPoints(std::size_t n, unsigned seed = SEED)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    std::vector<point3d> res;
+    res.reserve(n);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        res.emplace_back(dist(gen), dist(gen), dist(gen));
+    }
+    return res;
+}
+
+/**
+ * Generate a noise-displaced grid of n x n cells, 2n^2 triangles
+ * @param[in] n the number of cells along each side
+ * @param[out] vertices the vertices
+ * @param[out] mesh the faces
+ */
+void makeGrid(std::size_t n, std::vector<point3d>& vertices, std::vector<face>& mesh)
+{
+    MemorySink sink(vertices, mesh);
+    generateNoiseGrid(static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(n), .1f, SEED, sink);
+}
+
+void addMicroBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    benchmarks.push_back({"micro/v3f/add_scale", MICRO_SIZE, [] {
+                              return [a = randomPoints(MICRO_SIZE), b = randomPoints(MICRO_SIZE, SEED + 1),
+                                      out = std::vector<point3d>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(std::size_t i = 0; i < a.size(); ++i)
+                                      {
+                                          out[i] = a[i] + b[i] * .5f;
+                                      }
+                                      bench::doNotOptimize(out.data());
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/v3f/loop_edge_point", MICRO_SIZE, [] {
+                              // the position of the new vertex on an edge in the Loop subdivision
+                              return [a = randomPoints(MICRO_SIZE), b = randomPoints(MICRO_SIZE, SEED + 1),
+                                      c = randomPoints(MICRO_SIZE, SEED + 2), d = randomPoints(MICRO_SIZE, SEED + 3),
+                                      out = std::vector<point3d>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(std::size_t i = 0; i < a.size(); ++i)
+                                      {
+                                          out[i] = 3.f * (a[i] + b[i]) / 8.f + (c[i] + d[i]) / 8.f;
+                                      }
+                                      bench::doNotOptimize(out.data());
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/v3f/cross", MICRO_SIZE, [] {
+                              return [a = randomPoints(MICRO_SIZE), b = randomPoints(MICRO_SIZE, SEED + 1),
+                                      out = std::vector<point3d>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(std::size_t i = 0; i < a.size(); ++i)
+                                      {
+                                          out[i] = a[i].cross(b[i]);
+                                      }
+                                      bench::doNotOptimize(out.data());
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/v3f/dot", MICRO_SIZE, [] {
+                              return [a = randomPoints(MICRO_SIZE),
+                                      b = randomPoints(MICRO_SIZE, SEED + 1)](std::size_t iterations) {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      float sum{0};
+                                      for(std::size_t i = 0; i < a.size(); ++i)
+                                      {
+                                          sum += a[i].dot(b[i]);
+                                      }
+                                      bench::doNotOptimize(sum);
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/v3f/normalize", MICRO_SIZE, [] {
+                              return [a = randomPoints(MICRO_SIZE),
+                                      out = std::vector<point3d>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      std::copy(a.begin(), a.end(), out.begin());
+                                      for(auto& v : out)
+                                      {
+                                          v.normalize();
+                                      }
+                                      bench::doNotOptimize(out.data());
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/edgeHash", MICRO_SIZE, [] {
+                              std::mt19937 gen(SEED);
+                              std::uniform_int_distribution<idxtype> dist(0, 1000000);
+                              std::vector<edge> edges(MICRO_SIZE);
+                              for(auto& e : edges)
+                              {
+                                  e = {dist(gen), dist(gen)};
+                              }
+                              return [edges](std::size_t iterations) {
+                                  const edgeHash hash;
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      std::size_t res{0};
+                                      for(const auto& e : edges)
+                                      {
+                                          res ^= hash(e);
+                                      }
+                                      bench::doNotOptimize(res);
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/EdgeList/add_getIndex", MICRO_SIZE, [] {
+                              std::vector<point3d> vertices;
+                              std::vector<face> mesh;
+                              makeGrid(32, vertices, mesh);
+                              std::vector<edge> edges;
+                              for(const auto& f : mesh)
+                              {
+                                  edges.insert(edges.end(), {{f.v1, f.v2}, {f.v2, f.v3}, {f.v3, f.v1}});
+                              }
+                              edges.resize(std::min(edges.size(), MICRO_SIZE));
+                              return [edges](std::size_t iterations) {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      EdgeList list;
+                                      idxtype n{0};
+                                      for(const auto& e : edges)
+                                      {
+                                          if(!list.contains(e))
+                                          {
+                                              list.add(e, n++);
+                                          }
+                                      }
+                                      idxtype sum{0};
+                                      for(const auto& e : edges)
+                                      {
+                                          sum += list.getIndex({e.second, e.first});
+                                      }
+                                      bench::doNotOptimize(sum);
+                                  }
+                              };
+                          }});
+
+    benchmarks.push_back({"micro/parseVertexString", MICRO_SIZE, [] {
+                              std::vector<std::string> lines;
+                              for(const auto& p : randomPoints(MICRO_SIZE))
+                              {
+                                  lines.push_back("v " + std::to_string(p.x) + " " + std::to_string(p.y) + " "
+                                                  + std::to_string(p.z));
+                              }
+                              return [lines](std::size_t iterations) {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(const auto& l : lines)
+                                      {
+                                          bench::doNotOptimize(parseVertexString(l));
+                                      }
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/parseFaceString", MICRO_SIZE, [] {
+                              // the four formats of the faces, in equal proportions
+                              std::mt19937 gen(SEED);
+                              std::uniform_int_distribution<idxtype> dist(1, 100000);
+                              std::vector<std::string> lines;
+                              for(std::size_t i = 0; i < MICRO_SIZE; ++i)
+                              {
+                                  std::string l{"f"};
+                                  for(int v = 0; v < 3; ++v)
+                                  {
+                                      const auto idx = std::to_string(dist(gen));
+                                      const std::string suffixes[] = {"", "/" + idx, "/" + idx + "/" + idx, "//" + idx};
+                                      l += " " + idx + suffixes[i % 4];
+                                  }
+                                  lines.push_back(l);
+                              }
+                              return [lines](std::size_t iterations) {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(const auto& l : lines)
+                                      {
+                                          bench::doNotOptimize(parseFaceString(l));
+                                      }
+                                  }
+                              };
+                          }});
+
+    benchmarks.push_back({"micro/computeNormal", MICRO_SIZE, [] {
+                              return [a = randomPoints(3 * MICRO_SIZE),
+                                      out = std::vector<vec3d>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      for(std::size_t i = 0; i < out.size(); ++i)
+                                      {
+                                          out[i] = computeNormal(a[3 * i], a[3 * i + 1], a[3 * i + 2]);
+                                      }
+                                      bench::doNotOptimize(out.data());
+                                  }
+                              };
+                          }});
+    benchmarks.push_back({"micro/angleAtVertex", MICRO_SIZE, [] {
+                              return [a = randomPoints(3 * MICRO_SIZE)](std::size_t iterations) {
+                                  for(std::size_t it = 0; it < iterations; ++it)
+                                  {
+                                      float sum{0};
+                                      for(std::size_t i = 0; i < MICRO_SIZE; ++i)
+                                      {
+                                          sum += angleAtVertex(a[3 * i], a[3 * i + 1], a[3 * i + 2]);
+                                      }
+                                      bench::doNotOptimize(sum);
+                                  }
+                              };
+                          }});
+
+    // the same angles by edgeAngles, the approximations with each instruction set
+    for(const auto weighting : {AngleWeighting::Exact, AngleWeighting::Accurate, AngleWeighting::Fast})
+    {
+        const int maxLevel = (weighting == AngleWeighting::Exact) ? 0 : static_cast<int>(soa::detectSimdLevel());
+        for(int level = 0; level <= maxLevel; ++level)
+        {
+            const auto simd = static_cast<soa::SimdLevel>(level);
+            std::string name = std::string("micro/edgeAngles/") + toString(weighting);
+            if(weighting != AngleWeighting::Exact)
+            {
+                name += std::string("/") + soa::toString(simd);
+            }
+            benchmarks.push_back({name, MICRO_SIZE, [weighting, simd] {
+                                      // the x, y and z arrays of the first vectors, then of the second ones
+                                      std::vector<float> edges(6 * MICRO_SIZE);
+                                      const auto a = randomPoints(MICRO_SIZE);
+                                      const auto b = randomPoints(MICRO_SIZE, SEED + 1);
+                                      for(std::size_t i = 0; i < MICRO_SIZE; ++i)
+                                      {
+                                          edges[i] = a[i].x;
+                                          edges[MICRO_SIZE + i] = a[i].y;
+                                          edges[2 * MICRO_SIZE + i] = a[i].z;
+                                          edges[3 * MICRO_SIZE + i] = b[i].x;
+                                          edges[4 * MICRO_SIZE + i] = b[i].y;
+                                          edges[5 * MICRO_SIZE + i] = b[i].z;
+                                      }
+                                      return [weighting, simd, edges = std::move(edges),
+                                              out = std::vector<float>(MICRO_SIZE)](std::size_t iterations) mutable {
+                                          const float* const pa[3]{edges.data(), edges.data() + MICRO_SIZE, edges.data() + 2 * MICRO_SIZE};
+                                          const float* const pb[3]{edges.data() + 3 * MICRO_SIZE, edges.data() + 4 * MICRO_SIZE,
+                                                                   edges.data() + 5 * MICRO_SIZE};
+                                          soa::setSimdLevel(simd);
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              edgeAngles(pa, pb, out.data(), MICRO_SIZE, weighting);
+                                              bench::doNotOptimize(out.data());
+                                          }
+                                          soa::setSimdLevel(soa::detectSimdLevel());
+                                      };
+                                  }});
+        }
+    }
+}
+
+/**
+ * Add the benchmarks of the SoA kernels for each instruction set supported, on an input that fits
+ * in the cache and on one that does not, with the equivalent loop on std::vector<v3f> as reference
+ * @param[out] benchmarks the list to complete
+ */
+void addSoABenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    using Kernel = std::function<void(SoAVertices&, SoAVertices&, SoAVertices&, std::size_t)>;
+    struct SoAKernel
+    {
+        const char* name;
+        /// the bytes read and written per vector
+        std::size_t bytes;
+        Kernel kernel;
+    };
+    // the operations are chosen so that repeating them does not overflow
+    const std::vector<SoAKernel> kernels{
+        {"translate", 24,
+         [](SoAVertices& a, SoAVertices&, SoAVertices&, std::size_t it) {
+             soa::translate(a, (it % 2 == 0) ? v3f(.5f, -.5f, .25f) : v3f(-.5f, .5f, -.25f));
+         }},
+        {"scale", 24, [](SoAVertices& a, SoAVertices&, SoAVertices&, std::size_t) { soa::scale(a, -1.f); }},
+        {"bounds", 12,
+         [](SoAVertices& a, SoAVertices&, SoAVertices&, std::size_t) {
+             point3d pmin;
+             point3d pmax;
+             soa::bounds(a, pmin, pmax);
+             bench::doNotOptimize(pmin);
+             bench::doNotOptimize(pmax);
+         }},
+        {"normalize", 24, [](SoAVertices& a, SoAVertices&, SoAVertices&, std::size_t) { soa::normalize(a); }},
+        {"axpy", 36, [](SoAVertices& a, SoAVertices& b, SoAVertices&, std::size_t) { soa::axpy(1e-3f, a, b); }},
+        {"blend", 36,
+         [](SoAVertices& a, SoAVertices& b, SoAVertices& out, std::size_t) { soa::blend(.375f, a, .625f, b, out); }},
+    };
+
+    for(const std::size_t n : {MICRO_SIZE, SOA_LARGE_SIZE})
+    {
+        const std::string size = "/" + std::to_string(n);
+        benchmarks.push_back({"micro/aos/translate" + size, n,
+                              [n] {
+                                  return [a = randomPoints(n)](std::size_t iterations) mutable {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          const float t = (it % 2 == 0) ? .5f : -.5f;
+                                          for(auto& v : a)
+                                          {
+                                              v.translate(t, -t, t / 2);
+                                          }
+                                          bench::doNotOptimize(a.data());
+                                      }
+                                  };
+                              },
+                              24 * n});
+        for(const auto& k : kernels)
+        {
+            for(int level = 0; level <= static_cast<int>(soa::detectSimdLevel()); ++level)
+            {
+                const auto simd = static_cast<soa::SimdLevel>(level);
+                benchmarks.push_back(
+                    {std::string("micro/soa/") + k.name + "/" + soa::toString(simd) + size, n,
+                     [n, simd, kernel = k.kernel] {
+                         return [simd, kernel, a = SoAVertices(randomPoints(n)),
+                                 b = SoAVertices(randomPoints(n, SEED + 1)),
+                                 out = SoAVertices(n)](std::size_t iterations) mutable {
+                             soa::setSimdLevel(simd);
+                             for(std::size_t it = 0; it < iterations; ++it)
+                             {
+                                 kernel(a, b, out, it);
+                                 bench::doNotOptimize(a.x());
+                             }
+                             soa::setSimdLevel(soa::detectSimdLevel());
+                         };
+                     },
+                     k.bytes * n});
+            }
+        }
+    }
+}
+
+void addQuantizationBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    const auto makeMesh = [](std::size_t n, std::vector<point3d>& vertices, std::vector<vec3d>& normals, BoundingBox& bb) {
+        vertices = randomPoints(n);
+        normals = randomPoints(n, SEED + 1);
+        for(auto& v : normals)
+        {
+            v.normalize();
+        }
+        bb.set(vertices.front());
+        for(const auto& v : vertices)
+        {
+            bb.add(v);
+        }
+    };
+    for(const std::size_t n : {MICRO_SIZE, SOA_LARGE_SIZE})
+    {
+        for(const auto encoding : {NormalEncoding::Oct8, NormalEncoding::Oct16})
+        {
+            const std::string name = std::string((encoding == NormalEncoding::Oct8) ? "oct8" : "oct16") + "/" + std::to_string(n);
+            // the bytes of a position and a normal as floats and quantized
+            const std::size_t quantizedBytes = (encoding == NormalEncoding::Oct8) ? 8 : 10;
+            benchmarks.push_back({"micro/quantize/encode/" + name, n,
+                                  [n, encoding, makeMesh] {
+                                      std::vector<point3d> vertices;
+                                      std::vector<vec3d> normals;
+                                      BoundingBox bb;
+                                      makeMesh(n, vertices, normals, bb);
+                                      return [vertices, normals, bb, encoding](std::size_t iterations) {
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              const QuantizedMesh q(vertices, normals, bb, encoding);
+                                              bench::doNotOptimize(q.positions.data());
+                                          }
+                                      };
+                                  },
+                                  (24 + quantizedBytes) * n});
+            benchmarks.push_back({"micro/quantize/decode/" + name, n,
+                                  [n, encoding, makeMesh] {
+                                      std::vector<point3d> vertices;
+                                      std::vector<vec3d> normals;
+                                      BoundingBox bb;
+                                      makeMesh(n, vertices, normals, bb);
+                                      return [q = QuantizedMesh(vertices, normals, bb, encoding), vertices,
+                                              normals](std::size_t iterations) mutable {
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              q.decode(vertices, normals);
+                                              bench::doNotOptimize(vertices.data());
+                                          }
+                                      };
+                                  },
+                                  (24 + quantizedBytes) * n});
+        }
+    }
+}
+
+/**
+ * Count the faces of an OBJ file without parsing it
+ * @param[in] path the OBJ file
+ * @return the number of faces
+ */
+std::size_t countFaces(const std::filesystem::path& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::size_t res{0};
+    while(std::getline(in, line))
+    {
+        res += (line.rfind("f ", 0) == 0) ? 1U : 0U;
+    }
+    return res;
+}
+
+/**
+ * Return the benchmark of one step of subdivision
+ * @param[in] name the name of the mesh
+ * @param[in] numFaces the number of faces of the mesh
+ * @param[in] makeMesh generate or load the mesh
+ * @return the benchmark
+ */
+bench::Benchmark subdivisionBenchmark(const std::string& name, std::size_t numFaces,
+                                      std::function<void(std::vector<point3d>&, std::vector<face>&)> makeMesh)
+{
+    return {"macro/loopSubdivision/" + name, numFaces, [makeMesh] {
+                std::vector<point3d> vertices;
+                std::vector<face> mesh;
+                makeMesh(vertices, mesh);
+                return [vertices, mesh](std::size_t iterations) {
+                    for(std::size_t it = 0; it < iterations; ++it)
+                    {
+                        std::vector<point3d> destVert;
+                        std::vector<face> destMesh;
+                        std::vector<vec3d> destNorm;
+                        loopSubdivision(vertices, mesh, destVert, destMesh, destNorm);
+                        bench::doNotOptimize(destMesh.data());
+                    }
+                };
+            }};
+}
+
+/**
+ * A file in the temporary directory, removed with the object
+ */
+struct TemporaryFile
+{
+    explicit TemporaryFile(const std::string& name) : path((std::filesystem::temp_directory_path() / name).string()) { }
+    ~TemporaryFile() { std::remove(path.c_str()); }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    std::string path;
+};
+
+/**
+ * The same grid written in each format and loaded with the corresponding loader, to compare the
+ * throughput of the formats on the same geometry
+ */
+void addFormatBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    using Loader = std::function<bool(const std::string&, std::vector<point3d>&, std::vector<face>&)>;
+    struct Format
+    {
+        std::string name;
+        std::string extension;
+        std::function<std::unique_ptr<MeshSink>(const std::string&)> makeSink;
+        Loader load;
+    };
+    const std::vector<Format> formats{
+        {"obj", ".obj", [](const std::string& f) { return std::make_unique<ObjSink>(f); },
+         [](const std::string& f, std::vector<point3d>& v, std::vector<face>& m) {
+             std::vector<vec3d> n;
+             BoundingBox b;
+             return load(f, v, m, n, b);
+         }},
+        {"ply-ascii", ".ply", [](const std::string& f) { return std::make_unique<PlySink>(f, false); },
+         [](const std::string& f, std::vector<point3d>& v, std::vector<face>& m) {
+             std::vector<vec3d> n;
+             return loadPly(f, v, m, n);
+         }},
+        {"ply-binary", ".ply", [](const std::string& f) { return std::make_unique<PlySink>(f, true); },
+         [](const std::string& f, std::vector<point3d>& v, std::vector<face>& m) {
+             std::vector<vec3d> n;
+             return loadPly(f, v, m, n);
+         }},
+        {"bmesh", ".bmesh", [](const std::string& f) { return std::make_unique<BinarySink>(f); },
+         [](const std::string& f, std::vector<point3d>& v, std::vector<face>& m) {
+             std::vector<vec3d> n;
+             return loadBinaryMesh(f, v, m, n);
+         }},
+        // a triangle soup: the loading includes the welding
+        {"stl", ".stl", [](const std::string& f) { return std::make_unique<StlSink>(f); },
+         [](const std::string& f, std::vector<point3d>& v, std::vector<face>& m) { return loadStl(f, v, m); }}};
+
+    const std::size_t n{FORMAT_GRID_SIZE};
+    for(const auto& format : formats)
+    {
+        const std::string name = "grid" + std::to_string(n);
+        benchmarks.push_back({"macro/loadFormat/" + format.name + "/" + name, 2 * n * n, [format, name, n] {
+                                  auto file = std::make_shared<TemporaryFile>("renderer_bench_" + name + "_" + format.name
+                                                                              + format.extension);
+                                  const auto sink = format.makeSink(file->path);
+                                  generateNoiseGrid(static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(n), .1f, SEED,
+                                                    *sink);
+                                  return [file, load = format.load](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          std::vector<point3d> v;
+                                          std::vector<face> m;
+                                          load(file->path, v, m);
+                                          bench::doNotOptimize(m.data());
+                                      }
+                                  };
+                              }});
+    }
+}
+
+/**
+ * Weld the triangle soup of an icosphere, exactly and with an epsilon, on one thread and on all the cores
+ */
+void addWeldBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    constexpr std::uint32_t frequency{128};
+    const std::size_t numFaces = 20U * frequency * frequency;
+    for(const float epsilon : {0.f, 1e-5f})
+    {
+        for(const unsigned threads : {1U, 0U})
+        {
+            const std::string name = "macro/weld/icosphere" + std::to_string(frequency) + ((epsilon > 0.f) ? "/epsilon" : "/exact")
+                                     + ((threads == 1) ? "/1thread" : "/allThreads");
+            benchmarks.push_back({name, numFaces, [epsilon, threads] {
+                                      std::vector<point3d> vertices;
+                                      std::vector<face> mesh;
+                                      MemorySink sink(vertices, mesh);
+                                      generateIcosphere(frequency, sink);
+                                      std::vector<point3d> soup;
+                                      soup.reserve(3 * mesh.size());
+                                      for(const auto& f : mesh)
+                                      {
+                                          soup.push_back(vertices[f.v1]);
+                                          soup.push_back(vertices[f.v2]);
+                                          soup.push_back(vertices[f.v3]);
+                                      }
+                                      return [soup, epsilon, threads](std::size_t iterations) {
+                                          std::vector<point3d> welded;
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              bench::doNotOptimize(weldVertices(soup, epsilon, welded, threads).data());
+                                          }
+                                      };
+                                  }});
+        }
+    }
+}
+
+/**
+ * Extract the edges of an icosphere with the radix sort, on one thread and on all the cores, compared
+ * with the map of the edges used by the subdivision before
+ */
+void addEdgeBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    // about 80k and 10M triangles
+    for(const std::uint32_t frequency : {64U, 708U})
+    {
+        const std::size_t numFaces = 20U * frequency * frequency;
+        const std::string prefix = "macro/edges/icosphere" + std::to_string(frequency);
+        const auto makeMesh = [frequency](std::vector<point3d>& vertices, std::vector<face>& mesh) {
+            MemorySink sink(vertices, mesh);
+            generateIcosphere(frequency, sink);
+        };
+        for(const unsigned threads : {1U, 0U})
+        {
+            benchmarks.push_back({prefix + ((threads == 1) ? "/radix/1thread" : "/radix/allThreads"), numFaces, [makeMesh, threads] {
+                                      auto vertices = std::make_shared<std::vector<point3d>>();
+                                      auto mesh = std::make_shared<std::vector<face>>();
+                                      makeMesh(*vertices, *mesh);
+                                      return [vertices, mesh, threads](std::size_t iterations) {
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              EdgeTable table;
+                                              extractEdges(*mesh, vertices->size(), table, threads);
+                                              bench::doNotOptimize(table.faceEdges.data());
+                                          }
+                                      };
+                                  }});
+        }
+        benchmarks.push_back({prefix + "/hash", numFaces, [makeMesh] {
+                                  auto vertices = std::make_shared<std::vector<point3d>>();
+                                  auto mesh = std::make_shared<std::vector<face>>();
+                                  makeMesh(*vertices, *mesh);
+                                  return [mesh](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          // the same output: the index of the edge of each corner
+                                          EdgeList edges(3 * mesh->size() / 2);
+                                          std::vector<idxtype> faceEdges(3 * mesh->size());
+                                          idxtype numEdges{0};
+                                          for(std::size_t f = 0; f < mesh->size(); ++f)
+                                          {
+                                              const face& t = (*mesh)[f];
+                                              const edge sides[3]{edge(t.v1, t.v2), edge(t.v2, t.v3), edge(t.v3, t.v1)};
+                                              for(std::size_t k = 0; k < 3; ++k)
+                                              {
+                                                  if(!edges.contains(sides[k]))
+                                                  {
+                                                      edges.add(sides[k], numEdges++);
+                                                  }
+                                                  faceEdges[3 * f + k] = edges.getIndex(sides[k]);
+                                              }
+                                          }
+                                          bench::doNotOptimize(faceEdges.data());
+                                      }
+                                  };
+                              }});
+    }
+}
+
+/**
+ * Compute the angle-weighted normals of an icosphere by scattering the faces into their vertices, and
+ * by gathering the corners of each vertex through the vertex-corner index on one thread and on all
+ * the cores, the index being built in each iteration. The approximated angle weights are measured
+ * through computeVertexNormals.
+ */
+void addNormalBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    // about 80k and 1.3M triangles
+    for(const std::uint32_t frequency : {64U, 256U})
+    {
+        const std::size_t numFaces = 20U * frequency * frequency;
+        const std::size_t numVertices = 10U * frequency * frequency + 2;
+        // the faces, the vertices of their corners and the normals
+        const std::size_t bytes = numFaces * (sizeof(face) + 3 * sizeof(point3d)) + numVertices * sizeof(vec3d);
+        const std::string prefix = "macro/normals/icosphere" + std::to_string(frequency);
+        const auto makeMesh = [frequency](std::vector<point3d>& vertices, std::vector<face>& mesh) {
+            MemorySink sink(vertices, mesh);
+            generateIcosphere(frequency, sink);
+        };
+        benchmarks.push_back({prefix + "/scatter", numFaces, [makeMesh] {
+                                  auto vertices = std::make_shared<std::vector<point3d>>();
+                                  auto mesh = std::make_shared<std::vector<face>>();
+                                  makeMesh(*vertices, *mesh);
+                                  return [vertices, mesh](std::size_t iterations) {
+                                      std::vector<vec3d> normals;
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          const auto& v = *vertices;
+                                          normals.assign(v.size(), vec3d{0, 0, 0});
+                                          for(const auto& t : *mesh)
+                                          {
+                                              const vec3d n = computeNormal(v[t.v1], v[t.v2], v[t.v3]);
+                                              normals[t.v1] += n * angleAtVertex(v[t.v1], v[t.v2], v[t.v3]);
+                                              normals[t.v2] += n * angleAtVertex(v[t.v2], v[t.v1], v[t.v3]);
+                                              normals[t.v3] += n * angleAtVertex(v[t.v3], v[t.v2], v[t.v1]);
+                                          }
+                                          bench::doNotOptimize(normals.data());
+                                      }
+                                  };
+                              }, bytes});
+        for(const unsigned threads : {1U, 0U})
+        {
+            benchmarks.push_back({prefix + ((threads == 1) ? "/gather/1thread" : "/gather/allThreads"), numFaces, [makeMesh, threads] {
+                                      auto vertices = std::make_shared<std::vector<point3d>>();
+                                      auto mesh = std::make_shared<std::vector<face>>();
+                                      makeMesh(*vertices, *mesh);
+                                      return [vertices, mesh, threads](std::size_t iterations) {
+                                          std::vector<vec3d> normals;
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              normals.assign(vertices->size(), vec3d{0, 0, 0});
+                                              VertexCorners adjacency;
+                                              buildVertexCorners(Span<const face>(*mesh), vertices->size(), adjacency);
+                                              gatherVertexNormals(*vertices, Span<const face>(*mesh), adjacency, normals, threads);
+                                              bench::doNotOptimize(normals.data());
+                                          }
+                                      };
+                                  }, bytes});
+        }
+        for(const auto weighting : {AngleWeighting::Exact, AngleWeighting::Accurate, AngleWeighting::Fast})
+        {
+            benchmarks.push_back({prefix + "/computeVertexNormals/" + toString(weighting), numFaces, [makeMesh, weighting] {
+                                      auto vertices = std::make_shared<std::vector<point3d>>();
+                                      auto mesh = std::make_shared<std::vector<face>>();
+                                      makeMesh(*vertices, *mesh);
+                                      return [vertices, mesh, weighting](std::size_t iterations) {
+                                          std::vector<vec3d> normals;
+                                          for(std::size_t it = 0; it < iterations; ++it)
+                                          {
+                                              computeVertexNormals(*vertices, Span<const face>(*mesh), normals, weighting);
+                                              bench::doNotOptimize(normals.data());
+                                          }
+                                      };
+                                  }, bytes});
+        }
+    }
+}
+
+/**
+ * Repair the triangle soup of an icosphere, compared with the welding alone done by a pairwise search
+ */
+void addRepairBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    constexpr std::uint32_t frequency{16};
+    constexpr float epsilon{1e-6f};
+    const std::size_t numFaces = 20U * frequency * frequency;
+    for(const bool pairwise : {false, true})
+    {
+        const std::string name = "macro/repair/icosphere" + std::to_string(frequency) + (pairwise ? "/pairwise" : "/grid");
+        benchmarks.push_back({name, numFaces, [pairwise] {
+                                  std::vector<point3d> vertices;
+                                  std::vector<face> mesh;
+                                  MemorySink sink(vertices, mesh);
+                                  generateIcosphere(frequency, sink);
+                                  std::vector<point3d> soup;
+                                  std::vector<face> soupMesh;
+                                  for(const auto& f : mesh)
+                                  {
+                                      const auto first = static_cast<idxtype>(soup.size());
+                                      soup.push_back(vertices[f.v1]);
+                                      soup.push_back(vertices[f.v2]);
+                                      soup.push_back(vertices[f.v3]);
+                                      soupMesh.emplace_back(first, first + 1, first + 2);
+                                  }
+                                  return [soup, soupMesh, pairwise](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          if(!pairwise)
+                                          {
+                                              std::vector<point3d> v = soup;
+                                              std::vector<face> m = soupMesh;
+                                              bench::doNotOptimize(repairMesh(v, m, epsilon, 1).verticesAfter);
+                                              continue;
+                                          }
+                                          // each vertex is compared with all the previous ones
+                                          std::vector<idxtype> remap(soup.size());
+                                          for(std::size_t i = 0; i < soup.size(); ++i)
+                                          {
+                                              remap[i] = static_cast<idxtype>(i);
+                                              for(std::size_t j = 0; j < i; ++j)
+                                              {
+                                                  const point3d d = soup[i] - soup[j];
+                                                  if(d.dot(d) <= epsilon * epsilon)
+                                                  {
+                                                      remap[i] = remap[j];
+                                                      break;
+                                                  }
+                                              }
+                                          }
+                                          bench::doNotOptimize(remap.data());
+                                      }
+                                  };
+                              }});
+    }
+}
+
+/**
+ * Load a scene of 100 instances, from 100 OBJ files one after the other and on the shared pool, and
+ * from 10 files shared by 10 instances each
+ */
+void addSceneBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    constexpr std::size_t numInstances{100};
+    struct Variant
+    {
+        std::string name;
+        std::size_t numFiles;
+        bool pool;
+    };
+    for(const auto& variant : {Variant{"load100/sequential", 100, false}, Variant{"load100/pool", 100, true},
+                               Variant{"load100x10/pool", 10, true}})
+    {
+        benchmarks.push_back({"macro/scene/" + variant.name, numInstances, [variant] {
+                                  // tori of about 2000 triangles, slightly different from each other
+                                  auto files = std::make_shared<std::vector<std::unique_ptr<TemporaryFile>>>();
+                                  for(std::size_t f = 0; f < variant.numFiles; ++f)
+                                  {
+                                      files->push_back(std::make_unique<TemporaryFile>("renderer_bench_scene" + std::to_string(f) + ".obj"));
+                                      ObjSink sink(files->back()->path);
+                                      generateTorus(static_cast<std::uint32_t>(56 + f % 16), 18, 1.f, .3f, sink);
+                                  }
+                                  return [files, variant](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          Scene scene;
+                                          for(std::size_t i = 0; i < numInstances; ++i)
+                                          {
+                                              scene.add((*files)[i % files->size()]->path);
+                                          }
+                                          const SceneLoadStats stats = scene.load(0.f, variant.pool ? &ThreadPool::shared() : nullptr,
+                                                                                  [](MeshModel& m) { m.unitizeModel(); });
+                                          bench::doNotOptimize(stats.instances);
+                                      }
+                                  };
+                              }});
+    }
+}
+
+/**
+ * Update a subdivided model with moved vertices, from the cached topology of the subdivision, compared
+ * with replacing the model and subdividing it again as when the faces change
+ */
+void addReloadBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    constexpr std::uint32_t frequency{8};
+    constexpr unsigned short levels{2};
+    const std::size_t numFaces = 20U * frequency * frequency * 16U;
+    for(const bool samePositions : {true, false})
+    {
+        const std::string name = "macro/reload/icosphere" + std::to_string(frequency) + "x" + std::to_string(levels)
+                                 + (samePositions ? "/positions" : "/topology");
+        benchmarks.push_back({name, numFaces, [samePositions] {
+                                  MeshBatch sphere;
+                                  MemorySink sink(sphere.vertices, sphere.faces);
+                                  generateIcosphere(frequency, sink);
+                                  auto model = std::make_shared<MeshModel>();
+                                  model->append(MeshBatch{sphere});
+                                  bench::doNotOptimize(model->level(levels).vertices.data());
+                                  return [model, sphere, samePositions](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          // the model breathes, as when a file is exported again
+                                          MeshBatch moved = sphere;
+                                          for(auto& v : moved.vertices)
+                                          {
+                                              v = v * (1.f + .01f * static_cast<float>(it % 2));
+                                          }
+                                          if(samePositions)
+                                          {
+                                              model->update(std::move(moved));
+                                          }
+                                          else
+                                          {
+                                              model->clear();
+                                              model->append(std::move(moved));
+                                          }
+                                          bench::doNotOptimize(model->level(levels).vertices.data());
+                                      }
+                                  };
+                              }});
+    }
+}
+
+/**
+ * Save a mesh as large as the level 5 of the subdivision of an icosphere of 1280 faces: element by
+ * element through ObjSink, by blocks on the calling thread and on the shared pool, in the binary
+ * container, and the same number of bytes as the OBJ file written without formatting
+ */
+void addExportBenchmarks(std::vector<bench::Benchmark>& benchmarks)
+{
+    // the icosphere of frequency 8 * 2^5 has the faces of the level 5
+    constexpr std::uint32_t frequency{256};
+    const std::size_t numFaces = 20U * frequency * frequency;
+    for(const std::string variant : {"objSink", "obj", "obj/pool", "bmesh", "write"})
+    {
+        benchmarks.push_back({"macro/export/level5/" + variant, numFaces, [variant] {
+                                  auto mesh = std::make_shared<MeshLevel>();
+                                  std::vector<face> faces;
+                                  MemorySink sink(mesh->vertices, faces);
+                                  generateIcosphere(frequency, sink);
+                                  mesh->faces.assign(faces, mesh->vertices.size());
+                                  computeVertexNormals(mesh->vertices, faces, mesh->normals);
+                                  auto file = std::make_shared<TemporaryFile>("renderer_bench_export" + std::string(variant == "bmesh" ? ".bmesh" : ".obj"));
+                                  // the size of the text, for the write without formatting
+                                  writeObj(file->path, mesh->vertices, mesh->faces);
+                                  const auto objBytes = static_cast<std::size_t>(std::filesystem::file_size(file->path));
+                                  return [mesh, file, faces, variant, objBytes](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          bool saved{false};
+                                          if(variant == "objSink")
+                                          {
+                                              ObjSink obj(file->path);
+                                              saved = obj.begin(mesh->vertices.size(), faces.size());
+                                              for(const auto& v : mesh->vertices)
+                                              {
+                                                  obj.vertex(v);
+                                              }
+                                              for(const auto& f : faces)
+                                              {
+                                                  obj.face(f);
+                                              }
+                                              saved = obj.end() && saved;
+                                          }
+                                          else if(variant == "obj" || variant == "obj/pool")
+                                          {
+                                              saved = writeObj(file->path, mesh->vertices, mesh->faces, variant == "obj" ? 1 : 0);
+                                          }
+                                          else if(variant == "bmesh")
+                                          {
+                                              saved = writeBinaryMesh(file->path, mesh->vertices, mesh->normals, mesh->faces);
+                                          }
+                                          else
+                                          {
+                                              std::FILE* out = std::fopen(file->path.c_str(), "wb");
+                                              const std::vector<char> block(4U << 20U, 'x');
+                                              for(std::size_t written = 0; out != nullptr && written < objBytes; written += block.size())
+                                              {
+                                                  std::fwrite(block.data(), 1, std::min(block.size(), objBytes - written), out);
+                                              }
+                                              saved = out != nullptr && std::fclose(out) == 0;
+                                          }
+                                          bench::doNotOptimize(saved);
+                                      }
+                                  };
+                              }});
+    }
+}
+
+void addMacroBenchmarks(std::vector<bench::Benchmark>& benchmarks, const std::string& modelsDir)
+{
+    // synthetic meshes
+    for(const std::size_t n : {std::size_t{16}, std::size_t{32}})
+    {
+        benchmarks.push_back(subdivisionBenchmark("grid" + std::to_string(n), 2 * n * n,
+                                                  [n](std::vector<point3d>& vertices, std::vector<face>& mesh) {
+                                                      makeGrid(n, vertices, mesh);
+                                                  }));
+    }
+    for(const std::uint32_t frequency : {4U, 8U})
+    {
+        benchmarks.push_back(subdivisionBenchmark("icosphere" + std::to_string(frequency),
+                                                  20U * frequency * frequency,
+                                                  [frequency](std::vector<point3d>& vertices, std::vector<face>& mesh) {
+                                                      MemorySink sink(vertices, mesh);
+                                                      generateIcosphere(frequency, sink);
+                                                  }));
+    }
+
+    // the models, sorted to keep the same order across runs
+    std::vector<std::filesystem::path> models;
+    std::error_code error;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(modelsDir, error))
+    {
+        if(entry.is_regular_file() && entry.path().extension() == ".obj")
+        {
+            models.push_back(entry.path());
+        }
+    }
+    if(error)
+    {
+        LOG_WARNING(General, "Unable to list the models in " << modelsDir << ": " << error.message());
+    }
+    std::sort(models.begin(), models.end());
+
+    for(const auto& path : models)
+    {
+        const std::string name = path.stem().string();
+        const std::size_t numFaces = countFaces(path);
+        benchmarks.push_back({"macro/load/" + name, numFaces, [path] {
+                                  return [path](std::size_t iterations) {
+                                      for(std::size_t it = 0; it < iterations; ++it)
+                                      {
+                                          std::vector<point3d> v;
+                                          std::vector<face> m;
+                                          std::vector<vec3d> n;
+                                          BoundingBox b;
+                                          load(path.string(), v, m, n, b);
+                                          bench::doNotOptimize(m.data());
+                                      }
+                                  };
+                              }});
+        if(numFaces <= MAX_SUBDIVISION_FACES)
+        {
+            benchmarks.push_back(subdivisionBenchmark(
+                name, numFaces, [path](std::vector<point3d>& vertices, std::vector<face>& mesh) {
+                    std::vector<vec3d> normals;
+                    BoundingBox bb;
+                    load(path.string(), vertices, mesh, normals, bb);
+                }));
+        }
+    }
+}
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage:\n"
+              << "\t" << program << " [options]\n"
+              << "\t" << program << " --compare <base.json> <new.json> [--threshold PERCENT] [--alpha ALPHA]\n\n"
+              << "Options:\n"
+              << "\t--filter STRING   run only the benchmarks whose name contains STRING\n"
+              << "\t--samples N       number of samples of each benchmark (default 15)\n"
+              << "\t--min-time MS     minimum duration of a sample in milliseconds (default 20)\n"
+              << "\t--models DIR      directory of the OBJ models (default " << RENDERER_MODELS_DIR << ")\n"
+              << "\t--out FILE        write the results in JSON to FILE\n"
+              << "\t--list            list the benchmarks and exit\n\n"
+              << "Compare mode: the exit status is 1 if a benchmark is slower by more than the threshold\n"
+              << "(default 5%) and the Mann-Whitney U test rejects equality at level alpha (default 0.01)"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // the loader reports each model it loads: keep only the warnings and the errors
+    logging::Logger::instance().setLevel(logging::Level::Warning);
+
+    bench::RunOptions options;
+    std::string modelsDir{RENDERER_MODELS_DIR};
+    std::string outFile;
+    std::vector<std::string> compareFiles;
+    double threshold{5};
+    double alpha{.01};
+    bool list{false};
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string arg{argv[i]};
+            const auto next = [&]() -> std::string {
+                if(i + 1 >= argc)
+                {
+                    throw std::invalid_argument(arg);
+                }
+                return argv[++i];
+            };
+            if(arg == "--filter")
+            {
+                options.filter = next();
+            }
+            else if(arg == "--samples")
+            {
+                options.samples = std::stoul(next());
+            }
+            else if(arg == "--min-time")
+            {
+                options.minSampleMs = std::stod(next());
+            }
+            else if(arg == "--models")
+            {
+                modelsDir = next();
+            }
+            else if(arg == "--out")
+            {
+                outFile = next();
+            }
+            else if(arg == "--list")
+            {
+                list = true;
+            }
+            else if(arg == "--compare")
+            {
+                compareFiles = {next(), next()};
+            }
+            else if(arg == "--threshold")
+            {
+                threshold = std::stod(next());
+            }
+            else if(arg == "--alpha")
+            {
+                alpha = std::stod(next());
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return (arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+    }
+    catch(const std::logic_error&)
+    {
+        LOG_ERROR(General, "invalid or missing value in the arguments");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(!compareFiles.empty())
+    {
+        std::vector<bench::Result> base;
+        std::vector<bench::Result> current;
+        if(!bench::readJSON(compareFiles[0], base) || !bench::readJSON(compareFiles[1], current))
+        {
+            return EXIT_FAILURE;
+        }
+        return (bench::compare(base, current, threshold / 100, alpha) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::vector<bench::Benchmark> benchmarks;
+    addMicroBenchmarks(benchmarks);
+    addSoABenchmarks(benchmarks);
+    addQuantizationBenchmarks(benchmarks);
+    addMacroBenchmarks(benchmarks, modelsDir);
+    addFormatBenchmarks(benchmarks);
+    addWeldBenchmarks(benchmarks);
+    addEdgeBenchmarks(benchmarks);
+    addNormalBenchmarks(benchmarks);
+    addRepairBenchmarks(benchmarks);
+    addSceneBenchmarks(benchmarks);
+    addReloadBenchmarks(benchmarks);
+    addExportBenchmarks(benchmarks);
+    if(list)
+    {
+        for(const auto& b : benchmarks)
+        {
+            std::cout << b.name << "\n";
+        }
+        return EXIT_SUCCESS;
+    }
+
+    const auto results = bench::run(benchmarks, options);
+    if(!outFile.empty() && !bench::writeJSON(outFile, results, options))
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
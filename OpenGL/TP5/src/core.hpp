@@ -6,24 +6,22 @@
 
 #pragma once
 
-#include "openglAll.hpp"
+#include "logger.hpp"
+#include "opengl.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include <iostream>
 #include <string>
 
+#include <memory_resource>
 #include <unordered_map>
+#include <variant>
 #include <functional>
 
 
-#define DEBUGGING 1
-
-#if DEBUGGING
-#define PRINTVAR( a ) std::cout << #a << " = " << (a) << "\n\n";
-#else
-#define PRINTVAR( a )
-#endif
-
 /**
  * Renaming, the type of an index is a unsigned int
  */
@@ -110,9 +108,10 @@ struct edgeHash
 
 
 /**
- * An edge list is a map of edges (the keys) and a index of the vertex
+ * An edge list is a map of edges (the keys) and a index of the vertex. Its nodes come from a
+ * memory resource, eg the arena of the subdivision
  */
-using edge2vertex = std::unordered_map< edge, idxtype, edgeHash, edgeEquivalent >;
+using edge2vertex = std::pmr::unordered_map< edge, idxtype, edgeHash, edgeEquivalent >;
 
 inline std::ostream& operator<<( std::ostream& os, const edge2vertex & l )
 {
@@ -139,6 +138,14 @@ class EdgeList
 public:
     EdgeList( ) = default;
 
+    /**
+     * Constructor
+     * @param[in] numEdges the number of edges expected, so that the map is never rehashed
+     * @param[in] resource where the nodes of the map are allocated
+     */
+    explicit EdgeList( std::size_t numEdges, std::pmr::memory_resource* resource = std::pmr::get_default_resource( ) )
+        : list( numEdges, resource ) { }
+
     /**
      * Add the edge and the index of the new vertex generated on it
      * @param[in] e the edge
@@ -185,16 +192,21 @@ inline std::ostream& operator<<( std::ostream& os, const EdgeList& l )
 
 
 /**
- * A generic vector of three elements of type float (x, y, z)
+ * A generic vector of three elements of type T (x, y, z). All the operations are constexpr
+ * and defined here so that the compiler can inline and vectorize the loops using them.
+ * @tparam T the type of the elements, float (v3f) or double (v3d)
  */
-struct v3f
+template<typename T>
+struct v3
 {
+    using value_type = T;
+
     /// the first component
-    float x{0.f};
+    T x{0};
     /// the second component
-    float y{0.f};
+    T y{0};
     /// the third component
-    float z{0.f};
+    T z{0};
 
     /**
      * Generic constructor
@@ -202,159 +214,208 @@ struct v3f
      * @param[in] yc the second element
      * @param[in] zc the third element
      */
-    v3f( float xc, float yc, float zc ) : x( xc ), y( yc ), z( zc ) { }
+    constexpr v3( T xc, T yc, T zc ) : x( xc ), y( yc ), z( zc ) { }
 
     /**
      * Default constructor, everything is initialized to 0
      */
-    v3f() = default;
+    constexpr v3() = default;
 
     /**
      * Constructor from an array of three elements
      * @param[in] a the array from which to copy the elements
      */
-    explicit v3f( const float a[3] ) : x( a[0] ), y( a[1] ), z( a[2] ) { }
+    constexpr explicit v3( const T a[3] ) : x( a[0] ), y( a[1] ), z( a[2] ) { }
+
+    /**
+     * Conversion from a vector of another precision, eg to process a v3f in double
+     * @param[in] v the vector to convert
+     */
+    template<typename U>
+    constexpr explicit v3( const v3<U>& v ) : x( static_cast<T>( v.x ) ), y( static_cast<T>( v.y ) ), z( static_cast<T>( v.z ) ) { }
 
     /**
-     * Normalize the vector (ie divide by the norm)
+     * Normalize the vector (ie divide by the norm), the vectors too short are left unchanged
      */
-    void normalize( );
+    void normalize( )
+    {
+        const T n = norm( );
+        if( n > ( T{100} * std::numeric_limits<T>::epsilon( ) ) )
+        {
+            x /= n;
+            y /= n;
+            z /= n;
+        }
+    }
 
     /**
      * Return the dot product with another vector
      * @param[in] v the other vector
      * @return the dot product
      */
-    float dot( const v3f &v ) const;
+    constexpr T dot( const v3 &v ) const { return ( x * v.x + y * v.y + z * v.z ); }
 
     /**
      * Return the norm of the vector
      * @return the norm
      */
-    float norm( ) const;
+    T norm( ) const { return std::sqrt( dot( *this ) ); }
 
     /**
      * Translate the vector
-     * @param[in] x the delta x of the translation
-     * @param[in] y the delta y of the translation
-     * @param[in] z the delta z of the translation
+     * @param[in] xc the delta x of the translation
+     * @param[in] yc the delta y of the translation
+     * @param[in] zc the delta z of the translation
      */
-    void translate( float x, float y, float z );
+    constexpr void translate( T xc, T yc, T zc )
+    {
+        x += xc;
+        y += yc;
+        z += zc;
+    }
 
     /**
      * Translate the vector
      * @param[in] t the translation
      */
-    void translate( const v3f &t );
+    constexpr void translate( const v3 &t ) { *this += t; }
 
     /**
      * Scale each element of the vector by the corresponding value
      * @param[in] t a vector containing a factor scale to apply to each element
      */
-    void scale( const v3f &t );
+    constexpr void scale( const v3 &t ) { *this *= t; }
 
     /**
      * Scale each element of the vector by the corresponding value
-     * @param x the scale value on x
-     * @param y the scale value on y
-     * @param z the scale value on z
+     * @param xc the scale value on x
+     * @param yc the scale value on y
+     * @param zc the scale value on z
      */
-    void scale(float x, float y, float z );
+    constexpr void scale( T xc, T yc, T zc ) { scale( v3( xc, yc, zc ) ); }
 
     /**
      * Scale each element of the vector by the same value
      * @param a The scalar value to apply to each element
      */
-    void scale( const float &a );
+    constexpr void scale( const T &a ) { *this *= a; }
 
     /**
      * Set each element of the current vector to the minimum value wrt another vector
      * @param a the other vector
      */
-    void min( const v3f& a );
+    constexpr void min( const v3& a )
+    {
+        x = std::min( x, a.x );
+        y = std::min( y, a.y );
+        z = std::min( z, a.z );
+    }
 
     /**
      * Return the minimum value among the 3 elements
      * @return the minimum value
      */
-    float min( ) const;
+    constexpr T min( ) const { return std::min( { x, y, z } ); }
 
     /**
      * Set each element of the current vector to the maximum value wrt another vector
      * @param a the other vector
      */
-    void max( const v3f& a );
+    constexpr void max( const v3& a )
+    {
+        x = std::max( x, a.x );
+        y = std::max( y, a.y );
+        z = std::max( z, a.z );
+    }
 
     /**
      * Return the maximum value among the 3 elements
      * @return the maximum value
      */
-    float max( ) const;
+    constexpr T max( ) const { return std::max( { x, y, z } ); }
 
     /**
      * Return the cross product of two vectors
      * @param v the other vector
      * @return the cross product
      */
-    v3f cross( const v3f& v ) const;
+    constexpr v3 cross( const v3& v ) const
+    {
+        return { y * v.z - z * v.y,
+                 z * v.x - x * v.z,
+                 x * v.y - y * v.x };
+    }
 
     /**
      * Return the cross product of two vectors
      * @param v the other array
      * @return the cross product
      */
-    v3f cross( const float v[3] ) const;
+    constexpr v3 cross( const T v[3] ) const { return cross( v3( v ) ); }
 
     // element-wise addition
 
-    v3f operator +( const v3f& a ) const;
-    v3f& operator +=( const v3f& a );
+    constexpr v3 operator +( const v3& a ) const { return { x + a.x, y + a.y, z + a.z }; }
+    constexpr v3& operator +=( const v3& a ) { return ( *this = *this + a ); }
 
-    v3f operator +( const float a[3] ) const;
-    v3f& operator +=( const float a[3] );
+    constexpr v3 operator +( const T a[3] ) const { return *this + v3( a ); }
+    constexpr v3& operator +=( const T a[3] ) { return ( *this = *this + a ); }
 
-    v3f operator +( const float &a ) const;
-    v3f& operator +=( const float &a );
+    constexpr v3 operator +( const T &a ) const { return { x + a, y + a, z + a }; }
+    constexpr v3& operator +=( const T &a ) { return ( *this = *this + a ); }
 
     // element-wise subtraction
 
-    v3f operator -( const v3f& a ) const;
-    v3f& operator -=( const v3f& a );
+    constexpr v3 operator -( const v3& a ) const { return { x - a.x, y - a.y, z - a.z }; }
+    constexpr v3& operator -=( const v3& a ) { return ( *this = *this - a ); }
 
-    v3f operator -( const float a[3] ) const;
-    v3f& operator -=( const float a[3] );
+    constexpr v3 operator -( const T a[3] ) const { return *this - v3( a ); }
+    constexpr v3& operator -=( const T a[3] ) { return ( *this = *this - a ); }
 
-    v3f operator -( const float &a ) const;
-    v3f& operator -=( const float &a );
+    constexpr v3 operator -( const T &a ) const { return { x - a, y - a, z - a }; }
+    constexpr v3& operator -=( const T &a ) { return ( *this = *this - a ); }
 
     // element-wise product
 
-    v3f operator *( const v3f& a ) const;
-    v3f& operator *=( const v3f& a );
+    constexpr v3 operator *( const v3& a ) const { return { x * a.x, y * a.y, z * a.z }; }
+    constexpr v3& operator *=( const v3& a ) { return ( *this = *this * a ); }
 
-    v3f operator *( const float a[3] ) const;
-    v3f& operator *=( const float a[3] );
+    constexpr v3 operator *( const T a[3] ) const { return *this * v3( a ); }
+    constexpr v3& operator *=( const T a[3] ) { return ( *this = *this * a ); }
 
-    v3f operator *( const float &a ) const;
-    v3f& operator *=( const float &a );
+    constexpr v3 operator *( const T &a ) const { return { x * a, y * a, z * a }; }
+    constexpr v3& operator *=( const T &a ) { return ( *this = *this * a ); }
 
     // element-wise ratio
 
-    v3f operator /( const v3f& a ) const;
-    v3f& operator /=( const v3f& a );
+    constexpr v3 operator /( const v3& a ) const { return { x / a.x, y / a.y, z / a.z }; }
+    constexpr v3& operator /=( const v3& a ) { return ( *this = *this / a ); }
+
+    constexpr v3 operator /( const T a[3] ) const { return *this / v3( a ); }
+    constexpr v3& operator /=( const T a[3] ) { return ( *this = *this / a ); }
+
+    constexpr v3 operator /( const T &a ) const { return { x / a, y / a, z / a }; }
+    constexpr v3& operator /=( const T &a ) { return ( *this = *this / a ); }
 
-    v3f operator /( const float a[3] ) const;
-    v3f& operator /=( const float a[3] );
+    // REFLEXIVE OPERATORS, defined as friends so that the scalar can be converted (eg 3.0 * v3f)
 
-    v3f operator /( const float &a ) const;
-    v3f& operator /=( const float &a );
+    friend constexpr v3 operator +( const T &a, const v3& p ) { return ( p + a ); }
+    friend constexpr v3 operator +( const T a[3], const v3& p ) { return ( p + a ); }
+    friend constexpr v3 operator -( const T &a, const v3& p ) { return ( p - a ); }
+    friend constexpr v3 operator -( const T a[3], const v3& p ) { return ( p - a ); }
+    friend constexpr v3 operator *( const T a[3], const v3& p ) { return ( p * a ); }
+    friend constexpr v3 operator *( const T &a, const v3& p ) { return ( p * a ); }
+    friend constexpr v3 operator /( const T a[3], const v3& p ) { return ( p / a ); }
+    friend constexpr v3 operator /( const T &a, const v3& p ) { return ( p / a ); }
 };
 
 /**
  * Some definitions
  */
-using point3d = struct v3f ;
-using vec3d = struct v3f;
+using v3f = v3<float>;
+using v3d = v3<double>;
+using point3d = v3f;
+using vec3d = v3f;
 
 /**
  * Print the elements of a vector
@@ -362,18 +423,20 @@ using vec3d = struct v3f;
  * @param p the vector
  * @return the string with the values
  */
-inline std::ostream& operator<<( std::ostream& os, const v3f& p )
+template<typename T>
+std::ostream& operator<<( std::ostream& os, const v3<T>& p )
 {
     return os << "[" << p.x << "," << p.y << "," << p.z << "]";
 }
 
 /**
- * Print the elements of a vector of v3f elements
+ * Print the elements of a vector of v3 elements
  * @param os the string to fill with the vector elements
  * @param p the vector
  * @return the string with the vector elements
  */
-inline std::ostream& operator<<( std::ostream& os, const std::vector<v3f>& p )
+template<typename T>
+std::ostream& operator<<( std::ostream& os, const std::vector<v3<T>>& p )
 {
     os << std::endl;
     for (const auto& v : p)
@@ -382,70 +445,47 @@ inline std::ostream& operator<<( std::ostream& os, const std::vector<v3f>& p )
 }
 
 
+/**************************************************************************/
 
-// REFLEXIVE OPERATORS FOR V3F
-
-inline v3f operator +( const float &a, const v3f& p )
-{
-    return (p + a );
-}
-
-inline v3f operator +( const float a[3], const v3f& p )
-{
-    return (p + a );
-}
-
-inline v3f operator -( const float &a, const v3f& p )
-{
-    return (p - a );
-}
-
-inline v3f operator -( const float a[3], const v3f& p )
-{
-    return (p - a );
-}
-
-inline v3f operator *( const float a[3], const v3f& p )
-{
-    return (p * a );
-}
 
-inline v3f operator *( const float &a, const v3f& p )
-{
-    return (p * a );
-}
 
-inline v3f operator /( const float a[3], const v3f& p )
-{
-    return (p / a );
-}
+/**
+ * Renaming, the type of a 16-bit index, enough for the meshes with at most 65536 vertices
+ */
+using idx16type = GLushort;
 
-inline v3f operator /( const float &a, const v3f& p )
+/**
+ * Return the OpenGL type of an index, eg for glDrawElements
+ * @tparam Index idxtype or idx16type
+ * @return GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+ */
+template<typename Index>
+constexpr GLenum glIndexType( )
 {
-    return (p / a );
+    static_assert( sizeof( Index ) == 2 || sizeof( Index ) == 4, "unsupported index type" );
+    return ( sizeof( Index ) == 2 ) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 }
 
-
-/**************************************************************************/
-
-
-
 /**
  * The face as a triplet of indices
+ * @tparam Index the type of the indices, idxtype or idx16type
  */
-struct face
+template<typename Index>
+struct basicFace
 {
+    using index_type = Index;
+
     /// the first index
-    idxtype v1{0};
+    Index v1{0};
     /// the second index
-    idxtype v2{0};
+    Index v2{0};
     /// the third index
-    idxtype v3{0};
+    Index v3{0};
 
     /**
      * Default constructor, everything set to 0
      */
-    face() = default;
+    constexpr basicFace() = default;
 
     /**
      * Constructor from indices
@@ -453,7 +493,15 @@ struct face
      * @param[in] v2_ the second index
      * @param[in] v3_ the third index
      */
-    face( idxtype v1_, idxtype v2_, idxtype v3_ ) : v1( v1_ ), v2( v2_ ), v3( v3_ ) { }
+    constexpr basicFace( Index v1_, Index v2_, Index v3_ ) : v1( v1_ ), v2( v2_ ), v3( v3_ ) { }
+
+    /**
+     * Conversion from a face with another index type, the indices must fit in Index
+     * @param[in] f the face to convert
+     */
+    template<typename Other>
+    constexpr explicit basicFace( const basicFace<Other>& f )
+        : v1( static_cast<Index>( f.v1 ) ), v2( static_cast<Index>( f.v2 ) ), v3( static_cast<Index>( f.v3 ) ) { }
 
     /**
      * Return true if the edge e is contained in the triplet of indices. If it is
@@ -465,43 +513,85 @@ struct face
      * vertex wrt the edge in the triangle
      * @return true if the edge is contained (the order of the indices does not matter)
      */
-    bool containsEdge( const edge &e, idxtype &oppositeVertex ) const;
+    constexpr bool containsEdge( const edge &e, idxtype &oppositeVertex ) const
+    {
+        const auto same = []( const edge &a, const edge &b ) {
+            return ( ( a.first == b.first ) && ( a.second == b.second ) ) ||
+                   ( ( a.first == b.second ) && ( a.second == b.first ) );
+        };
+        if( same( edge( v1, v2 ), e ) )
+        {
+            oppositeVertex = v3;
+            return true;
+        }
+        if( same( edge( v2, v3 ), e ) )
+        {
+            oppositeVertex = v1;
+            return true;
+        }
+        if( same( edge( v3, v1 ), e ) )
+        {
+            oppositeVertex = v2;
+            return true;
+        }
+        return false;
+    }
 
-    face operator +( const face& a ) const;
-    face& operator +=( const face& a );
+    constexpr basicFace operator +( const basicFace& a ) const { return make( v1 + a.v1, v2 + a.v2, v3 + a.v3 ); }
+    constexpr basicFace& operator +=( const basicFace& a ) { return ( *this = *this + a ); }
 
-    face operator +( const idxtype &a ) const;
-    face& operator +=( const idxtype &a );
+    constexpr basicFace operator +( const Index &a ) const { return make( v1 + a, v2 + a, v3 + a ); }
+    constexpr basicFace& operator +=( const Index &a ) { return ( *this = *this + a ); }
 
-    face operator -( const face& a ) const;
-    face& operator -=( const face& a );
+    constexpr basicFace operator -( const basicFace& a ) const { return make( v1 - a.v1, v2 - a.v2, v3 - a.v3 ); }
+    constexpr basicFace& operator -=( const basicFace& a ) { return ( *this = *this - a ); }
 
-    face operator -( const idxtype &a ) const;
-    face& operator -=( const idxtype &a );
+    constexpr basicFace operator -( const Index &a ) const { return make( v1 - a, v2 - a, v3 - a ); }
+    constexpr basicFace& operator -=( const Index &a ) { return ( *this = *this - a ); }
 
-    face operator *( const face& a ) const;
-    face& operator *=( const face& a );
+    constexpr basicFace operator *( const basicFace& a ) const { return make( v1 * a.v1, v2 * a.v2, v3 * a.v3 ); }
+    constexpr basicFace& operator *=( const basicFace& a ) { return ( *this = *this * a ); }
 
-    face operator *( const idxtype &a ) const;
-    face& operator *=( const idxtype &a );
+    constexpr basicFace operator *( const Index &a ) const { return make( v1 * a, v2 * a, v3 * a ); }
+    constexpr basicFace& operator *=( const Index &a ) { return ( *this = *this * a ); }
 
     /**
      * Two index triplets are equal if their corresponding elements are equal
      */
-    bool operator==( const face& rhs ) const;
+    constexpr bool operator==( const basicFace& rhs ) const
+    {
+        return ( ( v1 == rhs.v1 ) && ( v2 == rhs.v2 ) && ( v3 == rhs.v3 ) );
+    }
     /**
      * Two index triplets are different if... they are not equal
      */
-    bool operator!=( const face& rhs ) const;
+    constexpr bool operator!=( const basicFace& rhs ) const { return ( !( *this == rhs ) ); }
+
+private:
+    /**
+     * Build a face from the result of an arithmetic operation, the 16-bit indices are promoted to int
+     */
+    template<typename T>
+    static constexpr basicFace make( T a, T b, T c )
+    {
+        return { static_cast<Index>( a ), static_cast<Index>( b ), static_cast<Index>( c ) };
+    }
 };
 
+/**
+ * Some definitions
+ */
+using face = basicFace<idxtype>;
+using face16 = basicFace<idx16type>;
+
 /**
  * Print the face values on a string
  * @param os the string to fill with the values
  * @param p the face to print
  * @return the string filled with the values
  */
-inline std::ostream& operator<<( std::ostream& os, const face& p )
+template<typename Index>
+std::ostream& operator<<( std::ostream& os, const basicFace<Index>& p )
 {
     return os << "[" << p.v1 << "," << p.v2 << "," << p.v3 << "]";
 }
@@ -512,7 +602,8 @@ inline std::ostream& operator<<( std::ostream& os, const face& p )
  * @param[in] p the vector of faces to print
  * @return the string filled with the faces
  */
-inline std::ostream& operator<<( std::ostream& os, const std::vector<face>& p )
+template<typename Index>
+std::ostream& operator<<( std::ostream& os, const std::vector<basicFace<Index>>& p )
 {
     os << std::endl;
     for (auto v : p)
@@ -520,6 +611,157 @@ inline std::ostream& operator<<( std::ostream& os, const std::vector<face>& p )
     return os;
 }
 
+/**
+ * The faces of a mesh stored with the narrowest index type that can address all its vertices:
+ * 16 bits up to 65536 vertices, halving the memory and the bandwidth of the indices, 32 bits above.
+ * The faces are accessed with visit, which calls a generic function with the vector of the
+ * actual type.
+ */
+class FaceList
+{
+public:
+    /// the maximum number of vertices addressed by the 16-bit indices
+    static constexpr std::size_t MAX_VERTICES_16{std::size_t{std::numeric_limits<idx16type>::max( )} + 1};
+
+    FaceList( ) = default;
+
+    /**
+     * Store the faces with the narrowest index type
+     * @param[in] faces the faces
+     * @param[in] numVertices the number of vertices addressed by the faces
+     */
+    FaceList( const std::vector<face> &faces, std::size_t numVertices ) { assign( faces, numVertices ); }
+
+    /**
+     * Return true if the 16-bit indices can address the given number of vertices
+     * @param[in] numVertices the number of vertices
+     * @return true if 16 bits are enough
+     */
+    static constexpr bool fits16( std::size_t numVertices ) { return numVertices <= MAX_VERTICES_16; }
+
+    /**
+     * Store the faces with the narrowest index type
+     * @param[in] faces the faces
+     * @param[in] numVertices the number of vertices addressed by the faces
+     */
+    void assign( const std::vector<face> &faces, std::size_t numVertices )
+    {
+        if( fits16( numVertices ) )
+        {
+            std::vector<face16> narrow;
+            narrow.reserve( faces.size( ) );
+            for( const auto &f : faces )
+            {
+                narrow.emplace_back( f );
+            }
+            _faces = std::move( narrow );
+        }
+        else
+        {
+            _faces = faces;
+        }
+    }
+
+    /**
+     * Append faces, eg while the mesh is loaded. The 16-bit indices are promoted to 32 bits when the
+     * number of vertices no longer fits.
+     * @param[in] faces the faces to append
+     * @param[in] numVertices the number of vertices addressed by all the faces
+     */
+    void append( const std::vector<face> &faces, std::size_t numVertices )
+    {
+        if( is16( ) && !fits16( numVertices ) )
+        {
+            const auto &narrow = std::get<std::vector<face16>>( _faces );
+            std::vector<face> wide;
+            wide.reserve( narrow.size( ) + faces.size( ) );
+            for( const auto &f : narrow )
+            {
+                wide.emplace_back( f.v1, f.v2, f.v3 );
+            }
+            _faces = std::move( wide );
+        }
+        std::visit( [&faces]( auto &current ) {
+            current.reserve( current.size( ) + faces.size( ) );
+            for( const auto &f : faces )
+            {
+                current.emplace_back( f );
+            }
+        }, _faces );
+    }
+
+    /**
+     * Store faces already using the proper index type
+     * @param[in] faces the faces
+     */
+    template<typename Index>
+    void assign( std::vector<basicFace<Index>> &&faces ) { _faces = std::move( faces ); }
+
+    /**
+     * Return the vector of faces of the given index type, eg to fill it in place. If the list
+     * already holds this type its vector is returned with its storage, otherwise it is emptied.
+     * @tparam Index the index type
+     * @return the vector of faces
+     */
+    template<typename Index>
+    std::vector<basicFace<Index>> &emplace( )
+    {
+        using Faces = std::vector<basicFace<Index>>;
+        if( !std::holds_alternative<Faces>( _faces ) )
+        {
+            _faces.template emplace<Faces>( );
+        }
+        return std::get<Faces>( _faces );
+    }
+
+    /**
+     * Call f with the vector of faces (std::vector<face16> or std::vector<face>)
+     * @param[in] f a generic function
+     * @return the value returned by f
+     */
+    template<typename F>
+    decltype( auto ) visit( F &&f ) const { return std::visit( std::forward<F>( f ), _faces ); }
+
+    /// true if the indices are 16 bits
+    [[nodiscard]] bool is16( ) const { return std::holds_alternative<std::vector<face16>>( _faces ); }
+    /// the number of faces
+    [[nodiscard]] std::size_t size( ) const { return visit( []( const auto &faces ) { return faces.size( ); } ); }
+    [[nodiscard]] bool empty( ) const { return size( ) == 0; }
+    /// the size of the indices in bytes
+    [[nodiscard]] std::size_t bytes( ) const
+    {
+        return visit( []( const auto &faces ) { return faces.size( ) * sizeof( faces.front( ) ); } );
+    }
+
+private:
+    std::variant<std::vector<face16>, std::vector<face>> _faces;
+};
+
+/**
+ * A level of a mesh: its vertices, faces and vertex normals. It is move-only, so that the whole
+ * arrays are never copied by accident: a subdivision step writes into the buffers of another
+ * level, then the levels are swapped.
+ */
+struct MeshLevel
+{
+    /// the vertices
+    std::vector<point3d> vertices{};
+    /// the faces, in 16 bits when possible
+    FaceList faces{};
+    /// the normal of each vertex
+    std::vector<vec3d> normals{};
+
+    MeshLevel( ) = default;
+    MeshLevel( MeshLevel && ) noexcept = default;
+    MeshLevel &operator=( MeshLevel && ) noexcept = default;
+    MeshLevel( const MeshLevel & ) = delete;
+    MeshLevel &operator=( const MeshLevel & ) = delete;
+    ~MeshLevel( ) = default;
+
+    /// true if the level has no face
+    [[nodiscard]] bool empty( ) const { return faces.empty( ); }
+};
+
 /**
  * It checks if the edge e is a boundary edge in the list of triangle. It also 
  * return the indices of the two opposite vertices of the edge or only one of 
@@ -531,5 +773,5 @@ inline std::ostream& operator<<( std::ostream& os, const std::vector<face>& p )
  * @param[out] oppVert2 the index of the second opposite vertices (only if the edge is not a boundary edge)
  * @return true if the edge is not a boundary edge
  */
-bool isBoundaryEdge( const edge &e, const std::vector<face> &triangleList, idxtype &oppVert1, idxtype &oppVert2 );
-
+template<typename Index>
+bool isBoundaryEdge( const edge &e, const std::vector<basicFace<Index>> &triangleList, idxtype &oppVert1, idxtype &oppVert2 );
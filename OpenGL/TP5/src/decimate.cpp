@@ -0,0 +1,107 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "decimate.hpp"
+#include "repair.hpp"
+#include "weld.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+/// the largest number of cells along a side, so that the 3 coordinates of a cell fit in a 64-bit key
+constexpr std::uint64_t MAX_GRID_SIZE{1U << 21U};
+
+/**
+ * Return the coordinate of the cell of a value along one axis
+ * @param[in] value the coordinate of the vertex
+ * @param[in] origin the minimum of the bounding box along the axis
+ * @param[in] scale the number of cells per unit
+ * @param[in] gridSize the number of cells along the longest side
+ * @return the coordinate of the cell, in [0, gridSize)
+ */
+std::uint64_t cellCoordinate(float value, float origin, float scale, std::uint64_t gridSize)
+{
+    const auto cell = static_cast<std::uint64_t>(std::max(0.f, (value - origin) * scale));
+    // the maximum of the bounding box is in the last cell
+    return std::min(cell, gridSize - 1);
+}
+
+} // namespace
+
+DecimateReport decimateMesh(std::vector<point3d>& vertices, std::vector<face>& mesh, unsigned gridSize,
+                            unsigned numThreads)
+{
+    const auto start = std::chrono::steady_clock::now();
+    DecimateReport report;
+    report.verticesBefore = vertices.size();
+    report.facesBefore = mesh.size();
+    if(vertices.empty())
+    {
+        return report;
+    }
+
+    point3d lower{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    point3d upper{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                  std::numeric_limits<float>::lowest()};
+    for(const auto& v : vertices)
+    {
+        lower = point3d{std::min(lower.x, v.x), std::min(lower.y, v.y), std::min(lower.z, v.z)};
+        upper = point3d{std::max(upper.x, v.x), std::max(upper.y, v.y), std::max(upper.z, v.z)};
+    }
+    const std::uint64_t cells = std::clamp<std::uint64_t>(gridSize, 1, MAX_GRID_SIZE);
+    const float side = std::max({upper.x - lower.x, upper.y - lower.y, upper.z - lower.z});
+    const float scale = (side > 0.f) ? static_cast<float>(cells) / side : 0.f;
+
+    // the clusters are numbered in the order of their first vertex, so the result keeps the order of the input
+    std::unordered_map<std::uint64_t, idxtype> clusters;
+    clusters.reserve(std::min<std::size_t>(vertices.size(), cells * cells * cells));
+    std::vector<idxtype> remap(vertices.size());
+    std::vector<point3d> sums;
+    std::vector<std::uint32_t> counts;
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        const point3d& v = vertices[i];
+        const std::uint64_t key = cellCoordinate(v.x, lower.x, scale, cells)
+                                  + cells * (cellCoordinate(v.y, lower.y, scale, cells) + cells * cellCoordinate(v.z, lower.z, scale, cells));
+        const auto inserted = clusters.emplace(key, static_cast<idxtype>(sums.size()));
+        if(inserted.second)
+        {
+            sums.push_back(v);
+            counts.push_back(1);
+        }
+        else
+        {
+            sums[inserted.first->second] += v;
+            ++counts[inserted.first->second];
+        }
+        remap[i] = inserted.first->second;
+    }
+    for(std::size_t c = 0; c < sums.size(); ++c)
+    {
+        sums[c] = sums[c] / static_cast<float>(counts[c]);
+    }
+    vertices.swap(sums);
+    remapFaces(remap, mesh);
+    // the faces that became flat or duplicated, and the vertices of the removed faces
+    repairMesh(vertices, mesh, 0.f, numThreads);
+
+    report.verticesAfter = vertices.size();
+    report.facesAfter = mesh.size();
+    report.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& os, const DecimateReport& r)
+{
+    return os << r.verticesBefore << " -> " << r.verticesAfter << " vertices, " << r.facesBefore << " -> "
+              << r.facesAfter << " faces in " << r.ms << " ms";
+}
@@ -0,0 +1,53 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * What the decimation changed in the mesh
+ */
+struct DecimateReport
+{
+    /// the number of vertices before the decimation
+    std::size_t verticesBefore{0};
+    /// the number of vertices after the decimation
+    std::size_t verticesAfter{0};
+    /// the number of faces before the decimation
+    std::size_t facesBefore{0};
+    /// the number of faces after the decimation
+    std::size_t facesAfter{0};
+    /// the duration of the decimation in milliseconds
+    double ms{0};
+};
+
+/**
+ * Decimate a mesh by vertex clustering: the bounding box is divided into a grid of cubic cells, the
+ * vertices of each cell are merged into one vertex at their mean position, then the faces that
+ * collapse, the faces of null area, the duplicated faces and the unreferenced vertices are removed
+ * as by repairMesh. It runs in O(vertices + faces), the finer the grid the closer to the input; the
+ * topology of the details smaller than a cell is not preserved.
+ * @param[in,out] vertices the vertices
+ * @param[in,out] mesh the faces
+ * @param[in] gridSize the number of cells along the longest side of the bounding box
+ * @param[in] numThreads the number of threads of the cleanup, 0 to use all the cores
+ * @return what has been changed
+ */
+DecimateReport decimateMesh(std::vector<point3d>& vertices, std::vector<face>& mesh, unsigned gridSize,
+                            unsigned numThreads = 0);
+
+/**
+ * Print the report on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] r the report
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const DecimateReport& r);
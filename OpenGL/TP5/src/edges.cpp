@@ -0,0 +1,170 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "edges.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+/// under this number of corners the sort runs on the calling thread only
+constexpr std::size_t MIN_PARALLEL_CORNERS{1U << 15U};
+/// the number of bits sorted by each pass
+constexpr unsigned DIGIT_BITS{8};
+constexpr std::size_t RADIX{1U << DIGIT_BITS};
+
+/// the number of bits needed to write a value
+unsigned bitWidth(std::uint64_t value)
+{
+    unsigned bits{0};
+    for(; value != 0; value >>= 1U)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+/// the vertex of a corner of a face, 0 to 2
+template<typename Index>
+idxtype cornerVertex(const basicFace<Index>& f, unsigned corner)
+{
+    return (corner == 0) ? f.v1 : ((corner == 1) ? f.v2 : f.v3);
+}
+
+/**
+ * Sort the keys and their values on the bits [0, bits) of the keys with a parallel LSD radix sort.
+ * It is stable, so the values with the same key stay in their order, and the result does not
+ * depend on the number of threads. The passes where all the keys have the same digit are skipped.
+ * @param[in,out] keys the keys
+ * @param[in,out] values the value of each key
+ * @param[in] bits the number of bits of the keys
+ * @param[in] threads the number of threads
+ */
+void radixSortPairs(std::pmr::vector<std::uint64_t>& keys, std::pmr::vector<std::uint32_t>& values, unsigned bits, unsigned threads)
+{
+    std::pmr::vector<std::uint64_t> tmpKeys(keys.size(), keys.get_allocator());
+    std::pmr::vector<std::uint32_t> tmpValues(values.size(), values.get_allocator());
+    std::vector<std::size_t> histograms(threads * RADIX);
+    for(unsigned shift = 0; shift < bits; shift += DIGIT_BITS)
+    {
+        const auto digit = [shift](std::uint64_t key) { return static_cast<std::size_t>((key >> shift) & (RADIX - 1)); };
+        parallelChunks(keys.size(), threads, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t* h = &histograms[chunk * RADIX];
+            std::fill(h, h + RADIX, 0);
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                ++h[digit(keys[i])];
+            }
+        });
+        // the offsets: by digit, then by chunk to keep the order of the chunks
+        std::size_t sum{0};
+        bool sorted{false};
+        for(std::size_t d = 0; d < RADIX; ++d)
+        {
+            const std::size_t before = sum;
+            for(unsigned chunk = 0; chunk < threads; ++chunk)
+            {
+                const std::size_t count = histograms[chunk * RADIX + d];
+                histograms[chunk * RADIX + d] = sum;
+                sum += count;
+            }
+            sorted = sorted || (sum - before == keys.size());
+        }
+        if(sorted)
+        {
+            continue;
+        }
+        parallelChunks(keys.size(), threads, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t* offset = &histograms[chunk * RADIX];
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                const std::size_t to = offset[digit(keys[i])]++;
+                tmpKeys[to] = keys[i];
+                tmpValues[to] = values[i];
+            }
+        });
+        keys.swap(tmpKeys);
+        values.swap(tmpValues);
+    }
+}
+
+} // namespace
+
+template<typename Index>
+void extractEdges(const std::vector<basicFace<Index>>& mesh, std::size_t numVertices, EdgeTable& table, unsigned numThreads)
+{
+    PROFILE_SCOPE("extractEdges");
+    const std::size_t numCorners = 3 * mesh.size();
+    assert(numCorners <= std::uint64_t{1} << 32U);
+    const unsigned threads = (numCorners < MIN_PARALLEL_CORNERS) ? 1U : resolveThreads(numThreads);
+    std::pmr::memory_resource* resource = table.edges.get_allocator().resource();
+
+    // the key of an edge is the pair of its vertices, the lowest first
+    std::pmr::vector<std::uint64_t> keys(numCorners, resource);
+    std::pmr::vector<std::uint32_t> corners(numCorners, resource);
+    parallelChunks(mesh.size(), threads, [&](unsigned, std::size_t begin, std::size_t end) {
+        for(std::size_t f = begin; f < end; ++f)
+        {
+            for(unsigned k = 0; k < 3; ++k)
+            {
+                const idxtype a = cornerVertex(mesh[f], k);
+                const idxtype b = cornerVertex(mesh[f], (k + 1) % 3);
+                keys[3 * f + k] = std::uint64_t{std::min(a, b)} * numVertices + std::max(a, b);
+                corners[3 * f + k] = static_cast<std::uint32_t>(3 * f + k);
+            }
+        }
+    });
+    const std::uint64_t maxKey = std::uint64_t{numVertices} * numVertices;
+    radixSortPairs(keys, corners, bitWidth(maxKey > 0 ? maxKey - 1 : 0), threads);
+
+    // the runs of equal keys are the edges, their corners are in the order of the faces
+    std::size_t numEdges = (numCorners > 0) ? 1 : 0;
+    for(std::size_t i = 1; i < numCorners; ++i)
+    {
+        if(keys[i] != keys[i - 1])
+        {
+            ++numEdges;
+        }
+    }
+    table.edges.assign(numEdges, MeshEdge{});
+    table.faceEdges.resize(numCorners);
+    std::size_t e{0};
+    for(std::size_t i = 0; i < numCorners; ++i)
+    {
+        if(i > 0 && keys[i] != keys[i - 1])
+        {
+            ++e;
+        }
+        const std::uint32_t c = corners[i];
+        const auto& f = mesh[c / 3];
+        const unsigned k = c % 3;
+        MeshEdge& current = table.edges[e];
+        if(current.faces == 0)
+        {
+            const idxtype a = cornerVertex(f, k);
+            const idxtype b = cornerVertex(f, (k + 1) % 3);
+            current.first = std::min(a, b);
+            current.second = std::max(a, b);
+        }
+        if(current.faces < 2)
+        {
+            current.opposite[current.faces] = cornerVertex(f, (k + 2) % 3);
+        }
+        ++current.faces;
+        table.faceEdges[c] = static_cast<idxtype>(e);
+    }
+}
+
+void extractEdges(const FaceList& mesh, std::size_t numVertices, EdgeTable& table, unsigned numThreads)
+{
+    mesh.visit([&](const auto& faces) { extractEdges(faces, numVertices, table, numThreads); });
+}
+
+template void extractEdges(const std::vector<face16>&, std::size_t, EdgeTable&, unsigned);
+template void extractEdges(const std::vector<face>&, std::size_t, EdgeTable&, unsigned);
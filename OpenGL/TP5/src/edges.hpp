@@ -0,0 +1,95 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * An edge of a mesh and the faces sharing it
+ */
+struct MeshEdge
+{
+    /// the lowest vertex of the edge
+    idxtype first{0};
+    /// the highest vertex of the edge
+    idxtype second{0};
+    /// the vertex opposite the edge in each of its first two faces, in the order of the faces
+    idxtype opposite[2]{0, 0};
+    /// the number of faces sharing the edge: 1 on the boundary, 2 inside a manifold, more otherwise
+    std::uint32_t faces{0};
+
+    /// true if the edge belongs to a single face
+    [[nodiscard]] bool boundary() const { return faces == 1; }
+};
+
+/**
+ * The unique edges of a mesh, numbered in the order of their vertices (first, then second), and
+ * the edge of each corner of the faces. The arrays come from a memory resource, eg the arena of
+ * the subdivision.
+ */
+struct EdgeTable
+{
+    /**
+     * Create an empty table
+     * @param[in] resource where the arrays are allocated
+     */
+    explicit EdgeTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : edges(resource), faceEdges(resource)
+    {
+    }
+
+    /// the edges, sorted by their vertices
+    std::pmr::vector<MeshEdge> edges;
+    /// the index of the edge of each corner: 3f is the edge v1-v2 of the face f, 3f+1 v2-v3 and 3f+2 v3-v1
+    std::pmr::vector<idxtype> faceEdges;
+
+    /// the number of edges
+    [[nodiscard]] std::size_t size() const { return edges.size(); }
+};
+
+/**
+ * Return the bytes allocated by extractEdges from the memory resource of the table
+ * @param[in] numFaces the number of faces of the mesh
+ * @param[in] numEdges the number of edges of the mesh, at most 3 numFaces
+ * @return the size in bytes, without the alignment of the allocations
+ */
+constexpr std::size_t extractEdgesBytes(std::size_t numFaces, std::size_t numEdges)
+{
+    // the keys and the corners, twice for the radix sort, then the table
+    return 2 * 3 * numFaces * (sizeof(std::uint64_t) + sizeof(std::uint32_t)) + numEdges * sizeof(MeshEdge)
+           + 3 * numFaces * sizeof(idxtype);
+}
+
+/**
+ * Find the edges of a mesh without hashing: each corner of each face emits its edge as a key made
+ * of the indices of its vertices, the keys are sorted with a parallel LSD radix sort, which keeps the
+ * corners of an edge in the order of the faces, and a linear sweep over the sorted keys gives the
+ * unique edges, their opposite vertices and their number of faces. The result does not depend on
+ * the number of threads.
+ *
+ * @param[in] mesh the faces
+ * @param[in] numVertices the number of vertices, all the indices are lower
+ * @param[out] table the edges and the edge of each corner
+ * @param[in] numThreads the number of threads of the sort, 0 to use all the cores
+ */
+template<typename Index>
+void extractEdges(const std::vector<basicFace<Index>>& mesh, std::size_t numVertices, EdgeTable& table, unsigned numThreads = 0);
+
+/**
+ * Find the edges of a mesh stored with the narrowest index type, see extractEdges
+ *
+ * @param[in] mesh the faces
+ * @param[in] numVertices the number of vertices, all the indices are lower
+ * @param[out] table the edges and the edge of each corner
+ * @param[in] numThreads the number of threads of the sort, 0 to use all the cores
+ */
+void extractEdges(const FaceList& mesh, std::size_t numVertices, EdgeTable& table, unsigned numThreads = 0);
@@ -6,8 +6,88 @@
 
 
 #include "geometry.hpp"
+#include "logger.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include <algorithm>
 #include <cmath>
 
+namespace {
+
+/// under this number of faces the normals are summed on the calling thread, by scattering
+constexpr std::size_t MIN_GATHER_FACES{1U << 14U};
+/// the number of faces whose angles are approximated at once by scatterVertexNormals
+constexpr std::size_t ANGLE_BLOCK{256};
+
+/**
+ * Add the weighted normal of each face to the normals of its three vertices, face by face
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the faces to add
+ * @param[in,out] normals the normal of each vertex, not normalized
+ * @param[in] weighting how the angles of the faces are computed
+ */
+template<typename Index>
+void scatterVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, std::vector<vec3d>& normals,
+                           AngleWeighting weighting )
+{
+    if( weighting == AngleWeighting::Exact )
+    {
+        for( const auto& t : faces )
+        {
+            const vec3d normal = computeNormal( vertices[t.v1], vertices[t.v2], vertices[t.v3] );
+            normals[t.v1] += normal * angleAtVertex( vertices[t.v1], vertices[t.v2], vertices[t.v3] );
+            normals[t.v2] += normal * angleAtVertex( vertices[t.v2], vertices[t.v1], vertices[t.v3] );
+            normals[t.v3] += normal * angleAtVertex( vertices[t.v3], vertices[t.v2], vertices[t.v1] );
+        }
+        return;
+    }
+
+    // the approximated angles of a block of faces are computed at once by the SIMD kernels
+    float angles[3 * ANGLE_BLOCK];
+    for( std::size_t first = 0; first < faces.size( ); first += ANGLE_BLOCK )
+    {
+        const std::size_t count = std::min( ANGLE_BLOCK, faces.size( ) - first );
+        cornerAngles( vertices, Span<const basicFace<Index>>( faces.data( ) + first, count ), angles, weighting );
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            const auto& t = faces[first + i];
+            const vec3d normal = computeNormal( vertices[t.v1], vertices[t.v2], vertices[t.v3] );
+            normals[t.v1] += normal * angles[3 * i];
+            normals[t.v2] += normal * angles[3 * i + 1];
+            normals[t.v3] += normal * angles[3 * i + 2];
+        }
+    }
+}
+
+/**
+ * Add the weighted normals of some faces to the normals of their vertices, by gathering or by scattering
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the faces to add
+ * @param[in,out] normals the normal of each vertex, not normalized
+ * @param[in] weighting how the angles of the faces are computed
+ * @param[in] resource where the temporary data is allocated
+ */
+template<typename Index>
+void addVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, std::vector<vec3d>& normals,
+                       AngleWeighting weighting, std::pmr::memory_resource* resource )
+{
+    // the index covers all the vertices, not worth it for a small batch of a large mesh, and on a
+    // single core gathering only adds the index and a pass over the corners. The choice is not tuned:
+    // the gather is 1.5 times slower on one core and its speedup on several cores is not measured yet
+    if( faces.size( ) < MIN_GATHER_FACES || 3 * faces.size( ) < vertices.size( ) || resolveThreads( 0 ) == 1 )
+    {
+        scatterVertexNormals( vertices, faces, normals, weighting );
+        return;
+    }
+    VertexCorners adjacency( resource );
+    buildVertexCorners( faces, vertices.size( ), adjacency );
+    gatherVertexNormals( vertices, faces, adjacency, normals, 0, weighting );
+}
+
+} // namespace
+
 /**
  * Calculate the normal of a triangular face defined by three points
  *
@@ -55,11 +135,75 @@ float angleAtVertex( const point3d& baseV, const point3d& v2, const point3d& v3
     //safe acos...
     if ( std::fabs( e1.dot( e2 ) / (e1.norm( ) * e2.norm( )) ) >= 1.f )
     {
-        std::cerr << "warning: using safe acos" << std::endl;
+        // called for each corner of the mesh: do not flood the log
+        LOG_RATE_LIMITED( Warning, Geometry, 1, "using safe acos" );
         return (std::acos( 1.f ));
     }
     else
     {
         return ( std::acos( e1.dot( e2 ) / (e1.norm( ) * e2.norm( )) ));
     }
-}
\ No newline at end of file
+}
+
+void computeVertexNormals( const std::vector<point3d>& vertices, const std::vector<face>& mesh, std::vector<vec3d>& normals,
+                           AngleWeighting weighting )
+{
+    computeVertexNormals( vertices, Span( mesh ), normals, weighting );
+}
+
+template<typename Index>
+void computeVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> mesh, std::vector<vec3d>& normals,
+                           AngleWeighting weighting, std::pmr::memory_resource* resource )
+{
+    normals.assign( vertices.size( ), vec3d{0, 0, 0} );
+    addVertexNormals( vertices, mesh, normals, weighting, resource );
+}
+
+template void computeVertexNormals( const std::vector<point3d>&, Span<const face16>, std::vector<vec3d>&, AngleWeighting,
+                                    std::pmr::memory_resource* );
+template void computeVertexNormals( const std::vector<point3d>&, Span<const face>, std::vector<vec3d>&, AngleWeighting,
+                                    std::pmr::memory_resource* );
+
+void accumulateVertexNormals( const std::vector<point3d>& vertices, Span<const face> faces, std::vector<vec3d>& normals,
+                              AngleWeighting weighting )
+{
+    addVertexNormals( vertices, faces, normals, weighting, std::pmr::get_default_resource( ) );
+}
+
+template<typename Index>
+void gatherVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, const VertexCorners& adjacency,
+                          std::vector<vec3d>& normals, unsigned numThreads, AngleWeighting weighting )
+{
+    PROFILE_SCOPE( "gatherVertexNormals" );
+    const unsigned threads = ( faces.size( ) < MIN_GATHER_FACES ) ? 1U : resolveThreads( numThreads );
+
+    // each vertex only writes its own normal, the corners are summed in the order of the faces with
+    // the same products as scatterVertexNormals: the normal of a face is computed for each of its
+    // corners, which costs less than storing the weighted normals of all the corners
+    parallelChunks( adjacency.vertices( ), threads, [&]( unsigned, std::size_t begin, std::size_t end ) {
+        for( std::size_t v = begin; v < end; ++v )
+        {
+            vec3d sum = normals[v];
+            for( const idxtype c : adjacency.of( v ) )
+            {
+                const auto& t = faces[c / 3];
+                const point3d& v1 = vertices[t.v1];
+                const point3d& v2 = vertices[t.v2];
+                const point3d& v3 = vertices[t.v3];
+                const vec3d normal = computeNormal( v1, v2, v3 );
+                switch( c % 3 )
+                {
+                    case 0: sum += normal * angleAtVertex( v1, v2, v3, weighting ); break;
+                    case 1: sum += normal * angleAtVertex( v2, v1, v3, weighting ); break;
+                    default: sum += normal * angleAtVertex( v3, v2, v1, weighting ); break;
+                }
+            }
+            normals[v] = sum;
+        }
+    } );
+}
+
+template void gatherVertexNormals( const std::vector<point3d>&, Span<const face16>, const VertexCorners&, std::vector<vec3d>&, unsigned,
+                                   AngleWeighting );
+template void gatherVertexNormals( const std::vector<point3d>&, Span<const face>, const VertexCorners&, std::vector<vec3d>&, unsigned,
+                                   AngleWeighting );
@@ -6,7 +6,14 @@
 
 #pragma once
 
+#include "adjacency.hpp"
+#include "angles.hpp"
 #include "core.hpp"
+#include "span.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
 
 /**
  * Calculate the normal of a triangular face defined by three points
@@ -29,4 +36,64 @@ vec3d computeNormal( const point3d& v1, const point3d& v2, const point3d& v3);
  * @param[in] v2 the other vertex of the second edge baseV-v2
  * @return the angle in radiants
  */
-[[nodiscard]] float angleAtVertex(const point3d& baseV, const point3d& v2, const point3d& v3);
\ No newline at end of file
+[[nodiscard]] float angleAtVertex(const point3d& baseV, const point3d& v2, const point3d& v3);
+
+/**
+ * Compute the normal of each vertex as the sum of the normals of the faces sharing it, weighted
+ * by the angle of the face at the vertex (the same normals as the ones computed by load)
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] mesh the list of faces
+ * @param[out] normals the normal of each vertex, not normalized
+ * @param[in] weighting how the angles of the faces are computed
+ */
+void computeVertexNormals( const std::vector<point3d>& vertices, const std::vector<face>& mesh, std::vector<vec3d>& normals,
+                           AngleWeighting weighting = AngleWeighting::Exact );
+
+/**
+ * Compute the normal of each vertex as in computeVertexNormals, for the faces of any index type. The
+ * vertices gather the normals of their faces (see gatherVertexNormals) when the mesh is large and
+ * several cores are available, the faces are scattered into their vertices otherwise, with the same
+ * sums.
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] mesh the list of faces
+ * @param[out] normals the normal of each vertex, not normalized
+ * @param[in] weighting how the angles of the faces are computed
+ * @param[in] resource where the temporary data is allocated
+ */
+template<typename Index>
+void computeVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> mesh, std::vector<vec3d>& normals,
+                           AngleWeighting weighting = AngleWeighting::Exact,
+                           std::pmr::memory_resource* resource = std::pmr::get_default_resource( ) );
+
+/**
+ * Add the angle-weighted normals of some faces to the normals of their vertices, eg for the faces
+ * appended to a mesh being loaded. Accumulating the faces batch by batch gives the same normals as
+ * computeVertexNormals. The large batches are gathered as in computeVertexNormals.
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the faces to add
+ * @param[in,out] normals the normal of each vertex, not normalized
+ * @param[in] weighting how the angles of the faces are computed
+ */
+void accumulateVertexNormals( const std::vector<point3d>& vertices, Span<const face> faces, std::vector<vec3d>& normals,
+                              AngleWeighting weighting = AngleWeighting::Exact );
+
+/**
+ * Add the angle-weighted normals of some faces to the normals of their vertices without scattering:
+ * each vertex sums the weighted normals of its corners in the order of the faces. The vertices are
+ * summed in parallel without write conflicts, and the sums are the same as the ones of
+ * accumulateVertexNormals whatever the number of threads.
+ *
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the faces to add
+ * @param[in] adjacency the corners of each vertex in faces, see buildVertexCorners
+ * @param[in,out] normals the normal of each vertex, not normalized
+ * @param[in] numThreads the number of threads, 0 to use all the cores
+ * @param[in] weighting how the angles of the faces are computed
+ */
+template<typename Index>
+void gatherVertexNormals( const std::vector<point3d>& vertices, Span<const basicFace<Index>> faces, const VertexCorners& adjacency,
+                          std::vector<vec3d>& normals, unsigned numThreads = 0, AngleWeighting weighting = AngleWeighting::Exact );
+
@@ -0,0 +1,171 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "hotReload.hpp"
+#include "logger.hpp"
+#include "threadPool.hpp"
+
+#include <cstring>
+#include <exception>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__)
+#define FILE_WATCHER_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * Return the modification time of a file
+ * @param[in] file the file
+ * @return the modification time, the minimum if the file does not exist
+ */
+std::filesystem::file_time_type lastWriteTime(const std::filesystem::path& file)
+{
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(file, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
+
+} // namespace
+
+FileWatcher::FileWatcher(const std::string& filename) : _file(filename), _lastWrite(lastWriteTime(_file))
+{
+#ifdef FILE_WATCHER_INOTIFY
+    _fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(_fd < 0)
+    {
+        LOG_WARNING(Loader, "inotify not available, the modification time of " << filename << " is polled");
+        return;
+    }
+    // IN_MODIFY would report the file while it is written, the end of the writing is IN_CLOSE_WRITE
+    // and a file written elsewhere then renamed is IN_MOVED_TO
+    const std::filesystem::path directory = _file.has_parent_path() ? _file.parent_path() : std::filesystem::path(".");
+    if(::inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        LOG_WARNING(Loader, "Unable to watch " << directory << ", the modification time of " << filename << " is polled");
+        ::close(_fd);
+        _fd = -1;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef FILE_WATCHER_INOTIFY
+    if(_fd >= 0)
+    {
+        ::close(_fd);
+    }
+#endif
+}
+
+bool FileWatcher::changed()
+{
+#ifdef FILE_WATCHER_INOTIFY
+    if(_fd >= 0)
+    {
+        // the events of the other files of the directory are skipped
+        const std::string name = _file.filename().string();
+        bool found{false};
+        alignas(inotify_event) char buffer[4096];
+        for(ssize_t length = ::read(_fd, buffer, sizeof(buffer)); length > 0; length = ::read(_fd, buffer, sizeof(buffer)))
+        {
+            for(ssize_t offset = 0; offset < length;)
+            {
+                inotify_event event{};
+                std::memcpy(&event, buffer + offset, sizeof(event));
+                if(event.len > 0 && name == buffer + offset + sizeof(event))
+                {
+                    found = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(event) + event.len);
+            }
+        }
+        return found;
+    }
+#endif
+    const auto time = lastWriteTime(_file);
+    if(time == _lastWrite)
+    {
+        return false;
+    }
+    _lastWrite = time;
+    return true;
+}
+
+HotReloader::HotReloader(const std::string& filename, float weldEpsilon, PrepareFunction prepare)
+    : _filename(filename), _weldEpsilon(weldEpsilon), _prepare(std::move(prepare)), _watcher(filename)
+{
+}
+
+HotReloader::~HotReloader()
+{
+    if(_reading.valid())
+    {
+        _reading.wait();
+    }
+}
+
+HotReloader::Result HotReloader::poll(MeshModel& model)
+{
+    if(_watcher.changed())
+    {
+        _changedAgain = true;
+    }
+
+    Result result{Result::None};
+    if(_reading.valid() && _reading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        std::optional<MeshBatch> batch = _reading.get();
+        if(!batch)
+        {
+            LOG_ERROR(Loader, "error while reloading the model " << _filename << ", the previous version is kept");
+            result = Result::Failed;
+        }
+        else
+        {
+            result = model.update(std::move(*batch)) ? Result::Positions : Result::Topology;
+            _lastReloadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+            LOG_INFO(Loader, "Model reloaded in " << _lastReloadMs << " ms, "
+                                                  << ((result == Result::Positions) ? "same faces: positions and normals updated"
+                                                                                    : "the faces changed: model replaced"));
+        }
+    }
+
+    if(_changedAgain && !_reading.valid())
+    {
+        // a change during the reading is read once the previous version is applied
+        _changedAgain = false;
+        _start = std::chrono::steady_clock::now();
+        _reading = ThreadPool::shared().submit(
+          [filename = _filename, weldEpsilon = _weldEpsilon, prepare = _prepare]() -> std::optional<MeshBatch> {
+              MeshBatch batch;
+              try
+              {
+                  if(!MeshModel::read(filename, weldEpsilon, batch.vertices, batch.faces, batch.normals))
+                  {
+                      return std::nullopt;
+                  }
+              }
+              catch(const std::exception& e)
+              {
+                  // eg the file is being written again and a line is cut
+                  LOG_ERROR(Loader, filename << ": " << e.what());
+                  return std::nullopt;
+              }
+              if(prepare)
+              {
+                  prepare(batch);
+              }
+              return batch;
+          });
+    }
+    return result;
+}
@@ -0,0 +1,128 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "MeshModel.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <optional>
+#include <string>
+
+/**
+ * Tell when a file has been written. On Linux the directory of the file is watched with inotify,
+ * so that the files replaced by a rename, as many editors and exporters do, are seen too; elsewhere
+ * the modification time of the file is compared at each call.
+ */
+class FileWatcher
+{
+public:
+    /**
+     * Start watching a file, it does not need to exist yet
+     * @param[in] filename the file
+     */
+    explicit FileWatcher(const std::string& filename);
+
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Return true if the file has been written or replaced since the previous call, without blocking
+     * @return true if the file changed
+     */
+    bool changed();
+
+    /// true if the changes are notified by the system, false if the modification time is polled
+    [[nodiscard]] bool notified() const { return _fd >= 0; }
+
+private:
+    /// the watched file
+    std::filesystem::path _file{};
+    /// the inotify instance, -1 if not available
+    int _fd{-1};
+    /// the modification time of the file at the previous call, when it is polled
+    std::filesystem::file_time_type _lastWrite{};
+};
+
+/**
+ * Reload a model when its file changes. The file is read again in the background, on the shared
+ * thread pool, then compared with the model: if the faces are the same only the positions and the
+ * normals are updated (see MeshModel::update), which keeps the topology of the subdivision.
+ */
+class HotReloader
+{
+public:
+    /// a function applied to the new version of the model in the background, eg to repair it
+    using PrepareFunction = std::function<void(MeshBatch&)>;
+
+    /// what poll did to the model
+    enum class Result
+    {
+        /// nothing, the file did not change or is being read
+        None,
+        /// the faces are the same, the positions and the normals have been updated
+        Positions,
+        /// the faces changed, the model has been replaced
+        Topology,
+        /// the file could not be read, the model is unchanged
+        Failed
+    };
+
+    /**
+     * Start watching the file of a model
+     * @param[in] filename the file of the model
+     * @param[in] weldEpsilon the distance under which the vertices of the STL triangle soups are merged
+     * @param[in] prepare the function applied to each new version before comparing it, if any
+     */
+    HotReloader(const std::string& filename, float weldEpsilon = 0.f, PrepareFunction prepare = {});
+
+    /**
+     * Wait for the file being read, if any
+     */
+    ~HotReloader();
+
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+
+    /**
+     * Start reading the file if it changed, and update the model once it has been read
+     * @param[in,out] model the model loaded from the file
+     * @return what has been done to the model
+     */
+    Result poll(MeshModel& model);
+
+    /// true while the file is being read
+    [[nodiscard]] bool busy() const { return _reading.valid(); }
+
+    /// the duration of the last reload in milliseconds, from the change until the model is updated
+    [[nodiscard]] double lastReloadMs() const { return _lastReloadMs; }
+
+    /// true if the changes are notified by the system, false if the modification time is polled
+    [[nodiscard]] bool notified() const { return _watcher.notified(); }
+
+private:
+    /// the file of the model
+    std::string _filename{};
+    /// the distance under which the vertices of the STL triangle soups are merged
+    float _weldEpsilon{0.f};
+    /// the function applied to each new version
+    PrepareFunction _prepare{};
+    /// tells when the file changes
+    FileWatcher _watcher;
+    /// true if the file changed while it was being read, it has to be read again
+    bool _changedAgain{false};
+    /// the new version being read, nothing if it could not be read
+    std::future<std::optional<MeshBatch>> _reading{};
+    /// when the change was seen
+    std::chrono::steady_clock::time_point _start{};
+    /// the duration of the last reload in milliseconds
+    double _lastReloadMs{0};
+};
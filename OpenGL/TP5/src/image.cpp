@@ -0,0 +1,157 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "image.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace {
+
+/**
+ * The CRC-32 used by the PNG chunks
+ */
+std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0)
+{
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for(std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for(int k = 0; k < 8; ++k)
+            {
+                c = (c & 1U) ? (0xEDB88320U ^ (c >> 1U)) : (c >> 1U);
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFFU] ^ (crc >> 8U);
+    }
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<std::uint8_t>& buffer, std::uint32_t value)
+{
+    buffer.push_back(static_cast<std::uint8_t>(value >> 24U));
+    buffer.push_back(static_cast<std::uint8_t>(value >> 16U));
+    buffer.push_back(static_cast<std::uint8_t>(value >> 8U));
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+void writeChunk(std::ofstream& out, const char type[4], const std::vector<std::uint8_t>& data)
+{
+    std::vector<std::uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+    appendBigEndian(chunk, static_cast<std::uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // the crc covers the type and the data
+    appendBigEndian(chunk, crc32(chunk.data() + 4, data.size() + 4));
+    out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+bool endsWith(const std::string& str, const std::string& suffix)
+{
+    return str.size() >= suffix.size() && std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
+}
+
+} // namespace
+
+bool writePPM(const std::string& filename, const Image& img)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if(!out.is_open())
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    out << "P6\n" << img.width << " " << img.height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(img.rgb.data()), static_cast<std::streamsize>(img.rgb.size()));
+    return out.good();
+}
+
+bool writePNG(const std::string& filename, const Image& img)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if(!out.is_open())
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+
+    static const std::uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    // header: size, 8 bits per channel, RGB, default compression/filter/interlace
+    std::vector<std::uint8_t> header;
+    appendBigEndian(header, img.width);
+    appendBigEndian(header, img.height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    writeChunk(out, "IHDR", header);
+
+    // the raw stream is each row prefixed by the filter type (0, none)
+    const std::size_t rowSize = static_cast<std::size_t>(img.width) * 3;
+    std::vector<std::uint8_t> raw;
+    raw.reserve((rowSize + 1) * img.height);
+    for(std::size_t y = 0; y < img.height; ++y)
+    {
+        raw.push_back(0);
+        const auto row = img.rgb.begin() + static_cast<std::ptrdiff_t>(y * rowSize);
+        raw.insert(raw.end(), row, row + static_cast<std::ptrdiff_t>(rowSize));
+    }
+
+    // zlib stream made of stored blocks of at most 65535 bytes
+    constexpr std::size_t maxBlock{65535};
+    std::vector<std::uint8_t> zlib;
+    zlib.reserve(raw.size() + (raw.size() / maxBlock + 1) * 5 + 6);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    std::size_t pos{0};
+    do
+    {
+        const std::size_t len = std::min(maxBlock, raw.size() - pos);
+        const bool last = (pos + len) == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<std::uint8_t>(len & 0xFFU));
+        zlib.push_back(static_cast<std::uint8_t>(len >> 8U));
+        zlib.push_back(static_cast<std::uint8_t>(~len & 0xFFU));
+        zlib.push_back(static_cast<std::uint8_t>((~len >> 8U) & 0xFFU));
+        zlib.insert(zlib.end(),
+                    raw.begin() + static_cast<std::ptrdiff_t>(pos),
+                    raw.begin() + static_cast<std::ptrdiff_t>(pos + len));
+        pos += len;
+    } while(pos < raw.size());
+
+    // adler32 checksum of the uncompressed data
+    std::uint32_t a{1};
+    std::uint32_t b{0};
+    for(const auto byte : raw)
+    {
+        a = (a + byte) % 65521U;
+        b = (b + a) % 65521U;
+    }
+    appendBigEndian(zlib, (b << 16U) | a);
+    writeChunk(out, "IDAT", zlib);
+    writeChunk(out, "IEND", {});
+
+    return out.good();
+}
+
+bool writeImage(const std::string& filename, const Image& img)
+{
+    if(endsWith(filename, ".png"))
+    {
+        return writePNG(filename, img);
+    }
+    return writePPM(filename, img);
+}
@@ -0,0 +1,49 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A simple 8-bit RGB image, the first row is the top one
+ */
+struct Image
+{
+    /// the width in pixels
+    unsigned width{0};
+    /// the height in pixels
+    unsigned height{0};
+    /// the pixels, 3 bytes per pixel
+    std::vector<std::uint8_t> rgb{};
+};
+
+/**
+ * Write the image as a binary PPM (P6) file
+ * @param[in] filename the name of the file
+ * @param[in] img the image to save
+ * @return true if everything went well, false otherwise
+ */
+bool writePPM(const std::string& filename, const Image& img);
+
+/**
+ * Write the image as an uncompressed PNG file (deflate "stored" blocks), so that
+ * no external library is needed
+ * @param[in] filename the name of the file
+ * @param[in] img the image to save
+ * @return true if everything went well, false otherwise
+ */
+bool writePNG(const std::string& filename, const Image& img);
+
+/**
+ * Write the image choosing the format from the extension of the file name (.png or .ppm)
+ * @param[in] filename the name of the file
+ * @param[in] img the image to save
+ * @return true if everything went well, false otherwise
+ */
+bool writeImage(const std::string& filename, const Image& img);
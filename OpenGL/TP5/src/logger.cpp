@@ -0,0 +1,162 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace logging {
+
+const char* toString(Level level)
+{
+    switch(level)
+    {
+        case Level::Trace:
+            return "trace";
+        case Level::Debug:
+            return "debug";
+        case Level::Info:
+            return "info";
+        case Level::Warning:
+            return "warning";
+        case Level::Error:
+            return "error";
+    }
+    return "";
+}
+
+const char* toString(Category category)
+{
+    switch(category)
+    {
+        case Category::General:
+            return "general";
+        case Category::Loader:
+            return "loader";
+        case Category::Subdivision:
+            return "subdivision";
+        case Category::Geometry:
+            return "geometry";
+        case Category::Render:
+            return "render";
+        case Category::Window:
+            return "window";
+    }
+    return "";
+}
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : _head(new Node), _tail(_head.load())
+{
+    _thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+    _stop = true;
+    _thread.join();
+    // the messages pushed while the thread was stopping
+    while(writeNext()) { }
+    delete _tail;
+}
+
+void Logger::push(Level level, Category category, std::string text)
+{
+    auto* node = new Node;
+    node->level = level;
+    node->category = category;
+    node->text = std::move(text);
+
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+    // link the node after the last one: the exchange serializes the producers
+    Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+
+    if(level >= Level::Error)
+    {
+        flush();
+    }
+}
+
+bool Logger::writeNext()
+{
+    Node* next = _tail->next.load(std::memory_order_acquire);
+    if(next == nullptr)
+    {
+        // empty, or a producer has not linked its node yet
+        return false;
+    }
+    std::cerr << '[' << toString(next->level) << "][" << toString(next->category) << "] " << next->text << '\n';
+    // next becomes the dummy node
+    delete _tail;
+    _tail = next;
+    next->text.clear();
+    _written.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void Logger::run()
+{
+    using namespace std::chrono_literals;
+    auto wait = 1ms;
+    while(!_stop.load(std::memory_order_acquire))
+    {
+        bool written = false;
+        while(writeNext())
+        {
+            written = true;
+        }
+        if(written)
+        {
+            std::cerr.flush();
+            wait = 1ms;
+        }
+        else
+        {
+            wait = std::min(2 * wait, std::chrono::milliseconds(16ms));
+        }
+        std::this_thread::sleep_for(wait);
+    }
+    while(writeNext()) { }
+    std::cerr.flush();
+}
+
+void Logger::flush()
+{
+    const auto target = _pushed.load(std::memory_order_relaxed);
+    while(_written.load(std::memory_order_acquire) < target && !_stop.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+bool RateLimiter::allow(std::uint64_t& suppressed)
+{
+    const auto second =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    auto current = _second.load(std::memory_order_relaxed);
+    if(current != second && _second.compare_exchange_strong(current, second, std::memory_order_relaxed))
+    {
+        // a new second has started
+        _count.store(0, std::memory_order_relaxed);
+    }
+    if(_count.fetch_add(1, std::memory_order_relaxed) < _maxPerSecond)
+    {
+        suppressed = _suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    _suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+} // namespace logging
@@ -0,0 +1,232 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * The levels of the log messages. The minimum level compiled in is given by LOG_LEVEL (cmake
+ * option LOG_LEVEL, INFO by default): the messages below it are removed at compile time, hence
+ * they cost nothing, including the evaluation of their arguments.
+ */
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * The mask of the categories compiled in, bit i enables the category i (cmake option LOG_CATEGORIES)
+ */
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES 0xFFFFFFFFU
+#endif
+
+namespace logging {
+
+/**
+ * The severity of a message
+ */
+enum class Level : std::uint8_t
+{
+    Trace = LOG_LEVEL_TRACE,
+    Debug = LOG_LEVEL_DEBUG,
+    Info = LOG_LEVEL_INFO,
+    Warning = LOG_LEVEL_WARNING,
+    Error = LOG_LEVEL_ERROR
+};
+
+/**
+ * The part of the application a message comes from
+ */
+enum class Category : std::uint8_t
+{
+    General,
+    Loader,
+    Subdivision,
+    Geometry,
+    Render,
+    Window
+};
+
+/**
+ * Tell whether the messages of the given level and category are compiled in
+ * @param[in] level the level of the message
+ * @param[in] category the category of the message
+ * @return true if the messages are kept
+ */
+constexpr bool isEnabled(Level level, Category category)
+{
+    return (static_cast<int>(level) >= LOG_LEVEL)
+           && ((static_cast<std::uint32_t>(LOG_CATEGORIES) & (1U << static_cast<unsigned>(category))) != 0);
+}
+
+const char* toString(Level level);
+const char* toString(Category category);
+
+/**
+ * The logger of the application: the messages are pushed on a lock-free queue (the callers never
+ * block nor do any I/O) and written to the standard error by a dedicated thread.
+ * Use the LOG_* macros instead of using it directly.
+ */
+class Logger
+{
+public:
+    /**
+     * Return the logger of the application, the writing thread is started on the first call
+     * @return the logger
+     */
+    static Logger& instance();
+
+    /**
+     * Push a message on the queue, error messages are flushed before returning
+     * @param[in] level the level of the message
+     * @param[in] category the category of the message
+     * @param[in] text the message
+     */
+    void push(Level level, Category category, std::string text);
+
+    /**
+     * Wait until all the messages pushed so far have been written
+     */
+    void flush();
+
+    /**
+     * Set the minimum level of the messages written, on top of the one chosen at compile time
+     * @param[in] level the minimum level
+     */
+    void setLevel(Level level) { _minLevel.store(level, std::memory_order_relaxed); }
+
+    /**
+     * Tell whether the messages of the given level are written
+     * @param[in] level the level
+     * @return true if the messages are written
+     */
+    [[nodiscard]] bool accepts(Level level) const { return level >= _minLevel.load(std::memory_order_relaxed); }
+
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    Logger();
+
+    /**
+     * A node of the multiple-producer single-consumer queue. The queue always contains a dummy
+     * node: the first node whose message has already been consumed.
+     */
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        Level level{Level::Info};
+        Category category{Category::General};
+        std::string text;
+    };
+
+    bool writeNext();
+    void run();
+
+    /// the last node pushed, shared by the producers
+    std::atomic<Node*> _head;
+    /// the dummy node, only accessed by the consumer
+    Node* _tail;
+    std::atomic<std::uint64_t> _pushed{0};
+    std::atomic<std::uint64_t> _written{0};
+    std::atomic<bool> _stop{false};
+    std::atomic<Level> _minLevel{Level::Trace};
+    std::thread _thread;
+};
+
+/**
+ * Limit the number of messages emitted by a call site to a given number per second, it counts
+ * the messages dropped so that the next emitted one can report them
+ */
+class RateLimiter
+{
+public:
+    explicit RateLimiter(unsigned maxPerSecond) : _maxPerSecond(maxPerSecond) { }
+
+    /**
+     * Tell whether a message can be emitted now
+     * @param[out] suppressed the number of messages dropped since the last emitted one
+     * @return true if the message can be emitted
+     */
+    bool allow(std::uint64_t& suppressed);
+
+private:
+    const unsigned _maxPerSecond;
+    std::atomic<std::int64_t> _second{-1};
+    std::atomic<unsigned> _count{0};
+    std::atomic<std::uint64_t> _suppressed{0};
+};
+
+} // namespace logging
+
+/**
+ * The logging macros. The message is anything that can be streamed, eg
+ * LOG_INFO(Loader, "Object loaded with " << n << " vertices")
+ *
+ * LOG_RATE_LIMITED(Warning, Geometry, 1, "...") emits at most 1 message per second from this call
+ * site, use it for the warnings that can occur for each element of a mesh
+ */
+#define LOG_MESSAGE(level, category, message)                                                                \
+    do                                                                                                       \
+    {                                                                                                        \
+        if constexpr(logging::isEnabled(logging::Level::level, logging::Category::category))                 \
+        {                                                                                                    \
+            if(logging::Logger::instance().accepts(logging::Level::level))                                   \
+            {                                                                                                \
+                std::ostringstream logStream_;                                                               \
+                logStream_ << message;                                                                       \
+                logging::Logger::instance().push(logging::Level::level, logging::Category::category,         \
+                                                 logStream_.str());                                          \
+            }                                                                                                \
+        }                                                                                                    \
+    } while(false)
+
+#define LOG_RATE_LIMITED(level, category, maxPerSecond, message)                                             \
+    do                                                                                                       \
+    {                                                                                                        \
+        if constexpr(logging::isEnabled(logging::Level::level, logging::Category::category))                 \
+        {                                                                                                    \
+            static logging::RateLimiter logLimiter_(maxPerSecond);                                           \
+            std::uint64_t logSuppressed_{0};                                                                 \
+            if(logging::Logger::instance().accepts(logging::Level::level)                                    \
+               && logLimiter_.allow(logSuppressed_))                                                         \
+            {                                                                                                \
+                std::ostringstream logStream_;                                                               \
+                logStream_ << message;                                                                       \
+                if(logSuppressed_ > 0)                                                                       \
+                {                                                                                            \
+                    logStream_ << " (" << logSuppressed_ << " similar messages suppressed)";                 \
+                }                                                                                            \
+                logging::Logger::instance().push(logging::Level::level, logging::Category::category,         \
+                                                 logStream_.str());                                          \
+            }                                                                                                \
+        }                                                                                                    \
+    } while(false)
+
+#define LOG_TRACE(category, message) LOG_MESSAGE(Trace, category, message)
+#define LOG_DEBUG(category, message) LOG_MESSAGE(Debug, category, message)
+#define LOG_INFO(category, message) LOG_MESSAGE(Info, category, message)
+#define LOG_WARNING(category, message) LOG_MESSAGE(Warning, category, message)
+#define LOG_ERROR(category, message) LOG_MESSAGE(Error, category, message)
+
+/**
+ * Print the name and the value of a variable as a debug message
+ */
+#define PRINTVAR(a) LOG_DEBUG(General, #a " = " << (a))
@@ -7,8 +7,50 @@
 #include "loop.hpp"
 
 #include "core.hpp"
+#include "edges.hpp"
 #include "geometry.hpp"
+#include "profiler.hpp"
+#include "threadPool.hpp"
 #include <cassert>
+#include <type_traits>
+
+namespace {
+
+/// the number of vertices per task of the loops run on the shared pool
+constexpr std::size_t VERTEX_GRAIN{16384};
+
+/**
+ * Compute the normal of each vertex as the normalized sum of the normals of its faces, weighted by
+ * the angle of the face at the vertex
+ *
+ * @param[in] destVert The list of vertices
+ * @param[in] destMesh The faces
+ * @param[out] destNorm The normal of each vertex
+ * @param[in] resource Where the temporary data is allocated
+ */
+template<typename Index>
+void computeLoopNormals(const std::vector<point3d>& destVert,
+                        const std::vector<basicFace<Index>>& destMesh,
+                        std::vector<vec3d>& destNorm,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+    //*********************************************************************
+    // Sum the normal of each face to each vertex normal using the angleAtVertex as weight, each
+    // vertex gathering the weighted normals of its corners when there are several cores
+    //*********************************************************************
+    computeVertexNormals(destVert, Span(destMesh), destNorm, AngleWeighting::Exact, resource);
+    //*********************************************************************
+    // normalize the normals of each vertex
+    //*********************************************************************
+    ThreadPool::shared().parallelFor(0, destNorm.size(), VERTEX_GRAIN, [&destNorm](std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            destNorm[i].normalize();
+        }
+    });
+}
+
+} // namespace
 
 /**
  * Compute the subdivision of the input mesh by applying one step of the Loop algorithm
@@ -18,93 +60,119 @@
  * @param[out] destVert The list of the new vertices for the subdivided mesh
  * @param[out] destMesh The new subdivided mesh (the vertex indices for each face/triangle)
  * @param[out] destNorm The new list of normals for each new vertex of the subdivided mesh
+ * @param[in,out] scratch The arena of the temporary data
  */
-void loopSubdivision(const std::vector<point3d>& origVert, //!< the original vertices
-                     const std::vector<face>& origMesh,    //!< the original mesh
-                     std::vector<point3d>& destVert,       //!< the new vertices
-                     std::vector<face>& destMesh,          //!< the new mesh
-                     std::vector<vec3d>& destNorm)         //!< the new normals
+template<typename InIndex, typename OutIndex>
+void loopSubdivision(const std::vector<point3d>& origVert,              //!< the original vertices
+                     const std::vector<basicFace<InIndex>>& origMesh,   //!< the original mesh
+                     std::vector<point3d>& destVert,                    //!< the new vertices
+                     std::vector<basicFace<OutIndex>>& destMesh,        //!< the new mesh
+                     std::vector<vec3d>& destNorm,                      //!< the new normals
+                     Arena& scratch)                                    //!< the temporary data
 {
-    // copy the original vertices in destVert
-    destVert = origVert;
+    // the caller chooses OutIndex wide enough for all the new vertices
+    assert(sizeof(OutIndex) >= sizeof(idxtype)
+           || FaceList::fits16(loopSubdivisionMaxVertices(origVert.size(), origMesh.size())));
+
+    PROFILE_SCOPE("loopSubdivision");
+    const auto sizes = loopSubdivisionSizes(origVert.size(), origMesh.size());
+    // release the data of the previous step and make room for this one in a single block
+    scratch.reset();
+    scratch.reserve(sizes.scratchBytes);
+
+    // the first origVert.size() elements of destVert receive the updated original vertices (they are
+    // accumulated there in the second pass), the new ones are appended without reallocating
+    destVert.clear();
+    destVert.reserve(sizes.vertices);
+    destVert.resize(origVert.size());
 
     // start fresh with the new mesh
     destMesh.clear();
+    destMesh.reserve(sizes.faces);
 
     //    PRINTVAR(destVert);
     //    PRINTVAR(origVert);
 
-    // create a list of the new vertices created with the reference to the edge
-    EdgeList newVertices;
+    // the edges sorted by their vertices, with their opposite vertices and the edge of each corner
+    EdgeTable edges(&scratch);
+    extractEdges(origMesh, origVert.size(), edges);
 
     //*********************************************************************
-    // for each face
+    // one new vertex per edge, numbered in the order of the edges
     //*********************************************************************
-    for(face f : origMesh)
-    {
-        //*********************************************************************
-        // get the indices of the triangle vertices
-        //*********************************************************************
-        idxtype i1 = f.v1;
-        idxtype i2 = f.v2;
-        idxtype i3 = f.v3;
-
-        //*********************************************************************
-        // for each edge get the index of the vertex of the midpoint using getNewVertex
-        //*********************************************************************
-
-        edge e1(i1, i2);
-        idxtype a = getNewVertex(e1, destVert, origMesh, newVertices);
-
-        edge e2(i2, i3);
-        idxtype b = getNewVertex(e2, destVert, origMesh, newVertices);
-
-        edge e3(i1, i3);
-        idxtype c = getNewVertex(e3, destVert, origMesh, newVertices);
-
-        //*********************************************************************
-        // create the four new triangles
-        // BE CAREFUL WITH THE VERTEX ORDER!!
-        //               v2
-        //               /\
-        //              /  \
-        //             /    \
-        //            a ---- b
-        //           / \     /\
-        //          /   \   /  \
-        //         /     \ /    \
-        //        v1 ---- c ---- v3
-        //
-        // the original triangle was v1-v2-v3, use the same clock-wise order for the other
-        // hence v1-a-c, a-b-c and so on
-        //*********************************************************************
+    const std::size_t numOrig = origVert.size();
+    destVert.resize(numOrig + edges.size());
+    ThreadPool::shared().parallelFor(0, edges.size(), VERTEX_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const MeshEdge& e = edges.edges[i];
+            if(!e.boundary())
+            {
+                //*********************************************************************
+                // the new vertex is the linear combination of the two extrema of
+                // the edge V1 and V2 and the two opposite vertices oppV1 and oppV2
+                // Using the loop coefficient the new vertex is
+                // nvert = 3/8 (V1+V2) + 1/8(oppV1 + oppV2)
+                //*********************************************************************
+                destVert[numOrig + i] = 3.0 * (origVert[e.first] + origVert[e.second]) / 8.0
+                                        + 1.0 * (origVert[e.opposite[0]] + origVert[e.opposite[1]]) / 8.0;
+            }
+            else
+            {
+                // on the boundary the vertex is the middle of the edge
+                destVert[numOrig + i] = (origVert[e.first] + origVert[e.second]) / 2.0;
+            }
+        }
+    });
 
-        destMesh.push_back(*new face(i1, a, c));
-        destMesh.push_back(*new face(a, i2, b));
-        destMesh.push_back(*new face(b, i3, c));
-        destMesh.push_back(*new face(a, b, c));
-    }
+    //*********************************************************************
+    // create the four new triangles of each face
+    // BE CAREFUL WITH THE VERTEX ORDER!!
+    //               v2
+    //               /\
+    //              /  \
+    //             /    \
+    //            a ---- b
+    //           / \     /\
+    //          /   \   /  \
+    //         /     \ /    \
+    //        v1 ---- c ---- v3
+    //
+    // the original triangle was v1-v2-v3, use the same clock-wise order for the other
+    // hence v1-a-c, a-b-c and so on
+    //*********************************************************************
+    destMesh.resize(4 * origMesh.size());
+    ThreadPool::shared().parallelFor(0, origMesh.size(), VERTEX_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const auto& f = origMesh[i];
+            const auto a = static_cast<idxtype>(numOrig + edges.faceEdges[3 * i]);
+            const auto b = static_cast<idxtype>(numOrig + edges.faceEdges[3 * i + 1]);
+            const auto c = static_cast<idxtype>(numOrig + edges.faceEdges[3 * i + 2]);
+            destMesh[4 * i] = basicFace<OutIndex>(face(f.v1, a, c));
+            destMesh[4 * i + 1] = basicFace<OutIndex>(face(a, f.v2, b));
+            destMesh[4 * i + 2] = basicFace<OutIndex>(face(b, f.v3, c));
+            destMesh[4 * i + 3] = basicFace<OutIndex>(face(a, b, c));
+        }
+    });
 
     //*********************************************************************
     // Update each "old" vertex using the Loop coefficients. A smart way to do
     // so is to think in terms of faces than the single vertex: for each face
     // we update each of the 3 vertices using the Loop formula wrt the other 2 and
-    // sum it to a temporary copy tmp of the vertices (which is initialized to
-    // [0 0 0] at the beginning). We also keep a record of the occurrence of each vertex.
+    // sum it to the first part of destVert (which is initialized to [0 0 0] at the
+    // beginning). We also keep a record of the occurrence of each vertex.
     // At then end, to get the final vertices we just need to divide each vertex
-    // in tmp by its occurrence
+    // by its occurrence
     //*********************************************************************
 
     // A list containing the occurrence of each vertex
-    std::vector<size_t> occurrences(origVert.size(), 0);
-
-    // A list of the same size as origVert with all the elements initialized to [0 0 0]
-    std::vector<point3d> tmp(origVert.size());
+    std::pmr::vector<size_t> occurrences(origVert.size(), 0, &scratch);
 
     //*********************************************************************
     // for each face
     //*********************************************************************
-    for(face f : origMesh)
+    for(const auto& f : origMesh)
     {
         //*********************************************************************
         // consider each of the 3 vertices:
@@ -120,9 +188,9 @@ void loopSubdivision(const std::vector<point3d>& origVert, //!< the original ver
 
         // V^ = V * 5/8 + 3/8 1/n (sum V_i)
 
-        tmp[v] += origVert[v]* 5.0 / 8.0 + (origVert[v1] + origVert[v2]) * 3.0/16.0;
-        tmp[v1] += origVert[v1]* 5.0 / 8.0 + (origVert[v] + origVert[v2]) * 3.0/16.0;
-        tmp[v2] += origVert[v2]* 5.0 / 8.0 + (origVert[v1] + origVert[v]) * 3.0/16.0;
+        destVert[v] += origVert[v]* 5.0 / 8.0 + (origVert[v1] + origVert[v2]) * 3.0/16.0;
+        destVert[v1] += origVert[v1]* 5.0 / 8.0 + (origVert[v] + origVert[v2]) * 3.0/16.0;
+        destVert[v2] += origVert[v2]* 5.0 / 8.0 + (origVert[v1] + origVert[v]) * 3.0/16.0;
         occurrences[v]++;
         occurrences[v1]++;
         occurrences[v2]++;
@@ -132,138 +200,200 @@ void loopSubdivision(const std::vector<point3d>& origVert, //!< the original ver
     //*********************************************************************
     //  To obtain the new vertices, divide each vertex by its occurrence value
     //*********************************************************************
-    for(ulong i = 0; i < origVert.size(); i++)
-    {
-        assert(occurrences[i] != 0);
-        destVert[i] = tmp[i]/occurrences[i];
-    }
+    ThreadPool::shared().parallelFor(0, origVert.size(), VERTEX_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; i++)
+        {
+            assert(occurrences[i] != 0);
+            destVert[i] = destVert[i]/occurrences[i];
+        }
+    });
     // PRINTVAR(destVert);
 
-    // redo the normals, reset and create a list of normals of the same size as
-    // the vertices, each normal set to [0 0 0]
-    destNorm.clear();
-    destNorm = std::vector<vec3d>(destVert.size());
+    computeLoopNormals(destVert, destMesh, destNorm, &scratch);
+}
 
-    //*********************************************************************
-    //  Recompute the normals for each face
-    //*********************************************************************
-    for(face f : destMesh)
-    {
-        point3d v1 = destVert[f.v1];
-        point3d v2 = destVert[f.v2];
-        point3d v3 = destVert[f.v3];
-        //*********************************************************************
-        //  Calculate the normal of the triangles, it will be the same for each vertex
-        //*********************************************************************
-        vec3d n = computeNormal(v1, v2, v3);
+template<typename InIndex, typename OutIndex>
+void loopSubdivision(const std::vector<point3d>& origVert,
+                     const std::vector<basicFace<InIndex>>& origMesh,
+                     std::vector<point3d>& destVert,
+                     std::vector<basicFace<OutIndex>>& destMesh,
+                     std::vector<vec3d>& destNorm)
+{
+    Arena scratch;
+    loopSubdivision(origVert, origMesh, destVert, destMesh, destNorm, scratch);
+}
 
-        //*********************************************************************
-        // Sum the normal of the face to each vertex normal using the angleAtVertex as weight
-        //*********************************************************************
-        destNorm[f.v1] +=  n * angleAtVertex(v1, v2, v3);
-        destNorm[f.v2] +=  n * angleAtVertex(v2, v1, v3);
-        destNorm[f.v3] +=  n * angleAtVertex(v3, v2, v1);
-    }
-    //*********************************************************************
-    // normalize the normals of each vertex
-    //*********************************************************************
-    for(ulong i = 0; i< destVert.size(); i++){
-        destNorm[i].normalize();
-    }
+void loopSubdivision(const std::vector<point3d>& origVert,
+                     const FaceList& origMesh,
+                     std::vector<point3d>& destVert,
+                     FaceList& destMesh,
+                     std::vector<vec3d>& destNorm,
+                     Arena& scratch)
+{
+    // the result is written in place, reusing the storage of destMesh if it has the same index type
+    assert(&origMesh != &destMesh && &origVert != &destVert);
+    origMesh.visit([&](const auto& faces) {
+        using InIndex = typename std::decay_t<decltype(faces)>::value_type::index_type;
+        if constexpr(sizeof(InIndex) < sizeof(idxtype))
+        {
+            if(FaceList::fits16(loopSubdivisionMaxVertices(origVert.size(), faces.size())))
+            {
+                loopSubdivision(origVert, faces, destVert, destMesh.emplace<idx16type>(), destNorm, scratch);
+                return;
+            }
+            LOG_INFO(Subdivision, "The subdivided mesh may have more than " << FaceList::MAX_VERTICES_16
+                                  << " vertices, promoting the indices to 32 bits");
+        }
+        loopSubdivision(origVert, faces, destVert, destMesh.emplace<idxtype>(), destNorm, scratch);
+    });
+}
 
+void loopSubdivision(const MeshLevel& orig, MeshLevel& dest, Arena& scratch)
+{
+    loopSubdivision(orig.vertices, orig.faces, dest.vertices, dest.faces, dest.normals, scratch);
 }
 
-/**
- * For a given edge it returns the index of the new vertex created on its middle point.
- * If such vertex already exists it just returns the its index; if it does not exist
- * it creates it in vertList along it's normal and return the index
- *
- * @param[in] e the edge
- * @param[in,out] vertList the list of vertices
- * @param[in] mesh the list of triangles
- * @param[in,out] newVertList The list of the new vertices added so far
- * @return the index of the new vertex or the one that has been already created for that edge
- * @see EdgeList
- */
-idxtype getNewVertex(const edge& e,
-                     std::vector<point3d>& vertList,
-                     const std::vector<face>& mesh,
-                     EdgeList& newVertList)
+void loopStencil(const MeshLevel& orig, const MeshLevel& dest, LoopStencil& stencil)
 {
-    //    PRINTVAR(e);
-    //    PRINTVAR(newVertList);
+    PROFILE_SCOPE("loopStencil");
+    const std::size_t numVertices = orig.vertices.size();
+    const std::size_t numEdges = dest.vertices.size() - numVertices;
 
-    //*********************************************************************
-    // if the egde is NOT contained in the new vertex list (see EdgeList.contains() method)
-    //*********************************************************************
-    if(!newVertList.contains(e))
+    // the i-th face v1-v2-v3 of orig became the faces 4i to 4i+3 of dest, the last one is a-b-c made
+    // of the new vertices on v1-v2, v2-v3 and v1-v3 (see loopSubdivision)
+    struct EdgeVertex
     {
-        //*********************************************************************
-        // generate new index (vertex.size)
-        //*********************************************************************
-        int new_index = vertList.size();
-
-        //*********************************************************************
-        // add the edge and index to the newVertList
-        //*********************************************************************
-        newVertList.add(e, new_index);
+        idxtype first{0};
+        idxtype second{0};
+        idxtype opposite[2]{0, 0};
+        unsigned faces{0};
+    };
+    std::vector<EdgeVertex> edges(numEdges);
+    std::vector<std::size_t> occurrences(numVertices, 0);
+    orig.faces.visit([&](const auto& origMesh) {
+        dest.faces.visit([&](const auto& destMesh) {
+            assert(destMesh.size() == 4 * origMesh.size());
+            for(std::size_t i = 0; i < origMesh.size(); ++i)
+            {
+                const auto& f = origMesh[i];
+                const auto& middle = destMesh[4 * i + 3];
+                const idxtype corners[3][3] = {{f.v1, f.v2, f.v3}, {f.v2, f.v3, f.v1}, {f.v1, f.v3, f.v2}};
+                const idxtype created[3] = {middle.v1, middle.v2, middle.v3};
+                for(std::size_t k = 0; k < 3; ++k)
+                {
+                    // like isBoundaryEdge, the first two faces sharing the edge give its opposite vertices
+                    auto& e = edges[created[k] - numVertices];
+                    e.first = corners[k][0];
+                    e.second = corners[k][1];
+                    if(e.faces < 2)
+                    {
+                        e.opposite[e.faces] = corners[k][2];
+                    }
+                    ++e.faces;
+                }
+                ++occurrences[f.v1];
+                ++occurrences[f.v2];
+                ++occurrences[f.v3];
+            }
+        });
+    });
+
+    // an updated vertex has itself and the two other vertices of each of its faces, a new vertex
+    // the ends of its edge and, if it is not on the boundary, the two opposite vertices
+    auto& offsets = stencil.offsets;
+    offsets.resize(numVertices + numEdges + 1);
+    offsets[0] = 0;
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        offsets[v + 1] = offsets[v] + 1 + 2 * occurrences[v];
+    }
+    for(std::size_t e = 0; e < numEdges; ++e)
+    {
+        offsets[numVertices + e + 1] = offsets[numVertices + e] + ((edges[e].faces > 1) ? 4 : 2);
+    }
+    stencil.indices.resize(offsets.back());
+    stencil.weights.resize(offsets.back());
 
-        // generate new vertex
-        point3d nvert; //!< this will contain the new vertex
-        idxtype oppV1; //!< the index of the first "opposite" vertex
-        idxtype oppV2; //!< the index of the second "opposite" vertex (if it exists)
+    // V^ = V * 5/8 + 3/8 1/n (sum V_i), the neighbours are found twice through the faces
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.begin() + static_cast<std::ptrdiff_t>(numVertices));
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        stencil.indices[cursor[v]] = static_cast<idxtype>(v);
+        stencil.weights[cursor[v]++] = 5.f / 8.f;
+    }
+    const auto addNeighbours = [&](idxtype v, idxtype n1, idxtype n2) {
+        const float w = 3.f / (16.f * static_cast<float>(occurrences[v]));
+        stencil.indices[cursor[v]] = n1;
+        stencil.weights[cursor[v]++] = w;
+        stencil.indices[cursor[v]] = n2;
+        stencil.weights[cursor[v]++] = w;
+    };
+    orig.faces.visit([&](const auto& origMesh) {
+        for(const auto& f : origMesh)
+        {
+            addNeighbours(f.v1, f.v2, f.v3);
+            addNeighbours(f.v2, f.v1, f.v3);
+            addNeighbours(f.v3, f.v1, f.v2);
+        }
+    });
 
-        //*********************************************************************
-        // check if it is a boundary edge, ie check if there is another triangle
-        // sharing this edge and if so get the index of its "opposite" vertex
-        //*********************************************************************
-        if(!isBoundaryEdge(e, mesh, oppV1, oppV2))
+    // nvert = 3/8 (V1+V2) + 1/8(oppV1 + oppV2), or the midpoint on the boundary
+    for(std::size_t e = 0; e < numEdges; ++e)
+    {
+        const std::size_t o = offsets[numVertices + e];
+        const auto& ev = edges[e];
+        stencil.indices[o] = ev.first;
+        stencil.indices[o + 1] = ev.second;
+        if(ev.faces > 1)
         {
-            // if it is not a boundary edge create the new vertex
-
-            //*********************************************************************
-            // the new vertex is the linear combination of the two extrema of
-            // the edge V1 and V2 and the two opposite vertices oppV1 and oppV2
-            // Using the loop coefficient the new vertex is
-            // nvert = 3/8 (V1+V2) + 1/8(oppV1 + oppV2)
-            //
-            // REMEMBER THAT IN THE CODE OPPV1 AND OPPV2 ARE INDICES, NOT VERTICES!!!
-            //*********************************************************************
-            nvert =
-              3.0  * (vertList[e.first] + vertList[e.second]) / 8.0 + 1.0  * (vertList[oppV1] + vertList[oppV2])/ 8.0;
+            stencil.weights[o] = stencil.weights[o + 1] = 3.f / 8.f;
+            stencil.indices[o + 2] = ev.opposite[0];
+            stencil.indices[o + 3] = ev.opposite[1];
+            stencil.weights[o + 2] = stencil.weights[o + 3] = 1.f / 8.f;
         }
         else
         {
-            //*********************************************************************
-            // otherwise it is a boundary edge then the vertex is the linear combination of the
-            // two extrema
-            //*********************************************************************
-            nvert = (vertList[e.first] + vertList[e.second]) / 2.0;
+            stencil.weights[o] = stencil.weights[o + 1] = .5f;
         }
-        //*********************************************************************
-        // append the new vertex to the list of vertices
-        //*********************************************************************
-        vertList.push_back(nvert);
-
-        //*********************************************************************
-        // return the index of the new vertex
-        //*********************************************************************
-        return new_index;
-    }
-    else
-    // else we don't need to do anything, just return the associated index of the
-    // already existing vertex
-    {
-        //*********************************************************************
-        // get and return the index of the vertex
-        //*********************************************************************
-        return newVertList.getIndex(e);
     }
+}
+
+void applyLoopStencil(const LoopStencil& stencil, const std::vector<point3d>& origVert, std::vector<point3d>& destVert)
+{
+    PROFILE_SCOPE("applyLoopStencil");
+    destVert.resize(stencil.rows());
+    // each row only reads the original vertices, the rows are independent
+    ThreadPool::shared().parallelFor(0, destVert.size(), VERTEX_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for(std::size_t r = begin; r < end; ++r)
+        {
+            point3d v{};
+            for(std::size_t k = stencil.offsets[r]; k < stencil.offsets[r + 1]; ++k)
+            {
+                v += origVert[stencil.indices[k]] * stencil.weights[k];
+            }
+            destVert[r] = v;
+        }
+    });
+}
+
+void loopNormals(const std::vector<point3d>& vertices, const FaceList& mesh, std::vector<vec3d>& normals)
+{
+    mesh.visit([&](const auto& faces) { computeLoopNormals(vertices, faces, normals); });
+}
+
+void loopSubdivision(const std::vector<point3d>& origVert,
+                     const FaceList& origMesh,
+                     std::vector<point3d>& destVert,
+                     FaceList& destMesh,
+                     std::vector<vec3d>& destNorm)
+{
+    Arena scratch;
+    loopSubdivision(origVert, origMesh, destVert, destMesh, destNorm, scratch);
+}
 
-    // this is just to avoid compilation errors at the beginning
-    // execution should normally never reach here
-    // the return instructions go inside each branch of the if - else above
-    // remove this return instruction once you have implemented the function
-    std::cerr << "WARNING: the subdivision may not be implemented correctly" << std::endl;
-    return 0;
-}
\ No newline at end of file
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face16>&, std::vector<point3d>&, std::vector<face16>&, std::vector<vec3d>&, Arena&);
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face16>&, std::vector<point3d>&, std::vector<face>&, std::vector<vec3d>&, Arena&);
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face>&, std::vector<point3d>&, std::vector<face>&, std::vector<vec3d>&, Arena&);
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face16>&, std::vector<point3d>&, std::vector<face16>&, std::vector<vec3d>&);
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face16>&, std::vector<point3d>&, std::vector<face>&, std::vector<vec3d>&);
+template void loopSubdivision(const std::vector<point3d>&, const std::vector<face>&, std::vector<point3d>&, std::vector<face>&, std::vector<vec3d>&);
@@ -6,10 +6,63 @@
 
 #pragma once
 
+#include "arena.hpp"
 #include "core.hpp"
+#include "adjacency.hpp"
+#include "edges.hpp"
 
 /**
- * Compute the subdivision of the input mesh by applying one step of the Loop algorithm
+ * The sizes of the buffers of one step of the Loop subdivision, known from the input mesh before
+ * the step starts
+ */
+struct LoopSubdivisionSizes
+{
+    /// the number of edges, exact for a closed mesh, each boundary edge adds half an edge
+    std::size_t edges{0};
+    /// the number of vertices of the result, one new vertex per edge
+    std::size_t vertices{0};
+    /// the number of faces of the result, each face is split in 4
+    std::size_t faces{0};
+    /// the bytes of the scratch buffers: the occurrences of the vertices, the edge table and the
+    /// corners of the vertices for the normals
+    std::size_t scratchBytes{0};
+};
+
+/**
+ * Compute the sizes of the buffers of one step of the Loop subdivision
+ * @param[in] numVertices the number of vertices of the input mesh
+ * @param[in] numFaces the number of faces of the input mesh
+ * @return the sizes
+ */
+constexpr LoopSubdivisionSizes loopSubdivisionSizes(std::size_t numVertices, std::size_t numFaces)
+{
+    const std::size_t edges = (3 * numFaces + 1) / 2;
+    const std::size_t scratch = numVertices * sizeof(std::size_t) + extractEdgesBytes(numFaces, edges)
+                                + vertexCornersBytes(numVertices + edges, 4 * numFaces);
+    // the margin covers the alignment of each allocation and the rounding of the number of buckets
+    return {edges, numVertices + edges, 4 * numFaces, scratch + scratch / 4};
+}
+
+/**
+ * Compute the subdivision of the input mesh by applying one step of the Loop algorithm.
+ * It is instantiated for the 16-bit and the 32-bit faces, the output faces can be wider than the
+ * input ones to promote the indices when the number of vertices does not fit in 16 bits anymore.
+ * The output lists are reserved once at their final size, all the temporary data is allocated in
+ * the scratch arena, which is reset at the beginning of the step and can be reused by the next one.
+ *
+ * @param[in] origVert The list of the input vertices
+ * @param[in] origMesh The input mesh (the vertex indices for each face/triangle)
+ * @param[out] destVert The list of the new vertices for the subdivided mesh
+ * @param[out] destMesh The new subdivided mesh (the vertex indices for each face/triangle)
+ * @param[out] destNorm The new list of normals for each new vertex of the subdivided mesh
+ * @param[in,out] scratch The arena of the temporary data
+ */
+template<typename InIndex, typename OutIndex>
+void loopSubdivision(const std::vector<point3d> &origVert, const std::vector<basicFace<InIndex>> &origMesh, std::vector<point3d> &destVert, std::vector<basicFace<OutIndex>> &destMesh, std::vector<vec3d> &destNorm, Arena &scratch);
+
+/**
+ * Compute the subdivision of the input mesh by applying one step of the Loop algorithm, with an
+ * arena used only for this step
  *
  * @param[in] origVert The list of the input vertices
  * @param[in] origMesh The input mesh (the vertex indices for each face/triangle)
@@ -17,20 +70,100 @@
  * @param[out] destMesh The new subdivided mesh (the vertex indices for each face/triangle)
  * @param[out] destNorm The new list of normals for each new vertex of the subdivided mesh
  */
-void loopSubdivision(const std::vector<point3d> &origVert, const std::vector<face> &origMesh, std::vector<point3d> &destVert, std::vector<face> &destMesh, std::vector<vec3d> &destNorm);
+template<typename InIndex, typename OutIndex>
+void loopSubdivision(const std::vector<point3d> &origVert, const std::vector<basicFace<InIndex>> &origMesh, std::vector<point3d> &destVert, std::vector<basicFace<OutIndex>> &destMesh, std::vector<vec3d> &destNorm);
+
+/**
+ * Compute one step of the Loop subdivision of a mesh stored with the narrowest index type: the
+ * result keeps 16-bit indices as long as its vertices can be addressed with them, otherwise the
+ * indices are promoted to 32 bits
+ *
+ * @param[in] origVert The list of the input vertices
+ * @param[in] origMesh The input mesh
+ * @param[out] destVert The list of the new vertices for the subdivided mesh
+ * @param[out] destMesh The new subdivided mesh
+ * @param[out] destNorm The new list of normals for each new vertex of the subdivided mesh
+ * @param[in,out] scratch The arena of the temporary data
+ */
+void loopSubdivision(const std::vector<point3d> &origVert, const FaceList &origMesh, std::vector<point3d> &destVert, FaceList &destMesh, std::vector<vec3d> &destNorm, Arena &scratch);
+
+/**
+ * Compute one step of the Loop subdivision of a mesh stored with the narrowest index type, with
+ * an arena used only for this step
+ *
+ * @param[in] origVert The list of the input vertices
+ * @param[in] origMesh The input mesh
+ * @param[out] destVert The list of the new vertices for the subdivided mesh
+ * @param[out] destMesh The new subdivided mesh
+ * @param[out] destNorm The new list of normals for each new vertex of the subdivided mesh
+ */
+void loopSubdivision(const std::vector<point3d> &origVert, const FaceList &origMesh, std::vector<point3d> &destVert, FaceList &destMesh, std::vector<vec3d> &destNorm);
+
+/**
+ * Compute one step of the Loop subdivision of a mesh level into another one. The buffers of the
+ * destination are reused, so that alternating two levels subdivides without allocating nor copying
+ * the whole arrays once their capacity is large enough
+ *
+ * @param[in] orig The input level
+ * @param[out] dest The subdivided level, it must be a different object
+ * @param[in,out] scratch The arena of the temporary data
+ */
+void loopSubdivision(const MeshLevel &orig, MeshLevel &dest, Arena &scratch);
+
+/**
+ * The topology of one step of the Loop subdivision: each vertex of the result as a weighted sum of
+ * the vertices of the input, stored as a sparse matrix (one row per vertex of the result). As long
+ * as the faces do not change, applying it to moved vertices gives the result of the step without
+ * searching the edges again.
+ */
+struct LoopStencil
+{
+    /// where the entries of each row start, plus the end of the last one
+    std::vector<std::size_t> offsets{};
+    /// the input vertex of each entry
+    std::vector<idxtype> indices{};
+    /// the weight of each entry
+    std::vector<float> weights{};
 
+    /// the number of vertices of the result
+    [[nodiscard]] std::size_t rows() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+/**
+ * Compute the stencil of a step of the Loop subdivision from its input and its result
+ *
+ * @param[in] orig The input level
+ * @param[in] dest The level computed from orig by loopSubdivision
+ * @param[out] stencil The weights of the input vertices for each vertex of dest
+ */
+void loopStencil(const MeshLevel &orig, const MeshLevel &dest, LoopStencil &stencil);
+
+/**
+ * Compute the vertices of a subdivided level from moved input vertices and the stencil of the step
+ *
+ * @param[in] stencil The stencil of the step
+ * @param[in] origVert The input vertices, with the same topology as when the stencil was computed
+ * @param[out] destVert The vertices of the subdivided level
+ */
+void applyLoopStencil(const LoopStencil &stencil, const std::vector<point3d> &origVert, std::vector<point3d> &destVert);
+
+/**
+ * Compute the normalized normals of a subdivided level, the same as the ones computed by loopSubdivision
+ *
+ * @param[in] vertices The list of vertices
+ * @param[in] mesh The faces
+ * @param[out] normals The normal of each vertex
+ */
+void loopNormals(const std::vector<point3d> &vertices, const FaceList &mesh, std::vector<vec3d> &normals);
 
 /**
- * For a given edge it returns the index of the new vertex created on its middle point. If such vertex already exists it just returns the
- * its index; if it does not exist it creates it in vertList along it's normal and return the index
- * @brief ObjModel::getNewVertex
- * @param e the edge
- * @param currFace the current triangle containing the edge e
- * @param vertList the list of vertices
- * @param indices the list of triangles
- * @param normList the list of normals associated to the vertices
- * @param newVertList The list of the new vertices added so far
- * @return the index of the new vertex
- * @see EdgeList
+ * Return an upper bound of the number of vertices after one step of the Loop subdivision (one new
+ * vertex per edge, at most 3 edges per face), to choose the index type of the result
+ * @param[in] numVertices the number of vertices of the input mesh
+ * @param[in] numFaces the number of faces of the input mesh
+ * @return the maximum number of vertices of the subdivided mesh
  */
-idxtype getNewVertex(const edge &e, std::vector<point3d> &vertList, const std::vector<face> &mesh, EdgeList &newVertList);
\ No newline at end of file
+constexpr std::size_t loopSubdivisionMaxVertices(std::size_t numVertices, std::size_t numFaces)
+{
+    return numVertices + 3 * numFaces;
+}
@@ -4,11 +4,30 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include "asyncLoader.hpp"
+#include "hotReload.hpp"
+#include "image.hpp"
+#include "logger.hpp"
 #include "MeshModel.hpp"
 #include "openglAll.hpp"
+#include "profiler.hpp"
+#include "scene.hpp"
+#ifdef RENDERER_WITH_EGL
+#include "offscreen.hpp"
+#endif
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <vector>
 
 #define KEY_ESCAPE 27
 
@@ -49,13 +68,51 @@ int angle_y = 0;
 int angle_x = 0;
 float camDistance = 5;
 RenderingParameters params;
+/// the distance under which the vertices of the STL models, and of the repaired ones, are merged
+float weldEpsilon{0.f};
+/// if true the model is repaired after being loaded
+bool repairModel{false};
+/// loads the model in the background while the window is displayed
+AsyncLoader loader;
+/// how often the window appends the batches of the model being loaded, in milliseconds
+constexpr unsigned LOADING_POLL_MS{30};
+/// the instances of the models when several files or a scene manifest are given, a single model is obj
+Scene scene;
+/// the loading of the scene in the background of the window
+std::future<SceneLoadStats> sceneLoading;
+/// true once the models of the scene are loaded, they are not rendered before
+bool sceneReady{false};
+/// if set the model is saved there, unitized and subdivided as displayed, instead of being displayed
+string exportFile;
+/// if true the model is reloaded when its file changes
+bool watchModel{false};
+/// reloads the model when its file changes, if watched
+std::unique_ptr<HotReloader> reloader;
+/// how often the window checks the file of the watched model, in milliseconds
+constexpr unsigned WATCH_POLL_MS{200};
+/// if set the levels of subdivision are cached in this directory
+string cacheDirectory;
+/// the maximum size of the cache directory in bytes
+std::uint64_t cacheBytes{DEFAULT_MESH_CACHE_BYTES};
+/// the cache of the levels of subdivision shared by the models, if any
+std::shared_ptr<MeshCache> cache;
+/// when the program started, the time to first pixel is measured from there
+const std::chrono::steady_clock::time_point programStart = std::chrono::steady_clock::now();
+/// the time between the start of the program and the first frame showing the model, once known
+std::optional<double> firstPixelMs;
 
 glutWindow win;
 
+/// the light of the scene, in eye coordinates (the colors are the ones set by place_light)
+const Light sceneLight{{0.f, 0.f, 140.f}, {.2f, .2f, .2f}, {1.f, 1.f, 1.f}, {1.f, 1.f, 1.f}};
+/// the material of the model
+const Material sceneMaterial{{.2f, .2f, .2f}, {.8f, .8f, .8f}, {1.f, .8f, .8f}, 100.f};
+
 
 // Function called every time the main window is resized
 void reshape( int width, int height );
 void DrawAxis( float scale );
+void DrawAxis( SoftwareRasterizer& target, float scale );
 // initialize the opengl
 void initialize( );
 
@@ -197,7 +254,135 @@ void render_fps()
     glMatrixMode(GL_MODELVIEW);
 }
 
-void display( )
+#ifdef ENABLE_PROFILER
+/// the file where the Chrome trace is written on exit
+string traceFile{"visualizer_trace.json"};
+
+/**
+ * Write the Chrome trace of the session, called on exit
+ */
+void write_trace()
+{
+    if(Profiler::instance().writeChromeTrace(traceFile))
+    {
+        LOG_INFO( General, "Chrome trace written to " << traceFile );
+    }
+}
+
+/**
+ * Format the statistics of a stage as a line of text
+ * @param stage the statistics of the stage
+ * @return the text
+ */
+std::string format_stage(const StageStats& stage)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-22s min %7.2f  avg %7.2f  p99 %7.2f ms", stage.name.c_str(), stage.min, stage.avg, stage.p99);
+    return line;
+}
+
+/**
+ * Format the counters of a worker of the shared pool as a line of text
+ * @param index the index of the worker
+ * @param worker the counters of the worker
+ * @param utilization the fraction of the time spent executing tasks
+ * @return the text
+ */
+std::string format_worker(std::size_t index, const WorkerStats& worker, double utilization)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "worker %-15zu %5.1f%%  %8llu tasks %6llu steals", index, 100. * utilization,
+                  static_cast<unsigned long long>(worker.tasks), static_cast<unsigned long long>(worker.steals));
+    return line;
+}
+
+/**
+ * Render the time of the frame and of each stage (min/avg/p99 over the last frames) on the screen,
+ * then the utilization of the workers of the shared pool over the last second
+ */
+void render_profiler()
+{
+    // Set up an orthographic projection for 2D text rendering
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+
+    const auto width = glutGet(GLUT_WINDOW_WIDTH);
+    const auto height = glutGet(GLUT_WINDOW_HEIGHT);
+    gluOrtho2D(0, width, 0, height);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // one line per stage from the top-left corner, the frame first
+    constexpr int lineHeight{20};
+    int y = height - lineHeight;
+    for(const auto& stage : Profiler::instance().stats())
+    {
+        render_text(format_stage(stage), 10, y);
+        y -= lineHeight;
+    }
+
+    // the utilization is the busy time between two samples of the cumulated counters
+    static std::vector<WorkerStats> previous{ThreadPool::shared().workerStats()};
+    static std::vector<double> utilization(previous.size(), 0.);
+    static auto sampled = std::chrono::steady_clock::now();
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsedMs = std::chrono::duration<double, std::milli>(now - sampled).count();
+    if(elapsedMs >= 1000.)
+    {
+        const std::vector<WorkerStats> current = ThreadPool::shared().workerStats();
+        for(std::size_t w = 0; w < current.size(); ++w)
+        {
+            utilization[w] = std::min(1., (current[w].busyMs - previous[w].busyMs) / elapsedMs);
+        }
+        previous = current;
+        sampled = now;
+    }
+    for(std::size_t w = 0; w < previous.size(); ++w)
+    {
+        render_text(format_worker(w, previous[w], utilization[w]), 10, y);
+        y -= lineHeight;
+    }
+
+    // Restore previous projection and modelview matrices
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+#endif
+
+/**
+ * Return the rendering parameters of a model being loaded: it is subdivided once loaded, rather
+ * than after each batch
+ * @return the parameters
+ */
+RenderingParameters loadingParameters( )
+{
+    RenderingParameters loading = params;
+    loading.subdivision = false;
+    return loading;
+}
+
+/**
+ * Record the time to first pixel the first time a frame shows some of the model
+ */
+void recordFirstPixel( )
+{
+    if( !firstPixelMs && ( !obj.empty() || sceneReady ) )
+    {
+        firstPixelMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - programStart ).count();
+        LOG_INFO( General, "Time to first pixel: " << *firstPixelMs << " ms" );
+    }
+}
+
+/**
+ * Draw the whole scene (light, axis and model) with the current camera, without
+ * any overlay nor buffer swap, so that it can be used both in the window and headless
+ */
+void render_scene( )
 {
     glClearColor(0.5, .5, .75, 1.);
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
@@ -206,7 +391,7 @@ void display( )
     glLoadIdentity( );
 
     glPushMatrix( );
-    place_light( 0, 0, 140 );
+    place_light( sceneLight.position.x, sceneLight.position.y, sceneLight.position.z );
     glTranslatef( 0, 0, -camDistance );
     glRotatef(static_cast<GLfloat>(angle_x), 1.f, .0f, .0f );
     glRotatef(static_cast<GLfloat>(angle_y), .0f, 1.f, .0f );
@@ -216,20 +401,90 @@ void display( )
     DrawAxis( 1.0f );
 
     define_material(
-                     .2f, .2f, .2f,
-                     .8f, .8f, .8f,
-                     1.f, .8f, .8f,
-                     100 );
+                     sceneMaterial.ambient.x, sceneMaterial.ambient.y, sceneMaterial.ambient.z,
+                     sceneMaterial.diffuse.x, sceneMaterial.diffuse.y, sceneMaterial.diffuse.z,
+                     sceneMaterial.specular.x, sceneMaterial.specular.y, sceneMaterial.specular.z,
+                     sceneMaterial.shininess );
     //***********************************************
     // draw the model
     //***********************************************
-    obj.render( params );
+    if( sceneReady )
+    {
+        scene.render( params );
+    }
+    else if( loader.busy() )
+    {
+        // the model being loaded is unitized by the modelview, its vertices are unitized at the end
+        const MeshModel::Unitization u = obj.unitization();
+        glScalef( u.scale, u.scale, u.scale );
+        glTranslatef( -u.center.x, -u.center.y, -u.center.z );
+        obj.render( loadingParameters() );
+    }
+    else
+    {
+        obj.render( params );
+    }
 
     glPopMatrix( );
+}
 
+/**
+ * Draw the whole scene with the software rasterizer, with the same camera, light and
+ * material as render_scene()
+ * @param target the software rasterizer to draw into
+ */
+void render_scene( SoftwareRasterizer& target )
+{
+    target.clear( {.5f, .5f, .75f} );
+
+    const auto aspect = static_cast<float>( win.width ) / static_cast<float>( win.height );
+    target.setProjection( perspectiveMatrix( win.field_of_view_angle, aspect, win.z_near, win.z_far ) );
+
+    // the light is placed before the camera transformations, ie in eye coordinates
+    target.setLight( sceneLight );
+
+    mat4 modelView = translationMatrix( 0, 0, -camDistance );
+    modelView = multiply( modelView, rotationMatrix( static_cast<float>( angle_x ), 1.f, .0f, .0f ) );
+    modelView = multiply( modelView, rotationMatrix( static_cast<float>( angle_y ), .0f, 1.f, .0f ) );
+    target.setModelView( modelView );
+
+    DrawAxis( target, 1.0f );
+
+    target.setMaterial( sceneMaterial );
+    if( sceneReady )
+    {
+        scene.render( target, modelView, params );
+    }
+    else if( loader.busy() )
+    {
+        const MeshModel::Unitization u = obj.unitization();
+        modelView = multiply( modelView, scalingMatrix( u.scale ) );
+        modelView = multiply( modelView, translationMatrix( -u.center.x, -u.center.y, -u.center.z ) );
+        target.setModelView( modelView );
+        obj.render( target, loadingParameters() );
+    }
+    else
+    {
+        obj.render( target, params );
+    }
+}
+
+void display( )
+{
+    render_scene( );
+
+#ifdef ENABLE_PROFILER
+    render_profiler();
+#else
     render_fps();
+#endif
 
-    glutSwapBuffers( );
+    {
+        PROFILE_SCOPE("glutSwapBuffers");
+        glutSwapBuffers( );
+    }
+    recordFirstPixel( );
+    PROFILE_FRAME_END();
 }
 
 void printKeyboardHelp()
@@ -255,34 +510,34 @@ void keyboard( unsigned char key, int , int  )
             exit( 0 );
         case 's':
             params.useIndexRendering = !params.useIndexRendering;
-            PRINTVAR( params.useIndexRendering );
+            LOG_INFO( Window, "useIndexRendering: " << std::boolalpha << params.useIndexRendering );
             break;
         case 'w':
             params.wireframe = !params.wireframe;
-            PRINTVAR( params.wireframe );
+            LOG_INFO( Window, "wireframe: " << std::boolalpha << params.wireframe );
             break;
         case 'h':
             params.subdivision = !params.subdivision;
-            PRINTVAR( params.subdivision );
+            LOG_INFO( Window, "subdivision: " << std::boolalpha << params.subdivision );
             break;
         case 'd':
             params.solid = !params.solid;
-            PRINTVAR( params.solid );
+            LOG_INFO( Window, "solid: " << std::boolalpha << params.solid );
             break;
         case 'a':
             params.smooth = !params.smooth;
-            PRINTVAR( params.smooth );
+            LOG_INFO( Window, "smooth: " << std::boolalpha << params.smooth );
             break;
         case 'n':
             params.normals = !params.normals;
-            PRINTVAR( params.normals );
+            LOG_INFO( Window, "normals: " << std::boolalpha << params.normals );
             break;
         case '1':
         case '2':
         case '3':
         case '4':
             params.subdivLevel = static_cast<decltype(params.subdivLevel)>(key - '0');
-            PRINTVAR( params.subdivLevel );
+            LOG_INFO( Window, "subdivLevel: " << params.subdivLevel );
             break;
         default:
             break;
@@ -318,22 +573,787 @@ void arrows( int key, int , int )
     glutPostRedisplay( );
 }
 
-int main( int argc, char **argv )
+/**
+ * The options of the headless (offscreen) mode
+ */
+struct HeadlessOptions
+{
+    /// render offscreen, without any window
+    bool enabled{false};
+    /// the number of frames to render, the camera does a full orbit around the model
+    unsigned frames{360};
+    /// if not empty the frames are saved as <prefix>NNNN.<format>
+    string framePrefix{};
+    /// the image format of the saved frames, ppm or png
+    string frameFormat{"ppm"};
+    /// if not empty the frame-time statistics are written to this JSON file
+    string statsFile{};
+    /// use the software rasterizer instead of OpenGL
+    bool software{false};
+    /// the number of threads of the software rasterizer, 0 for all the cores
+    unsigned threads{0};
+    /// load the model in the background while the frames are rendered, like the window does
+    bool asyncLoad{false};
+};
+
+void printUsage( const string& program )
+{
+    std::cout << "Usage:\n\t" << program << " [options] <model files or .scene manifests>\n"
+              << "options:\n"
+              << "\t --headless           render offscreen without window and print frame-time statistics\n"
+              << "\t --frames N           number of frames of the headless orbit (default 360)\n"
+              << "\t --save-frames PREFIX save each headless frame as PREFIXNNNN.<format>\n"
+              << "\t --format ppm|png     image format of the saved frames (default ppm)\n"
+              << "\t --stats FILE         write the headless frame-time statistics as JSON\n"
+              << "\t --size WxH           size of the window/offscreen surface\n"
+              << "\t --software           headless rendering with the software rasterizer (no GPU nor EGL)\n"
+              << "\t --threads N          number of threads of the software rasterizer (default all cores)\n"
+              << "\t --async              load the model while the headless frames are rendered (the window always does)\n"
+#ifdef ENABLE_PROFILER
+              << "\t --trace FILE         where the Chrome trace is written on exit (default visualizer_trace.json)\n"
+#endif
+              << "\t --subdiv N           enable subdivision with N levels\n"
+              << "\t --smooth             enable smooth rendering\n"
+              << "\t --index              use index rendering\n"
+              << "\t --no-wireframe       disable the wireframe\n"
+              << "\t --no-solid           disable solid rendering\n"
+              << "\t --normals            draw the normals\n"
+              << "\t --weld EPS           merge the vertices of the STL and repaired models closer than EPS (default 0, identical ones)\n"
+              << "\t --repair             weld the vertices, remove the degenerate and duplicated faces and report the non-manifold edges\n"
+              << "\t --watch              reload the model when its file changes, keeping the subdivision if the faces are the same\n"
+              << "\t --export FILE        save the model as it would be displayed (.obj, .bmesh, .ply or .stl) and exit\n"
+              << "\t --cache DIR          read the levels of subdivision from DIR if already computed, and store them there\n"
+              << "\t --cache-size MB      maximum size of the cache, the least recently used levels are removed (default 1024)\n"
+              << "\t --help               print this help\n"
+              << "Several models, or a manifest listing one model per line optionally followed by x y z\n"
+              << "and a scale, are loaded concurrently into a scene; each file is loaded once and shared."
+              << std::endl;
+}
+
+/**
+ * Parse the command line arguments
+ * @param[in] argc the number of arguments
+ * @param[in] argv the arguments
+ * @param[out] models the model files and scene manifests to load
+ * @param[out] headless the headless options
+ * @param[out] help true if the usage was asked for with --help or -h
+ * @return true if the arguments are valid, false if they are not or the usage was asked for
+ */
+bool parseArguments( int argc, char** argv, vector<string>& models, HeadlessOptions& headless, bool& help )
+{
+    for( int i = 1; i < argc; ++i )
+    {
+        const string arg( argv[i] );
+        const auto hasValue = [&]() { return ( i + 1 ) < argc; };
+        try
+        {
+            if( arg == "--help" || arg == "-h" )
+            {
+                help = true;
+                return false;
+            }
+            else if( arg == "--headless" )
+            {
+                headless.enabled = true;
+            }
+            else if( arg == "--frames" && hasValue() )
+            {
+                headless.frames = static_cast<unsigned>( std::stoul( argv[++i] ) );
+            }
+            else if( arg == "--save-frames" && hasValue() )
+            {
+                headless.framePrefix = argv[++i];
+            }
+            else if( arg == "--format" && hasValue() )
+            {
+                headless.frameFormat = argv[++i];
+                if( headless.frameFormat != "ppm" && headless.frameFormat != "png" )
+                {
+                    LOG_ERROR( General, "unknown image format " << headless.frameFormat );
+                    return false;
+                }
+            }
+            else if( arg == "--stats" && hasValue() )
+            {
+                headless.statsFile = argv[++i];
+            }
+            else if( arg == "--size" && hasValue() )
+            {
+                const string size( argv[++i] );
+                const auto sep = size.find( 'x' );
+                if( sep == string::npos )
+                {
+                    LOG_ERROR( General, "invalid size " << size << ", expected WxH" );
+                    return false;
+                }
+                win.width = std::stoi( size.substr( 0, sep ) );
+                win.height = std::stoi( size.substr( sep + 1 ) );
+                if( win.width <= 0 || win.height <= 0 )
+                {
+                    LOG_ERROR( General, "invalid size " << size << ", the width and the height must be positive" );
+                    return false;
+                }
+            }
+            else if( arg == "--async" )
+            {
+                headless.asyncLoad = true;
+            }
+            else if( arg == "--software" )
+            {
+                headless.software = true;
+            }
+            else if( arg == "--threads" && hasValue() )
+            {
+                headless.threads = static_cast<unsigned>( std::stoul( argv[++i] ) );
+            }
+#ifdef ENABLE_PROFILER
+            else if( arg == "--trace" && hasValue() )
+            {
+                traceFile = argv[++i];
+            }
+#endif
+            else if( arg == "--subdiv" && hasValue() )
+            {
+                params.subdivision = true;
+                params.subdivLevel = static_cast<decltype( params.subdivLevel )>( std::stoul( argv[++i] ) );
+            }
+            else if( arg == "--smooth" )
+            {
+                params.smooth = true;
+            }
+            else if( arg == "--index" )
+            {
+                params.useIndexRendering = true;
+            }
+            else if( arg == "--no-wireframe" )
+            {
+                params.wireframe = false;
+            }
+            else if( arg == "--no-solid" )
+            {
+                params.solid = false;
+            }
+            else if( arg == "--normals" )
+            {
+                params.normals = true;
+            }
+            else if( arg == "--weld" && hasValue() )
+            {
+                weldEpsilon = std::stof( argv[++i] );
+            }
+            else if( arg == "--repair" )
+            {
+                repairModel = true;
+            }
+            else if( arg == "--watch" )
+            {
+                watchModel = true;
+            }
+            else if( arg == "--export" && hasValue() )
+            {
+                exportFile = argv[++i];
+            }
+            else if( arg == "--cache" && hasValue() )
+            {
+                cacheDirectory = argv[++i];
+            }
+            else if( arg == "--cache-size" && hasValue() )
+            {
+                cacheBytes = std::stoull( argv[++i] ) << 20U;
+            }
+            else if( arg.rfind( "--", 0 ) == 0 )
+            {
+                LOG_ERROR( General, "unexpected argument " << arg );
+                return false;
+            }
+            else
+            {
+                models.push_back( arg );
+            }
+        }
+        catch( const std::logic_error& )
+        {
+            LOG_ERROR( General, "invalid value for " << arg );
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Make the model unitary and give it the cache of the subdivisions
+ * @param[in,out] model the model
+ */
+void placeModel( MeshModel& model )
+{
+    //***********************************************
+    // Make it unitary
+    //***********************************************
+    model.unitizeModel();
+    model.setCache( cache );
+}
+
+/**
+ * Log the counters of the cache, called on exit
+ */
+void logCacheStats()
+{
+    LOG_INFO( Subdivision, "Subdivision cache " << cache->directory( ) << ": " << cache->stats( ) );
+}
+
+/**
+ * Repair the loaded model if required and make it unitary
+ * @param[in,out] model the model
+ */
+void finishModel( MeshModel& model )
+{
+    if( repairModel )
+    {
+        model.repair( weldEpsilon );
+    }
+    placeModel( model );
+}
+
+/**
+ * Add the model files and the instances of the manifests to the scene
+ * @param[in] files the model files and the manifests
+ * @return true if everything went well, false otherwise
+ */
+bool buildScene( const vector<string>& files )
+{
+    for( const auto& f : files )
+    {
+        if( !Scene::isManifest( f ) )
+        {
+            scene.add( f );
+        }
+        else if( !scene.readManifest( f ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Load the models of the scene concurrently on the shared thread pool, each one is made unitary
+ * @return what has been loaded
+ */
+SceneLoadStats loadScene( )
+{
+    return scene.load( weldEpsilon, &ThreadPool::shared(), []( MeshModel& model ) { finishModel( model ); } );
+}
+
+/**
+ * Load the model and make it unitary
+ * @param[in] filename the model file
+ * @return true if everything went well, false otherwise
+ */
+bool loadModel( const string& filename )
+{
+    //***********************************************
+    // Load the obj model from file
+    //***********************************************
+    if( !obj.load( filename, weldEpsilon ) )
+    {
+        LOG_ERROR( Loader, "error while opening the model" );
+        return false;
+    }
+    finishModel( obj );
+    return true;
+}
+
+/**
+ * Append the batches loaded in the background to the model, and finish the model once it is
+ * entirely loaded
+ * @return false if the loading failed
+ */
+bool pollLoading( )
+{
+    switch( loader.poll( obj ) )
+    {
+    case AsyncLoader::State::Loaded:
+        LOG_INFO( Loader, "Model loaded in the background in " << loader.elapsedMs() << " ms" );
+        finishModel( obj );
+        return true;
+    case AsyncLoader::State::Failed:
+        LOG_ERROR( Loader, "error while opening the model" );
+        obj.clear( );
+        return false;
+    default:
+        return true;
+    }
+}
+
+/**
+ * The GLUT timer polling the model being loaded, it redraws the window with the new batches
+ * @param[in] value unused
+ */
+void pollLoadingTimer( int value )
+{
+    bool loading{false};
+    if( sceneLoading.valid() )
+    {
+        // the models of a scene are rendered once they are all loaded
+        loading = sceneLoading.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready;
+        if( !loading )
+        {
+            LOG_INFO( Loader, "Scene: " << sceneLoading.get() );
+            sceneReady = !scene.empty();
+        }
+    }
+    else
+    {
+        pollLoading( );
+        loading = loader.busy();
+    }
+    glutPostRedisplay( );
+    if( loading )
+    {
+        glutTimerFunc( LOADING_POLL_MS, pollLoadingTimer, value );
+    }
+}
+
+/**
+ * The GLUT timer checking the file of the watched model, it redraws the window once the model is reloaded
+ * @param[in] value unused
+ */
+void watchTimer( int value )
 {
-    if(argc ==1 )
+    // the first version of the model has to be entirely loaded before being compared
+    if( !loader.busy() )
     {
-      std::cout << "No obj file to load, displaying an empty scene with the reference system" << std::endl;
-      std::cout << "Usage:\n\t" + std::string(argv[0]) + " <obj file>" << std::endl;
+        const auto result = reloader->poll( obj );
+        if( result == HotReloader::Result::Positions || result == HotReloader::Result::Topology )
+        {
+            // the new version has already been repaired in the background
+            placeModel( obj );
+            glutPostRedisplay( );
+        }
     }
+    glutTimerFunc( WATCH_POLL_MS, watchTimer, value );
+}
 
+/**
+ * Escape a string for JSON
+ * @param[in] s the string
+ * @return the string with the quotes, the backslashes and the control characters escaped
+ */
+string escapeJson( const string& s )
+{
+    string escaped;
+    escaped.reserve( s.size() );
+    for( const char c : s )
+    {
+        if( c == '"' || c == '\\' )
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if( static_cast<unsigned char>( c ) < 0x20 )
+        {
+            std::ostringstream code;
+            code << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << static_cast<int>( c );
+            escaped += code.str();
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Print the statistics of the frame times and optionally save them as JSON
+ * @param[in] frameTimes the duration of each frame in milliseconds
+ * @param[in] firstFrame the duration of the first frame (that includes the subdivision, if any)
+ * @param[in] renderer the name of the renderer
+ * @param[in] model the rendered model
+ * @param[in] opts the headless options
+ * @param[in] trianglesPerFrame the number of triangles drawn in each frame, 0 if unknown (null in the JSON)
+ */
+void reportFrameTimes( std::vector<double> frameTimes,
+                       double firstFrame,
+                       const string& renderer,
+                       const string& model,
+                       const HeadlessOptions& opts,
+                       size_t trianglesPerFrame = 0 )
+{
+    std::sort( frameTimes.begin(), frameTimes.end() );
+    const auto percentile = [&frameTimes]( double p ) {
+        const auto idx = static_cast<size_t>( p * static_cast<double>( frameTimes.size() - 1 ) + .5 );
+        return frameTimes[idx];
+    };
+    const double avg = std::accumulate( frameTimes.begin(), frameTimes.end(), .0 ) / static_cast<double>( frameTimes.size() );
+
+    std::cout << "frames: " << frameTimes.size() << " (" << renderer << ")\n"
+              << "first frame: " << firstFrame << " ms\n"
+              << "min: " << frameTimes.front() << " ms  avg: " << avg << " ms  median: " << percentile( .5 )
+              << " ms  p95: " << percentile( .95 ) << " ms  p99: " << percentile( .99 ) << " ms  max: " << frameTimes.back()
+              << " ms\n"
+              << "fps: " << 1000. / avg << std::endl;
+    if( firstPixelMs )
+    {
+        std::cout << "time to first pixel: " << *firstPixelMs << " ms" << std::endl;
+    }
+    // triangles per microsecond are millions of triangles per second
+    const double mtris = static_cast<double>( trianglesPerFrame ) / ( avg * 1000. );
+    if( trianglesPerFrame != 0 )
+    {
+        std::cout << "throughput: " << mtris << " Mtri/s (" << trianglesPerFrame << " triangles per frame)" << std::endl;
+    }
+
+#ifdef ENABLE_PROFILER
+    for( const auto& stage : Profiler::instance().stats() )
+    {
+        std::cout << format_stage( stage ) << "\n";
+    }
+    const std::vector<WorkerStats> workers = ThreadPool::shared().workerStats();
+    for( std::size_t w = 0; w < workers.size(); ++w )
+    {
+        std::cout << format_worker( w, workers[w], workers[w].utilization ) << "\n";
+    }
+#endif
+
+    if( opts.statsFile.empty() )
+    {
+        return;
+    }
+    std::ofstream out( opts.statsFile );
+    if( !out.is_open() )
+    {
+        LOG_ERROR( General, "Unable to open file " << opts.statsFile );
+        return;
+    }
+    out << std::boolalpha << "{\n"
+        << "  \"model\": \"" << escapeJson( model ) << "\",\n"
+        << "  \"renderer\": \"" << escapeJson( renderer ) << "\",\n"
+        << "  \"width\": " << win.width << ",\n"
+        << "  \"height\": " << win.height << ",\n"
+        << "  \"params\": {\"wireframe\": " << params.wireframe << ", \"solid\": " << params.solid
+        << ", \"index\": " << params.useIndexRendering << ", \"smooth\": " << params.smooth
+        << ", \"normals\": " << params.normals << ", \"subdivision\": " << ( params.subdivision ? params.subdivLevel : 0 )
+        << "},\n"
+        << "  \"frames\": " << frameTimes.size() << ",\n"
+        << "  \"first_frame_ms\": " << firstFrame << ",\n"
+        << "  \"min_ms\": " << frameTimes.front() << ",\n"
+        << "  \"avg_ms\": " << avg << ",\n"
+        << "  \"median_ms\": " << percentile( .5 ) << ",\n"
+        << "  \"p95_ms\": " << percentile( .95 ) << ",\n"
+        << "  \"p99_ms\": " << percentile( .99 ) << ",\n"
+        << "  \"max_ms\": " << frameTimes.back() << ",\n"
+        << "  \"triangles_per_frame\": " << ( trianglesPerFrame != 0 ? std::to_string( trianglesPerFrame ) : "null" ) << ",\n"
+        << "  \"time_to_first_pixel_ms\": " << firstPixelMs.value_or( -1. ) << ",\n"
+        << "  \"mtri_per_s\": ";
+    if( trianglesPerFrame != 0 )
+    {
+        out << mtris;
+    }
+    else
+    {
+        out << "null";
+    }
+    out << "\n"
+        << "}" << std::endl;
+}
+
+/**
+ * Load the model of a headless run, in the background if required
+ * @param[in] model the model to load, none if empty
+ * @param[in] opts the headless options
+ * @return false if the model could not be loaded
+ */
+bool startHeadlessLoading( const string& model, const HeadlessOptions& opts )
+{
+    if( !scene.empty() )
+    {
+        LOG_INFO( Loader, "Scene: " << loadScene() );
+        sceneReady = !scene.empty();
+        return sceneReady;
+    }
+    if( model.empty() )
+    {
+        return true;
+    }
+    if( opts.asyncLoad )
+    {
+        loader.start( model, weldEpsilon );
+        return true;
+    }
+    return loadModel( model );
+}
+
+/**
+ * Wait for the end of the background loading of a headless run
+ * @return false if the loading failed
+ */
+bool finishHeadlessLoading( )
+{
+    if( !loader.busy() )
+    {
+        return true;
+    }
+    loader.wait( );
+    return pollLoading( );
+}
+
+/**
+ * Same as runHeadless() but with the software rasterizer, hence without any OpenGL context
+ * @param[in] model the model to render
+ * @param[in] opts the headless options
+ * @return the exit code of the application
+ */
+int runSoftware( const string& model, const HeadlessOptions& opts )
+{
+    namespace chr = std::chrono;
+
+    SoftwareRasterizer target( win.width, win.height, opts.threads );
+    if( !startHeadlessLoading( model, opts ) )
+    {
+        return EXIT_FAILURE;
+    }
+
+    // the first frame also applies the subdivision, keep it out of the statistics
+    auto start = chr::steady_clock::now();
+    if( loader.busy() && !pollLoading() )
+    {
+        return EXIT_FAILURE;
+    }
+    render_scene( target );
+    const double firstFrame = chr::duration<double, std::milli>( chr::steady_clock::now() - start ).count();
+    recordFirstPixel( );
+    PROFILE_FRAME_END();
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve( opts.frames );
+    RasterStats stages;
+    for( unsigned i = 0; i < opts.frames; ++i )
+    {
+        angle_y = static_cast<int>( ( 360UL * i ) / opts.frames );
+
+        start = chr::steady_clock::now();
+        if( loader.busy() && !pollLoading() )
+        {
+            return EXIT_FAILURE;
+        }
+        render_scene( target );
+        frameTimes.push_back( chr::duration<double, std::milli>( chr::steady_clock::now() - start ).count() );
+        recordFirstPixel( );
+        PROFILE_FRAME_END();
+
+        const auto& stats = target.stats();
+        stages.vertexMs += stats.vertexMs;
+        stages.binningMs += stats.binningMs;
+        stages.rasterMs += stats.rasterMs;
+        stages.culled += stats.culled;
+        stages.hizRejected += stats.hizRejected;
+
+        if( !opts.framePrefix.empty() )
+        {
+            char number[16];
+            std::snprintf( number, sizeof( number ), "%04u", i );
+            if( !writeImage( opts.framePrefix + number + "." + opts.frameFormat, target.image() ) )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if( !finishHeadlessLoading( ) )
+    {
+        return EXIT_FAILURE;
+    }
+
+    const double n = static_cast<double>( opts.frames );
+    std::cout << "stages (avg per frame): vertex " << stages.vertexMs / n << " ms, binning " << stages.binningMs / n
+              << " ms, raster " << stages.rasterMs / n << " ms; culled " << stages.culled / opts.frames
+              << " triangles, " << stages.hizRejected / opts.frames << " blocks rejected by hierarchical depth"
+              << std::endl;
+    reportFrameTimes( frameTimes,
+                      firstFrame,
+                      "software rasterizer (" + std::to_string( target.threads() ) + " threads)",
+                      model,
+                      opts,
+                      target.stats().submitted );
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Render the model offscreen while the camera orbits around it, then report the frame times
+ * @param[in] model the model to render
+ * @param[in] opts the headless options
+ * @return the exit code of the application
+ */
+int runHeadless( const string& model, const HeadlessOptions& opts )
+{
+    if( opts.frames == 0 )
+    {
+        LOG_ERROR( General, "at least one frame is needed" );
+        return EXIT_FAILURE;
+    }
+    if( opts.software )
+    {
+        return runSoftware( model, opts );
+    }
+
+#ifdef RENDERER_WITH_EGL
+    namespace chr = std::chrono;
+
+    OffscreenContext context;
+    if( !context.create( win.width, win.height ) )
+    {
+        return EXIT_FAILURE;
+    }
+    initialize( );
+    if( !startHeadlessLoading( model, opts ) )
+    {
+        return EXIT_FAILURE;
+    }
+
+    // the first frame also applies the subdivision, keep it out of the statistics
+    auto start = chr::steady_clock::now();
+    if( loader.busy() && !pollLoading() )
+    {
+        return EXIT_FAILURE;
+    }
+    render_scene( );
+    glFinish( );
+    const double firstFrame = chr::duration<double, std::milli>( chr::steady_clock::now() - start ).count();
+    recordFirstPixel( );
+    PROFILE_FRAME_END();
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve( opts.frames );
+    Image img{static_cast<unsigned>( win.width ), static_cast<unsigned>( win.height ), {}};
+    for( unsigned i = 0; i < opts.frames; ++i )
+    {
+        angle_y = static_cast<int>( ( 360UL * i ) / opts.frames );
+
+        start = chr::steady_clock::now();
+        if( loader.busy() && !pollLoading() )
+        {
+            return EXIT_FAILURE;
+        }
+        render_scene( );
+        {
+            PROFILE_SCOPE("glFinish");
+            glFinish( );
+        }
+        frameTimes.push_back( chr::duration<double, std::milli>( chr::steady_clock::now() - start ).count() );
+        recordFirstPixel( );
+        PROFILE_FRAME_END();
+
+        if( !opts.framePrefix.empty() )
+        {
+            context.readPixels( img.rgb );
+            char number[16];
+            std::snprintf( number, sizeof( number ), "%04u", i );
+            if( !writeImage( opts.framePrefix + number + "." + opts.frameFormat, img ) )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if( !finishHeadlessLoading( ) )
+    {
+        return EXIT_FAILURE;
+    }
+    // the faces of the model at the drawn level, unknown for a scene or without the solid
+    const size_t triangles = ( !sceneReady && params.solid && !obj.empty() )
+                                 ? obj.level( params.subdivision ? params.subdivLevel : 0 ).faces.size()
+                                 : 0;
+    reportFrameTimes( frameTimes, firstFrame, context.renderer(), model, opts, triangles );
+    return EXIT_SUCCESS;
+#else
+    (void) model;
+    (void) opts;
+    LOG_ERROR( General, "headless mode not available: built without EGL support" );
+    return EXIT_FAILURE;
+#endif
+}
+
+int main( int argc, char **argv )
+{
     // set window values
     win.width = 1024;
     win.height = 760;
     win.title = string("OpenGL/GLUT OBJ Loader.");
+
+    // start the logger first, so that it is destroyed after the exit handlers that may log
+    logging::Logger::instance();
     win.field_of_view_angle = 45;
     win.z_near = 0.25f;
     win.z_far = 500.f;
 
+    vector<string> models;
+    HeadlessOptions headless;
+    bool help{false};
+    if( !parseArguments( argc, argv, models, headless, help ) )
+    {
+        printUsage( argv[0] );
+        return help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // a single model is loaded into obj, several ones or a manifest into the scene
+    string model;
+    if( models.size() > 1 || ( models.size() == 1 && Scene::isManifest( models.front() ) ) )
+    {
+        if( !buildScene( models ) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else if( !models.empty() )
+    {
+        model = models.front();
+    }
+
+#ifdef ENABLE_PROFILER
+    // create the profiler before registering the handler, so that it is destroyed after it runs
+    Profiler::instance();
+    std::atexit( write_trace );
+#endif
+    if( !cacheDirectory.empty() )
+    {
+        cache = std::make_shared<MeshCache>( cacheDirectory, cacheBytes );
+        std::atexit( logCacheStats );
+    }
+
+    if( !exportFile.empty() )
+    {
+        // the model is unitized and repaired as for the display, then subdivided
+        if( model.empty() )
+        {
+            LOG_ERROR( General, "--export needs a single model" );
+            return EXIT_FAILURE;
+        }
+        if( !loadModel( model ) )
+        {
+            return EXIT_FAILURE;
+        }
+        return obj.save( exportFile, params.subdivision ? params.subdivLevel : 0, 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if( watchModel && model.empty() )
+    {
+        LOG_WARNING( General, "--watch needs a single model, it is ignored" );
+        watchModel = false;
+    }
+    if( headless.enabled )
+    {
+        if( watchModel )
+        {
+            LOG_WARNING( General, "--watch is only used by the window, it is ignored" );
+        }
+        return runHeadless( model, headless );
+    }
+
+    if( model.empty() && scene.empty() )
+    {
+      LOG_INFO( General, "No obj file to load, displaying an empty scene with the reference system" );
+      printUsage( argv[0] );
+    }
+
     // initialize and run program
     glutInit( &argc, argv );
     glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH );
@@ -346,23 +1366,28 @@ int main( int argc, char **argv )
     glutSpecialFunc( arrows );
     initialize( );
 
-    if(argc == 2)
+    if( !model.empty() )
     {
-        //***********************************************
-        // Load the obj model from file
-        //***********************************************
-        if(obj.load(argv[1]))
+        // the window is displayed while the model is loaded
+        loader.start( model, weldEpsilon );
+        glutTimerFunc( LOADING_POLL_MS, pollLoadingTimer, 0 );
+        if( watchModel )
         {
-            //***********************************************
-            // Make it unitary
-            //***********************************************
-            obj.unitizeModel();
-        }
-        else
-        {
-            std::cerr << "error while opening the model\n";
+            HotReloader::PrepareFunction repair;
+            if( repairModel )
+            {
+                repair = []( MeshBatch& batch ) { MeshModel::repair( batch, weldEpsilon ); };
+            }
+            reloader = std::make_unique<HotReloader>( model, weldEpsilon, repair );
+            LOG_INFO( Loader, "Watching " << model << ( reloader->notified() ? " with inotify" : " by polling its modification time" ) );
+            glutTimerFunc( WATCH_POLL_MS, watchTimer, 0 );
         }
     }
+    else if( !scene.empty() )
+    {
+        sceneLoading = std::async( std::launch::async, loadScene );
+        glutTimerFunc( LOADING_POLL_MS, pollLoadingTimer, 0 );
+    }
     printKeyboardHelp();
 
     glutMainLoop( );
@@ -403,7 +1428,7 @@ void reshape( int width, int height )
             const auto x_viewport = static_cast<GLint>((static_cast<float>(width) - (float)height * aspect) / 2);
             const auto width_viewport = static_cast<GLint>(static_cast<GLfloat>(height) * aspect);
             glViewport( x_viewport, 0, width_viewport, height );
-            cout << "d " << x_viewport << endl;
+            LOG_DEBUG( Window, "viewport x " << x_viewport );
         }
     }
 }
@@ -452,6 +1477,30 @@ void DrawAxis( float scale )
     glPopMatrix( );
 }
 
+void DrawAxis( SoftwareRasterizer& target, float scale )
+{
+    const auto line = [&target, scale]( const point3d& a, const point3d& b, const v3f& color ) {
+        target.drawLine( a * scale, b * scale, color );
+    };
+    const v3f red{1.f, .0f, .0f};
+    const v3f green{.0f, 1.f, .0f};
+    const v3f blue{.0f, .0f, 1.f};
+
+    /*  X axis and letter X */
+    line( {.0f, .0f, .0f}, {1.f, .0f, .0f}, red );
+    line( {.8f, 0.05f, .0f}, {1.f, 0.25f, .0f}, red );
+    line( {.8f, 0.25f, .0f}, {1.f, 0.05f, .0f}, red );
+
+    /*  Y axis */
+    line( {.0f, .0f, .0f}, {.0f, 1.f, .0f}, green );
+
+    /*  Z axis and letter Z */
+    line( {.0f, .0f, .0f}, {.0f, .0f, 1.f}, blue );
+    line( {.0f, 0.05f, .8f}, {.0f, 0.05f, 1.f}, blue );
+    line( {.0f, 0.05f, 1.f}, {.0f, 0.25f, .8f}, blue );
+    line( {.0f, 0.25f, .8f}, {.0f, 0.25f, 1.f}, blue );
+}
+
 void initialize( )
 {
     glMatrixMode( GL_MODELVIEW );
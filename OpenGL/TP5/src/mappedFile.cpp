@@ -0,0 +1,115 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mappedFile.hpp"
+#include "logger.hpp"
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)),
+      _mapped(std::exchange(other._mapped, false)), _buffer(std::move(other._buffer))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if(this != &other)
+    {
+        close();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _mapped = std::exchange(other._mapped, false);
+        _buffer = std::move(other._buffer);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+#ifdef MAPPED_FILE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        LOG_ERROR(Loader, "Unable to open file " << filename);
+        return false;
+    }
+    struct stat info{};
+    if(::fstat(fd, &info) != 0)
+    {
+        LOG_ERROR(Loader, "Unable to read the size of " << filename);
+        ::close(fd);
+        return false;
+    }
+    _size = static_cast<std::size_t>(info.st_size);
+    if(_size > 0)
+    {
+        void* p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED)
+        {
+            // the loaders read the file once from the beginning to the end
+            ::madvise(p, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const char*>(p);
+            _mapped = true;
+        }
+    }
+    ::close(fd);
+    if(_size == 0 || _mapped)
+    {
+        return true;
+    }
+    // eg a pipe or a file system without mmap: read it instead
+    LOG_DEBUG(Loader, "Unable to map " << filename << ", reading it");
+    _size = 0;
+#endif
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if(!in.is_open())
+    {
+        LOG_ERROR(Loader, "Unable to open file " << filename);
+        return false;
+    }
+    _buffer.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    if(!in.read(_buffer.data(), static_cast<std::streamsize>(_buffer.size())))
+    {
+        LOG_ERROR(Loader, "Error while reading " << filename);
+        _buffer.clear();
+        return false;
+    }
+    _data = _buffer.empty() ? nullptr : _buffer.data();
+    _size = _buffer.size();
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_MMAP
+    if(_mapped)
+    {
+        ::munmap(const_cast<char*>(_data), _size);
+    }
+#endif
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+}
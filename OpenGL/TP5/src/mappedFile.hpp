@@ -0,0 +1,54 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * A read-only view of the whole content of a file. The file is mapped in memory where mmap is
+ * available, so that the loaders parse the page cache directly without copying it in a buffer;
+ * on the other platforms it is read in a buffer.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * Map a file, the file previously mapped is released
+     * @param[in] filename the name of the file
+     * @return true if everything went well, false otherwise
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * Release the file
+     */
+    void close();
+
+    /// the first byte of the file, nullptr if it is empty
+    [[nodiscard]] const char* data() const { return _data; }
+    /// the size of the file in bytes
+    [[nodiscard]] std::size_t size() const { return _size; }
+    /// true if the content comes from mmap, false if it has been read in a buffer
+    [[nodiscard]] bool isMapped() const { return _mapped; }
+
+private:
+    const char* _data{nullptr};
+    std::size_t _size{0};
+    bool _mapped{false};
+    /// the content of the file when it cannot be mapped
+    std::vector<char> _buffer{};
+};
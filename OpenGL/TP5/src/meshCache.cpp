@@ -0,0 +1,408 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "meshCache.hpp"
+#include "logger.hpp"
+#include "mappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+namespace {
+
+/// the constants of the mixing, from MurmurHash3
+constexpr std::uint64_t MIX_1{0x87c37b91114253d5ULL};
+constexpr std::uint64_t MIX_2{0x4cf5ad432745937fULL};
+
+/// the number of faces widened at once to hash the 16-bit indices
+constexpr std::size_t HASH_BLOCK_FACES{4096};
+
+/// the extension of the entries
+const std::string ENTRY_EXTENSION{".mcache"};
+
+/**
+ * The header of an entry, followed by the vertices, the normals if any and the faces
+ */
+struct EntryHeader
+{
+    /// identifies the files of the cache and the version of the format
+    std::array<char, 8> magic{'M', 'C', 'A', 'C', 'H', 'E', '0', '1'};
+    /// the key of the entry, against the collisions of the file names
+    std::uint64_t key{0};
+    /// the number of vertices
+    std::uint64_t numVertices{0};
+    /// the number of faces
+    std::uint64_t numFaces{0};
+    /// the size of an index, 2 or 4
+    std::uint32_t indexBytes{0};
+    /// 1 if there is a normal per vertex
+    std::uint32_t hasNormals{0};
+};
+static_assert(sizeof(EntryHeader) == 40, "the header must not have padding");
+
+constexpr std::uint64_t rotateLeft(std::uint64_t x, unsigned bits) { return (x << bits) | (x >> (64U - bits)); }
+
+/// the finalization of MurmurHash3, every bit of the input changes half the bits of the output
+constexpr std::uint64_t finalMix(std::uint64_t x)
+{
+    x ^= x >> 33U;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33U;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33U;
+    return x;
+}
+
+/**
+ * Return the size of an entry
+ * @param[in] header the header of the entry
+ * @return the size of the file in bytes
+ */
+std::uint64_t entryBytes(const EntryHeader& header)
+{
+    return sizeof(EntryHeader) + header.numVertices * sizeof(point3d) * (header.hasNormals != 0 ? 2U : 1U)
+           + header.numFaces * 3U * header.indexBytes;
+}
+
+/**
+ * Check that the counts of a header are bounded by the size of its file, so that entryBytes
+ * cannot overflow with a damaged header
+ * @param[in] header the header of the entry, with a valid indexBytes
+ * @param[in] fileSize the size of the file in bytes
+ * @return true if each array of the header fits in the file
+ */
+bool countsFit(const EntryHeader& header, std::uint64_t fileSize)
+{
+    return header.numVertices <= fileSize / (sizeof(point3d) * (header.hasNormals != 0 ? 2U : 1U))
+           && header.numFaces <= fileSize / (3U * header.indexBytes);
+}
+
+/**
+ * Write bytes in a file
+ * @return true if everything has been written
+ */
+bool writeBytes(std::FILE* file, const void* data, std::size_t size)
+{
+    return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+/**
+ * Copy an array of the mapped file into a vector
+ * @param[in,out] cursor the position in the file, moved after the array
+ * @param[in] count the number of elements
+ * @param[out] values the elements
+ */
+template<typename T>
+void readArray(const char*& cursor, std::size_t count, std::vector<T>& values)
+{
+    values.resize(count);
+    if(count > 0)
+    {
+        std::memcpy(values.data(), cursor, count * sizeof(T));
+    }
+    cursor += count * sizeof(T);
+}
+
+} // namespace
+
+void MeshHasher::addWord(std::uint64_t word)
+{
+    word *= MIX_1;
+    word = rotateLeft(word, 31U);
+    word *= MIX_2;
+    _state ^= word;
+    _state = rotateLeft(_state, 27U) * 5U + 0x52dce729U;
+}
+
+void MeshHasher::add(const void* data, std::size_t size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    _length += size;
+    // complete the word started by the previous call
+    while(_tailSize > 0 && _tailSize < sizeof(std::uint64_t) && size > 0)
+    {
+        _tail |= std::uint64_t{*bytes++} << (8U * _tailSize++);
+        --size;
+    }
+    if(_tailSize == sizeof(std::uint64_t))
+    {
+        addWord(_tail);
+        _tail = 0;
+        _tailSize = 0;
+    }
+    for(; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t), bytes += sizeof(std::uint64_t))
+    {
+        std::uint64_t word{0};
+        std::memcpy(&word, bytes, sizeof(word));
+        addWord(word);
+    }
+    for(; size > 0; --size)
+    {
+        _tail |= std::uint64_t{*bytes++} << (8U * _tailSize++);
+    }
+}
+
+std::uint64_t MeshHasher::value() const
+{
+    std::uint64_t state = _state;
+    if(_tailSize > 0)
+    {
+        state ^= rotateLeft(_tail * MIX_1, 31U) * MIX_2;
+    }
+    return finalMix(state ^ _length);
+}
+
+std::uint64_t hashMesh(const std::vector<point3d>& vertices, const FaceList& faces)
+{
+    MeshHasher hasher;
+    hasher.addValue(std::uint64_t{vertices.size()});
+    hasher.add(vertices.data(), vertices.size() * sizeof(point3d));
+    hasher.addValue(std::uint64_t{faces.size()});
+    faces.visit([&hasher](const auto& list) {
+        if constexpr(sizeof(list.front()) == sizeof(face))
+        {
+            hasher.add(list.data(), list.size() * sizeof(face));
+        }
+        else
+        {
+            std::vector<face> wide;
+            wide.reserve(std::min(list.size(), HASH_BLOCK_FACES));
+            for(std::size_t begin = 0; begin < list.size(); begin += HASH_BLOCK_FACES)
+            {
+                const std::size_t end = std::min(list.size(), begin + HASH_BLOCK_FACES);
+                wide.clear();
+                for(std::size_t i = begin; i < end; ++i)
+                {
+                    wide.emplace_back(list[i].v1, list[i].v2, list[i].v3);
+                }
+                hasher.add(wide.data(), wide.size() * sizeof(face));
+            }
+        }
+    });
+    return hasher.value();
+}
+
+std::uint64_t hashMesh(const std::vector<point3d>& vertices, const std::vector<face>& faces)
+{
+    MeshHasher hasher;
+    hasher.addValue(std::uint64_t{vertices.size()});
+    hasher.add(vertices.data(), vertices.size() * sizeof(point3d));
+    hasher.addValue(std::uint64_t{faces.size()});
+    hasher.add(faces.data(), faces.size() * sizeof(face));
+    return hasher.value();
+}
+
+MeshCache::MeshCache(const std::string& directory, std::uint64_t maxBytes) : _directory(directory), _maxBytes(maxBytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(_directory, error);
+    if(error)
+    {
+        LOG_WARNING(Loader, "Unable to create the cache directory " << directory << ": " << error.message());
+    }
+}
+
+std::uint64_t MeshCache::key(std::uint64_t geometry, const std::string& operation, std::uint64_t parameter)
+{
+    MeshHasher hasher(geometry);
+    hasher.add(operation.data(), operation.size());
+    hasher.addValue(parameter);
+    return hasher.value();
+}
+
+std::filesystem::path MeshCache::entryPath(std::uint64_t key) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ENTRY_EXTENSION;
+    return _directory / name.str();
+}
+
+bool MeshCache::contains(std::uint64_t key) const
+{
+    std::error_code error;
+    return std::filesystem::exists(entryPath(key), error);
+}
+
+bool MeshCache::load(std::uint64_t key, MeshLevel& level)
+{
+    const std::filesystem::path path = entryPath(key);
+    MappedFile file;
+    EntryHeader header;
+    bool valid = std::filesystem::exists(path) && file.open(path.string()) && file.size() >= sizeof(EntryHeader);
+    if(valid)
+    {
+        std::memcpy(&header, file.data(), sizeof(header));
+        valid = header.magic == EntryHeader{}.magic && header.key == key && (header.indexBytes == 2 || header.indexBytes == 4)
+                && countsFit(header, file.size()) && entryBytes(header) == file.size();
+        if(!valid)
+        {
+            LOG_WARNING(Loader, "Invalid cache entry " << path << ", it is ignored");
+        }
+    }
+    if(!valid)
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.misses;
+        return false;
+    }
+
+    const char* cursor = file.data() + sizeof(EntryHeader);
+    readArray(cursor, header.numVertices, level.vertices);
+    if(header.hasNormals != 0)
+    {
+        readArray(cursor, header.numVertices, level.normals);
+    }
+    else
+    {
+        level.normals.clear();
+    }
+    if(header.indexBytes == 2)
+    {
+        readArray(cursor, header.numFaces, level.faces.emplace<idx16type>());
+    }
+    else
+    {
+        readArray(cursor, header.numFaces, level.faces.emplace<idxtype>());
+    }
+
+    // the entry becomes the most recently used one
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    const std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.hits;
+    _stats.bytesRead += file.size();
+    return true;
+}
+
+bool MeshCache::store(std::uint64_t key, const MeshLevel& level)
+{
+    const std::filesystem::path path = entryPath(key);
+    std::error_code error;
+    if(std::filesystem::exists(path, error))
+    {
+        return true;
+    }
+    EntryHeader header;
+    header.key = key;
+    header.numVertices = level.vertices.size();
+    header.numFaces = level.faces.size();
+    header.indexBytes = level.faces.is16() ? 2U : 4U;
+    header.hasNormals = (level.normals.size() == level.vertices.size()) ? 1U : 0U;
+    const std::uint64_t bytes = entryBytes(header);
+    if(bytes > _maxBytes)
+    {
+        return false;
+    }
+
+    // written aside then renamed, so that the other processes never see an incomplete entry
+    std::ostringstream suffix;
+    suffix << ".tmp" << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "-"
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+    const std::filesystem::path temporary = path.string() + suffix.str();
+    std::FILE* file = std::fopen(temporary.string().c_str(), "wb");
+    if(file == nullptr)
+    {
+        LOG_WARNING(Loader, "Unable to write the cache entry " << temporary);
+        return false;
+    }
+    bool written = writeBytes(file, &header, sizeof(header))
+                   && writeBytes(file, level.vertices.data(), level.vertices.size() * sizeof(point3d))
+                   && (header.hasNormals == 0 || writeBytes(file, level.normals.data(), level.normals.size() * sizeof(vec3d)))
+                   && level.faces.visit([file](const auto& faces) {
+                          return writeBytes(file, faces.data(), faces.size() * sizeof(faces.front()));
+                      });
+    written = (std::fclose(file) == 0) && written;
+    if(written)
+    {
+        std::filesystem::rename(temporary, path, error);
+        written = !error;
+    }
+    if(!written)
+    {
+        LOG_WARNING(Loader, "Unable to write the cache entry " << path);
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.stores;
+    _stats.bytesWritten += bytes;
+    evict();
+    return true;
+}
+
+MeshCacheStats MeshCache::stats() const
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+std::uint64_t MeshCache::diskBytes() const
+{
+    std::uint64_t total{0};
+    std::error_code error;
+    for(const auto& entry : std::filesystem::directory_iterator(_directory, error))
+    {
+        if(entry.path().extension() == ENTRY_EXTENSION)
+        {
+            total += entry.file_size(error);
+        }
+    }
+    return total;
+}
+
+void MeshCache::evict()
+{
+    std::vector<std::tuple<std::filesystem::file_time_type, std::uint64_t, std::filesystem::path>> entries;
+    std::uint64_t total{0};
+    std::error_code error;
+    for(const auto& entry : std::filesystem::directory_iterator(_directory, error))
+    {
+        if(entry.path().extension() != ENTRY_EXTENSION)
+        {
+            continue;
+        }
+        const std::uint64_t size = entry.file_size(error);
+        if(!error)
+        {
+            entries.emplace_back(entry.last_write_time(error), size, entry.path());
+            total += size;
+        }
+    }
+    if(total <= _maxBytes)
+    {
+        return;
+    }
+    // the least recently used first
+    std::sort(entries.begin(), entries.end());
+    for(const auto& [time, size, path] : entries)
+    {
+        if(total <= _maxBytes)
+        {
+            break;
+        }
+        // another process may have removed it already
+        if(std::filesystem::remove(path, error))
+        {
+            ++_stats.evictions;
+        }
+        total -= size;
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const MeshCacheStats& s)
+{
+    return os << s.hits << " hits, " << s.misses << " misses, " << s.stores << " stores, " << s.evictions
+              << " evictions, " << s.bytesRead << " bytes read, " << s.bytesWritten << " bytes written";
+}
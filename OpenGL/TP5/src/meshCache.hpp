@@ -0,0 +1,199 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// the default maximum size of a cache directory, 1 GiB
+constexpr std::uint64_t DEFAULT_MESH_CACHE_BYTES{std::uint64_t{1} << 30U};
+/// the operation of the levels of Loop subdivision in the cache, the parameter being the level: to change with the algorithm
+constexpr const char* LOOP_CACHE_OPERATION{"loop-2"};
+
+/**
+ * A fast non-cryptographic 64-bit hash of a stream of bytes, to identify meshes. The result only
+ * depends on the bytes, not on how they are split between the calls to add.
+ */
+class MeshHasher
+{
+public:
+    /**
+     * Start a hash
+     * @param[in] seed the initial state, eg to tell apart the hashes of different kinds of data
+     */
+    explicit MeshHasher(std::uint64_t seed = 0) : _state(seed) { }
+
+    /**
+     * Add bytes to the hash
+     * @param[in] data the bytes
+     * @param[in] size the number of bytes
+     */
+    void add(const void* data, std::size_t size);
+
+    /**
+     * Add the bytes of a value to the hash, eg a parameter
+     * @param[in] value the value, a type without padding
+     */
+    template<typename T>
+    void addValue(const T& value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    /// the hash of the bytes added so far
+    [[nodiscard]] std::uint64_t value() const;
+
+private:
+    /// mix a word of 8 bytes into the state
+    void addWord(std::uint64_t word);
+
+    /// the state after the complete words
+    std::uint64_t _state{0};
+    /// the bytes of the last incomplete word
+    std::uint64_t _tail{0};
+    /// the number of bytes in _tail
+    std::size_t _tailSize{0};
+    /// the number of bytes added
+    std::uint64_t _length{0};
+};
+
+/**
+ * Return the hash of the geometry of a mesh: the positions and the faces, the indices being hashed
+ * as 32-bit values so that the result does not depend on the width of the indices
+ * @param[in] vertices the vertices
+ * @param[in] faces the faces
+ * @return the hash
+ */
+std::uint64_t hashMesh(const std::vector<point3d>& vertices, const FaceList& faces);
+
+/**
+ * Return the hash of the geometry of a mesh with 32-bit indices, the same as for a FaceList
+ * @param[in] vertices the vertices
+ * @param[in] faces the faces
+ * @return the hash
+ */
+std::uint64_t hashMesh(const std::vector<point3d>& vertices, const std::vector<face>& faces);
+
+/**
+ * The counters of a cache since it has been created
+ */
+struct MeshCacheStats
+{
+    /// the entries found
+    std::size_t hits{0};
+    /// the entries not found, or found invalid
+    std::size_t misses{0};
+    /// the entries written
+    std::size_t stores{0};
+    /// the entries removed to keep the cache under its maximum size
+    std::size_t evictions{0};
+    /// the size of the entries read
+    std::uint64_t bytesRead{0};
+    /// the size of the entries written
+    std::uint64_t bytesWritten{0};
+};
+
+/**
+ * A content-addressed cache of processed meshes on disk, eg the levels of subdivision. Each entry
+ * is a file named after its key, a hash of the input geometry and of the parameters of the
+ * processing, holding the vertices, the normals and the faces as raw arrays: it is read by mapping
+ * the file, and written to a temporary file renamed at the end, so that several processes, or
+ * machines sharing the directory, can use the same cache. The entries are evicted in least recently
+ * used order, by modification time, when the directory exceeds its maximum size.
+ */
+class MeshCache
+{
+public:
+    /**
+     * Open a cache directory, it is created if needed
+     * @param[in] directory the directory of the entries
+     * @param[in] maxBytes the maximum size of the entries
+     */
+    explicit MeshCache(const std::string& directory, std::uint64_t maxBytes = DEFAULT_MESH_CACHE_BYTES);
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    /**
+     * Return the key of a processing of a mesh
+     * @param[in] geometry the hash of the input geometry, see hashMesh
+     * @param[in] operation the name and the version of the processing, eg LOOP_CACHE_OPERATION
+     * @param[in] parameter the parameter of the processing, eg the level of subdivision
+     * @return the key
+     */
+    static std::uint64_t key(std::uint64_t geometry, const std::string& operation, std::uint64_t parameter);
+
+    /**
+     * Return true if an entry is in the cache, without reading it nor counting a hit or a miss
+     * @param[in] key the key of the entry
+     * @return true if the entry exists
+     */
+    [[nodiscard]] bool contains(std::uint64_t key) const;
+
+    /**
+     * Read an entry
+     * @param[in] key the key of the entry
+     * @param[out] level the mesh of the entry, unchanged if it is not found
+     * @return true if the entry has been found, false otherwise (a miss)
+     */
+    bool load(std::uint64_t key, MeshLevel& level);
+
+    /**
+     * Write an entry, unless it is already there or larger than the cache, then evict the least
+     * recently used entries above the maximum size
+     * @param[in] key the key of the entry
+     * @param[in] level the mesh
+     * @return true if the entry is in the cache
+     */
+    bool store(std::uint64_t key, const MeshLevel& level);
+
+    /// the counters since the cache has been created
+    [[nodiscard]] MeshCacheStats stats() const;
+
+    /// the directory of the entries
+    [[nodiscard]] const std::filesystem::path& directory() const { return _directory; }
+
+    /// the maximum size of the entries in bytes
+    [[nodiscard]] std::uint64_t maxBytes() const { return _maxBytes; }
+
+    /**
+     * Return the size of the entries on disk, by listing the directory
+     * @return the size in bytes
+     */
+    [[nodiscard]] std::uint64_t diskBytes() const;
+
+private:
+    /// the file of an entry
+    [[nodiscard]] std::filesystem::path entryPath(std::uint64_t key) const;
+
+    /// remove the oldest entries until the cache fits in its maximum size
+    void evict();
+
+    /// the directory of the entries
+    std::filesystem::path _directory{};
+    /// the maximum size of the entries
+    std::uint64_t _maxBytes{DEFAULT_MESH_CACHE_BYTES};
+    /// protects the counters and the eviction, when the cache is shared by several models
+    mutable std::mutex _mutex{};
+    /// the counters
+    MeshCacheStats _stats{};
+};
+
+/**
+ * Print the counters on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] s the counters
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const MeshCacheStats& s);
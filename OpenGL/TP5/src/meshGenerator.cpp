@@ -0,0 +1,433 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "meshGenerator.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// the maximum number of vertices, the indices are 32-bit
+constexpr std::uint64_t MAX_VERTICES{std::uint64_t{std::numeric_limits<idxtype>::max()} + 1};
+
+constexpr float TWO_PI{6.28318530717958647692f};
+
+bool checkSize(std::uint64_t numVertices, const char* generator)
+{
+    if(numVertices > MAX_VERTICES)
+    {
+        LOG_ERROR(General, generator << ": " << numVertices << " vertices exceed the 32-bit indices");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The splitmix64 mixing function: a good quality hash, so that every random value can be computed
+ * independently from its index
+ */
+std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27U)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31U);
+}
+
+std::uint64_t hash(std::uint64_t seed, std::uint64_t a, std::uint64_t b = 0, std::uint64_t c = 0)
+{
+    return mix(mix(mix(mix(seed) ^ a) ^ b) ^ c);
+}
+
+/**
+ * Return a float in [-1, 1] from a hash
+ */
+float toUnit(std::uint64_t h)
+{
+    return static_cast<float>(h >> 40U) / static_cast<float>(1U << 23U) - 1.f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// icosphere
+
+const std::array<point3d, 12>& icosahedronVertices()
+{
+    static const std::array<point3d, 12> vertices = [] {
+        const float t = (1.f + std::sqrt(5.f)) / 2.f;
+        std::array<point3d, 12> res{point3d{-1, t, 0}, point3d{1, t, 0},  point3d{-1, -t, 0}, point3d{1, -t, 0},
+                                    point3d{0, -1, t}, point3d{0, 1, t},  point3d{0, -1, -t}, point3d{0, 1, -t},
+                                    point3d{t, 0, -1}, point3d{t, 0, 1},  point3d{-t, 0, -1}, point3d{-t, 0, 1}};
+        for(auto& v : res)
+        {
+            v.normalize();
+        }
+        return res;
+    }();
+    return vertices;
+}
+
+/// the faces of the icosahedron, counter-clockwise seen from outside
+constexpr std::array<std::array<idxtype, 3>, 20> ICOSAHEDRON_FACES{{{0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10},
+                                                                   {0, 10, 11}, {1, 5, 9},  {5, 11, 4},  {11, 10, 2},
+                                                                   {10, 7, 6},  {7, 1, 8},  {3, 9, 4},   {3, 4, 2},
+                                                                   {3, 2, 6},   {3, 6, 8},  {3, 8, 9},   {4, 9, 5},
+                                                                   {2, 4, 11},  {6, 2, 10}, {8, 6, 7},   {9, 8, 1}}};
+
+/**
+ * The analytic indexing of the vertices of the subdivided icosahedron: first the 12 corners, then
+ * the frequency - 1 points inside each of the 30 edges, then the points inside each of the 20 faces
+ */
+class IcosphereIndexing
+{
+public:
+    explicit IcosphereIndexing(std::uint32_t frequency) : _n(frequency)
+    {
+        // number the edges in the order of their first appearance
+        for(std::size_t f = 0; f < ICOSAHEDRON_FACES.size(); ++f)
+        {
+            for(std::size_t k = 0; k < 3; ++k)
+            {
+                const idxtype a = ICOSAHEDRON_FACES[f][k];
+                const idxtype b = ICOSAHEDRON_FACES[f][(k + 1) % 3];
+                const edge e{std::min(a, b), std::max(a, b)};
+                const auto it = std::find(_edges.begin(), _edges.begin() + _numEdges, e);
+                if(it == _edges.begin() + _numEdges)
+                {
+                    _edges[_numEdges++] = e;
+                }
+                _faceEdges[f][k] = static_cast<std::size_t>(it - _edges.begin());
+            }
+        }
+    }
+
+    [[nodiscard]] const std::array<edge, 30>& edges() const { return _edges; }
+
+    [[nodiscard]] std::uint64_t numVertices() const { return 10ULL * _n * _n + 2; }
+    [[nodiscard]] std::uint64_t numFaces() const { return 20ULL * _n * _n; }
+
+    /**
+     * Return the index of the k-th point (1 <= k < n) inside the edge id, counted from the corner x
+     */
+    [[nodiscard]] std::uint64_t edgeVertex(std::size_t id, idxtype x, std::uint64_t k) const
+    {
+        // the points of an edge are numbered from its smallest corner
+        const std::uint64_t fromFirst = (x == _edges[id].first) ? k : _n - k;
+        return 12 + id * (_n - 1) + (fromFirst - 1);
+    }
+
+    /**
+     * Return the index of the point inside the face f (i, j >= 1, i + j < n)
+     */
+    [[nodiscard]] std::uint64_t interiorVertex(std::uint64_t f, std::uint64_t i, std::uint64_t j) const
+    {
+        const std::uint64_t perFace = (_n - 1) * (_n - 2) / 2;
+        const std::uint64_t rowOffset = (j - 1) * (_n - 1) - (j - 1) * j / 2;
+        return 12 + 30 * (_n - 1) + f * perFace + rowOffset + (i - 1);
+    }
+
+    /**
+     * Return the index of the lattice point (i, j) of the face f, ie the point
+     * (A * (n - i - j) + B * i + C * j) / n where A, B, C are the corners of the face
+     */
+    [[nodiscard]] idxtype latticeVertex(std::size_t f, std::uint64_t i, std::uint64_t j) const
+    {
+        const auto& [a, b, c] = ICOSAHEDRON_FACES[f];
+        std::uint64_t res{0};
+        if(i == 0 && j == 0)
+        {
+            res = a;
+        }
+        else if(i == _n)
+        {
+            res = b;
+        }
+        else if(j == _n)
+        {
+            res = c;
+        }
+        else if(j == 0)
+        {
+            res = edgeVertex(_faceEdges[f][0], a, i);
+        }
+        else if(i == 0)
+        {
+            res = edgeVertex(_faceEdges[f][2], a, j);
+        }
+        else if(i + j == _n)
+        {
+            res = edgeVertex(_faceEdges[f][1], b, j);
+        }
+        else
+        {
+            res = interiorVertex(f, i, j);
+        }
+        return static_cast<idxtype>(res);
+    }
+
+private:
+    std::uint64_t _n;
+    std::array<edge, 30> _edges{};
+    std::size_t _numEdges{0};
+    /// the edges AB, BC and CA of each face
+    std::array<std::array<std::size_t, 3>, 20> _faceEdges{};
+};
+
+/**
+ * Return the point of the unit sphere above the point p
+ */
+point3d project(point3d p)
+{
+    p.normalize();
+    return p;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// noise
+
+float smooth(float t)
+{
+    return t * t * (3.f - 2.f * t);
+}
+
+/**
+ * Value noise in [-1, 1] on the integer lattice
+ */
+float valueNoise(std::uint64_t seed, std::uint64_t octave, float x, float y)
+{
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    // the lattice coordinates can be negative: shift them before hashing
+    const auto ix = static_cast<std::uint64_t>(static_cast<std::int64_t>(fx) + (1LL << 32));
+    const auto iy = static_cast<std::uint64_t>(static_cast<std::int64_t>(fy) + (1LL << 32));
+    const float tx = smooth(x - fx);
+    const float ty = smooth(y - fy);
+    const float v00 = toUnit(hash(seed, octave, ix, iy));
+    const float v10 = toUnit(hash(seed, octave, ix + 1, iy));
+    const float v01 = toUnit(hash(seed, octave, ix, iy + 1));
+    const float v11 = toUnit(hash(seed, octave, ix + 1, iy + 1));
+    const float bottom = v00 + (v10 - v00) * tx;
+    const float top = v01 + (v11 - v01) * tx;
+    return bottom + (top - bottom) * ty;
+}
+
+/**
+ * Fractal noise in [-1, 1]: sum of octaves of value noise of doubling frequency and halving amplitude
+ */
+float fractalNoise(std::uint64_t seed, float x, float y)
+{
+    constexpr std::uint64_t OCTAVES{5};
+    constexpr float BASE_FREQUENCY{2.f};
+    float sum{0};
+    float norm{0};
+    float amplitude{1};
+    float frequency{BASE_FREQUENCY};
+    for(std::uint64_t o = 0; o < OCTAVES; ++o)
+    {
+        sum += amplitude * valueNoise(seed, o, x * frequency, y * frequency);
+        norm += amplitude;
+        amplitude *= .5f;
+        frequency *= 2.f;
+    }
+    return sum / norm;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// soup
+
+/// the number of triangles of a cluster of the soup, the first one is the base of the fins
+constexpr std::uint64_t SOUP_CLUSTER{8};
+/// the size of the triangles of the soup
+constexpr float SOUP_TRIANGLE_SIZE{.05f};
+
+point3d soupVertex(std::uint64_t seed, std::uint64_t index)
+{
+    const std::uint64_t cluster = index / (3 * SOUP_CLUSTER);
+    const point3d center{.9f * toUnit(hash(seed, 1, cluster, 0)), .9f * toUnit(hash(seed, 1, cluster, 1)),
+                         .9f * toUnit(hash(seed, 1, cluster, 2))};
+    const point3d offset{toUnit(hash(seed, 2, index, 0)), toUnit(hash(seed, 2, index, 1)),
+                         toUnit(hash(seed, 2, index, 2))};
+    return center + offset * SOUP_TRIANGLE_SIZE;
+}
+
+} // namespace
+
+bool generateIcosphere(std::uint32_t frequency, MeshSink& sink)
+{
+    if(frequency < 1)
+    {
+        LOG_ERROR(General, "icosphere: the frequency must be at least 1");
+        return false;
+    }
+    const IcosphereIndexing indexing(frequency);
+    if(!checkSize(indexing.numVertices(), "icosphere") || !sink.begin(indexing.numVertices(), indexing.numFaces()))
+    {
+        return false;
+    }
+    const auto& corners = icosahedronVertices();
+    const std::uint32_t n = frequency;
+    const auto fn = static_cast<float>(n);
+
+    // the vertices, in the order of IcosphereIndexing
+    for(const auto& c : corners)
+    {
+        sink.vertex(c);
+    }
+    for(const auto& e : indexing.edges())
+    {
+        for(std::uint32_t k = 1; k < n; ++k)
+        {
+            const float w = static_cast<float>(k) / fn;
+            sink.vertex(project(corners[e.first] * (1.f - w) + corners[e.second] * w));
+        }
+    }
+    for(const auto& [a, b, c] : ICOSAHEDRON_FACES)
+    {
+        for(std::uint32_t j = 1; j + 1 < n; ++j)
+        {
+            for(std::uint32_t i = 1; i + j < n; ++i)
+            {
+                const float wb = static_cast<float>(i) / fn;
+                const float wc = static_cast<float>(j) / fn;
+                sink.vertex(project(corners[a] * (1.f - wb - wc) + corners[b] * wb + corners[c] * wc));
+            }
+        }
+    }
+
+    // the faces: n^2 triangles per face of the icosahedron
+    for(std::size_t f = 0; f < ICOSAHEDRON_FACES.size(); ++f)
+    {
+        for(std::uint32_t j = 0; j < n; ++j)
+        {
+            for(std::uint32_t i = 0; i + j < n; ++i)
+            {
+                sink.face({indexing.latticeVertex(f, i, j), indexing.latticeVertex(f, i + 1, j),
+                           indexing.latticeVertex(f, i, j + 1)});
+                if(i + j + 1 < n)
+                {
+                    sink.face({indexing.latticeVertex(f, i + 1, j), indexing.latticeVertex(f, i + 1, j + 1),
+                               indexing.latticeVertex(f, i, j + 1)});
+                }
+            }
+        }
+    }
+    return sink.end();
+}
+
+bool generateTorus(std::uint32_t majorSegments,
+                   std::uint32_t minorSegments,
+                   float majorRadius,
+                   float minorRadius,
+                   MeshSink& sink)
+{
+    if(majorSegments < 3 || minorSegments < 3)
+    {
+        LOG_ERROR(General, "torus: at least 3 segments are needed along each circle");
+        return false;
+    }
+    const std::uint64_t numVertices = std::uint64_t{majorSegments} * minorSegments;
+    if(!checkSize(numVertices, "torus") || !sink.begin(numVertices, 2 * numVertices))
+    {
+        return false;
+    }
+    for(std::uint32_t u = 0; u < majorSegments; ++u)
+    {
+        const float theta = TWO_PI * static_cast<float>(u) / static_cast<float>(majorSegments);
+        for(std::uint32_t v = 0; v < minorSegments; ++v)
+        {
+            const float phi = TWO_PI * static_cast<float>(v) / static_cast<float>(minorSegments);
+            const float r = majorRadius + minorRadius * std::cos(phi);
+            sink.vertex({r * std::cos(theta), r * std::sin(theta), minorRadius * std::sin(phi)});
+        }
+    }
+    const auto index = [minorSegments](std::uint64_t u, std::uint64_t v) {
+        return static_cast<idxtype>(u * minorSegments + v);
+    };
+    for(std::uint32_t u = 0; u < majorSegments; ++u)
+    {
+        const std::uint32_t nu = (u + 1) % majorSegments;
+        for(std::uint32_t v = 0; v < minorSegments; ++v)
+        {
+            const std::uint32_t nv = (v + 1) % minorSegments;
+            sink.face({index(u, v), index(nu, v), index(nu, nv)});
+            sink.face({index(u, v), index(nu, nv), index(u, nv)});
+        }
+    }
+    return sink.end();
+}
+
+bool generateNoiseGrid(std::uint32_t nx, std::uint32_t ny, float amplitude, std::uint64_t seed, MeshSink& sink)
+{
+    if(nx < 1 || ny < 1)
+    {
+        LOG_ERROR(General, "grid: at least one cell is needed along each axis");
+        return false;
+    }
+    const std::uint64_t numVertices = (std::uint64_t{nx} + 1) * (std::uint64_t{ny} + 1);
+    if(!checkSize(numVertices, "grid") || !sink.begin(numVertices, 2ULL * nx * ny))
+    {
+        return false;
+    }
+    for(std::uint32_t j = 0; j <= ny; ++j)
+    {
+        const float y = -1.f + 2.f * static_cast<float>(j) / static_cast<float>(ny);
+        for(std::uint32_t i = 0; i <= nx; ++i)
+        {
+            const float x = -1.f + 2.f * static_cast<float>(i) / static_cast<float>(nx);
+            sink.vertex({x, y, amplitude * fractalNoise(seed, x, y)});
+        }
+    }
+    const auto index = [nx](std::uint64_t i, std::uint64_t j) { return static_cast<idxtype>(j * (nx + 1ULL) + i); };
+    for(std::uint32_t j = 0; j < ny; ++j)
+    {
+        for(std::uint32_t i = 0; i < nx; ++i)
+        {
+            sink.face({index(i, j), index(i + 1, j), index(i + 1, j + 1)});
+            sink.face({index(i, j), index(i + 1, j + 1), index(i, j + 1)});
+        }
+    }
+    return sink.end();
+}
+
+bool generateSoup(std::uint64_t numFaces, std::uint64_t seed, MeshSink& sink)
+{
+    const std::uint64_t numVertices = 3 * numFaces;
+    if(!checkSize(numVertices, "soup") || !sink.begin(numVertices, numFaces))
+    {
+        return false;
+    }
+    for(std::uint64_t v = 0; v < numVertices; ++v)
+    {
+        sink.vertex(soupVertex(seed, v));
+    }
+    for(std::uint64_t t = 0; t < numFaces; ++t)
+    {
+        const auto first = static_cast<idxtype>(3 * t);
+        const std::uint64_t base = t - t % SOUP_CLUSTER;
+        switch((t == base) ? 7 : hash(seed, 3, t) % 8)
+        {
+            case 0:
+            case 1:
+            {
+                // a fin on the first edge of the base triangle of the cluster, shared by all its fins
+                const auto b = static_cast<idxtype>(3 * base);
+                sink.face({b, b + 1, first + 2});
+                break;
+            }
+            case 2:
+                // flipped orientation
+                sink.face({first, first + 2, first + 1});
+                break;
+            default:
+                sink.face({first, first + 1, first + 2});
+                break;
+        }
+    }
+    return sink.end();
+}
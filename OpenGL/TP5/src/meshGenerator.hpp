@@ -0,0 +1,66 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "meshStream.hpp"
+
+#include <cstdint>
+
+/**
+ * Generators of synthetic meshes of any size. They stream the mesh to a MeshSink and compute each
+ * vertex and each face independently from the others: the memory used is constant whatever the
+ * size, and the result only depends on the parameters (and the seed).
+ * They return false if the mesh has more than 2^32 vertices or if the sink failed.
+ */
+
+/**
+ * Generate a geodesic sphere of radius 1 by splitting each face of an icosahedron in frequency^2
+ * triangles: 10 * frequency^2 + 2 vertices and 20 * frequency^2 faces. The vertices shared by two
+ * faces are indexed analytically, without any lookup table.
+ * @param[in] frequency the number of segments along each edge of the icosahedron, at least 1
+ * @param[in] sink where to send the mesh
+ * @return true if everything went well, false otherwise
+ */
+bool generateIcosphere(std::uint32_t frequency, MeshSink& sink);
+
+/**
+ * Generate a torus around the z axis: majorSegments * minorSegments vertices and twice as many faces
+ * @param[in] majorSegments the number of segments along the major circle, at least 3
+ * @param[in] minorSegments the number of segments along the minor circle, at least 3
+ * @param[in] majorRadius the distance from the center of the torus to the center of the tube
+ * @param[in] minorRadius the radius of the tube
+ * @param[in] sink where to send the mesh
+ * @return true if everything went well, false otherwise
+ */
+bool generateTorus(std::uint32_t majorSegments,
+                   std::uint32_t minorSegments,
+                   float majorRadius,
+                   float minorRadius,
+                   MeshSink& sink);
+
+/**
+ * Generate a grid of nx * ny cells in [-1, 1]^2 displaced along z by a fractal value noise:
+ * (nx + 1) * (ny + 1) vertices and 2 * nx * ny faces
+ * @param[in] nx the number of cells along x, at least 1
+ * @param[in] ny the number of cells along y, at least 1
+ * @param[in] amplitude the maximum displacement
+ * @param[in] seed the seed of the noise
+ * @param[in] sink where to send the mesh
+ * @return true if everything went well, false otherwise
+ */
+bool generateNoiseGrid(std::uint32_t nx, std::uint32_t ny, float amplitude, std::uint64_t seed, MeshSink& sink);
+
+/**
+ * Generate a non-manifold triangle soup in [-1, 1]^3, similar to the scanned models without
+ * consistent topology: each triangle has its own vertices (3 per face), except some that are
+ * attached as fins to an edge shared by several faces, and some have a flipped orientation
+ * @param[in] numFaces the number of faces
+ * @param[in] seed the seed of the positions and of the defects
+ * @param[in] sink where to send the mesh
+ * @return true if everything went well, false otherwise
+ */
+bool generateSoup(std::uint64_t numFaces, std::uint64_t seed, MeshSink& sink);
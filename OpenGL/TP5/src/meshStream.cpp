@@ -0,0 +1,616 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "meshStream.hpp"
+#include "logger.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the binary mesh container is little endian");
+#endif
+
+namespace {
+
+char* writeFloat(char* out, float value)
+{
+    // the shortest representation that reads back to the same float
+    return std::to_chars(out, out + 32, value).ptr;
+}
+
+char* writeIndex(char* out, std::uint64_t value)
+{
+    return std::to_chars(out, out + 24, value).ptr;
+}
+
+template<typename T>
+char* put(char* out, T value)
+{
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+/// the longest OBJ line: the letter, three values of at most 24 characters, the spaces and the newline
+constexpr std::size_t MAX_OBJ_LINE{2 + 3 * 24 + 3};
+
+char* writeVertexLine(char* out, const point3d& p)
+{
+    *out++ = 'v';
+    *out++ = ' ';
+    out = writeFloat(out, p.x);
+    *out++ = ' ';
+    out = writeFloat(out, p.y);
+    *out++ = ' ';
+    out = writeFloat(out, p.z);
+    *out++ = '\n';
+    return out;
+}
+
+template<typename Index>
+char* writeFaceLine(char* out, const basicFace<Index>& f)
+{
+    // OBJ starts counting from 1
+    *out++ = 'f';
+    *out++ = ' ';
+    out = writeIndex(out, std::uint64_t{f.v1} + 1);
+    *out++ = ' ';
+    out = writeIndex(out, std::uint64_t{f.v2} + 1);
+    *out++ = ' ';
+    out = writeIndex(out, std::uint64_t{f.v3} + 1);
+    *out++ = '\n';
+    return out;
+}
+
+/**
+ * A block of OBJ text, its buffer is not initialized
+ */
+struct ObjBlock
+{
+    /// the text, room for OBJ_BLOCK_ELEMENTS lines
+    std::unique_ptr<char[]> text{new char[OBJ_BLOCK_ELEMENTS * MAX_OBJ_LINE]};
+    /// the number of characters of the text
+    std::size_t size{0};
+};
+
+/**
+ * Format the lines of a range of vertices or faces into a block
+ * @param[in] elements the vertices or the faces
+ * @param[in] begin the first element of the block
+ * @param[in] end the end of the block, at most OBJ_BLOCK_ELEMENTS after begin
+ * @param[out] block the text
+ */
+template<typename Element>
+void formatObjBlock(const std::vector<Element>& elements, std::size_t begin, std::size_t end, ObjBlock& block)
+{
+    char* out = block.text.get();
+    for(std::size_t i = begin; i < end; ++i)
+    {
+        if constexpr(std::is_same_v<Element, point3d>)
+        {
+            out = writeVertexLine(out, elements[i]);
+        }
+        else
+        {
+            out = writeFaceLine(out, elements[i]);
+        }
+    }
+    block.size = static_cast<std::size_t>(out - block.text.get());
+}
+
+/**
+ * Write a buffer to a file
+ * @return true if everything has been written
+ */
+bool writeAll(std::FILE* file, const void* data, std::size_t size)
+{
+    return std::fwrite(data, 1, size, file) == size;
+}
+
+} // namespace
+
+bool MemorySink::begin(std::uint64_t numVertices, std::uint64_t numFaces)
+{
+    _vertices.clear();
+    _mesh.clear();
+    _vertices.reserve(numVertices);
+    _mesh.reserve(numFaces);
+    return true;
+}
+
+FileSink::~FileSink()
+{
+    if(_file != nullptr)
+    {
+        std::fclose(_file);
+    }
+}
+
+bool FileSink::open(const char* mode)
+{
+    _file = std::fopen(_filename.c_str(), mode);
+    if(_file == nullptr)
+    {
+        LOG_ERROR(General, "Unable to open file " << _filename);
+        return false;
+    }
+    _buffer.resize(BUFFER_SIZE);
+    _used = 0;
+    _failed = false;
+    _vertexCount = 0;
+    _faceCount = 0;
+    return true;
+}
+
+void FileSink::write(const void* data, std::size_t size)
+{
+    flush();
+    if(std::fwrite(data, 1, size, _file) != size)
+    {
+        _failed = true;
+    }
+}
+
+void FileSink::flush()
+{
+    if(_used > 0 && std::fwrite(_buffer.data(), 1, _used, _file) != _used)
+    {
+        _failed = true;
+    }
+    _used = 0;
+}
+
+bool FileSink::close()
+{
+    flush();
+    const bool closed = (std::fclose(_file) == 0);
+    _file = nullptr;
+    if(_failed || !closed)
+    {
+        LOG_ERROR(General, "Error while writing " << _filename);
+        return false;
+    }
+    if(_vertexCount != _numVertices || _faceCount != _numFaces)
+    {
+        LOG_ERROR(General, "Wrote " << _vertexCount << " vertices and " << _faceCount << " faces in " << _filename
+                                    << ", " << _numVertices << " and " << _numFaces << " were announced");
+        return false;
+    }
+    return true;
+}
+
+bool ObjSink::begin(std::uint64_t numVertices, std::uint64_t numFaces)
+{
+    _numVertices = numVertices;
+    _numFaces = numFaces;
+    if(!open("w"))
+    {
+        return false;
+    }
+    char* out = reserve();
+    const char header[] = "# vertices ";
+    out = std::copy(header, header + sizeof(header) - 1, out);
+    out = writeIndex(out, numVertices);
+    const char middle[] = ", faces ";
+    out = std::copy(middle, middle + sizeof(middle) - 1, out);
+    out = writeIndex(out, numFaces);
+    *out++ = '\n';
+    commit(out);
+    return true;
+}
+
+void ObjSink::vertex(const point3d& p)
+{
+    commit(writeVertexLine(reserve(), p));
+    ++_vertexCount;
+}
+
+void ObjSink::face(const ::face& f)
+{
+    commit(writeFaceLine(reserve(), f));
+    ++_faceCount;
+}
+
+bool ObjSink::end()
+{
+    return close();
+}
+
+bool BinarySink::begin(std::uint64_t numVertices, std::uint64_t numFaces)
+{
+    _numVertices = numVertices;
+    _numFaces = numFaces;
+    if(!open("wb"))
+    {
+        return false;
+    }
+    char* out = reserve();
+    out = std::copy(bmesh::MAGIC, bmesh::MAGIC + sizeof(bmesh::MAGIC), out);
+    out = put(out, bmesh::VERSION);
+    out = put(out, std::uint32_t{0});
+    out = put(out, numVertices);
+    out = put(out, numFaces);
+    commit(out);
+    return true;
+}
+
+void BinarySink::vertex(const point3d& p)
+{
+    char* out = reserve();
+    out = put(out, p.x);
+    out = put(out, p.y);
+    out = put(out, p.z);
+    commit(out);
+    ++_vertexCount;
+}
+
+void BinarySink::face(const ::face& f)
+{
+    char* out = reserve();
+    out = put(out, std::uint32_t{f.v1});
+    out = put(out, std::uint32_t{f.v2});
+    out = put(out, std::uint32_t{f.v3});
+    commit(out);
+    ++_faceCount;
+}
+
+bool BinarySink::end()
+{
+    return close();
+}
+
+bool PlySink::begin(std::uint64_t numVertices, std::uint64_t numFaces)
+{
+    _numVertices = numVertices;
+    _numFaces = numFaces;
+    if(!open(_binary ? "wb" : "w"))
+    {
+        return false;
+    }
+    std::string header = "ply\nformat ";
+    header += _binary ? "binary_little_endian" : "ascii";
+    header += " 1.0\nelement vertex " + std::to_string(numVertices)
+              + "\nproperty float x\nproperty float y\nproperty float z\nelement face " + std::to_string(numFaces)
+              + "\nproperty list uchar uint vertex_indices\nend_header\n";
+    write(header.data(), header.size());
+    return true;
+}
+
+void PlySink::vertex(const point3d& p)
+{
+    char* out = reserve();
+    if(_binary)
+    {
+        out = put(out, p.x);
+        out = put(out, p.y);
+        out = put(out, p.z);
+    }
+    else
+    {
+        out = writeFloat(out, p.x);
+        *out++ = ' ';
+        out = writeFloat(out, p.y);
+        *out++ = ' ';
+        out = writeFloat(out, p.z);
+        *out++ = '\n';
+    }
+    commit(out);
+    ++_vertexCount;
+}
+
+void PlySink::face(const ::face& f)
+{
+    char* out = reserve();
+    if(_binary)
+    {
+        out = put(out, std::uint8_t{3});
+        out = put(out, std::uint32_t{f.v1});
+        out = put(out, std::uint32_t{f.v2});
+        out = put(out, std::uint32_t{f.v3});
+    }
+    else
+    {
+        *out++ = '3';
+        *out++ = ' ';
+        out = writeIndex(out, f.v1);
+        *out++ = ' ';
+        out = writeIndex(out, f.v2);
+        *out++ = ' ';
+        out = writeIndex(out, f.v3);
+        *out++ = '\n';
+    }
+    commit(out);
+    ++_faceCount;
+}
+
+bool PlySink::end()
+{
+    return close();
+}
+
+bool StlSink::begin(std::uint64_t numVertices, std::uint64_t numFaces)
+{
+    _numVertices = numVertices;
+    _numFaces = numFaces;
+    if(numFaces > std::numeric_limits<std::uint32_t>::max())
+    {
+        LOG_ERROR(General, "STL files have at most 2^32 - 1 triangles");
+        return false;
+    }
+    if(!open("wb"))
+    {
+        return false;
+    }
+    _vertices.clear();
+    _vertices.reserve(numVertices);
+    char* out = reserve();
+    const char header[80] = "binary STL";
+    out = std::copy(header, header + sizeof(header), out);
+    out = put(out, static_cast<std::uint32_t>(numFaces));
+    commit(out);
+    return true;
+}
+
+void StlSink::vertex(const point3d& p)
+{
+    _vertices.push_back(p);
+    ++_vertexCount;
+}
+
+void StlSink::face(const ::face& f)
+{
+    const point3d& a = _vertices[f.v1];
+    const point3d& b = _vertices[f.v2];
+    const point3d& c = _vertices[f.v3];
+    vec3d n = (b - a).cross(c - a);
+    if(n.norm() > 0.f)
+    {
+        n.normalize();
+    }
+    char* out = reserve();
+    for(const v3f& v : {n, a, b, c})
+    {
+        out = put(out, v.x);
+        out = put(out, v.y);
+        out = put(out, v.z);
+    }
+    out = put(out, std::uint16_t{0});
+    commit(out);
+    ++_faceCount;
+}
+
+bool StlSink::end()
+{
+    _vertices.clear();
+    _vertices.shrink_to_fit();
+    return close();
+}
+
+bool writeObj(const std::string& filename, const std::vector<point3d>& vertices, const FaceList& faces, unsigned numThreads)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if(file == nullptr)
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    const std::string header =
+        "# vertices " + std::to_string(vertices.size()) + ", faces " + std::to_string(faces.size()) + "\n";
+    bool written = writeAll(file, header.data(), header.size());
+
+    // the blocks of the vertices, then the ones of the faces
+    const std::size_t vertexBlocks = (vertices.size() + OBJ_BLOCK_ELEMENTS - 1) / OBJ_BLOCK_ELEMENTS;
+    const std::size_t numBlocks = vertexBlocks + (faces.size() + OBJ_BLOCK_ELEMENTS - 1) / OBJ_BLOCK_ELEMENTS;
+    faces.visit([&](const auto& list) {
+        const auto format = [&vertices, &list, vertexBlocks](std::size_t b, ObjBlock& block) {
+            const bool isVertex = b < vertexBlocks;
+            const std::size_t begin = (isVertex ? b : b - vertexBlocks) * OBJ_BLOCK_ELEMENTS;
+            if(isVertex)
+            {
+                formatObjBlock(vertices, begin, std::min(vertices.size(), begin + OBJ_BLOCK_ELEMENTS), block);
+            }
+            else
+            {
+                formatObjBlock(list, begin, std::min(list.size(), begin + OBJ_BLOCK_ELEMENTS), block);
+            }
+        };
+        if(numThreads == 1)
+        {
+            ObjBlock block;
+            for(std::size_t b = 0; b < numBlocks; ++b)
+            {
+                format(b, block);
+                written = written && writeAll(file, block.text.get(), block.size);
+            }
+            return;
+        }
+
+        // the next blocks are formatted while the oldest one is written, the file keeps their order
+        ThreadPool& pool = ThreadPool::shared();
+        const std::size_t window = (numThreads == 0) ? pool.size() : numThreads;
+        std::deque<std::future<ObjBlock>> formatting;
+        try
+        {
+            std::size_t next{0};
+            for(std::size_t b = 0; b < numBlocks; ++b)
+            {
+                for(; next < numBlocks && next <= b + window; ++next)
+                {
+                    formatting.push_back(pool.submit([&format, next] {
+                        ObjBlock block;
+                        format(next, block);
+                        return block;
+                    }));
+                }
+                const ObjBlock block = formatting.front().get();
+                formatting.pop_front();
+                written = written && writeAll(file, block.text.get(), block.size);
+            }
+        }
+        catch(...)
+        {
+            // the queued blocks use the mesh of the caller
+            for(auto& f : formatting)
+            {
+                f.wait();
+            }
+            std::fclose(file);
+            throw;
+        }
+    });
+
+    if(std::fclose(file) != 0 || !written)
+    {
+        LOG_ERROR(General, "Error while writing " << filename);
+        return false;
+    }
+    return true;
+}
+
+bool writeBinaryMesh(const std::string& filename,
+                     const std::vector<point3d>& vertices,
+                     const std::vector<vec3d>& normals,
+                     const FaceList& faces)
+{
+    // the arrays are written as they are in memory
+    static_assert(sizeof(point3d) == 3 * sizeof(float) && sizeof(vec3d) == 3 * sizeof(float));
+    static_assert(sizeof(::face) == 3 * sizeof(std::uint32_t));
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if(file == nullptr)
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    const bool hasNormals = !vertices.empty() && normals.size() == vertices.size();
+    char header[bmesh::HEADER_SIZE];
+    char* out = std::copy(bmesh::MAGIC, bmesh::MAGIC + sizeof(bmesh::MAGIC), header);
+    out = put(out, bmesh::VERSION);
+    out = put(out, hasNormals ? bmesh::HAS_NORMALS : std::uint32_t{0});
+    out = put(out, std::uint64_t{vertices.size()});
+    put(out, std::uint64_t{faces.size()});
+
+    bool written = writeAll(file, header, sizeof(header)) && writeAll(file, vertices.data(), vertices.size() * sizeof(point3d));
+    if(hasNormals)
+    {
+        written = written && writeAll(file, normals.data(), normals.size() * sizeof(vec3d));
+    }
+    faces.visit([&](const auto& list) {
+        using Index = typename std::decay_t<decltype(list)>::value_type::index_type;
+        if constexpr(sizeof(Index) == sizeof(std::uint32_t))
+        {
+            written = written && writeAll(file, list.data(), list.size() * sizeof(::face));
+        }
+        else
+        {
+            // the 16-bit indices are widened block by block
+            std::vector<std::uint32_t> block;
+            for(std::size_t begin = 0; begin < list.size(); begin += OBJ_BLOCK_ELEMENTS)
+            {
+                block.clear();
+                for(std::size_t i = begin; i < std::min(list.size(), begin + OBJ_BLOCK_ELEMENTS); ++i)
+                {
+                    block.insert(block.end(), {list[i].v1, list[i].v2, list[i].v3});
+                }
+                written = written && writeAll(file, block.data(), block.size() * sizeof(std::uint32_t));
+            }
+        }
+    });
+
+    if(std::fclose(file) != 0 || !written)
+    {
+        LOG_ERROR(General, "Error while writing " << filename);
+        return false;
+    }
+    return true;
+}
+
+bool loadBinaryMesh(const std::string& filename,
+                    std::vector<point3d>& vertices,
+                    std::vector<::face>& mesh,
+                    std::vector<vec3d>& normals)
+{
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if(!in.is_open())
+    {
+        LOG_ERROR(Loader, "Unable to open file " << filename);
+        return false;
+    }
+    const auto fileSize = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0);
+
+    char header[bmesh::HEADER_SIZE];
+    if(!in.read(header, sizeof(header)) || std::memcmp(header, bmesh::MAGIC, sizeof(bmesh::MAGIC)) != 0)
+    {
+        LOG_ERROR(Loader, filename << " is not a binary mesh");
+        return false;
+    }
+    std::uint32_t version{0};
+    std::uint32_t flags{0};
+    std::uint64_t numVertices{0};
+    std::uint64_t numFaces{0};
+    std::memcpy(&version, header + 8, sizeof(version));
+    std::memcpy(&flags, header + 12, sizeof(flags));
+    std::memcpy(&numVertices, header + 16, sizeof(numVertices));
+    std::memcpy(&numFaces, header + 24, sizeof(numFaces));
+
+    const bool hasNormals = (flags & bmesh::HAS_NORMALS) != 0;
+    const std::uint64_t expectedSize =
+        bmesh::HEADER_SIZE + (hasNormals ? 2 : 1) * 12 * numVertices + 12 * numFaces;
+    if(version != bmesh::VERSION || expectedSize != fileSize)
+    {
+        LOG_ERROR(Loader, filename << ": unsupported version " << version << " or truncated file");
+        return false;
+    }
+
+    const auto readVectors = [&in](std::vector<v3f>& res, std::uint64_t n) {
+        std::vector<float> raw(3 * n);
+        in.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(raw.size() * sizeof(float)));
+        res.clear();
+        res.reserve(n);
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            res.emplace_back(raw[3 * i], raw[3 * i + 1], raw[3 * i + 2]);
+        }
+    };
+    readVectors(vertices, numVertices);
+    normals.clear();
+    if(hasNormals)
+    {
+        readVectors(normals, numVertices);
+    }
+
+    std::vector<std::uint32_t> indices(3 * numFaces);
+    in.read(reinterpret_cast<char*>(indices.data()),
+            static_cast<std::streamsize>(indices.size() * sizeof(std::uint32_t)));
+    if(!in)
+    {
+        LOG_ERROR(Loader, "Error while reading " << filename);
+        return false;
+    }
+    mesh.clear();
+    mesh.reserve(numFaces);
+    for(std::size_t i = 0; i < numFaces; ++i)
+    {
+        const ::face f(indices[3 * i], indices[3 * i + 1], indices[3 * i + 2]);
+        if(f.v1 >= numVertices || f.v2 >= numVertices || f.v3 >= numVertices)
+        {
+            LOG_ERROR(Loader, filename << ": face " << i << " has an index out of range");
+            return false;
+        }
+        mesh.push_back(f);
+    }
+    LOG_INFO(Loader, "Object loaded with " << vertices.size() << " vertices and " << mesh.size() << " faces");
+    return true;
+}
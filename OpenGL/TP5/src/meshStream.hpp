@@ -0,0 +1,253 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * The binary mesh container (extension .bmesh), all the values are little endian:
+ *
+ *  - header: the magic "TP5MESH\0", the version (uint32), the flags (uint32, bit 0 set if there are
+ *    normals), the number of vertices (uint64), the number of faces (uint64)
+ *  - the vertices, 3 float32 each
+ *  - the normals if present, 3 float32 each
+ *  - the faces, 3 uint32 indices each, starting from 0
+ */
+namespace bmesh {
+/// the magic string at the beginning of the file
+constexpr char MAGIC[8] = {'T', 'P', '5', 'M', 'E', 'S', 'H', '\0'};
+/// the current version of the format
+constexpr std::uint32_t VERSION{1};
+/// the flag telling that the file contains the normals
+constexpr std::uint32_t HAS_NORMALS{1U};
+/// the size of the header in bytes
+constexpr std::size_t HEADER_SIZE{32};
+} // namespace bmesh
+
+/**
+ * Receive a mesh element by element, so that meshes larger than the memory can be produced.
+ * The vertices are all sent before the faces.
+ */
+class MeshSink
+{
+public:
+    virtual ~MeshSink() = default;
+
+    /**
+     * Start a new mesh
+     * @param[in] numVertices the number of vertices that will be sent
+     * @param[in] numFaces the number of faces that will be sent
+     * @return true if everything went well, false otherwise
+     */
+    virtual bool begin(std::uint64_t numVertices, std::uint64_t numFaces) = 0;
+
+    /**
+     * Add a vertex
+     * @param[in] p the vertex
+     */
+    virtual void vertex(const point3d& p) = 0;
+
+    /**
+     * Add a face
+     * @param[in] f the face, the indices start from 0
+     */
+    virtual void face(const ::face& f) = 0;
+
+    /**
+     * End the mesh
+     * @return true if everything went well, false otherwise
+     */
+    virtual bool end() = 0;
+};
+
+/**
+ * Store the mesh in memory
+ */
+class MemorySink : public MeshSink
+{
+public:
+    MemorySink(std::vector<point3d>& vertices, std::vector<::face>& mesh) : _vertices(vertices), _mesh(mesh) { }
+
+    bool begin(std::uint64_t numVertices, std::uint64_t numFaces) override;
+    void vertex(const point3d& p) override { _vertices.push_back(p); }
+    void face(const ::face& f) override { _mesh.push_back(f); }
+    bool end() override { return true; }
+
+private:
+    std::vector<point3d>& _vertices;
+    std::vector<::face>& _mesh;
+};
+
+/**
+ * Base of the sinks writing to a file through a fixed-size buffer, so the memory used does not
+ * depend on the size of the mesh
+ */
+class FileSink : public MeshSink
+{
+public:
+    explicit FileSink(std::string filename) : _filename(std::move(filename)) { }
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+protected:
+    /// the size of the output buffer
+    static constexpr std::size_t BUFFER_SIZE{1U << 20U};
+    /// the maximum size of one element, the buffer is flushed when less space is left
+    static constexpr std::size_t MAX_ELEMENT_SIZE{256};
+
+    bool open(const char* mode);
+    bool close();
+
+    /**
+     * Return where to write the next element, at least MAX_ELEMENT_SIZE bytes are available
+     * @return the pointer to the free space of the buffer
+     */
+    char* reserve()
+    {
+        if(_used + MAX_ELEMENT_SIZE > _buffer.size())
+        {
+            flush();
+        }
+        return _buffer.data() + _used;
+    }
+
+    void commit(const char* end) { _used = static_cast<std::size_t>(end - _buffer.data()); }
+    void write(const void* data, std::size_t size);
+    void flush();
+
+    std::string _filename;
+    std::uint64_t _numVertices{0};
+    std::uint64_t _numFaces{0};
+    std::uint64_t _vertexCount{0};
+    std::uint64_t _faceCount{0};
+
+private:
+    std::FILE* _file{nullptr};
+    std::vector<char> _buffer;
+    std::size_t _used{0};
+    bool _failed{false};
+};
+
+/**
+ * Write the mesh in the OBJ format
+ */
+class ObjSink : public FileSink
+{
+public:
+    using FileSink::FileSink;
+
+    bool begin(std::uint64_t numVertices, std::uint64_t numFaces) override;
+    void vertex(const point3d& p) override;
+    void face(const ::face& f) override;
+    bool end() override;
+};
+
+/**
+ * Write the mesh in the binary mesh container (without normals)
+ */
+class BinarySink : public FileSink
+{
+public:
+    using FileSink::FileSink;
+
+    bool begin(std::uint64_t numVertices, std::uint64_t numFaces) override;
+    void vertex(const point3d& p) override;
+    void face(const ::face& f) override;
+    bool end() override;
+};
+
+/**
+ * Write the mesh in the Stanford PLY format, in ASCII or in binary little endian: float
+ * coordinates and triangles as lists with a uchar count and uint indices
+ */
+class PlySink : public FileSink
+{
+public:
+    /**
+     * Constructor
+     * @param[in] filename the name of the file
+     * @param[in] binary true for the binary little endian format, false for ASCII
+     */
+    PlySink(std::string filename, bool binary) : FileSink(std::move(filename)), _binary(binary) { }
+
+    bool begin(std::uint64_t numVertices, std::uint64_t numFaces) override;
+    void vertex(const point3d& p) override;
+    void face(const ::face& f) override;
+    bool end() override;
+
+private:
+    bool _binary;
+};
+
+/**
+ * Write the mesh in the binary STL format. STL stores the coordinates in each triangle, so the
+ * vertices are kept in memory until the faces are written.
+ */
+class StlSink : public FileSink
+{
+public:
+    using FileSink::FileSink;
+
+    bool begin(std::uint64_t numVertices, std::uint64_t numFaces) override;
+    void vertex(const point3d& p) override;
+    void face(const ::face& f) override;
+    bool end() override;
+
+private:
+    std::vector<point3d> _vertices;
+};
+
+/// the number of vertices or faces formatted in one block by writeObj, a few MiB of text
+constexpr std::size_t OBJ_BLOCK_ELEMENTS{1U << 16U};
+
+/**
+ * Write a whole mesh in the OBJ format, the same text as ObjSink. The lines are formatted with
+ * std::to_chars into blocks of OBJ_BLOCK_ELEMENTS vertices or faces, each block is written at once.
+ * With several threads the blocks are formatted concurrently on the shared thread pool while the
+ * previous ones are written, in order. A job of the shared pool must then not call it, since the
+ * blocks could be queued behind it.
+ * @param[in] filename the name of the file
+ * @param[in] vertices the list of vertices
+ * @param[in] faces the list of faces
+ * @param[in] numThreads the number of blocks formatted concurrently, 0 for one per worker of the
+ * shared pool, 1 to format them on the calling thread
+ * @return true if everything went well, false otherwise
+ */
+bool writeObj(const std::string& filename, const std::vector<point3d>& vertices, const FaceList& faces, unsigned numThreads = 1);
+
+/**
+ * Write a whole mesh in the binary mesh container, each array at once
+ * @param[in] filename the name of the .bmesh file
+ * @param[in] vertices the list of vertices
+ * @param[in] normals the normal of each vertex, they are not written if there is not one per vertex
+ * @param[in] faces the list of faces
+ * @return true if everything went well, false otherwise
+ */
+bool writeBinaryMesh(const std::string& filename,
+                     const std::vector<point3d>& vertices,
+                     const std::vector<vec3d>& normals,
+                     const FaceList& faces);
+
+/**
+ * Load a mesh from a binary mesh container
+ * @param[in] filename the name of the .bmesh file
+ * @param[out] vertices the list of vertices
+ * @param[out] mesh the list of faces
+ * @param[out] normals the list of normals, empty if the file has none
+ * @return true if everything went well, false otherwise
+ */
+bool loadBinaryMesh(const std::string& filename,
+                    std::vector<point3d>& vertices,
+                    std::vector<::face>& mesh,
+                    std::vector<vec3d>& normals);
@@ -7,6 +7,7 @@
 #include "objReader.hpp"
 #include "core.hpp"
 #include "geometry.hpp"
+#include "profiler.hpp"
 
 #include <regex>
 #include <array>
@@ -24,106 +25,105 @@
  */
 bool load(const std::string& filename, std::vector<point3d>& vertices, std::vector<face>& mesh, std::vector<vec3d>& normals, BoundingBox& bb)
 {
+    PROFILE_SCOPE("load");
+    const std::size_t firstFace = mesh.size();
+    const bool loaded = loadBatches(filename, OBJ_BATCH_SIZE, [&](std::vector<point3d>& newVertices, std::vector<face>& newFaces) {
+        for(const auto& p : newVertices)
+        {
+            // update the bounding box, if it is the first vertex simply
+            // set the bb to it, otherwise add the point
+            if(vertices.empty())
+            {
+                bb.set(p);
+            }
+            else
+            {
+                bb.add(p);
+            }
+            vertices.push_back(p);
+        }
+        mesh.insert(mesh.end(), newFaces.begin(), newFaces.end());
+    });
+    if(!loaded)
+    {
+        return false;
+    }
+
+    //**************************************************
+    // the normal of each new vertex starts from [0, 0, 0]
+    //**************************************************
+    normals.resize(vertices.size(), vec3d{0, 0, 0});
+
+    //*********************************************************************
+    // Sum the normal of each new face, weighted by its angle, to the normal
+    // of each of its vertices (section 5.3), once all the faces are read so
+    // that the vertices gather them in parallel
+    //*********************************************************************
+    accumulateVertexNormals(vertices, Span(mesh.data() + firstFace, mesh.size() - firstFace), normals);
+
+    LOG_DEBUG( Loader, "Found :\n\tNumber of triangles (_indices) " << mesh.size( ) << "\n\tNumber of Vertices: " << vertices.size( ) << "\n\tNumber of Normals: " << normals.size( ) );
+    LOG_INFO( Loader, "Object loaded with " << vertices.size( ) << " vertices and " << mesh.size( ) << " faces" );
+    LOG_INFO( Loader, "Bounding box : pmax=" << bb.pmax << "  pmin=" << bb.pmin );
+    return true;
+}
+
+bool loadBatches(const std::string& filename, std::size_t batchSize, const ObjBatchFunction& onBatch)
+{
+    PROFILE_SCOPE("loadBatches");
     std::string line;
     std::ifstream objFile( filename );
 
     // If obj file is not open return (e.g. file does not exist
     if (! objFile.is_open( ) )
     {
-        std::cerr << "Unable to open file " << filename << std::endl;
+        LOG_ERROR( Loader, "Unable to open file " << filename );
         return false;
     }
 
-    // Start reading file data
-    while( !objFile.eof( ) )
+    std::vector<point3d> vertices;
+    std::vector<face> faces;
+    std::size_t numVertices{0};
+    std::size_t numFaces{0};
+    while( getline( objFile, line ) )
     {
-        // Get a line from file
-        getline( objFile, line );
-
-        // If the first character is a simple 'v'...
-//            PRINTVAR( line );
-        if ( (line[0] == 'v') && (line[1] == ' ') ) // to drop all the vn and vn lines
+        // If the first character is a simple 'v'... (to drop all the vn and vt lines)
+        if ( line.size( ) > 1 && line[0] == 'v' && line[1] == ' ' )
         {
-//                PRINTVAR( line );
-            // Read 3 floats from the line:  X Y Z and store them in the corresponding place in _vertices
-            const point3d p = parseVertexString(line);
-
-            //**************************************************
-            // add the new point to the list of the vertices
-            // and its normal to the list of normals: for the time
-            // being it is a [0, 0 ,0] normal.
-            //**************************************************
-            vertices.push_back(p);
-            normals.push_back(point3d {0,0,0});
-
-
-            // update the bounding box, if it is the first vertex simply
-            // set the bb to it
-            if (vertices.size( ) == 1 )
-            {
-                bb.set( p );
-            }
-            else
-            {
-                // otherwise add the point
-                bb.add( p );
-            }
+            // Read 3 floats from the line:  X Y Z
+            vertices.push_back( parseVertexString( line ) );
+            ++numVertices;
         }
         // If the first character is a 'f'...
-        if ( line[0] == 'f' )
+        else if ( !line.empty( ) && line[0] == 'f' )
         {
-            face t = parseFaceString( line);
+            face t = parseFaceString( line );
 
             //**************************************************
             // correct the indices: OBJ starts counting from 1, in C the arrays starts at 0...
+            // the faces can only use the vertices read before them
             //**************************************************
             t.v1--;
             t.v2--;
             t.v3--;
-
-            //**************************************************
-            // add it to the mesh
-            //**************************************************
-            mesh.push_back(t);
-
-            //*********************************************************************
-            //  Compute the normal of the face  (to be done for section 5.3)
-            //*********************************************************************
-            vec3d normal = computeNormal(vertices[t.v1],vertices[t.v2], vertices[t.v3]);
-
-            //*********************************************************************
-            // Sum the normal of the face to each vertex normal (to be done for section 5.3)
-            //*********************************************************************
-            normals[t.v1] += normal * angleAtVertex(vertices[t.v1], vertices[t.v2],vertices[t.v3]);
-            normals[t.v2] += normal * angleAtVertex(vertices[t.v2], vertices[t.v1],vertices[t.v3]);
-            normals[t.v3] += normal * angleAtVertex(vertices[t.v3], vertices[t.v2],vertices[t.v1]);
-
-
-
+            if( t.v1 >= numVertices || t.v2 >= numVertices || t.v3 >= numVertices )
+            {
+                LOG_ERROR( Loader, filename << ": face " << numFaces << " has an index out of range" );
+                return false;
+            }
+            faces.push_back( t );
+            ++numFaces;
+        }
+        if( vertices.size( ) + faces.size( ) >= batchSize )
+        {
+            onBatch( vertices, faces );
+            vertices.clear( );
+            faces.clear( );
         }
     }
-
-    std::cerr << "Found :\n\tNumber of triangles (_indices) " << mesh.size( ) << "\n\tNumber of Vertices: " << vertices.size( ) << "\n\tNumber of Normals: " << normals.size( ) << std::endl;
-//        PRINTVAR( mesh );
-//        PRINTVAR( vertices );
-//        PRINTVAR( normals );
-
-    //*********************************************************************
-    // normalize the normals of each vertex (to be done for section 5.3)
-    //*********************************************************************
-
-
-
-
-
-//        PRINTVAR( normals );
-
-    // Close OBJ file
-    objFile.close();
-
-
-    std::cout << "Object loaded with " << vertices.size( ) << " vertices and " << mesh.size( ) << " faces" << std::endl;
-    std::cout << "Bounding box : pmax=" << bb.pmax << "  pmin=" << bb.pmin << std::endl;
+    if( !vertices.empty( ) || !faces.empty( ) )
+    {
+        onBatch( vertices, faces );
+    }
     return true;
 }
 
@@ -7,8 +7,10 @@
 #pragma once
 
 #include "core.hpp"
+#include <functional>
 #include <string>
 #include <optional>
+#include <vector>
 
 /**
  * A structure that model the bounding box
@@ -58,6 +60,25 @@ struct BoundingBox
  */
 bool load(const std::string& filename, std::vector<point3d>& vertices, std::vector<face>& mesh, std::vector<vec3d>& normals, BoundingBox& bb);
 
+/**
+ * Receive the vertices and the faces read since the previous batch, the indices start from 0. The
+ * vectors can be moved away, they are cleared afterwards.
+ */
+using ObjBatchFunction = std::function<void(std::vector<point3d>& vertices, std::vector<face>& faces)>;
+
+/// the default number of elements (vertices and faces) of a batch
+constexpr std::size_t OBJ_BATCH_SIZE{1U << 16U};
+
+/**
+ * Read the vertices and the faces of an OBJ file batch by batch, in the order of the file, without
+ * computing the normals, eg to display the model while it is loaded
+ * @param[in] filename The name of the OBJ file to load
+ * @param[in] batchSize The number of elements (vertices and faces) after which a batch is sent
+ * @param[in] onBatch The function receiving the batches
+ * @return true if everything went well, false otherwise (some batches may have been sent)
+ */
+bool loadBatches(const std::string& filename, std::size_t batchSize, const ObjBatchFunction& onBatch);
+
 
 
 
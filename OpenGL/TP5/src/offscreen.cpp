@@ -0,0 +1,165 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "offscreen.hpp"
+#include "logger.hpp"
+#include "openglAll.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+
+namespace {
+
+/**
+ * Get a display that does not need a windowing system: first try Mesa's surfaceless
+ * platform, then the default display (which works with the device platform).
+ */
+EGLDisplay getHeadlessDisplay()
+{
+    const auto getPlatformDisplay =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(getPlatformDisplay != nullptr)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if(display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+        {
+            return display;
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+    {
+        return display;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+} // namespace
+
+OffscreenContext::~OffscreenContext()
+{
+    destroy();
+}
+
+bool OffscreenContext::create(int width, int height)
+{
+    destroy();
+
+    EGLDisplay display = getHeadlessDisplay();
+    if(display == EGL_NO_DISPLAY)
+    {
+        LOG_ERROR(Render, "Unable to initialize an EGL display (error " << std::hex << eglGetError() << ")");
+        return false;
+    }
+    _display = display;
+
+    // the desktop OpenGL API is needed for the fixed-function pipeline
+    if(!eglBindAPI(EGL_OPENGL_API))
+    {
+        LOG_ERROR(Render, "EGL: desktop OpenGL is not supported");
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttribs[] = {EGL_SURFACE_TYPE,
+                                    EGL_PBUFFER_BIT,
+                                    EGL_RED_SIZE,
+                                    8,
+                                    EGL_GREEN_SIZE,
+                                    8,
+                                    EGL_BLUE_SIZE,
+                                    8,
+                                    EGL_DEPTH_SIZE,
+                                    24,
+                                    EGL_RENDERABLE_TYPE,
+                                    EGL_OPENGL_BIT,
+                                    EGL_NONE};
+    EGLConfig config{};
+    EGLint numConfigs{0};
+    if(!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+    {
+        LOG_ERROR(Render, "EGL: no suitable pbuffer configuration");
+        destroy();
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if(surface == EGL_NO_SURFACE)
+    {
+        LOG_ERROR(Render, "EGL: unable to create a " << width << "x" << height << " pbuffer");
+        destroy();
+        return false;
+    }
+    _surface = surface;
+
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if(context == EGL_NO_CONTEXT)
+    {
+        LOG_ERROR(Render, "EGL: unable to create the OpenGL context");
+        destroy();
+        return false;
+    }
+    _context = context;
+
+    if(!eglMakeCurrent(display, surface, surface, context))
+    {
+        LOG_ERROR(Render, "EGL: unable to make the context current");
+        destroy();
+        return false;
+    }
+
+    _width = width;
+    _height = height;
+    return true;
+}
+
+void OffscreenContext::destroy()
+{
+    if(_display == nullptr)
+    {
+        return;
+    }
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(_context != nullptr)
+    {
+        eglDestroyContext(_display, _context);
+    }
+    if(_surface != nullptr)
+    {
+        eglDestroySurface(_display, _surface);
+    }
+    eglTerminate(_display);
+    _display = nullptr;
+    _surface = nullptr;
+    _context = nullptr;
+    _width = 0;
+    _height = 0;
+}
+
+void OffscreenContext::readPixels(std::vector<std::uint8_t>& rgb) const
+{
+    const auto rowSize = static_cast<std::size_t>(_width) * 3;
+    rgb.resize(rowSize * static_cast<std::size_t>(_height));
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+
+    // OpenGL returns the bottom row first
+    for(std::size_t top = 0, bottom = static_cast<std::size_t>(_height) - 1; top < bottom; ++top, --bottom)
+    {
+        std::swap_ranges(rgb.begin() + static_cast<std::ptrdiff_t>(top * rowSize),
+                         rgb.begin() + static_cast<std::ptrdiff_t>((top + 1) * rowSize),
+                         rgb.begin() + static_cast<std::ptrdiff_t>(bottom * rowSize));
+    }
+}
+
+std::string OffscreenContext::renderer() const
+{
+    const auto* str = glGetString(GL_RENDERER);
+    return (str != nullptr) ? std::string(reinterpret_cast<const char*>(str)) : std::string("unknown");
+}
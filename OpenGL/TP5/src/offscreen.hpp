@@ -0,0 +1,61 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An OpenGL context without any window, backed by an EGL pbuffer surface.
+ * It allows to run the fixed-function rendering path on machines without a display
+ * (eg. Mesa llvmpipe on a render farm).
+ */
+class OffscreenContext
+{
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    /**
+     * Create the context and its surface and make them current on the calling thread
+     * @param[in] width the width of the surface in pixels
+     * @param[in] height the height of the surface in pixels
+     * @return true if everything went well, false otherwise
+     */
+    bool create(int width, int height);
+
+    /**
+     * Release the context and the surface
+     */
+    void destroy();
+
+    /**
+     * Read back the color buffer as RGB pixels, top row first
+     * @param[out] rgb the pixels, resized to width * height * 3
+     */
+    void readPixels(std::vector<std::uint8_t>& rgb) const;
+
+    /**
+     * Return the name of the OpenGL renderer, eg "llvmpipe"
+     * @return the renderer string
+     */
+    [[nodiscard]] std::string renderer() const;
+
+    [[nodiscard]] int width() const { return _width; }
+    [[nodiscard]] int height() const { return _height; }
+
+private:
+    void* _display{nullptr};
+    void* _surface{nullptr};
+    void* _context{nullptr};
+    int _width{0};
+    int _height{0};
+};
@@ -0,0 +1,20 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+// only OpenGL, for the renderer library that does not need GLU nor GLUT (see openglAll.hpp)
+// for mac osx
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+// only for windows
+#ifdef _WIN32
+#include <windows.h>
+#endif
+// for windows and linux
+#include <GL/gl.h>
+#endif
@@ -0,0 +1,51 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+/**
+ * Return the number of threads to use
+ * @param[in] numThreads the requested number, 0 for all the cores
+ * @return the number of threads, at least 1
+ */
+inline unsigned resolveThreads(unsigned numThreads)
+{
+    return (numThreads != 0) ? numThreads : std::max(1U, std::thread::hardware_concurrency());
+}
+
+/**
+ * Run fn(chunk, begin, end) on numChunks contiguous ranges of [0, count), each one as a task of the
+ * shared pool (the last one on the calling thread, which then runs the pending tasks until all the
+ * chunks are done). The chunks must not wait for each other.
+ * @param[in] count the size of the range
+ * @param[in] numChunks the number of chunks, at least 1
+ * @param[in] fn the function
+ * @throw the first exception thrown by a chunk, if any
+ */
+template<typename Fn>
+void parallelChunks(std::size_t count, unsigned numChunks, Fn&& fn)
+{
+    if(numChunks <= 1)
+    {
+        fn(0U, std::size_t{0}, count);
+        return;
+    }
+    TaskGroup group;
+    for(unsigned c = 0; c + 1 < numChunks; ++c)
+    {
+        const std::size_t begin = count * c / numChunks;
+        const std::size_t end = count * (c + 1) / numChunks;
+        group.run([&fn, c, begin, end]() { fn(c, begin, end); });
+    }
+    fn(numChunks - 1, count * (numChunks - 1) / numChunks, count);
+    group.wait();
+}
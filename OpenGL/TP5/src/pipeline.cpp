@@ -0,0 +1,472 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "pipeline.hpp"
+#include "arena.hpp"
+#include "decimate.hpp"
+#include "geometry.hpp"
+#include "logger.hpp"
+#include "loop.hpp"
+#include "repair.hpp"
+#include "vertexCache.hpp"
+#include "weld.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__)
+#define PIPELINE_PROC_STATUS
+#elif defined(__unix__) || defined(__APPLE__)
+#define PIPELINE_RUSAGE
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+/// the largest number of subdivision steps of a stage, each one multiplies the faces by 4
+constexpr float MAX_SUBDIVISION_STEPS{10.f};
+
+/**
+ * Return a field of /proc/self/status, eg VmRSS
+ * @param[in] field the name of the field followed by a colon
+ * @return the value in bytes, 0 if not found
+ */
+[[maybe_unused]] std::size_t procStatusBytes(const std::string& field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+    {
+        if(line.compare(0, field.size(), field) == 0)
+        {
+            // the sizes are in kB
+            return std::stoull(line.substr(field.size())) * 1024U;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Remove the blanks at the beginning and at the end of a string
+ * @param[in] s the string
+ * @return the string without the blanks
+ */
+std::string trim(const std::string& s)
+{
+    const auto first = s.find_first_not_of(" \t");
+    if(first == std::string::npos)
+    {
+        return {};
+    }
+    return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+/**
+ * Escape a string for JSON
+ * @param[in] s the string
+ * @return the string with the quotes, the backslashes and the control characters escaped
+ */
+std::string escape(const std::string& s)
+{
+    std::string escaped;
+    escaped.reserve(s.size());
+    for(const char c : s)
+    {
+        if(c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if(static_cast<unsigned char>(c) < 0x20)
+        {
+            std::ostringstream code;
+            code << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+            escaped += code.str();
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Replace {name} in the path of an exported file by the name of the input without its extension
+ * @param[in] path the path of the exported file
+ * @param[in] input the file of the model
+ * @return the path
+ */
+std::string exportPath(std::string path, const std::string& input)
+{
+    const std::string pattern{"{name}"};
+    const std::string stem = std::filesystem::path(input).stem().string();
+    for(auto pos = path.find(pattern); pos != std::string::npos; pos = path.find(pattern, pos + stem.size()))
+    {
+        path.replace(pos, pattern.size(), stem);
+    }
+    return path;
+}
+
+} // namespace
+
+bool Pipeline::parse(const std::string& text)
+{
+    std::istringstream stages(text);
+    std::string item;
+    while(std::getline(stages, item, ','))
+    {
+        std::istringstream fields(trim(item));
+        std::string stageName;
+        if(!(fields >> stageName))
+        {
+            LOG_ERROR(General, "empty stage in the pipeline \"" << text << "\"");
+            return false;
+        }
+        std::vector<std::string> args;
+        for(std::string arg; fields >> arg;)
+        {
+            args.push_back(arg);
+        }
+
+        PipelineStage stage;
+        bool valid{true};
+        try
+        {
+            if(stageName == "weld" || stageName == "repair")
+            {
+                stage.kind = (stageName == "weld") ? PipelineStage::Kind::Weld : PipelineStage::Kind::Repair;
+                stage.value = args.empty() ? 0.f : std::stof(args[0]);
+                valid = args.size() <= 1 && stage.value >= 0.f;
+            }
+            else if(stageName == "normals")
+            {
+                stage.kind = PipelineStage::Kind::Normals;
+                valid = args.empty() || (args.size() == 1 && parseAngleWeighting(args[0], stage.weighting));
+            }
+            else if(stageName == "optimize")
+            {
+                stage.kind = PipelineStage::Kind::Optimize;
+                valid = args.empty();
+            }
+            else if(stageName == "subdivide")
+            {
+                stage.kind = PipelineStage::Kind::Subdivide;
+                valid = args.size() == 1;
+                stage.value = valid ? static_cast<float>(std::stoul(args[0])) : 0.f;
+                valid = valid && stage.value <= MAX_SUBDIVISION_STEPS;
+            }
+            else if(stageName == "decimate")
+            {
+                stage.kind = PipelineStage::Kind::Decimate;
+                valid = args.size() == 1;
+                stage.value = valid ? static_cast<float>(std::stoul(args[0])) : 0.f;
+                valid = valid && stage.value >= 1.f;
+            }
+            else if(stageName == "export")
+            {
+                stage.kind = PipelineStage::Kind::Export;
+                valid = args.size() == 1;
+                stage.path = valid ? args[0] : std::string{};
+            }
+            else
+            {
+                LOG_ERROR(General, "unknown stage " << stageName << " in the pipeline \"" << text << "\"");
+                return false;
+            }
+        }
+        catch(const std::logic_error&)
+        {
+            valid = false;
+        }
+        if(!valid)
+        {
+            LOG_ERROR(General, "invalid arguments of the stage \"" << trim(item) << "\"");
+            return false;
+        }
+        add(stage);
+    }
+    return true;
+}
+
+PipelineStats Pipeline::run(const std::string& input) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    PipelineStats stats;
+    stats.input = input;
+    MeshBatch mesh;
+
+    // each stage is measured alone, its peak memory included
+    const auto measure = [&input, &mesh, &stats](const char* stageName, auto&& fn) {
+        resetPeakResident();
+        PipelineStageStats stage;
+        stage.name = stageName;
+        const auto stageStart = std::chrono::steady_clock::now();
+        bool succeeded{false};
+        try
+        {
+            succeeded = fn(stage);
+        }
+        catch(const std::exception& e)
+        {
+            // eg a line of an OBJ file that cannot be parsed, or an allocation that failed
+            LOG_ERROR(General, input << ": " << stageName << ": " << e.what());
+        }
+        stage.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stageStart).count();
+        stage.vertices = mesh.vertices.size();
+        stage.faces = mesh.faces.size();
+        stage.peakBytes = peakResidentBytes();
+        stats.peakBytes = std::max(stats.peakBytes, stage.peakBytes);
+        stats.stages.push_back(std::move(stage));
+        return succeeded;
+    };
+
+    stats.succeeded = measure("load", [&input, &mesh](PipelineStageStats&) {
+        if(!MeshModel::read(input, 0.f, mesh.vertices, mesh.faces, mesh.normals))
+        {
+            LOG_ERROR(General, "error while reading " << input);
+            return false;
+        }
+        return true;
+    });
+    for(const auto& stage : _stages)
+    {
+        if(!stats.succeeded)
+        {
+            break;
+        }
+        stats.succeeded = measure(name(stage.kind), [this, &stage, &input, &mesh](PipelineStageStats& stageStats) {
+            return apply(stage, input, mesh, stageStats);
+        });
+    }
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+bool Pipeline::apply(const PipelineStage& stage, const std::string& input, MeshBatch& mesh, PipelineStageStats& stats) const
+{
+    switch(stage.kind)
+    {
+        case PipelineStage::Kind::Weld:
+        {
+            std::vector<point3d> welded;
+            const std::vector<idxtype> remap = weldVertices(mesh.vertices, stage.value, welded, _numThreads);
+            mesh.vertices.swap(welded);
+            const std::size_t collapsed = remapFaces(remap, mesh.faces);
+            mesh.normals.clear();
+            stats.values.emplace_back("collapsedFaces", static_cast<double>(collapsed));
+            return true;
+        }
+        case PipelineStage::Kind::Repair:
+        {
+            const RepairReport report = repairMesh(mesh.vertices, mesh.faces, stage.value, _numThreads);
+            mesh.normals.clear();
+            stats.values.emplace_back("collapsedFaces", static_cast<double>(report.collapsedFaces));
+            stats.values.emplace_back("zeroAreaFaces", static_cast<double>(report.zeroAreaFaces));
+            stats.values.emplace_back("duplicateFaces", static_cast<double>(report.duplicateFaces));
+            stats.values.emplace_back("unreferencedVertices", static_cast<double>(report.unreferencedVertices));
+            stats.values.emplace_back("boundaryEdges", static_cast<double>(report.edges.boundary));
+            stats.values.emplace_back("nonManifoldEdges", static_cast<double>(report.edges.nonManifold));
+            return true;
+        }
+        case PipelineStage::Kind::Normals:
+        {
+            computeVertexNormals(mesh.vertices, mesh.faces, mesh.normals, stage.weighting);
+            for(auto& n : mesh.normals)
+            {
+                n.normalize();
+            }
+            return true;
+        }
+        case PipelineStage::Kind::Subdivide:
+        {
+            const auto steps = static_cast<unsigned>(stage.value);
+            const std::uint64_t key = _cache ? MeshCache::key(hashMesh(mesh.vertices, mesh.faces), LOOP_CACHE_OPERATION, steps) : 0;
+            MeshLevel cached;
+            if(_cache && _cache->load(key, cached))
+            {
+                mesh.vertices = std::move(cached.vertices);
+                mesh.normals = std::move(cached.normals);
+                cached.faces.visit([&mesh](const auto& faces) {
+                    mesh.faces.clear();
+                    mesh.faces.reserve(faces.size());
+                    for(const auto& f : faces)
+                    {
+                        mesh.faces.emplace_back(f.v1, f.v2, f.v3);
+                    }
+                });
+                stats.values.emplace_back("cacheHit", 1.);
+                return true;
+            }
+            // the temporary data of all the steps in the same arena
+            Arena scratch;
+            MeshBatch subdivided;
+            for(auto step = 0U; step < steps; ++step)
+            {
+                loopSubdivision(mesh.vertices, mesh.faces, subdivided.vertices, subdivided.faces, subdivided.normals, scratch);
+                std::swap(mesh, subdivided);
+            }
+            if(_cache)
+            {
+                cached.vertices = mesh.vertices;
+                cached.normals = mesh.normals;
+                cached.faces.assign(mesh.faces, mesh.vertices.size());
+                _cache->store(key, cached);
+                stats.values.emplace_back("cacheHit", 0.);
+            }
+            return true;
+        }
+        case PipelineStage::Kind::Decimate:
+        {
+            decimateMesh(mesh.vertices, mesh.faces, static_cast<unsigned>(stage.value), _numThreads);
+            mesh.normals.clear();
+            return true;
+        }
+        case PipelineStage::Kind::Optimize:
+        {
+            stats.values.emplace_back("acmrBefore", averageCacheMissRatio(mesh.vertices.size(), mesh.faces));
+            optimizeVertexCache(mesh.vertices.size(), mesh.faces);
+            optimizeVertexFetch(mesh.vertices, mesh.normals, mesh.faces);
+            stats.values.emplace_back("acmrAfter", averageCacheMissRatio(mesh.vertices.size(), mesh.faces));
+            return true;
+        }
+        case PipelineStage::Kind::Export:
+        {
+            const std::filesystem::path path = exportPath(stage.path, input);
+            if(path.has_parent_path())
+            {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+            if(!MeshModel::write(path.string(), mesh.vertices, mesh.normals, FaceList(mesh.faces, mesh.vertices.size()),
+                                 _numThreads))
+            {
+                return false;
+            }
+            std::error_code error;
+            const auto bytes = std::filesystem::file_size(path, error);
+            stats.values.emplace_back("bytes", error ? 0. : static_cast<double>(bytes));
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Pipeline::name(PipelineStage::Kind kind)
+{
+    switch(kind)
+    {
+        case PipelineStage::Kind::Weld: return "weld";
+        case PipelineStage::Kind::Repair: return "repair";
+        case PipelineStage::Kind::Normals: return "normals";
+        case PipelineStage::Kind::Subdivide: return "subdivide";
+        case PipelineStage::Kind::Decimate: return "decimate";
+        case PipelineStage::Kind::Optimize: return "optimize";
+        case PipelineStage::Kind::Export: return "export";
+    }
+    return "unknown";
+}
+
+std::size_t residentBytes()
+{
+#if defined(PIPELINE_PROC_STATUS)
+    return procStatusBytes("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+std::size_t peakResidentBytes()
+{
+#if defined(PIPELINE_PROC_STATUS)
+    return procStatusBytes("VmHWM:");
+#elif defined(PIPELINE_RUSAGE)
+    rusage usage{};
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024U;
+#endif
+#else
+    return 0;
+#endif
+}
+
+bool resetPeakResident()
+{
+#if defined(PIPELINE_PROC_STATUS)
+    // since Linux 4.0, 5 resets VmHWM to VmRSS
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return clearRefs.good();
+#else
+    return false;
+#endif
+}
+
+void writeStatsJson(std::ostream& os, const std::vector<PipelineStats>& stats)
+{
+    // the sizes in bytes are written in full
+    const auto precision = os.precision(10);
+    os << "[";
+    for(std::size_t i = 0; i < stats.size(); ++i)
+    {
+        const PipelineStats& s = stats[i];
+        os << ((i > 0) ? ",\n" : "\n") << "  {\n"
+           << "    \"input\": \"" << escape(s.input) << "\",\n"
+           << "    \"succeeded\": " << (s.succeeded ? "true" : "false") << ",\n"
+           << "    \"ms\": " << s.ms << ",\n"
+           << "    \"peakBytes\": " << s.peakBytes << ",\n"
+           << "    \"stages\": [";
+        for(std::size_t k = 0; k < s.stages.size(); ++k)
+        {
+            const PipelineStageStats& stage = s.stages[k];
+            os << ((k > 0) ? "," : "") << "\n      {\"name\": \"" << stage.name << "\", \"ms\": " << stage.ms
+               << ", \"vertices\": " << stage.vertices << ", \"faces\": " << stage.faces
+               << ", \"peakBytes\": " << stage.peakBytes;
+            for(const auto& value : stage.values)
+            {
+                os << ", \"" << value.first << "\": " << value.second;
+            }
+            os << "}";
+        }
+        os << "\n    ]\n  }";
+    }
+    os << "\n]\n";
+    os.precision(precision);
+}
+
+std::ostream& operator<<(std::ostream& os, const PipelineStats& s)
+{
+    const auto megabytes = [](std::size_t bytes) { return static_cast<double>(bytes) / (1024. * 1024.); };
+    os << s.input << ": " << (s.succeeded ? "done" : "FAILED") << " in " << s.ms << " ms, peak "
+       << megabytes(s.peakBytes) << " MiB\n";
+    for(const auto& stage : s.stages)
+    {
+        os << "  " << std::left << std::setw(10) << stage.name << std::right << std::setw(10) << std::fixed
+           << std::setprecision(2) << stage.ms << " ms" << std::setw(11) << stage.vertices << " vertices"
+           << std::setw(11) << stage.faces << " faces" << std::setw(9) << std::setprecision(1)
+           << megabytes(stage.peakBytes) << " MiB";
+        os.unsetf(std::ios::fixed);
+        os << std::setprecision(10);
+        for(const auto& value : stage.values)
+        {
+            os << "  " << value.first << " " << value.second;
+        }
+        os << "\n";
+    }
+    return os;
+}
@@ -0,0 +1,195 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "MeshModel.hpp"
+#include "angles.hpp"
+#include "meshCache.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A stage of a processing pipeline and its argument
+ */
+struct PipelineStage
+{
+    /// what the stage does
+    enum class Kind
+    {
+        /// merge the vertices closer than value, see weldVertices
+        Weld,
+        /// weld the vertices closer than value and clean up the faces, see repairMesh
+        Repair,
+        /// compute the normals from the faces
+        Normals,
+        /// apply value steps of Loop subdivision
+        Subdivide,
+        /// cluster the vertices on a grid of value cells, see decimateMesh
+        Decimate,
+        /// reorder the faces for the vertex cache and the vertices for the fetch, see vertexCache.hpp
+        Optimize,
+        /// write the mesh in path
+        Export
+    };
+
+    /// what the stage does
+    Kind kind{Kind::Normals};
+    /// the numeric argument of the stage, if any
+    float value{0.f};
+    /// the file of Export, where {name} is replaced by the name of the input without its extension
+    std::string path{};
+    /// how Normals weights the normals of the faces by their angles
+    AngleWeighting weighting{AngleWeighting::Exact};
+};
+
+/**
+ * The measures of a stage run on a model
+ */
+struct PipelineStageStats
+{
+    /// the name of the stage, load for the reading of the input
+    std::string name{};
+    /// the duration of the stage in milliseconds
+    double ms{0};
+    /// the number of vertices after the stage
+    std::size_t vertices{0};
+    /// the number of faces after the stage
+    std::size_t faces{0};
+    /// the maximum resident memory of the process during the stage in bytes
+    std::size_t peakBytes{0};
+    /// the values specific to the stage, eg the cache miss ratios of optimize
+    std::vector<std::pair<std::string, double>> values{};
+};
+
+/**
+ * The measures of a pipeline run on a model
+ */
+struct PipelineStats
+{
+    /// the input file
+    std::string input{};
+    /// true if all the stages succeeded
+    bool succeeded{false};
+    /// the duration of the whole pipeline in milliseconds
+    double ms{0};
+    /// the maximum resident memory of the process during the pipeline in bytes
+    std::size_t peakBytes{0};
+    /// the stages that have been run, the failed one last
+    std::vector<PipelineStageStats> stages{};
+};
+
+/**
+ * A sequence of processing stages run on models without rendering them, eg to batch-process assets.
+ * Each model is read, then transformed by the stages in order. The normals are dropped by the
+ * stages changing the vertices (weld, repair, decimate) and computed again by normals and subdivide.
+ */
+class Pipeline
+{
+public:
+    /**
+     * Create an empty pipeline
+     * @param[in] numThreads the number of threads of the stages that use several, 0 to use all the cores
+     */
+    explicit Pipeline(unsigned numThreads = 0) : _numThreads(numThreads) { }
+
+    /**
+     * Parse a pipeline and append its stages, eg "weld 1e-5, subdivide 2, optimize, export out/{name}.bmesh".
+     * The stages are separated by commas, each one is a name followed by its argument if any: weld [EPS],
+     * repair [EPS], normals [exact|accurate|fast], subdivide LEVELS, decimate CELLS, optimize, export FILE
+     * @param[in] text the stages
+     * @return false if a stage or an argument is not valid, with a message in the log
+     */
+    bool parse(const std::string& text);
+
+    /**
+     * Append a stage
+     * @param[in] stage the stage
+     */
+    void add(const PipelineStage& stage) { _stages.push_back(stage); }
+
+    /// the stages
+    [[nodiscard]] const std::vector<PipelineStage>& stages() const { return _stages; }
+
+    /**
+     * Use a cache for subdivide: the result is looked up by the hash of the mesh and the number of
+     * steps before being computed, and stored once computed
+     * @param[in] cache the cache, nullptr to always subdivide
+     */
+    void setCache(std::shared_ptr<MeshCache> cache) { _cache = std::move(cache); }
+
+    /**
+     * Read a model and run the stages on it, measuring each one. It stops at the first stage that fails.
+     * @param[in] input the file of the model
+     * @return the measures, succeeded is false if a stage failed
+     */
+    [[nodiscard]] PipelineStats run(const std::string& input) const;
+
+    /**
+     * Return the name of a kind of stage, as parsed
+     * @param[in] kind the kind of stage
+     * @return the name
+     */
+    static const char* name(PipelineStage::Kind kind);
+
+private:
+    /**
+     * Run a stage on a mesh
+     * @param[in] stage the stage
+     * @param[in] input the file of the model
+     * @param[in,out] mesh the mesh
+     * @param[in,out] stats the measures of the stage, to add its specific values
+     * @return false if the stage failed
+     */
+    bool apply(const PipelineStage& stage, const std::string& input, MeshBatch& mesh, PipelineStageStats& stats) const;
+
+    /// the stages in order
+    std::vector<PipelineStage> _stages{};
+    /// the number of threads of the stages, 0 to use all the cores
+    unsigned _numThreads{0};
+    /// the cache of subdivide, if any
+    std::shared_ptr<MeshCache> _cache{};
+};
+
+/**
+ * Return the resident memory of the process
+ * @return the size in bytes, 0 if it cannot be measured on this system
+ */
+std::size_t residentBytes();
+
+/**
+ * Return the maximum resident memory of the process since the last call to resetPeakResident, or
+ * since its start
+ * @return the size in bytes, 0 if it cannot be measured on this system
+ */
+std::size_t peakResidentBytes();
+
+/**
+ * Start measuring the maximum resident memory again from the current one, on Linux. Elsewhere the
+ * maximum stays the one since the start of the process.
+ * @return true if the maximum has been reset
+ */
+bool resetPeakResident();
+
+/**
+ * Write the measures of pipelines in JSON: an array of objects, one per input
+ * @param[in,out] os the stream
+ * @param[in] stats the measures of each input
+ */
+void writeStatsJson(std::ostream& os, const std::vector<PipelineStats>& stats);
+
+/**
+ * Print the measures of a pipeline on a stream, one line per stage
+ * @param[in,out] os the stream
+ * @param[in] s the measures
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const PipelineStats& s);
@@ -0,0 +1,768 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "plyReader.hpp"
+#include "logger.hpp"
+#include "mappedFile.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+
+namespace ply {
+
+std::size_t Element::stride() const
+{
+    std::size_t res{0};
+    for(const auto& p : properties)
+    {
+        if(p.isList)
+        {
+            return 0;
+        }
+        res += sizeOf(p.type);
+    }
+    return res;
+}
+
+int Element::find(const std::string& propertyName) const
+{
+    for(std::size_t i = 0; i < properties.size(); ++i)
+    {
+        if(properties[i].name == propertyName)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+namespace {
+
+/**
+ * Return the type corresponding to a name of the header, both the original names (uchar) and the
+ * sized ones (uint8) are accepted
+ * @param[in] name the name
+ * @param[out] type the type
+ * @return true if the name is known, false otherwise
+ */
+bool parseType(const std::string& name, Type& type)
+{
+    static const std::pair<const char*, Type> names[]{
+        {"char", Type::Int8},     {"int8", Type::Int8},       {"uchar", Type::UInt8},    {"uint8", Type::UInt8},
+        {"short", Type::Int16},   {"int16", Type::Int16},     {"ushort", Type::UInt16},  {"uint16", Type::UInt16},
+        {"int", Type::Int32},     {"int32", Type::Int32},     {"uint", Type::UInt32},    {"uint32", Type::UInt32},
+        {"float", Type::Float32}, {"float32", Type::Float32}, {"double", Type::Float64}, {"float64", Type::Float64}};
+    for(const auto& [n, t] : names)
+    {
+        if(name == n)
+        {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool parseHeader(const char* data, std::size_t size, Header& header)
+{
+    header = Header{};
+    const char* const end = data + size;
+    const char* line = data;
+    bool first{true};
+    bool hasFormat{false};
+    while(line < end)
+    {
+        const char* eol = std::find(line, end, '\n');
+        if(eol == end)
+        {
+            LOG_ERROR(Loader, "The PLY header is not terminated by end_header");
+            return false;
+        }
+        // the files written on Windows end the lines with \r\n
+        std::istringstream tokens(std::string(line, (eol > line && eol[-1] == '\r') ? eol - 1 : eol));
+        line = eol + 1;
+        std::string keyword;
+        tokens >> keyword;
+        if(first)
+        {
+            if(keyword != "ply")
+            {
+                LOG_ERROR(Loader, "Not a PLY file");
+                return false;
+            }
+            first = false;
+        }
+        else if(keyword == "format")
+        {
+            std::string format;
+            std::string version;
+            tokens >> format >> version;
+            if(format == "ascii")
+            {
+                header.format = Format::Ascii;
+            }
+            else if(format == "binary_little_endian")
+            {
+                header.format = Format::BinaryLittleEndian;
+            }
+            else if(format == "binary_big_endian")
+            {
+                header.format = Format::BinaryBigEndian;
+            }
+            else
+            {
+                LOG_ERROR(Loader, "Unknown PLY format " << format);
+                return false;
+            }
+            hasFormat = true;
+        }
+        else if(keyword == "element")
+        {
+            Element e;
+            if(!(tokens >> e.name >> e.count))
+            {
+                LOG_ERROR(Loader, "Invalid PLY element declaration");
+                return false;
+            }
+            header.elements.push_back(std::move(e));
+        }
+        else if(keyword == "property")
+        {
+            if(header.elements.empty())
+            {
+                LOG_ERROR(Loader, "PLY property declared before any element");
+                return false;
+            }
+            Property p;
+            std::string type;
+            tokens >> type;
+            bool valid{true};
+            if(type == "list")
+            {
+                std::string countType;
+                tokens >> countType >> type;
+                p.isList = true;
+                valid = parseType(countType, p.countType);
+            }
+            valid = valid && parseType(type, p.type) && static_cast<bool>(tokens >> p.name);
+            if(!valid)
+            {
+                LOG_ERROR(Loader, "Invalid PLY property declaration");
+                return false;
+            }
+            header.elements.back().properties.push_back(std::move(p));
+        }
+        else if(keyword == "end_header")
+        {
+            if(!hasFormat)
+            {
+                LOG_ERROR(Loader, "The PLY header has no format");
+                return false;
+            }
+            header.size = static_cast<std::size_t>(line - data);
+            return true;
+        }
+        else if(keyword != "comment" && keyword != "obj_info" && !keyword.empty())
+        {
+            LOG_ERROR(Loader, "Unknown PLY keyword " << keyword);
+            return false;
+        }
+    }
+    LOG_ERROR(Loader, "The PLY header is not terminated by end_header");
+    return false;
+}
+
+} // namespace ply
+
+namespace {
+
+using ply::Type;
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+constexpr ply::Format NATIVE_FORMAT{ply::Format::BinaryBigEndian};
+#else
+constexpr ply::Format NATIVE_FORMAT{ply::Format::BinaryLittleEndian};
+#endif
+
+static_assert(sizeof(point3d) == 3 * sizeof(float) && std::is_trivially_copyable_v<point3d>,
+              "the vertex blocks are copied directly in the point3d arrays");
+
+/**
+ * Read a scalar of the file
+ * @tparam T the type stored in the file
+ * @param[in] p the position of the scalar
+ * @param[in] swap true if the byte order of the file is not the one of the machine
+ * @return the value
+ */
+template<typename T>
+T loadScalar(const char* p, bool swap)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if(swap)
+    {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+/**
+ * Read a scalar of any type of the file and convert it
+ * @tparam T the type of the result
+ * @param[in] p the position of the scalar
+ * @param[in] type the type in the file
+ * @param[in] swap true if the byte order of the file is not the one of the machine
+ * @return the value
+ */
+template<typename T>
+T loadAs(const char* p, Type type, bool swap)
+{
+    switch(type)
+    {
+        case Type::Int8: return static_cast<T>(loadScalar<std::int8_t>(p, swap));
+        case Type::UInt8: return static_cast<T>(loadScalar<std::uint8_t>(p, swap));
+        case Type::Int16: return static_cast<T>(loadScalar<std::int16_t>(p, swap));
+        case Type::UInt16: return static_cast<T>(loadScalar<std::uint16_t>(p, swap));
+        case Type::Int32: return static_cast<T>(loadScalar<std::int32_t>(p, swap));
+        case Type::UInt32: return static_cast<T>(loadScalar<std::uint32_t>(p, swap));
+        case Type::Float32: return static_cast<T>(loadScalar<float>(p, swap));
+        case Type::Float64: return static_cast<T>(loadScalar<double>(p, swap));
+    }
+    return T{};
+}
+
+/**
+ * Read the scalars of the binary formats one after the other
+ */
+class BinaryCursor
+{
+public:
+    BinaryCursor(const char* begin, const char* end, bool swap) : _p(begin), _end(end), _swap(swap) { }
+
+    template<typename T>
+    bool read(Type type, T& value)
+    {
+        const std::size_t size = ply::sizeOf(type);
+        if(remaining() < size)
+        {
+            return false;
+        }
+        value = loadAs<T>(_p, type, _swap);
+        _p += size;
+        return true;
+    }
+
+    bool skip(Type type) { return skipBytes(ply::sizeOf(type)); }
+
+    bool skipBytes(std::size_t size)
+    {
+        if(remaining() < size)
+        {
+            return false;
+        }
+        _p += size;
+        return true;
+    }
+
+    [[nodiscard]] const char* position() const { return _p; }
+    [[nodiscard]] std::size_t remaining() const { return static_cast<std::size_t>(_end - _p); }
+    [[nodiscard]] bool swap() const { return _swap; }
+
+private:
+    const char* _p;
+    const char* _end;
+    bool _swap;
+};
+
+/**
+ * Read the scalars of the ASCII format, separated by spaces or line breaks
+ */
+class AsciiCursor
+{
+public:
+    AsciiCursor(const char* begin, const char* end) : _p(begin), _end(end) { }
+
+    template<typename T>
+    bool read(Type type, T& value)
+    {
+        skipSpaces();
+        // the integers are parsed as integers, so that the large indices are exact
+        if(type == Type::Float32 || type == Type::Float64)
+        {
+            std::conditional_t<std::is_floating_point_v<T>, T, double> v{};
+            const auto [ptr, ec] = std::from_chars(_p, _end, v);
+            if(ec != std::errc())
+            {
+                return false;
+            }
+            value = static_cast<T>(v);
+            _p = ptr;
+        }
+        else
+        {
+            std::int64_t v{};
+            const auto [ptr, ec] = std::from_chars(_p, _end, v);
+            if(ec != std::errc())
+            {
+                return false;
+            }
+            value = static_cast<T>(v);
+            _p = ptr;
+        }
+        return true;
+    }
+
+    bool skip(Type /*type*/)
+    {
+        skipSpaces();
+        const char* start = _p;
+        while(_p < _end && !isSpace(*_p))
+        {
+            ++_p;
+        }
+        return _p > start;
+    }
+
+private:
+    static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skipSpaces()
+    {
+        while(_p < _end && isSpace(*_p))
+        {
+            ++_p;
+        }
+    }
+
+    const char* _p;
+    const char* _end;
+};
+
+/**
+ * Skip a property of an element
+ * @tparam Cursor BinaryCursor or AsciiCursor
+ * @param[in,out] in the cursor
+ * @param[in] p the property
+ * @return true if everything went well, false otherwise
+ */
+template<typename Cursor>
+bool skipProperty(Cursor& in, const ply::Property& p)
+{
+    if(!p.isList)
+    {
+        return in.skip(p.type);
+    }
+    std::int64_t count{0};
+    if(!in.read(p.countType, count) || count < 0)
+    {
+        return false;
+    }
+    for(std::int64_t i = 0; i < count; ++i)
+    {
+        if(!in.skip(p.type))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Skip all the instances of an element
+ * @tparam Cursor BinaryCursor or AsciiCursor
+ * @param[in,out] in the cursor
+ * @param[in] e the element
+ * @return true if everything went well, false otherwise
+ */
+template<typename Cursor>
+bool skipElement(Cursor& in, const ply::Element& e)
+{
+    if constexpr(std::is_same_v<Cursor, BinaryCursor>)
+    {
+        const std::size_t stride = e.stride();
+        if(stride > 0 || e.properties.empty())
+        {
+            return (e.count <= in.remaining() / std::max<std::size_t>(stride, 1)) && in.skipBytes(e.count * stride);
+        }
+    }
+    for(std::uint64_t i = 0; i < e.count; ++i)
+    {
+        for(const auto& p : e.properties)
+        {
+            if(!skipProperty(in, p))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * The position of the properties of the vertex element that are read
+ */
+struct VertexLayout
+{
+    /// the indices of x, y, z, nx, ny, nz in the properties, -1 if absent
+    int index[6]{-1, -1, -1, -1, -1, -1};
+
+    explicit VertexLayout(const ply::Element& e)
+    {
+        const char* names[6]{"x", "y", "z", "nx", "ny", "nz"};
+        for(std::size_t i = 0; i < 6; ++i)
+        {
+            index[i] = e.find(names[i]);
+        }
+    }
+
+    [[nodiscard]] bool hasPositions() const { return index[0] >= 0 && index[1] >= 0 && index[2] >= 0; }
+    [[nodiscard]] bool hasNormals() const { return index[3] >= 0 && index[4] >= 0 && index[5] >= 0; }
+};
+
+/**
+ * Read the vertex element with a fixed size in a binary format: the properties are read at their
+ * offset in each instance, or the whole block is copied if it has the layout of point3d
+ * @param[in,out] in the cursor
+ * @param[in] e the vertex element, it has no list
+ * @param[in] layout the properties to read
+ * @param[out] vertices the vertices
+ * @param[out] normals the normals
+ * @return true if everything went well, false otherwise
+ */
+bool readFixedVertices(BinaryCursor& in, const ply::Element& e, const VertexLayout& layout,
+                       std::vector<point3d>& vertices, std::vector<vec3d>& normals)
+{
+    const std::size_t stride = e.stride();
+    if(e.count > in.remaining() / stride)
+    {
+        return false;
+    }
+    const auto n = static_cast<std::size_t>(e.count);
+    vertices.resize(n);
+    if(layout.hasNormals())
+    {
+        normals.resize(n);
+    }
+
+    std::size_t offsets[6]{};
+    for(std::size_t i = 0, offset = 0; i < e.properties.size(); ++i)
+    {
+        for(std::size_t c = 0; c < 6; ++c)
+        {
+            if(layout.index[c] == static_cast<int>(i))
+            {
+                offsets[c] = offset;
+            }
+        }
+        offset += ply::sizeOf(e.properties[i].type);
+    }
+    const auto typeOf = [&e, &layout](std::size_t c) { return e.properties[static_cast<std::size_t>(layout.index[c])].type; };
+
+    const char* block = in.position();
+    const bool packed = !in.swap() && stride == sizeof(point3d) && offsets[0] == 0 && offsets[1] == 4 && offsets[2] == 8
+                        && typeOf(0) == Type::Float32 && typeOf(1) == Type::Float32 && typeOf(2) == Type::Float32;
+    if(packed)
+    {
+        // the file has the layout of the array: a single copy
+        std::memcpy(static_cast<void*>(vertices.data()), block, n * stride);
+    }
+    else
+    {
+        const std::size_t numComponents = layout.hasNormals() ? 6 : 3;
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            const char* record = block + i * stride;
+            float values[6]{};
+            for(std::size_t c = 0; c < numComponents; ++c)
+            {
+                values[c] = loadAs<float>(record + offsets[c], typeOf(c), in.swap());
+            }
+            vertices[i] = point3d(values[0], values[1], values[2]);
+            if(numComponents == 6)
+            {
+                normals[i] = vec3d(values[3], values[4], values[5]);
+            }
+        }
+    }
+    return in.skipBytes(n * stride);
+}
+
+/**
+ * Read the vertex element property by property
+ * @tparam Cursor BinaryCursor or AsciiCursor
+ * @param[in,out] in the cursor
+ * @param[in] e the vertex element
+ * @param[in] layout the properties to read
+ * @param[out] vertices the vertices
+ * @param[out] normals the normals
+ * @return true if everything went well, false otherwise
+ */
+template<typename Cursor>
+bool readVertices(Cursor& in, const ply::Element& e, const VertexLayout& layout,
+                  std::vector<point3d>& vertices, std::vector<vec3d>& normals)
+{
+    if constexpr(std::is_same_v<Cursor, BinaryCursor>)
+    {
+        if(e.stride() > 0)
+        {
+            return readFixedVertices(in, e, layout, vertices, normals);
+        }
+    }
+    vertices.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(e.count, 1U << 26U)));
+    if(layout.hasNormals())
+    {
+        normals.reserve(vertices.capacity());
+    }
+    for(std::uint64_t i = 0; i < e.count; ++i)
+    {
+        float values[6]{};
+        for(std::size_t p = 0; p < e.properties.size(); ++p)
+        {
+            const auto* c = std::find(std::begin(layout.index), std::end(layout.index), static_cast<int>(p));
+            const bool ok = (c == std::end(layout.index) || e.properties[p].isList)
+                                ? skipProperty(in, e.properties[p])
+                                : in.read(e.properties[p].type, values[c - std::begin(layout.index)]);
+            if(!ok)
+            {
+                return false;
+            }
+        }
+        vertices.emplace_back(values[0], values[1], values[2]);
+        if(layout.hasNormals())
+        {
+            normals.emplace_back(values[3], values[4], values[5]);
+        }
+    }
+    return true;
+}
+
+/**
+ * Read the faces of a binary file made only of the list of indices, with a 1-byte count and 4-byte
+ * indices (the layout written by most tools): the triangles are read with a single copy each
+ * @tparam Swap true if the byte order of the file is not the one of the machine
+ * @param[in,out] in the cursor
+ * @param[in] count the number of faces
+ * @param[in] numVertices the number of vertices, to check the indices
+ * @param[out] mesh the faces
+ * @return the number of faces read, less than count if a face is not a triangle or is invalid
+ */
+template<bool Swap>
+std::uint64_t readTriangles(BinaryCursor& in, std::uint64_t count, std::uint64_t numVertices, std::vector<face>& mesh)
+{
+    constexpr std::size_t RECORD_SIZE{1 + 3 * sizeof(std::uint32_t)};
+    const char* p = in.position();
+    const std::uint64_t available = std::min<std::uint64_t>(count, in.remaining() / RECORD_SIZE);
+    std::uint64_t i{0};
+    for(; i < available; ++i, p += RECORD_SIZE)
+    {
+        if(static_cast<unsigned char>(*p) != 3)
+        {
+            break;
+        }
+        std::uint32_t v[3];
+        std::memcpy(v, p + 1, sizeof(v));
+        if constexpr(Swap)
+        {
+            for(auto& x : v)
+            {
+                x = loadScalar<std::uint32_t>(reinterpret_cast<const char*>(&x), true);
+            }
+        }
+        // the negative int32 indices are large uint32 ones, they are out of range as well
+        if(v[0] >= numVertices || v[1] >= numVertices || v[2] >= numVertices)
+        {
+            break;
+        }
+        mesh.emplace_back(v[0], v[1], v[2]);
+    }
+    in.skipBytes(static_cast<std::size_t>(i) * RECORD_SIZE);
+    return i;
+}
+
+/**
+ * Read the face element
+ * @tparam Cursor BinaryCursor or AsciiCursor
+ * @param[in,out] in the cursor
+ * @param[in] e the face element
+ * @param[in] indices the index of the list of the vertex indices in the properties
+ * @param[in] numVertices the number of vertices, to check the indices
+ * @param[out] mesh the faces
+ * @param[out] error the reason of the failure
+ * @return true if everything went well, false otherwise
+ */
+template<typename Cursor>
+bool readFaces(Cursor& in, const ply::Element& e, std::size_t indices, std::uint64_t numVertices,
+               std::vector<face>& mesh, std::string& error)
+{
+    mesh.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(e.count, 1U << 26U)));
+    std::uint64_t first{0};
+    if constexpr(std::is_same_v<Cursor, BinaryCursor>)
+    {
+        const ply::Property& p = e.properties[indices];
+        if(e.properties.size() == 1 && ply::sizeOf(p.countType) == 1 && ply::sizeOf(p.type) == 4
+           && (p.type == Type::Int32 || p.type == Type::UInt32))
+        {
+            // continue with the generic loop from the first face that is not a triangle
+            first = in.swap() ? readTriangles<true>(in, e.count, numVertices, mesh)
+                              : readTriangles<false>(in, e.count, numVertices, mesh);
+        }
+    }
+
+    std::vector<std::int64_t> polygon;
+    for(std::uint64_t i = first; i < e.count; ++i)
+    {
+        for(std::size_t p = 0; p < e.properties.size(); ++p)
+        {
+            const ply::Property& property = e.properties[p];
+            if(p != indices)
+            {
+                if(!skipProperty(in, property))
+                {
+                    error = "truncated face " + std::to_string(i);
+                    return false;
+                }
+                continue;
+            }
+            std::int64_t count{0};
+            if(!in.read(property.countType, count) || count < 0)
+            {
+                error = "invalid face " + std::to_string(i);
+                return false;
+            }
+            polygon.resize(static_cast<std::size_t>(count));
+            for(auto& v : polygon)
+            {
+                if(!in.read(property.type, v))
+                {
+                    error = "truncated face " + std::to_string(i);
+                    return false;
+                }
+                if(v < 0 || static_cast<std::uint64_t>(v) >= numVertices)
+                {
+                    error = "face " + std::to_string(i) + " has an index out of range";
+                    return false;
+                }
+            }
+            // split the polygon in a fan of triangles around its first vertex
+            for(std::size_t k = 2; k < polygon.size(); ++k)
+            {
+                mesh.emplace_back(static_cast<idxtype>(polygon[0]), static_cast<idxtype>(polygon[k - 1]),
+                                  static_cast<idxtype>(polygon[k]));
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Read all the elements of the file
+ * @tparam Cursor BinaryCursor or AsciiCursor
+ * @param[in,out] in the cursor on the data
+ * @param[in] header the header
+ * @param[out] vertices the vertices
+ * @param[out] mesh the faces
+ * @param[out] normals the normals
+ * @param[out] error the reason of the failure
+ * @return true if everything went well, false otherwise
+ */
+template<typename Cursor>
+bool readElements(Cursor& in, const ply::Header& header, std::vector<point3d>& vertices, std::vector<face>& mesh,
+                  std::vector<vec3d>& normals, std::string& error)
+{
+    const auto vertexElement = std::find_if(header.elements.begin(), header.elements.end(),
+                                            [](const ply::Element& e) { return e.name == "vertex"; });
+    if(vertexElement == header.elements.end() || !VertexLayout(*vertexElement).hasPositions())
+    {
+        error = "no vertex element with x, y and z";
+        return false;
+    }
+    for(const auto& e : header.elements)
+    {
+        bool ok{true};
+        if(&e == &*vertexElement)
+        {
+            ok = readVertices(in, e, VertexLayout(e), vertices, normals);
+        }
+        else if(e.name == "face" && (e.find("vertex_indices") >= 0 || e.find("vertex_index") >= 0))
+        {
+            const int indices = std::max(e.find("vertex_indices"), e.find("vertex_index"));
+            if(!e.properties[static_cast<std::size_t>(indices)].isList)
+            {
+                error = "the vertex indices of the faces are not a list";
+                return false;
+            }
+            if(!readFaces(in, e, static_cast<std::size_t>(indices), vertexElement->count, mesh, error))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            ok = skipElement(in, e);
+        }
+        if(!ok)
+        {
+            error = "truncated or invalid element " + e.name;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadPly(const std::string& filename,
+             std::vector<point3d>& vertices,
+             std::vector<face>& mesh,
+             std::vector<vec3d>& normals)
+{
+    PROFILE_SCOPE("loadPly");
+    vertices.clear();
+    mesh.clear();
+    normals.clear();
+
+    MappedFile file;
+    if(!file.open(filename))
+    {
+        return false;
+    }
+    ply::Header header;
+    if(!ply::parseHeader(file.data(), file.size(), header))
+    {
+        LOG_ERROR(Loader, "Unable to read the PLY header of " << filename);
+        return false;
+    }
+
+    const char* begin = file.data() + header.size;
+    const char* end = file.data() + file.size();
+    std::string error;
+    bool ok{false};
+    if(header.format == ply::Format::Ascii)
+    {
+        AsciiCursor in(begin, end);
+        ok = readElements(in, header, vertices, mesh, normals, error);
+    }
+    else
+    {
+        BinaryCursor in(begin, end, header.format != NATIVE_FORMAT);
+        ok = readElements(in, header, vertices, mesh, normals, error);
+    }
+    if(!ok)
+    {
+        LOG_ERROR(Loader, filename << ": " << error);
+        return false;
+    }
+    LOG_INFO(Loader, "Object loaded with " << vertices.size() << " vertices and " << mesh.size() << " faces");
+    return true;
+}
@@ -0,0 +1,147 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * The Stanford PLY format: a text header describing the elements of the file and their properties,
+ * followed by the data of the elements in ASCII, binary little endian or binary big endian.
+ */
+namespace ply {
+
+/// the encoding of the data after the header
+enum class Format
+{
+    Ascii,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+/// the scalar types of the properties
+enum class Type : std::uint8_t
+{
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+};
+
+/**
+ * Return the size of a scalar type in the binary formats
+ * @param[in] type the type
+ * @return the size in bytes
+ */
+constexpr std::size_t sizeOf(Type type)
+{
+    switch(type)
+    {
+        case Type::Int8:
+        case Type::UInt8: return 1;
+        case Type::Int16:
+        case Type::UInt16: return 2;
+        case Type::Int32:
+        case Type::UInt32:
+        case Type::Float32: return 4;
+        case Type::Float64: return 8;
+    }
+    return 0;
+}
+
+/**
+ * A property of an element, either a scalar or a list of scalars preceded by their count
+ */
+struct Property
+{
+    /// the name of the property, eg x or vertex_indices
+    std::string name{};
+    /// the type of the scalar, or of the items of the list
+    Type type{Type::Float32};
+    /// true if it is a list
+    bool isList{false};
+    /// the type of the count of the list
+    Type countType{Type::UInt8};
+};
+
+/**
+ * An element of the file (eg vertex, face), all its instances are stored one after the other
+ */
+struct Element
+{
+    /// the name of the element
+    std::string name{};
+    /// the number of instances
+    std::uint64_t count{0};
+    /// the properties of each instance, in the order of the file
+    std::vector<Property> properties{};
+
+    /**
+     * Return the size of an instance in the binary formats
+     * @return the size in bytes, 0 if the element has a list property and has no fixed size
+     */
+    [[nodiscard]] std::size_t stride() const;
+
+    /**
+     * Return the index of a property
+     * @param[in] propertyName the name of the property
+     * @return the index in properties, -1 if there is no such property
+     */
+    [[nodiscard]] int find(const std::string& propertyName) const;
+};
+
+/**
+ * The header of the file
+ */
+struct Header
+{
+    /// the encoding of the data
+    Format format{Format::Ascii};
+    /// the elements in the order of the file
+    std::vector<Element> elements{};
+    /// the size of the header in bytes, ie the offset of the data
+    std::size_t size{0};
+};
+
+/**
+ * Parse the header of a PLY file
+ * @param[in] data the beginning of the file
+ * @param[in] size the number of bytes available
+ * @param[out] header the header
+ * @return true if everything went well, false otherwise
+ */
+bool parseHeader(const char* data, std::size_t size, Header& header);
+
+} // namespace ply
+
+/**
+ * Load a mesh from a PLY file. The vertices are read from the x, y and z properties of the vertex
+ * element, the normals from nx, ny and nz if present, and the faces from the vertex_indices (or
+ * vertex_index) list of the face element; the polygons with more than 3 vertices are split in a
+ * fan of triangles. The other elements and properties are skipped.
+ *
+ * The file is mapped in memory and the binary blocks are copied directly into the arrays when
+ * their layout matches the one of point3d.
+ *
+ * @param[in] filename the name of the .ply file
+ * @param[out] vertices the list of vertices
+ * @param[out] mesh the list of faces
+ * @param[out] normals the list of normals, empty if the file has none
+ * @return true if everything went well, false otherwise
+ */
+bool loadPly(const std::string& filename,
+             std::vector<point3d>& vertices,
+             std::vector<face>& mesh,
+             std::vector<vec3d>& normals);
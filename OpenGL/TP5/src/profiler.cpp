@@ -0,0 +1,121 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "profiler.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+StageStats computeStats(const std::string& name, std::vector<double> values)
+{
+    StageStats s{name, 0, 0, 0};
+    if(values.empty())
+    {
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    s.min = values.front();
+    s.avg = std::accumulate(values.begin(), values.end(), .0) / static_cast<double>(values.size());
+    s.p99 = values[static_cast<std::size_t>(.99 * static_cast<double>(values.size() - 1) + .5)];
+    return s;
+}
+
+} // namespace
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : _origin(clock::now()), _frameStart(_origin) { }
+
+std::uint32_t Profiler::threadIndex(std::thread::id id)
+{
+    const auto it = std::find(_threads.begin(), _threads.end(), id);
+    if(it != _threads.end())
+    {
+        return static_cast<std::uint32_t>(it - _threads.begin());
+    }
+    _threads.push_back(id);
+    return static_cast<std::uint32_t>(_threads.size() - 1);
+}
+
+void Profiler::record(const char* name, clock::time_point start, clock::time_point end)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    // the names are string literals: compare the pointers first
+    auto stage = std::find_if(_stages.begin(), _stages.end(), [name](const Stage& s) {
+        return s.name == name || std::strcmp(s.name, name) == 0;
+    });
+    if(stage == _stages.end())
+    {
+        _stages.push_back(Stage{name});
+        stage = _stages.end() - 1;
+    }
+    stage->currentMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+    if(_events.size() < MAX_EVENTS)
+    {
+        namespace chr = std::chrono;
+        _events.push_back({name,
+                           chr::duration_cast<chr::microseconds>(start - _origin).count(),
+                           chr::duration_cast<chr::microseconds>(end - start).count(),
+                           threadIndex(std::this_thread::get_id())});
+    }
+}
+
+void Profiler::endFrame()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    const auto now = clock::now();
+    _frames.push(std::chrono::duration<double, std::milli>(now - _frameStart).count());
+    _frameStart = now;
+    for(auto& stage : _stages)
+    {
+        stage.history.push(stage.currentMs);
+        stage.currentMs = 0;
+    }
+}
+
+std::vector<StageStats> Profiler::stats() const
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<StageStats> res;
+    res.reserve(_stages.size() + 1);
+    res.push_back(computeStats("frame", _frames.values()));
+    for(const auto& stage : _stages)
+    {
+        res.push_back(computeStats(stage.name, stage.history.values()));
+    }
+    return res;
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) const
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    std::ofstream out(filename);
+    if(!out.is_open())
+    {
+        LOG_ERROR(General, "Unable to open file " << filename);
+        return false;
+    }
+    out << "{\"traceEvents\":[\n";
+    for(std::size_t i = 0; i < _events.size(); ++i)
+    {
+        const auto& e = _events[i];
+        out << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs
+            << ",\"pid\":0,\"tid\":" << e.thread << "}" << ((i + 1 < _events.size()) ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    return out.good();
+}
@@ -0,0 +1,183 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * The instrumentation macros. They are compiled out unless ENABLE_PROFILER is defined
+ * (cmake option ENABLE_PROFILER), hence they cost nothing in a normal build.
+ *
+ * PROFILE_SCOPE("name") times the enclosing scope as the stage "name"
+ * PROFILE_FRAME_END() closes the current frame and stores the times of its stages
+ */
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) const ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME_END() Profiler::instance().endFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME_END()
+#endif
+
+/**
+ * A fixed-size circular buffer keeping the last N values
+ */
+template<typename T, std::size_t N>
+class RingBuffer
+{
+public:
+    /**
+     * Add a value, overwriting the oldest one if the buffer is full
+     * @param[in] value the value to add
+     */
+    void push(const T& value)
+    {
+        _data[_next] = value;
+        _next = (_next + 1) % N;
+        _size = (_size < N) ? _size + 1 : N;
+    }
+
+    /**
+     * Return the stored values, oldest first
+     * @return the values
+     */
+    [[nodiscard]] std::vector<T> values() const
+    {
+        std::vector<T> res;
+        res.reserve(_size);
+        const std::size_t first = (_size < N) ? 0 : _next;
+        for(std::size_t i = 0; i < _size; ++i)
+        {
+            res.push_back(_data[(first + i) % N]);
+        }
+        return res;
+    }
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+
+private:
+    std::array<T, N> _data{};
+    std::size_t _next{0};
+    std::size_t _size{0};
+};
+
+/**
+ * The statistics of a stage over the last frames
+ */
+struct StageStats
+{
+    /// the name of the stage
+    std::string name;
+    /// the minimum time per frame in milliseconds
+    double min{0};
+    /// the average time per frame in milliseconds
+    double avg{0};
+    /// the 99th percentile of the time per frame in milliseconds
+    double p99{0};
+};
+
+/**
+ * Collect the time spent in each stage of the frames: for each stage the total time per frame is
+ * kept for the last FRAME_HISTORY frames, and each timed scope is recorded as an event so that
+ * the whole session can be exported as a Chrome trace (chrome://tracing or https://ui.perfetto.dev)
+ */
+class Profiler
+{
+public:
+    /// the number of frames kept for the statistics
+    static constexpr std::size_t FRAME_HISTORY{256};
+    /// the maximum number of events kept for the trace
+    static constexpr std::size_t MAX_EVENTS{1U << 20U};
+
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Return the profiler of the application
+     * @return the profiler
+     */
+    static Profiler& instance();
+
+    /**
+     * Record a timed scope
+     * @param[in] name the name of the stage, it must be a string literal
+     * @param[in] start the start time
+     * @param[in] end the end time
+     */
+    void record(const char* name, clock::time_point start, clock::time_point end);
+
+    /**
+     * Close the current frame: the time of the frame and of each stage are stored in the history
+     */
+    void endFrame();
+
+    /**
+     * Return the statistics of the frame time (named "frame") followed by the ones of each stage
+     * @return the statistics over the last frames
+     */
+    [[nodiscard]] std::vector<StageStats> stats() const;
+
+    /**
+     * Write the recorded events in the Chrome trace event format
+     * @param[in] filename the name of the JSON file
+     * @return true if everything went well, false otherwise
+     */
+    bool writeChromeTrace(const std::string& filename) const;
+
+private:
+    Profiler();
+
+    struct Event
+    {
+        const char* name;
+        std::int64_t startUs;
+        std::int64_t durationUs;
+        std::uint32_t thread;
+    };
+
+    struct Stage
+    {
+        const char* name;
+        double currentMs{0};
+        RingBuffer<double, FRAME_HISTORY> history{};
+    };
+
+    std::uint32_t threadIndex(std::thread::id id);
+
+    mutable std::mutex _mutex;
+    clock::time_point _origin;
+    clock::time_point _frameStart;
+    RingBuffer<double, FRAME_HISTORY> _frames{};
+    std::vector<Stage> _stages{};
+    std::vector<Event> _events{};
+    std::vector<std::thread::id> _threads{};
+};
+
+/**
+ * Time the scope in which it is declared, use PROFILE_SCOPE instead of using it directly
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* name) : _name(name), _start(Profiler::clock::now()) { }
+    ~ScopedTimer() { Profiler::instance().record(_name, _start, Profiler::clock::now()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* _name;
+    Profiler::clock::time_point _start;
+};
@@ -0,0 +1,222 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "quantization.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+namespace {
+
+/**
+ * Round to the nearest integer, std::lround is a call to the math library that is not inlined
+ * @param[in] v the value, in the range of int
+ * @return the nearest integer, the halves are rounded away from 0
+ */
+inline int roundToInt(float v)
+{
+    return static_cast<int>(v + std::copysign(.5f, v));
+}
+
+/**
+ * Quantize a value in [-1, 1] to a signed normalized integer
+ * @tparam T the integer type
+ * @param[in] v the value
+ * @return the integer
+ */
+template<typename T>
+T toSnorm(float v)
+{
+    constexpr auto maxValue = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(roundToInt(std::clamp(v, -1.f, 1.f) * maxValue));
+}
+
+/**
+ * Decode the 2 octahedral coordinates of a normal
+ * @param[in] u the first coordinate in [-1, 1]
+ * @param[in] v the second coordinate in [-1, 1]
+ * @return the unit normal
+ */
+inline vec3d octDecode(float u, float v)
+{
+    vec3d n{u, v, 1.f - std::fabs(u) - std::fabs(v)};
+    // unfold the lower half of the octahedron
+    const float t = std::max(-n.z, 0.f);
+    n.x += (n.x >= 0.f) ? -t : t;
+    n.y += (n.y >= 0.f) ? -t : t;
+    n.normalize();
+    return n;
+}
+
+/**
+ * Return the angle between two unit vectors in degrees
+ * @param[in] a the first vector
+ * @param[in] b the second vector
+ * @return the angle
+ */
+float angleDegrees(const vec3d& a, const vec3d& b)
+{
+    // the cross product is more accurate than the dot product for small angles
+    const float sine = a.cross(b).norm();
+    const float cosine = a.dot(b);
+    return std::atan2(sine, cosine) * 180.f / static_cast<float>(M_PI);
+}
+
+} // namespace
+
+QuantizedPositions::QuantizedPositions(const std::vector<point3d>& vertices, const BoundingBox& bb)
+    : _center((bb.pmax + bb.pmin) * .5f)
+{
+    const v3f halfExtent = (bb.pmax - bb.pmin) * .5f;
+    // a flat box (eg a planar mesh) has a null extent on one axis, any step decodes it exactly
+    const auto stepOf = [](float e) { return (e > 0.f) ? e / MAX_VALUE : 1.f; };
+    _step = v3f(stepOf(halfExtent.x), stepOf(halfExtent.y), stepOf(halfExtent.z));
+
+    const v3f inv(1.f / _step.x, 1.f / _step.y, 1.f / _step.z);
+    const auto quantize = [](float v) {
+        return static_cast<std::int16_t>(roundToInt(std::clamp(v, -float{MAX_VALUE}, float{MAX_VALUE})));
+    };
+    _values.resize(3 * vertices.size());
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        const v3f& p = vertices[i];
+        _values[3 * i] = quantize((p.x - _center.x) * inv.x);
+        _values[3 * i + 1] = quantize((p.y - _center.y) * inv.y);
+        _values[3 * i + 2] = quantize((p.z - _center.z) * inv.z);
+    }
+}
+
+void QuantizedPositions::decode(std::vector<point3d>& vertices) const
+{
+    vertices.resize(size());
+    // go through the floats so that the loop has no dependency between the coordinates
+    auto* out = reinterpret_cast<float*>(vertices.data());
+    const float center[3]{_center.x, _center.y, _center.z};
+    const float step[3]{_step.x, _step.y, _step.z};
+    for(std::size_t i = 0; i < _values.size(); i += 3)
+    {
+        for(std::size_t c = 0; c < 3; ++c)
+        {
+            out[i + c] = center[c] + static_cast<float>(_values[i + c]) * step[c];
+        }
+    }
+}
+
+template<typename T>
+OctahedralNormals<T>::OctahedralNormals(const std::vector<vec3d>& normals)
+{
+    _values.resize(2 * normals.size());
+    for(std::size_t i = 0; i < normals.size(); ++i)
+    {
+        const vec3d& n = normals[i];
+        const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        float u{0.f};
+        float v{0.f};
+        if(l1 > 0.f)
+        {
+            // project on the octahedron
+            u = n.x / l1;
+            v = n.y / l1;
+            if(n.z < 0.f)
+            {
+                // fold the lower half over the upper one
+                const float fu = (1.f - std::fabs(v)) * std::copysign(1.f, u);
+                const float fv = (1.f - std::fabs(u)) * std::copysign(1.f, v);
+                u = fu;
+                v = fv;
+            }
+        }
+        _values[2 * i] = toSnorm<T>(u);
+        _values[2 * i + 1] = toSnorm<T>(v);
+    }
+}
+
+template<typename T>
+vec3d OctahedralNormals<T>::at(std::size_t i) const
+{
+    constexpr float scale = 1.f / static_cast<float>(std::numeric_limits<T>::max());
+    return octDecode(static_cast<float>(_values[2 * i]) * scale, static_cast<float>(_values[2 * i + 1]) * scale);
+}
+
+template<typename T>
+void OctahedralNormals<T>::decode(std::vector<vec3d>& normals) const
+{
+    normals.resize(size());
+    for(std::size_t i = 0; i < normals.size(); ++i)
+    {
+        normals[i] = at(i);
+    }
+}
+
+template class OctahedralNormals<std::int8_t>;
+template class OctahedralNormals<std::int16_t>;
+
+QuantizedMesh::QuantizedMesh(const std::vector<point3d>& vertices,
+                             const std::vector<vec3d>& vertexNormals,
+                             const BoundingBox& bb,
+                             NormalEncoding encoding)
+    : positions(vertices, bb)
+{
+    if(encoding == NormalEncoding::Oct8)
+    {
+        normals = OctNormals8(vertexNormals);
+    }
+    else
+    {
+        normals = OctNormals16(vertexNormals);
+    }
+}
+
+void QuantizedMesh::decode(std::vector<point3d>& vertices, std::vector<vec3d>& vertexNormals) const
+{
+    positions.decode(vertices);
+    std::visit([&](const auto& n) { n.decode(vertexNormals); }, normals);
+}
+
+std::size_t QuantizedMesh::bytes() const
+{
+    return positions.bytes() + std::visit([](const auto& n) { return n.bytes(); }, normals);
+}
+
+QuantizationReport measureQuantization(const std::vector<point3d>& vertices,
+                                       const std::vector<vec3d>& vertexNormals,
+                                       const QuantizedMesh& mesh)
+{
+    assert(mesh.positions.size() == vertices.size());
+    QuantizationReport r;
+    r.floatBytes = vertices.size() * sizeof(point3d) + vertexNormals.size() * sizeof(vec3d);
+    r.quantizedBytes = mesh.bytes();
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        r.maxPositionError = std::max(r.maxPositionError, (mesh.positions.at(i) - vertices[i]).norm());
+    }
+    std::visit(
+        [&](const auto& normals) {
+            assert(normals.size() == vertexNormals.size());
+            for(std::size_t i = 0; i < vertexNormals.size(); ++i)
+            {
+                vec3d n = vertexNormals[i];
+                // the null normals (eg of the unused vertices) have no direction to preserve
+                if(n.norm() > 0.f)
+                {
+                    n.normalize();
+                    r.maxNormalErrorDegrees = std::max(r.maxNormalErrorDegrees, angleDegrees(n, normals.at(i)));
+                }
+            }
+        },
+        mesh.normals);
+    return r;
+}
+
+std::ostream& operator<<(std::ostream& os, const QuantizationReport& r)
+{
+    const double saved = (r.floatBytes > 0) ? 100. * (1. - static_cast<double>(r.quantizedBytes) / static_cast<double>(r.floatBytes)) : 0.;
+    return os << r.floatBytes << " -> " << r.quantizedBytes << " bytes (" << saved << "% saved), max position error "
+              << r.maxPositionError << ", max normal error " << r.maxNormalErrorDegrees << " deg";
+}
@@ -0,0 +1,184 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+#include "objReader.hpp"
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+/**
+ * The positions quantized to 16 bits per coordinate relative to a bounding box: each coordinate is
+ * stored as a signed integer q in [-32767, 32767] and decoded as center + q * step. The error is at
+ * most step / 2 on each axis, ie 1/65534 of the size of the box. The layout (3 GLshort per vertex)
+ * can be given as is to glVertexPointer(3, GL_SHORT, ...) with a glTranslate(center) and a
+ * glScale(step) on the modelview matrix.
+ */
+class QuantizedPositions
+{
+public:
+    /// the largest quantized value
+    static constexpr std::int16_t MAX_VALUE{32767};
+
+    QuantizedPositions() = default;
+
+    /**
+     * Quantize the positions
+     * @param[in] vertices the positions
+     * @param[in] bb a bounding box containing all the positions
+     */
+    QuantizedPositions(const std::vector<point3d>& vertices, const BoundingBox& bb);
+
+    /**
+     * Decode all the positions, the loop is vectorized by the compiler
+     * @param[out] vertices the positions
+     */
+    void decode(std::vector<point3d>& vertices) const;
+
+    /**
+     * Decode one position
+     * @param[in] i the index of the vertex
+     * @return the position
+     */
+    [[nodiscard]] point3d at(std::size_t i) const
+    {
+        return {_center.x + static_cast<float>(_values[3 * i]) * _step.x,
+                _center.y + static_cast<float>(_values[3 * i + 1]) * _step.y,
+                _center.z + static_cast<float>(_values[3 * i + 2]) * _step.z};
+    }
+
+    [[nodiscard]] std::size_t size() const { return _values.size() / 3; }
+    [[nodiscard]] std::size_t bytes() const { return _values.size() * sizeof(std::int16_t); }
+    [[nodiscard]] const std::int16_t* data() const { return _values.data(); }
+    /// the center of the bounding box, the position of the value 0
+    [[nodiscard]] const v3f& center() const { return _center; }
+    /// the size of a quantization step on each axis
+    [[nodiscard]] const v3f& step() const { return _step; }
+
+private:
+    std::vector<std::int16_t> _values;
+    v3f _center;
+    v3f _step;
+};
+
+/**
+ * The unit normals encoded with the octahedral mapping: the direction is projected on the
+ * octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one, and the 2
+ * resulting coordinates in [-1, 1] are stored as signed normalized integers
+ * @tparam T std::int8_t (2 bytes per normal, error < 1 degree) or std::int16_t (4 bytes per normal,
+ * error < 0.01 degree)
+ */
+template<typename T>
+class OctahedralNormals
+{
+public:
+    OctahedralNormals() = default;
+
+    /**
+     * Encode the normals, the null ones are decoded as (0, 0, 1)
+     * @param[in] normals the unit normals
+     */
+    explicit OctahedralNormals(const std::vector<vec3d>& normals);
+
+    /**
+     * Decode all the normals, the loop is vectorized by the compiler
+     * @param[out] normals the unit normals
+     */
+    void decode(std::vector<vec3d>& normals) const;
+
+    /**
+     * Decode one normal
+     * @param[in] i the index of the normal
+     * @return the unit normal
+     */
+    [[nodiscard]] vec3d at(std::size_t i) const;
+
+    [[nodiscard]] std::size_t size() const { return _values.size() / 2; }
+    [[nodiscard]] std::size_t bytes() const { return _values.size() * sizeof(T); }
+
+private:
+    std::vector<T> _values;
+};
+
+using OctNormals8 = OctahedralNormals<std::int8_t>;
+using OctNormals16 = OctahedralNormals<std::int16_t>;
+
+/**
+ * The precision of the encoded normals
+ */
+enum class NormalEncoding
+{
+    Oct8,
+    Oct16
+};
+
+/**
+ * A mesh whose positions and normals are quantized, the faces are not modified
+ */
+struct QuantizedMesh
+{
+    QuantizedPositions positions;
+    std::variant<OctNormals8, OctNormals16> normals;
+
+    /**
+     * Quantize the positions and the normals of a mesh
+     * @param[in] vertices the positions
+     * @param[in] vertexNormals the unit normals
+     * @param[in] bb a bounding box containing all the positions
+     * @param[in] encoding the precision of the normals
+     */
+    QuantizedMesh(const std::vector<point3d>& vertices,
+                  const std::vector<vec3d>& vertexNormals,
+                  const BoundingBox& bb,
+                  NormalEncoding encoding);
+
+    /**
+     * Decode the positions and the normals
+     * @param[out] vertices the positions
+     * @param[out] vertexNormals the unit normals
+     */
+    void decode(std::vector<point3d>& vertices, std::vector<vec3d>& vertexNormals) const;
+
+    /// the memory used by the positions and the normals in bytes
+    [[nodiscard]] std::size_t bytes() const;
+};
+
+/**
+ * The cost and the error of the quantization of a mesh
+ */
+struct QuantizationReport
+{
+    /// the memory used by the positions and the normals as floats
+    std::size_t floatBytes{0};
+    /// the memory used by the quantized positions and normals
+    std::size_t quantizedBytes{0};
+    /// the largest distance between an original position and its decoded value
+    float maxPositionError{0};
+    /// the largest angle between an original normal and its decoded value, in degrees
+    float maxNormalErrorDegrees{0};
+};
+
+/**
+ * Measure the memory saved and the error of a quantized mesh
+ * @param[in] vertices the original positions
+ * @param[in] vertexNormals the original normals
+ * @param[in] mesh the quantized mesh
+ * @return the report
+ */
+QuantizationReport measureQuantization(const std::vector<point3d>& vertices,
+                                       const std::vector<vec3d>& vertexNormals,
+                                       const QuantizedMesh& mesh);
+
+/**
+ * Print the report on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] r the report
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const QuantizationReport& r);
@@ -7,8 +7,7 @@
 #include "rendering.hpp"
 #include "core.hpp"
 #include "geometry.hpp"
-#include <GL/gl.h>
-#include <GL/glu.h>
+#include "profiler.hpp"
 
 /**
  * Draw the wireframe of the model
@@ -17,10 +16,12 @@
  * @param mesh The mesh as a list of faces, each face is a tripleIndex of vertex indices
  * @param params The rendering parameters
  */
-void drawWireframe(const std::vector<point3d>& vertices,
-                   const std::vector<face>& mesh,
+template<typename Index>
+void drawWireframe(Span<const point3d> vertices,
+                   Span<const basicFace<Index>> mesh,
                    const RenderingParameters& params)
 {
+    PROFILE_SCOPE("drawWireframe");
     //**************************************************
     // we first need to disable the lighting in order to
     // draw colored segments
@@ -44,7 +45,7 @@ void drawWireframe(const std::vector<point3d>& vertices,
     //**************************************************
     // for each face of the mesh...
     //**************************************************
-    for (face f: mesh)
+    for (const auto& f: mesh)
     {
         //**************************************************
         // draw the contour of the face as a  GL_LINE_LOOP
@@ -70,17 +71,19 @@ void drawWireframe(const std::vector<point3d>& vertices,
  * @param[in] vertexNormals The list of normals associated to each vertex
  * @param[in] params If smooth is true, the model is drawn with smooth shading, otherwise with flat shading
  */
-void drawFaces(const std::vector<point3d>& vertices,
-                   const std::vector<face>& mesh,
-                   const std::vector<vec3d>& vertexNormals,
+template<typename Index>
+void drawFaces(Span<const point3d> vertices,
+                   Span<const basicFace<Index>> mesh,
+                   Span<const vec3d> vertexNormals,
                    const RenderingParameters& params)
 {
+    PROFILE_SCOPE("drawFaces");
 // shading model to use
    if(!params.smooth)
    {
        glShadeModel(GL_FLAT);
 
-    for (face t : mesh) {
+    for (const auto& t : mesh) {
            //**************************************************
            // Compute the normal to the face and then draw the
            // faces as GL_TRIANGLES assigning the proper normal
@@ -102,7 +105,7 @@ void drawFaces(const std::vector<point3d>& vertices,
        glShadeModel(GL_SMOOTH);
 
 
-    for (face t : mesh) {
+    for (const auto& t : mesh) {
                 auto n1 = vertexNormals[t.v1];
         auto n2 = vertexNormals[t.v2];
         auto n3 = vertexNormals[t.v3];
@@ -127,7 +130,7 @@ void drawFaces(const std::vector<point3d>& vertices,
 //        //**************************************************
 //        // for each face
 //        //**************************************************
-//     for (face t : mesh) {
+//     for (const auto& t : mesh) {
 //            //**************************************************
 //            // Compute the normal to the face and then draw the
 //            // faces as GL_TRIANGLES assigning the proper normal
@@ -212,11 +215,13 @@ void drawFaces(const std::vector<point3d>& vertices,
  * @param vertexNormals The list of normals associated to each vertex
  * @param params The rendering parameters
  */
-void drawArrayFaces(const std::vector<point3d>& vertices,
-                     const std::vector<face>& indices,
-                     const std::vector<vec3d>& vertexNormals,
+template<typename Index>
+void drawArrayFaces(Span<const point3d> vertices,
+                     Span<const basicFace<Index>> indices,
+                     Span<const vec3d> vertexNormals,
                      const RenderingParameters& params)
 {
+    PROFILE_SCOPE("drawArrayFaces");
     if(params.smooth)
     {
         glShadeModel(GL_SMOOTH);
@@ -239,18 +244,18 @@ void drawArrayFaces(const std::vector<point3d>& vertices,
     //****************************************
     // Normal pointer to normal array
     //****************************************
-    glNormalPointer(GL_FLOAT, 0, (float*)&vertexNormals[0]);
+    glNormalPointer(GL_FLOAT, 0, vertexNormals.data());
 
     //****************************************
     // Vertex pointer to Vertex array
     //****************************************
-    glVertexPointer(3,GL_FLOAT, 0, (float*)&vertices[0]);
+    glVertexPointer(3,GL_FLOAT, 0, vertices.data());
 
 
     //****************************************
     // Draw the faces
     //****************************************
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size())*VERTICES_PER_TRIANGLE, GL_UNSIGNED_INT, (idxtype *)&indices[0]);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size())*VERTICES_PER_TRIANGLE, glIndexType<Index>(), indices.data());
 
     //****************************************
     // Disable vertex arrays
@@ -268,8 +273,9 @@ void drawArrayFaces(const std::vector<point3d>& vertices,
 
 //////////////////////////////////////// Nothing to do after this /////////////////////////////////
 
-void drawNormals(const std::vector<point3d>& vertices, const std::vector<vec3d>& vertexNormals)
+void drawNormals(Span<const point3d> vertices, Span<const vec3d> vertexNormals)
 {
+    PROFILE_SCOPE("drawNormals");
     glDisable(GL_LIGHTING);
 
     glColor3f(.8f, .0f, .0f);
@@ -292,9 +298,10 @@ void drawNormals(const std::vector<point3d>& vertices, const std::vector<vec3d>&
     glEnable(GL_LIGHTING);
 }
 
-void drawSolid(const std::vector<point3d>& vertices,
-               const std::vector<face>& indices,
-               std::vector<vec3d>& vertexNormals,
+template<typename Index>
+void drawSolid(Span<const point3d> vertices,
+               Span<const basicFace<Index>> indices,
+               Span<const vec3d> vertexNormals,
                const RenderingParameters& params)
 {
     if(params.useIndexRendering)
@@ -315,8 +322,10 @@ void drawSolid(const std::vector<point3d>& vertices,
  * @param vertexNormals list of normals
  * @param params Rendering parameters
  */
-void draw( const std::vector<point3d> &vertices, const std::vector<face> &indices, std::vector<vec3d> &vertexNormals, const RenderingParameters &params )
+template<typename Index>
+void draw( Span<const point3d> vertices, Span<const basicFace<Index>> indices, Span<const vec3d> vertexNormals, const RenderingParameters &params )
 {
+    PROFILE_SCOPE("draw");
     if ( params.solid )
     {
         drawSolid( vertices, indices, vertexNormals, params );
@@ -325,4 +334,53 @@ void draw( const std::vector<point3d> &vertices, const std::vector<face> &indice
     {
         ::drawWireframe( vertices, indices, params );
     }
-}
\ No newline at end of file
+}
+
+template<typename Index>
+void draw( Span<const point3d> vertices, Span<const basicFace<Index>> indices, Span<const vec3d> vertexNormals, const RenderingParameters &params, SoftwareRasterizer &target )
+{
+    PROFILE_SCOPE("draw (software)");
+    if ( params.solid )
+    {
+        target.drawTriangles( vertices, indices, vertexNormals, params.smooth );
+    }
+    if ( params.wireframe )
+    {
+        // same colors as drawWireframe: black thicker lines on top of the faces, otherwise white thin lines
+        if ( params.solid )
+        {
+            target.drawWireframe( vertices, indices, {.0f, .0f, .0f}, true );
+        }
+        else
+        {
+            target.drawWireframe( vertices, indices, {.8f, .8f, .8f}, false );
+        }
+    }
+}
+
+void drawNormals(Span<const point3d> vertices, Span<const vec3d> vertexNormals, SoftwareRasterizer &target)
+{
+    PROFILE_SCOPE("drawNormals (software)");
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        target.drawLine(vertices[i], vertices[i] + 0.05f * vertexNormals[i], {.8f, .0f, .0f}, true);
+    }
+}
+// the drawing functions are instantiated for the 16-bit and the 32-bit indices
+#define INSTANTIATE_DRAW(Index)                                                                                        \
+    template void drawWireframe(Span<const point3d>, Span<const basicFace<Index>>, const RenderingParameters&);        \
+    template void drawArrayFaces(Span<const point3d>, Span<const basicFace<Index>>, Span<const vec3d>,                 \
+                                 const RenderingParameters&);                                                          \
+    template void drawFaces(Span<const point3d>, Span<const basicFace<Index>>, Span<const vec3d>,                      \
+                            const RenderingParameters&);                                                               \
+    template void drawSolid(Span<const point3d>, Span<const basicFace<Index>>, Span<const vec3d>,                      \
+                            const RenderingParameters&);                                                               \
+    template void draw(Span<const point3d>, Span<const basicFace<Index>>, Span<const vec3d>,                           \
+                       const RenderingParameters&);                                                                    \
+    template void draw(Span<const point3d>, Span<const basicFace<Index>>, Span<const vec3d>,                           \
+                       const RenderingParameters&, SoftwareRasterizer&);
+
+INSTANTIATE_DRAW(idx16type)
+INSTANTIATE_DRAW(idxtype)
+
+#undef INSTANTIATE_DRAW
@@ -7,7 +7,9 @@
 #pragma once
 
 #include "core.hpp"
-#include "openglAll.hpp"
+#include "opengl.hpp"
+#include "softwareRasterizer.hpp"
+#include "span.hpp"
 #include <vector>
 
 /// number of vertices in a triangle
@@ -44,7 +46,8 @@ struct RenderingParameters
 * @param[in] mesh The mesh as a list of faces, each face is a tripleIndex of vertex indices
 * @param[in] params The rendering parameters
 */
-void drawWireframe(const std::vector<point3d> &vertices, const std::vector<face> &indices, const RenderingParameters &params);
+template<typename Index>
+void drawWireframe(Span<const point3d> vertices, Span<const basicFace<Index>> indices, const RenderingParameters &params);
 
 /**
  * Draw the model using the vertex indices and using a single normal for each vertex
@@ -54,9 +57,10 @@ void drawWireframe(const std::vector<point3d> &vertices, const std::vector<face>
  * @param[in] vertexNormals The list of normals associated to each vertex.
  * @param[in] params The rendering parameters
  */
-void drawArrayFaces(const std::vector<point3d> &vertices,
-                     const std::vector<face> &indices,
-                     const std::vector<vec3d> &vertexNormals,
+template<typename Index>
+void drawArrayFaces(Span<const point3d> vertices,
+                     Span<const basicFace<Index>> indices,
+                     Span<const vec3d> vertexNormals,
                      const RenderingParameters &params);
 
 /**
@@ -66,9 +70,10 @@ void drawArrayFaces(const std::vector<point3d> &vertices,
  * @param[in] vertexNormals The list of normals associated to each vertex
  * @param[in] params If smooth is true, the model is drawn with smooth shading, otherwise with flat shading
  */
-void drawFaces(const std::vector<point3d>& vertices,
-                   const std::vector<face>& mesh,
-                   const std::vector<vec3d>& vertexNormals,
+template<typename Index>
+void drawFaces(Span<const point3d> vertices,
+                   Span<const basicFace<Index>> mesh,
+                   Span<const vec3d> vertexNormals,
                    const RenderingParameters& params);
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -78,10 +83,11 @@ void drawFaces(const std::vector<point3d>& vertices,
 * @param[in] vertices The list of vertices
 * @param[in] vertexNormals The list of associated normals
 */
-void drawNormals(const std::vector<point3d> &vertices, const std::vector<vec3d>& vertexNormals);
+void drawNormals(Span<const point3d> vertices, Span<const vec3d> vertexNormals);
 
 
-void drawSolid(const std::vector<point3d> &vertices, const std::vector<face> &indices, std::vector<vec3d> &vertexNormals, const RenderingParameters &params);
+template<typename Index>
+void drawSolid(Span<const point3d> vertices, Span<const basicFace<Index>> indices, Span<const vec3d> vertexNormals, const RenderingParameters &params);
 
 /**
 * Draw the model
@@ -91,4 +97,25 @@ void drawSolid(const std::vector<point3d> &vertices, const std::vector<face> &in
 * @param[in] vertexNormals list of normals
 * @param[in] params Rendering parameters
 */
-void draw(const std::vector<point3d> &vertices, const std::vector<face> &indices, std::vector<vec3d> &vertexNormals, const RenderingParameters &params);
\ No newline at end of file
+template<typename Index>
+void draw(Span<const point3d> vertices, Span<const basicFace<Index>> indices, Span<const vec3d> vertexNormals, const RenderingParameters &params);
+
+/**
+* Draw the model with the software rasterizer instead of OpenGL, same parameters as draw()
+*
+* @param[in] vertices list of vertices
+* @param[in] indices list of faces
+* @param[in] vertexNormals list of normals
+* @param[in] params Rendering parameters
+* @param[in,out] target the software rasterizer to draw into
+*/
+template<typename Index>
+void draw(Span<const point3d> vertices, Span<const basicFace<Index>> indices, Span<const vec3d> vertexNormals, const RenderingParameters &params, SoftwareRasterizer &target);
+
+/**
+* Draw the normals at each vertex of the model with the software rasterizer
+* @param[in] vertices The list of vertices
+* @param[in] vertexNormals The list of associated normals
+* @param[in,out] target the software rasterizer to draw into
+*/
+void drawNormals(Span<const point3d> vertices, Span<const vec3d> vertexNormals, SoftwareRasterizer &target);
\ No newline at end of file
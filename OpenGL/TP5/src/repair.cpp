@@ -0,0 +1,228 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "repair.hpp"
+#include "logger.hpp"
+#include "weld.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+
+namespace {
+
+/**
+ * A face with its vertices sorted, to compare the faces whatever their orientation
+ */
+struct SortedFace
+{
+    idxtype b{0};
+    idxtype c{0};
+    /// the position of the face in the mesh
+    std::uint32_t index{0};
+};
+
+/**
+ * Turn the counts of items per vertex into the offsets of the groups
+ * @param[in,out] offsets the counts of the vertex v at v + 1, its offset at v on return
+ */
+void prefixSum(std::vector<std::uint32_t>& offsets)
+{
+    for(std::size_t v = 1; v < offsets.size(); ++v)
+    {
+        offsets[v] += offsets[v - 1];
+    }
+}
+
+/**
+ * Remove the faces of null area, whose normal is not defined
+ * @param[in] vertices the vertices
+ * @param[in,out] mesh the faces
+ * @return the number of faces removed
+ */
+std::size_t removeZeroAreaFaces(const std::vector<point3d>& vertices, std::vector<face>& mesh)
+{
+    const std::size_t before = mesh.size();
+    mesh.erase(std::remove_if(mesh.begin(), mesh.end(),
+                              [&vertices](const face& f) {
+                                  const point3d& a = vertices[f.v1];
+                                  const vec3d n = (vertices[f.v2] - a).cross(vertices[f.v3] - a);
+                                  return !(n.dot(n) > 0.f);
+                              }),
+               mesh.end());
+    return before - mesh.size();
+}
+
+/**
+ * Remove the faces with the same vertices as a previous face. The faces are grouped by their lowest
+ * vertex with a counting sort, so only the faces of a group, as many as the valence of the vertex,
+ * are compared.
+ * @param[in] numVertices the number of vertices
+ * @param[in,out] mesh the faces
+ * @return the number of faces removed
+ */
+std::size_t removeDuplicateFaces(std::size_t numVertices, std::vector<face>& mesh)
+{
+    std::vector<std::uint32_t> offsets(numVertices + 1, 0);
+    for(const auto& f : mesh)
+    {
+        ++offsets[std::min({f.v1, f.v2, f.v3}) + 1];
+    }
+    prefixSum(offsets);
+    std::vector<SortedFace> grouped(mesh.size());
+    std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for(std::size_t i = 0; i < mesh.size(); ++i)
+    {
+        idxtype v[3]{mesh[i].v1, mesh[i].v2, mesh[i].v3};
+        std::sort(v, v + 3);
+        grouped[next[v[0]]++] = {v[1], v[2], static_cast<std::uint32_t>(i)};
+    }
+
+    std::vector<bool> duplicate(mesh.size(), false);
+    const auto byVertices = [](const SortedFace& l, const SortedFace& r) {
+        return std::tie(l.b, l.c, l.index) < std::tie(r.b, r.c, r.index);
+    };
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        const auto first = grouped.begin() + offsets[v];
+        const auto last = grouped.begin() + offsets[v + 1];
+        std::sort(first, last, byVertices);
+        for(auto it = first; it != last && it + 1 != last; ++it)
+        {
+            // the first face of a run of equal faces is kept
+            if(it->b == (it + 1)->b && it->c == (it + 1)->c)
+            {
+                duplicate[(it + 1)->index] = true;
+            }
+        }
+    }
+
+    std::size_t kept{0};
+    for(std::size_t i = 0; i < mesh.size(); ++i)
+    {
+        if(!duplicate[i])
+        {
+            mesh[kept++] = mesh[i];
+        }
+    }
+    const std::size_t removed = mesh.size() - kept;
+    mesh.resize(kept);
+    return removed;
+}
+
+/**
+ * Remove the vertices that no face uses, keeping the order of the others
+ * @param[in,out] vertices the vertices
+ * @param[in,out] mesh the faces
+ * @return the number of vertices removed
+ */
+std::size_t removeUnreferencedVertices(std::vector<point3d>& vertices, std::vector<face>& mesh)
+{
+    constexpr idxtype UNUSED{~idxtype{0}};
+    std::vector<idxtype> remap(vertices.size(), UNUSED);
+    for(const auto& f : mesh)
+    {
+        remap[f.v1] = remap[f.v2] = remap[f.v3] = 0;
+    }
+    idxtype kept{0};
+    for(std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        if(remap[v] != UNUSED)
+        {
+            vertices[kept] = vertices[v];
+            remap[v] = kept++;
+        }
+    }
+    const std::size_t removed = vertices.size() - kept;
+    vertices.resize(kept);
+    for(auto& f : mesh)
+    {
+        f = face(remap[f.v1], remap[f.v2], remap[f.v3]);
+    }
+    return removed;
+}
+
+} // namespace
+
+EdgeCounts countEdges(std::size_t numVertices, const std::vector<face>& mesh)
+{
+    // the edges grouped by their lowest vertex, only the highest vertex is stored
+    std::vector<std::uint32_t> offsets(numVertices + 1, 0);
+    const auto forEachEdge = [&mesh](auto&& fn) {
+        for(const auto& f : mesh)
+        {
+            fn(f.v1, f.v2);
+            fn(f.v2, f.v3);
+            fn(f.v3, f.v1);
+        }
+    };
+    forEachEdge([&offsets](idxtype a, idxtype b) { ++offsets[std::min(a, b) + 1]; });
+    prefixSum(offsets);
+    std::vector<idxtype> others(3 * mesh.size());
+    std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+    forEachEdge([&](idxtype a, idxtype b) { others[next[std::min(a, b)]++] = std::max(a, b); });
+
+    // the number of faces of an edge is the length of its run in the sorted group
+    EdgeCounts counts;
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        const auto first = others.begin() + offsets[v];
+        const auto last = others.begin() + offsets[v + 1];
+        std::sort(first, last);
+        for(auto it = first; it != last;)
+        {
+            const auto end = std::find_if(it, last, [it](idxtype o) { return o != *it; });
+            const auto faces = end - it;
+            if(faces == 1)
+            {
+                ++counts.boundary;
+            }
+            else if(faces == 2)
+            {
+                ++counts.manifold;
+            }
+            else
+            {
+                ++counts.nonManifold;
+            }
+            it = end;
+        }
+    }
+    return counts;
+}
+
+RepairReport repairMesh(std::vector<point3d>& vertices, std::vector<face>& mesh, float weldEpsilon, unsigned numThreads)
+{
+    const auto start = std::chrono::steady_clock::now();
+    RepairReport report;
+    report.verticesBefore = vertices.size();
+
+    std::vector<point3d> welded;
+    const std::vector<idxtype> remap = weldVertices(vertices, weldEpsilon, welded, numThreads);
+    vertices.swap(welded);
+    report.collapsedFaces = remapFaces(remap, mesh);
+    report.zeroAreaFaces = removeZeroAreaFaces(vertices, mesh);
+    report.duplicateFaces = removeDuplicateFaces(vertices.size(), mesh);
+    report.unreferencedVertices = removeUnreferencedVertices(vertices, mesh);
+    report.verticesAfter = vertices.size();
+    report.edges = countEdges(vertices.size(), mesh);
+    report.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if(report.edges.nonManifold > 0)
+    {
+        LOG_WARNING(Loader, "The mesh has " << report.edges.nonManifold << " non-manifold edges, shared by more than 2 faces");
+    }
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& os, const RepairReport& r)
+{
+    return os << r.verticesBefore << " -> " << r.verticesAfter << " vertices (" << r.unreferencedVertices
+              << " unreferenced), faces removed: " << r.collapsedFaces << " collapsed, " << r.zeroAreaFaces
+              << " of null area, " << r.duplicateFaces << " duplicated; edges: " << r.edges.boundary << " boundary, "
+              << r.edges.manifold << " manifold, " << r.edges.nonManifold << " non-manifold, in " << r.ms << " ms";
+}
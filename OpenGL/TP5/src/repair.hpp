@@ -0,0 +1,82 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * The number of edges of a mesh by number of incident faces
+ */
+struct EdgeCounts
+{
+    /// the edges with one face
+    std::size_t boundary{0};
+    /// the edges with two faces
+    std::size_t manifold{0};
+    /// the edges with more than two faces
+    std::size_t nonManifold{0};
+};
+
+/**
+ * What the repair pass changed in the mesh
+ */
+struct RepairReport
+{
+    /// the number of vertices before the repair
+    std::size_t verticesBefore{0};
+    /// the number of vertices after the repair
+    std::size_t verticesAfter{0};
+    /// the faces removed because two of their vertices were welded
+    std::size_t collapsedFaces{0};
+    /// the faces removed because their vertices are aligned
+    std::size_t zeroAreaFaces{0};
+    /// the faces removed because another face has the same vertices
+    std::size_t duplicateFaces{0};
+    /// the vertices removed because no face uses them
+    std::size_t unreferencedVertices{0};
+    /// the edges of the repaired mesh
+    EdgeCounts edges{};
+    /// the duration of the repair in milliseconds
+    double ms{0};
+};
+
+/**
+ * Count the edges of a mesh by number of incident faces in O(vertices + faces): the edges are
+ * grouped by their lowest vertex, and each group, as small as the valence, is sorted.
+ * @param[in] numVertices the number of vertices
+ * @param[in] mesh the faces
+ * @return the counts
+ */
+EdgeCounts countEdges(std::size_t numVertices, const std::vector<face>& mesh);
+
+/**
+ * Repair a mesh: weld the vertices closer than epsilon with the grid of weldVertices, remove the faces
+ * that become degenerate, the faces of null area, the faces with the same vertices as a previous
+ * face (whatever their orientation) and the unreferenced vertices. The faces keep their order and the
+ * indices are remapped consistently. The edges of the result are counted, the non-manifold ones are
+ * logged as a warning.
+ * @param[in,out] vertices the vertices
+ * @param[in,out] mesh the faces
+ * @param[in] weldEpsilon the distance under which the vertices are merged, 0 to merge only the
+ * vertices with the same coordinates
+ * @param[in] numThreads the number of threads of the welding, 0 to use all the cores
+ * @return what has been changed
+ */
+RepairReport repairMesh(std::vector<point3d>& vertices, std::vector<face>& mesh, float weldEpsilon = 0.f,
+                        unsigned numThreads = 0);
+
+/**
+ * Print the report on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] r the report
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const RepairReport& r);
@@ -0,0 +1,255 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "scene.hpp"
+#include "logger.hpp"
+#include "opengl.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * Return the key identifying a file, the same for the different paths of the same file
+ * @param[in] filename the path of the file
+ * @return the key
+ */
+std::string fileKey(const std::string& filename)
+{
+    std::error_code error;
+    const auto canonical = std::filesystem::weakly_canonical(filename, error);
+    return error ? filename : canonical.string();
+}
+
+/**
+ * Load a model and prepare it
+ * @return the model, nullptr if it could not be loaded
+ */
+std::shared_ptr<MeshModel> loadModel(const std::string& filename, float weldEpsilon, const Scene::PrepareFunction& prepare)
+{
+    auto model = std::make_shared<MeshModel>();
+    if(!model->load(filename, weldEpsilon))
+    {
+        LOG_ERROR(Loader, "error while opening the model " << filename);
+        return nullptr;
+    }
+    if(prepare)
+    {
+        prepare(*model);
+    }
+    return model;
+}
+
+} // namespace
+
+void Scene::add(const std::string& filename)
+{
+    _instances.push_back({filename, nullptr, point3d{}, 1.f, false});
+}
+
+void Scene::add(const std::string& filename, const point3d& position, float scale)
+{
+    _instances.push_back({filename, nullptr, position, scale, true});
+}
+
+bool Scene::readManifest(const std::string& filename)
+{
+    std::ifstream manifest(filename);
+    if(!manifest.is_open())
+    {
+        LOG_ERROR(Loader, "Unable to open file " << filename);
+        return false;
+    }
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    std::string line;
+    for(std::size_t number = 1; std::getline(manifest, line); ++number)
+    {
+        std::istringstream fields(line);
+        std::string path;
+        if(!(fields >> path) || path[0] == '#')
+        {
+            continue;
+        }
+        const std::string model = (directory / path).string();
+        point3d position;
+        if(!(fields >> position.x))
+        {
+            add(model);
+            continue;
+        }
+        float scale{1.f};
+        bool valid = static_cast<bool>(fields >> position.y >> position.z);
+        if(float value; valid && fields >> value)
+        {
+            scale = value;
+        }
+        else
+        {
+            valid = valid && fields.eof();
+        }
+        if(!valid)
+        {
+            LOG_ERROR(Loader, filename << ":" << number << ": expected the path of the model, then x y z and the scale");
+            return false;
+        }
+        add(model, position, scale);
+    }
+    return true;
+}
+
+SceneLoadStats Scene::load(float weldEpsilon, ThreadPool* pool, const PrepareFunction& prepare)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // each file is loaded once, the instances keep the index of their file
+    std::unordered_map<std::string, std::size_t> files;
+    std::vector<std::string> filenames;
+    std::vector<std::size_t> fileOf(_instances.size());
+    for(std::size_t i = 0; i < _instances.size(); ++i)
+    {
+        const auto inserted = files.emplace(fileKey(_instances[i].filename), filenames.size());
+        if(inserted.second)
+        {
+            filenames.push_back(_instances[i].filename);
+        }
+        fileOf[i] = inserted.first->second;
+    }
+
+    std::vector<std::shared_ptr<MeshModel>> models(filenames.size());
+    if(pool != nullptr)
+    {
+        std::vector<std::future<std::shared_ptr<MeshModel>>> futures;
+        futures.reserve(filenames.size());
+        for(const auto& f : filenames)
+        {
+            futures.push_back(pool->submit([&f, weldEpsilon, &prepare] { return loadModel(f, weldEpsilon, prepare); }));
+        }
+        for(std::size_t m = 0; m < futures.size(); ++m)
+        {
+            try
+            {
+                models[m] = futures[m].get();
+            }
+            catch(const std::exception& e)
+            {
+                // eg a line of an OBJ file that cannot be parsed
+                LOG_ERROR(Loader, filenames[m] << ": " << e.what());
+            }
+        }
+    }
+    else
+    {
+        for(std::size_t m = 0; m < filenames.size(); ++m)
+        {
+            try
+            {
+                models[m] = loadModel(filenames[m], weldEpsilon, prepare);
+            }
+            catch(const std::exception& e)
+            {
+                LOG_ERROR(Loader, filenames[m] << ": " << e.what());
+            }
+        }
+    }
+
+    SceneLoadStats stats;
+    std::size_t kept{0};
+    for(std::size_t i = 0; i < _instances.size(); ++i)
+    {
+        if(models[fileOf[i]] != nullptr)
+        {
+            _instances[kept] = std::move(_instances[i]);
+            _instances[kept++].model = models[fileOf[i]];
+        }
+    }
+    _instances.resize(kept);
+    for(const auto& m : models)
+    {
+        if(m != nullptr)
+        {
+            ++stats.models;
+        }
+        else
+        {
+            ++stats.failed;
+        }
+    }
+    stats.instances = _instances.size();
+    layout();
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+void Scene::layout()
+{
+    std::size_t count{0};
+    for(const auto& instance : _instances)
+    {
+        count += instance.placed ? 0U : 1U;
+    }
+    if(count == 0)
+    {
+        return;
+    }
+    // a grid of square cells as close as possible to a square, centered on the origin
+    const auto columns = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const std::size_t rows = (count + columns - 1) / columns;
+    const float cell = 2.f / static_cast<float>(columns);
+    std::size_t index{0};
+    for(auto& instance : _instances)
+    {
+        if(instance.placed)
+        {
+            continue;
+        }
+        const auto column = static_cast<float>(index % columns);
+        const auto row = static_cast<float>(index / columns);
+        instance.position = {-1.f + cell * (column + .5f), cell * (static_cast<float>(rows) * .5f - row - .5f), 0.f};
+        // the unitized models fit in [-1, 1], a margin is left between the cells
+        instance.scale = .45f * cell;
+        ++index;
+    }
+}
+
+void Scene::render(const RenderingParameters& params)
+{
+    for(const auto& instance : _instances)
+    {
+        glPushMatrix();
+        glTranslatef(instance.position.x, instance.position.y, instance.position.z);
+        glScalef(instance.scale, instance.scale, instance.scale);
+        instance.model->render(params);
+        glPopMatrix();
+    }
+}
+
+void Scene::render(SoftwareRasterizer& target, const mat4& modelView, const RenderingParameters& params)
+{
+    for(const auto& instance : _instances)
+    {
+        const mat4 placed = multiply(translationMatrix(instance.position.x, instance.position.y, instance.position.z),
+                                     scalingMatrix(instance.scale));
+        target.setModelView(multiply(modelView, placed));
+        instance.model->render(target, params);
+    }
+    target.setModelView(modelView);
+}
+
+bool Scene::isManifest(const std::string& filename)
+{
+    return std::filesystem::path(filename).extension() == ".scene";
+}
+
+std::ostream& operator<<(std::ostream& os, const SceneLoadStats& s)
+{
+    return os << s.instances << " instances of " << s.models << " models (" << s.failed << " failed) loaded in " << s.ms << " ms";
+}
@@ -0,0 +1,137 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "MeshModel.hpp"
+#include "softwareRasterizer.hpp"
+#include "threadPool.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * An instance of a model in the scene
+ */
+struct SceneInstance
+{
+    /// the file of the model
+    std::string filename{};
+    /// the model, shared by all the instances of the same file
+    std::shared_ptr<MeshModel> model{};
+    /// where the center of the model is placed
+    point3d position{};
+    /// the scale factor of the model
+    float scale{1.f};
+    /// true if the position and the scale are given, false to place the instance on the grid
+    bool placed{false};
+};
+
+/**
+ * What the loading of a scene did
+ */
+struct SceneLoadStats
+{
+    /// the number of instances in the scene
+    std::size_t instances{0};
+    /// the number of files loaded, each one once whatever its number of instances
+    std::size_t models{0};
+    /// the number of files that could not be loaded, their instances are removed
+    std::size_t failed{0};
+    /// the duration of the loading in milliseconds
+    double ms{0};
+};
+
+/**
+ * A set of model instances. The models are loaded concurrently, each file once: the instances of
+ * the same file share its geometry.
+ */
+class Scene
+{
+public:
+    /// a function preparing a model once loaded, eg to unitize it, called by the thread that loaded it
+    using PrepareFunction = std::function<void(MeshModel&)>;
+
+    /**
+     * Add an instance of a model file, placed on the grid by load
+     * @param[in] filename the file of the model
+     */
+    void add(const std::string& filename);
+
+    /**
+     * Add an instance of a model file at a given place
+     * @param[in] filename the file of the model
+     * @param[in] position where the center of the model is placed
+     * @param[in] scale the scale factor of the model
+     */
+    void add(const std::string& filename, const point3d& position, float scale);
+
+    /**
+     * Add the instances listed by a manifest, one per line: the path of the model file, relative to
+     * the manifest, optionally followed by the position "x y z" and the scale. The lines starting
+     * with # are comments.
+     * @param[in] filename the manifest
+     * @return true if everything went well, false otherwise
+     */
+    bool readManifest(const std::string& filename);
+
+    /**
+     * Load the models of the instances, each file once, and place the instances without position on a
+     * grid that fits the unit cube
+     * @param[in] weldEpsilon the distance under which the vertices of the STL triangle soups are merged
+     * @param[in] pool the pool loading the models concurrently, nullptr to load them one after the other
+     * @param[in] prepare the function applied to each model once loaded, if any
+     * @return what has been loaded
+     */
+    SceneLoadStats load(float weldEpsilon = 0.f, ThreadPool* pool = nullptr, const PrepareFunction& prepare = {});
+
+    /**
+     * Render the instances with OpenGL, each one with its own modelview
+     * @param params The rendering parameters
+     */
+    void render(const RenderingParameters& params);
+
+    /**
+     * Render the instances with the software rasterizer
+     * @param target The software rasterizer to draw into
+     * @param modelView The modelview of the scene
+     * @param params The rendering parameters
+     */
+    void render(SoftwareRasterizer& target, const mat4& modelView, const RenderingParameters& params);
+
+    /// the instances
+    [[nodiscard]] const std::vector<SceneInstance>& instances() const { return _instances; }
+    /// true if the scene has no instance
+    [[nodiscard]] bool empty() const { return _instances.empty(); }
+
+    /**
+     * Return true if the file is a scene manifest, ie its extension is .scene
+     * @param[in] filename the file
+     * @return true for a manifest
+     */
+    static bool isManifest(const std::string& filename);
+
+private:
+    /**
+     * Place the instances without position on a grid that fits the unit cube
+     */
+    void layout();
+
+    /// the instances
+    std::vector<SceneInstance> _instances{};
+};
+
+/**
+ * Print the statistics on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] s the statistics
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const SceneLoadStats& s);
@@ -0,0 +1,477 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "soaVertices.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SOA_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC accepts the AVX intrinsics in any function
+#define SOA_TARGET_AVX2
+#else
+// only these functions are compiled for AVX2, they are called after checking the processor
+#define SOA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+void SoAVertices::fromInterleaved(const std::vector<v3f>& vertices)
+{
+    resize(vertices.size());
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        _x[i] = vertices[i].x;
+        _y[i] = vertices[i].y;
+        _z[i] = vertices[i].z;
+    }
+}
+
+void SoAVertices::toInterleaved(std::vector<v3f>& vertices) const
+{
+    vertices.resize(size());
+    for(std::size_t i = 0; i < size(); ++i)
+    {
+        vertices[i] = v3f(_x[i], _y[i], _z[i]);
+    }
+}
+
+namespace {
+
+/// below this length v3f::normalize leaves the vector unchanged
+constexpr float NORMALIZE_THRESHOLD{100.f * std::numeric_limits<float>::epsilon()};
+
+/**
+ * The kernels of one instruction set, they work on one array of floats (the 3 arrays of a
+ * SoAVertices are processed by 3 calls) except minMax and normalize which need the 3 at once
+ */
+struct Kernels
+{
+    /// v[i] += t
+    void (*add)(float* v, std::size_t n, float t);
+    /// v[i] *= a
+    void (*mul)(float* v, std::size_t n, float a);
+    /// the minimum and the maximum of v, n > 0
+    void (*minMax)(const float* v, std::size_t n, float& vmin, float& vmax);
+    /// (x[i], y[i], z[i]) /= norm
+    void (*normalize)(float* x, float* y, float* z, std::size_t n);
+    /// y[i] += a * x[i]
+    void (*axpy)(float a, const float* x, float* y, std::size_t n);
+    /// out[i] = a * x[i] + b * y[i]
+    void (*blend)(float a, const float* x, float b, const float* y, float* out, std::size_t n);
+};
+
+// scalar kernels, also used for the last elements by the SIMD ones
+
+void addScalar(float* v, std::size_t n, float t)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        v[i] += t;
+    }
+}
+
+void mulScalar(float* v, std::size_t n, float a)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        v[i] *= a;
+    }
+}
+
+void minMaxScalar(const float* v, std::size_t n, float& vmin, float& vmax)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        vmin = std::min(vmin, v[i]);
+        vmax = std::max(vmax, v[i]);
+    }
+}
+
+void normalizeScalar(float* x, float* y, float* z, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        const float norm = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        if(norm > NORMALIZE_THRESHOLD)
+        {
+            x[i] /= norm;
+            y[i] /= norm;
+            z[i] /= norm;
+        }
+    }
+}
+
+void axpyScalar(float a, const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        y[i] += a * x[i];
+    }
+}
+
+void blendScalar(float a, const float* x, float b, const float* y, float* out, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        out[i] = a * x[i] + b * y[i];
+    }
+}
+
+const Kernels SCALAR_KERNELS{addScalar, mulScalar, minMaxScalar, normalizeScalar, axpyScalar, blendScalar};
+
+#ifdef SOA_X86
+
+// SSE kernels, SSE2 is always available on x86-64
+// the loads are unaligned since the kernels also get the arrays at an offset, they are as fast as
+// the aligned ones on aligned addresses
+
+void addSSE(float* v, std::size_t n, float t)
+{
+    const __m128 vt = _mm_set1_ps(t);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(v + i, _mm_add_ps(_mm_loadu_ps(v + i), vt));
+    }
+    addScalar(v + i, n - i, t);
+}
+
+void mulSSE(float* v, std::size_t n, float a)
+{
+    const __m128 va = _mm_set1_ps(a);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), va));
+    }
+    mulScalar(v + i, n - i, a);
+}
+
+void minMaxSSE(const float* v, std::size_t n, float& vmin, float& vmax)
+{
+    std::size_t i = 0;
+    if(n >= 4)
+    {
+        __m128 mn = _mm_loadu_ps(v);
+        __m128 mx = mn;
+        for(i = 4; i + 4 <= n; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(v + i);
+            mn = _mm_min_ps(mn, x);
+            mx = _mm_max_ps(mx, x);
+        }
+        alignas(16) float lanesMin[4];
+        alignas(16) float lanesMax[4];
+        _mm_store_ps(lanesMin, mn);
+        _mm_store_ps(lanesMax, mx);
+        minMaxScalar(lanesMin, 4, vmin, vmax);
+        minMaxScalar(lanesMax, 4, vmin, vmax);
+    }
+    minMaxScalar(v + i, n - i, vmin, vmax);
+}
+
+void normalizeSSE(float* x, float* y, float* z, std::size_t n)
+{
+    const __m128 threshold = _mm_set1_ps(NORMALIZE_THRESHOLD);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        const __m128 vx = _mm_loadu_ps(x + i);
+        const __m128 vy = _mm_loadu_ps(y + i);
+        const __m128 vz = _mm_loadu_ps(z + i);
+        const __m128 norm =
+            _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        // the short vectors are divided by 1, SSE2 has no blend
+        const __m128 keep = _mm_cmpgt_ps(norm, threshold);
+        const __m128 divisor = _mm_or_ps(_mm_and_ps(keep, norm), _mm_andnot_ps(keep, _mm_set1_ps(1.f)));
+        _mm_storeu_ps(x + i, _mm_div_ps(vx, divisor));
+        _mm_storeu_ps(y + i, _mm_div_ps(vy, divisor));
+        _mm_storeu_ps(z + i, _mm_div_ps(vz, divisor));
+    }
+    normalizeScalar(x + i, y + i, z + i, n - i);
+}
+
+void axpySSE(float a, const float* x, float* y, std::size_t n)
+{
+    const __m128 va = _mm_set1_ps(a);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+    }
+    axpyScalar(a, x + i, y + i, n - i);
+}
+
+void blendSSE(float a, const float* x, float b, const float* y, float* out, std::size_t n)
+{
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vb = _mm_set1_ps(b);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(out + i,
+                      _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)), _mm_mul_ps(vb, _mm_loadu_ps(y + i))));
+    }
+    blendScalar(a, x + i, b, y + i, out + i, n - i);
+}
+
+const Kernels SSE_KERNELS{addSSE, mulSSE, minMaxSSE, normalizeSSE, axpySSE, blendSSE};
+
+// AVX2 kernels, 8 floats at a time
+
+SOA_TARGET_AVX2 void addAVX2(float* v, std::size_t n, float t)
+{
+    const __m256 vt = _mm256_set1_ps(t);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(v + i, _mm256_add_ps(_mm256_loadu_ps(v + i), vt));
+    }
+    addScalar(v + i, n - i, t);
+}
+
+SOA_TARGET_AVX2 void mulAVX2(float* v, std::size_t n, float a)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(v + i, _mm256_mul_ps(_mm256_loadu_ps(v + i), va));
+    }
+    mulScalar(v + i, n - i, a);
+}
+
+SOA_TARGET_AVX2 void minMaxAVX2(const float* v, std::size_t n, float& vmin, float& vmax)
+{
+    std::size_t i = 0;
+    if(n >= 8)
+    {
+        __m256 mn = _mm256_loadu_ps(v);
+        __m256 mx = mn;
+        for(i = 8; i + 8 <= n; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(v + i);
+            mn = _mm256_min_ps(mn, x);
+            mx = _mm256_max_ps(mx, x);
+        }
+        alignas(32) float lanesMin[8];
+        alignas(32) float lanesMax[8];
+        _mm256_store_ps(lanesMin, mn);
+        _mm256_store_ps(lanesMax, mx);
+        minMaxScalar(lanesMin, 8, vmin, vmax);
+        minMaxScalar(lanesMax, 8, vmin, vmax);
+    }
+    minMaxScalar(v + i, n - i, vmin, vmax);
+}
+
+SOA_TARGET_AVX2 void normalizeAVX2(float* x, float* y, float* z, std::size_t n)
+{
+    const __m256 threshold = _mm256_set1_ps(NORMALIZE_THRESHOLD);
+    const __m256 one = _mm256_set1_ps(1.f);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m256 vx = _mm256_loadu_ps(x + i);
+        const __m256 vy = _mm256_loadu_ps(y + i);
+        const __m256 vz = _mm256_loadu_ps(z + i);
+        // a true division rather than _mm256_rsqrt_ps, to get the same results as v3f::normalize
+        const __m256 norm = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+        const __m256 divisor = _mm256_blendv_ps(one, norm, _mm256_cmp_ps(norm, threshold, _CMP_GT_OQ));
+        _mm256_storeu_ps(x + i, _mm256_div_ps(vx, divisor));
+        _mm256_storeu_ps(y + i, _mm256_div_ps(vy, divisor));
+        _mm256_storeu_ps(z + i, _mm256_div_ps(vz, divisor));
+    }
+    normalizeScalar(x + i, y + i, z + i, n - i);
+}
+
+SOA_TARGET_AVX2 void axpyAVX2(float a, const float* x, float* y, std::size_t n)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    axpyScalar(a, x + i, y + i, n - i);
+}
+
+SOA_TARGET_AVX2 void blendAVX2(float a, const float* x, float b, const float* y, float* out, std::size_t n)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256 vb = _mm256_set1_ps(b);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i,
+                         _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_mul_ps(vb, _mm256_loadu_ps(y + i))));
+    }
+    blendScalar(a, x + i, b, y + i, out + i, n - i);
+}
+
+const Kernels AVX2_KERNELS{addAVX2, mulAVX2, minMaxAVX2, normalizeAVX2, axpyAVX2, blendAVX2};
+
+bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if(!osxsave || !fma || (_xgetbv(0) & 6) != 6)
+    {
+        // the OS does not save the AVX registers
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // SOA_X86
+
+const Kernels& kernelsOf(soa::SimdLevel level)
+{
+    switch(level)
+    {
+#ifdef SOA_X86
+    case soa::SimdLevel::AVX2:
+        return AVX2_KERNELS;
+    case soa::SimdLevel::SSE:
+        return SSE_KERNELS;
+#endif
+    default:
+        return SCALAR_KERNELS;
+    }
+}
+
+struct Dispatch
+{
+    soa::SimdLevel level;
+    const Kernels* kernels;
+};
+
+Dispatch& dispatch()
+{
+    static Dispatch current{soa::detectSimdLevel(), &kernelsOf(soa::detectSimdLevel())};
+    return current;
+}
+
+const Kernels& kernels()
+{
+    return *dispatch().kernels;
+}
+
+} // namespace
+
+namespace soa {
+
+SimdLevel detectSimdLevel()
+{
+#ifdef SOA_X86
+    static const SimdLevel level = cpuHasAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel simdLevel()
+{
+    return dispatch().level;
+}
+
+SimdLevel setSimdLevel(SimdLevel level)
+{
+    level = std::min(level, detectSimdLevel());
+    dispatch() = {level, &kernelsOf(level)};
+    return level;
+}
+
+const char* toString(SimdLevel level)
+{
+    switch(level)
+    {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE:
+        return "sse";
+    case SimdLevel::AVX2:
+        return "avx2";
+    }
+    return "";
+}
+
+void translate(SoAVertices& v, const v3f& t)
+{
+    const Kernels& k = kernels();
+    k.add(v.x(), v.size(), t.x);
+    k.add(v.y(), v.size(), t.y);
+    k.add(v.z(), v.size(), t.z);
+}
+
+void scale(SoAVertices& v, const v3f& s)
+{
+    const Kernels& k = kernels();
+    k.mul(v.x(), v.size(), s.x);
+    k.mul(v.y(), v.size(), s.y);
+    k.mul(v.z(), v.size(), s.z);
+}
+
+void scale(SoAVertices& v, float a)
+{
+    scale(v, v3f(a, a, a));
+}
+
+void bounds(const SoAVertices& v, point3d& pmin, point3d& pmax)
+{
+    assert(!v.empty());
+    pmin = pmax = v.get(0);
+    const Kernels& k = kernels();
+    k.minMax(v.x(), v.size(), pmin.x, pmax.x);
+    k.minMax(v.y(), v.size(), pmin.y, pmax.y);
+    k.minMax(v.z(), v.size(), pmin.z, pmax.z);
+}
+
+void normalize(SoAVertices& v)
+{
+    kernels().normalize(v.x(), v.y(), v.z(), v.size());
+}
+
+void axpy(float a, const SoAVertices& x, SoAVertices& y)
+{
+    assert(x.size() == y.size());
+    const Kernels& k = kernels();
+    k.axpy(a, x.x(), y.x(), x.size());
+    k.axpy(a, x.y(), y.y(), x.size());
+    k.axpy(a, x.z(), y.z(), x.size());
+}
+
+void blend(float a, const SoAVertices& x, float b, const SoAVertices& y, SoAVertices& out)
+{
+    assert(x.size() == y.size());
+    out.resize(x.size());
+    const Kernels& k = kernels();
+    k.blend(a, x.x(), b, y.x(), out.x(), x.size());
+    k.blend(a, x.y(), b, y.y(), out.y(), x.size());
+    k.blend(a, x.z(), b, y.z(), out.z(), x.size());
+}
+
+} // namespace soa
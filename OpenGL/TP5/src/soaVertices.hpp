@@ -0,0 +1,217 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * An allocator returning memory aligned on Alignment bytes, for the SIMD loads
+ */
+template<typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template<typename U>
+    explicit AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        // the size given to operator new must be a multiple of the alignment
+        const std::size_t bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        return static_cast<T*>(::operator new(bytes, std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t{Alignment}); }
+
+    bool operator==(const AlignedAllocator&) const { return true; }
+    bool operator!=(const AlignedAllocator&) const { return false; }
+};
+
+/**
+ * A list of 3D vectors (positions or normals) stored as a structure of arrays: all the x, then
+ * all the y, then all the z, each array aligned for the AVX loads. It is the layout used by the
+ * bulk kernels of the namespace soa, the interleaved layout (std::vector<v3f>) needed by the
+ * OpenGL path is obtained with toInterleaved.
+ */
+class SoAVertices
+{
+public:
+    /// the alignment of the arrays in bytes
+    static constexpr std::size_t ALIGNMENT{32};
+    using Array = std::vector<float, AlignedAllocator<float, ALIGNMENT>>;
+
+    SoAVertices() = default;
+
+    /**
+     * Create n vectors set to 0
+     * @param[in] n the number of vectors
+     */
+    explicit SoAVertices(std::size_t n) : _x(n), _y(n), _z(n) { }
+
+    /**
+     * Create the arrays from the interleaved layout
+     * @param[in] vertices the vectors
+     */
+    explicit SoAVertices(const std::vector<v3f>& vertices) { fromInterleaved(vertices); }
+
+    /**
+     * Copy the vectors from the interleaved layout
+     * @param[in] vertices the vectors
+     */
+    void fromInterleaved(const std::vector<v3f>& vertices);
+
+    /**
+     * Copy the vectors to the interleaved layout, eg for glVertexPointer
+     * @param[out] vertices the vectors
+     */
+    void toInterleaved(std::vector<v3f>& vertices) const;
+
+    [[nodiscard]] std::size_t size() const { return _x.size(); }
+    [[nodiscard]] bool empty() const { return _x.empty(); }
+
+    void resize(std::size_t n)
+    {
+        _x.resize(n);
+        _y.resize(n);
+        _z.resize(n);
+    }
+
+    [[nodiscard]] v3f get(std::size_t i) const { return {_x[i], _y[i], _z[i]}; }
+
+    void set(std::size_t i, const v3f& v)
+    {
+        _x[i] = v.x;
+        _y[i] = v.y;
+        _z[i] = v.z;
+    }
+
+    void push_back(const v3f& v)
+    {
+        _x.push_back(v.x);
+        _y.push_back(v.y);
+        _z.push_back(v.z);
+    }
+
+    [[nodiscard]] float* x() { return _x.data(); }
+    [[nodiscard]] float* y() { return _y.data(); }
+    [[nodiscard]] float* z() { return _z.data(); }
+    [[nodiscard]] const float* x() const { return _x.data(); }
+    [[nodiscard]] const float* y() const { return _y.data(); }
+    [[nodiscard]] const float* z() const { return _z.data(); }
+
+private:
+    Array _x;
+    Array _y;
+    Array _z;
+};
+
+/**
+ * Bulk operations on SoAVertices. Each one has a scalar, an SSE and an AVX2 implementation, the
+ * best one supported by the processor is chosen at runtime.
+ */
+namespace soa {
+
+/**
+ * The instruction sets of the kernels
+ */
+enum class SimdLevel
+{
+    Scalar,
+    SSE,
+    AVX2
+};
+
+/**
+ * Return the best instruction set supported by the processor
+ * @return the instruction set
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * Return the instruction set currently used by the kernels
+ * @return the instruction set
+ */
+SimdLevel simdLevel();
+
+/**
+ * Select the instruction set of the kernels, eg to compare them. It is limited to the ones supported
+ * by the processor.
+ * @param[in] level the requested instruction set
+ * @return the instruction set actually selected
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+const char* toString(SimdLevel level);
+
+/**
+ * Add t to each vector
+ * @param[in,out] v the vectors
+ * @param[in] t the translation
+ */
+void translate(SoAVertices& v, const v3f& t);
+
+/**
+ * Multiply each vector by s component by component
+ * @param[in,out] v the vectors
+ * @param[in] s the scale factors
+ */
+void scale(SoAVertices& v, const v3f& s);
+
+/**
+ * Multiply each vector by a
+ * @param[in,out] v the vectors
+ * @param[in] a the scale factor
+ */
+void scale(SoAVertices& v, float a);
+
+/**
+ * Compute the bounding box of the vectors, as BoundingBox::add would
+ * @param[in] v the vectors, at least one
+ * @param[out] pmin the minimum point
+ * @param[out] pmax the maximum point
+ */
+void bounds(const SoAVertices& v, point3d& pmin, point3d& pmax);
+
+/**
+ * Normalize each vector, as v3f::normalize (the vectors of length close to 0 are left unchanged)
+ * @param[in,out] v the vectors
+ */
+void normalize(SoAVertices& v);
+
+/**
+ * Compute y += a * x
+ * @param[in] a the factor
+ * @param[in] x the vectors to add
+ * @param[in,out] y the vectors to update, the same size as x
+ */
+void axpy(float a, const SoAVertices& x, SoAVertices& y);
+
+/**
+ * Compute out = a * x + b * y, the blend used to place the vertices of the Loop subdivision
+ * @param[in] a the factor of x
+ * @param[in] x the first vectors
+ * @param[in] b the factor of y
+ * @param[in] y the second vectors, the same size as x
+ * @param[out] out the result, resized to the size of x
+ */
+void blend(float a, const SoAVertices& x, float b, const SoAVertices& y, SoAVertices& out);
+
+} // namespace soa
@@ -0,0 +1,770 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "softwareRasterizer.hpp"
+#include "geometry.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RASTERIZER_USE_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * A point in homogeneous coordinates
+ */
+struct v4f
+{
+    float x{0.f};
+    float y{0.f};
+    float z{0.f};
+    float w{1.f};
+};
+
+/**
+ * A vertex in clip space with its (lit) color
+ */
+struct ClipVertex
+{
+    v4f pos{};
+    v3f color{};
+};
+
+v4f transformPoint(const mat4& m, const point3d& p)
+{
+    return {m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+            m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+            m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14],
+            m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15]};
+}
+
+point3d transformAffine(const mat4& m, const point3d& p)
+{
+    return {m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+            m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+            m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]};
+}
+
+/**
+ * Return the matrix used to transform the normals, ie the inverse transpose of the upper 3x3
+ * part of the modelview, up to a positive scale factor (the normals are normalized anyway, as
+ * GL_NORMALIZE does)
+ */
+std::array<float, 9> normalMatrix(const mat4& m)
+{
+    // cofactors of the 3x3 matrix, row-major result
+    std::array<float, 9> n{m[5] * m[10] - m[9] * m[6],
+                           m[8] * m[6] - m[4] * m[10],
+                           m[4] * m[9] - m[8] * m[5],
+                           m[9] * m[2] - m[1] * m[10],
+                           m[0] * m[10] - m[8] * m[2],
+                           m[8] * m[1] - m[0] * m[9],
+                           m[1] * m[6] - m[5] * m[2],
+                           m[4] * m[2] - m[0] * m[6],
+                           m[0] * m[5] - m[4] * m[1]};
+    const float det = m[0] * n[0] + m[4] * n[3] + m[8] * n[6];
+    if(det < 0.f)
+    {
+        for(auto& v : n)
+        {
+            v = -v;
+        }
+    }
+    return n;
+}
+
+vec3d transformNormal(const std::array<float, 9>& n, const vec3d& v)
+{
+    vec3d r{n[0] * v.x + n[3] * v.y + n[6] * v.z, n[1] * v.x + n[4] * v.y + n[7] * v.z, n[2] * v.x + n[5] * v.y + n[8] * v.z};
+    r.normalize();
+    return r;
+}
+
+/**
+ * The fixed-function lighting equation for one positional light, non-local viewer and
+ * the default global ambient of the light model
+ */
+v3f shade(const Light& light, const Material& mat, const point3d& eyePos, const vec3d& n)
+{
+    constexpr float sceneAmbient{.2f};
+    v3f color = mat.ambient * sceneAmbient + light.ambient * mat.ambient;
+
+    vec3d l = light.position - eyePos;
+    l.normalize();
+    const float nl = n.dot(l);
+    if(nl > 0.f)
+    {
+        color += light.diffuse * mat.diffuse * nl;
+        vec3d h = l + vec3d{0.f, 0.f, 1.f};
+        h.normalize();
+        const float nh = std::max(n.dot(h), 0.f);
+        color += light.specular * mat.specular * std::pow(nh, mat.shininess);
+    }
+    return {std::min(color.x, 1.f), std::min(color.y, 1.f), std::min(color.z, 1.f)};
+}
+
+std::uint8_t toByte(float c)
+{
+    return static_cast<std::uint8_t>(std::clamp(c, 0.f, 1.f) * 255.f + .5f);
+}
+
+std::uint32_t packColor(const v3f& c)
+{
+    return static_cast<std::uint32_t>(toByte(c.x)) | (static_cast<std::uint32_t>(toByte(c.y)) << 8U) |
+           (static_cast<std::uint32_t>(toByte(c.z)) << 16U) | 0xFF000000U;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Clip a polygon against the near plane (z >= -w)
+ * @param[in] in the vertices of the polygon
+ * @param[in] count the number of vertices
+ * @param[out] out the vertices of the clipped polygon (at most count + 1)
+ * @return the number of vertices of the clipped polygon
+ */
+int clipNear(const ClipVertex* in, int count, ClipVertex* out)
+{
+    int n{0};
+    for(int i = 0; i < count; ++i)
+    {
+        const ClipVertex& a = in[i];
+        const ClipVertex& b = in[(i + 1) % count];
+        const float da = a.pos.z + a.pos.w;
+        const float db = b.pos.z + b.pos.w;
+        if(da >= 0.f)
+        {
+            out[n++] = a;
+        }
+        if((da >= 0.f) != (db >= 0.f))
+        {
+            const float t = da / (da - db);
+            out[n].pos = {a.pos.x + t * (b.pos.x - a.pos.x),
+                          a.pos.y + t * (b.pos.y - a.pos.y),
+                          a.pos.z + t * (b.pos.z - a.pos.z),
+                          a.pos.w + t * (b.pos.w - a.pos.w)};
+            out[n].color = a.color + (b.color - a.color) * t;
+            ++n;
+        }
+    }
+    return n;
+}
+
+} // namespace
+
+//************************************ matrices ************************************//
+
+mat4 identityMatrix()
+{
+    return {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+}
+
+mat4 multiply(const mat4& a, const mat4& b)
+{
+    mat4 r{};
+    for(std::size_t col = 0; col < 4; ++col)
+    {
+        for(std::size_t row = 0; row < 4; ++row)
+        {
+            float sum{0.f};
+            for(std::size_t k = 0; k < 4; ++k)
+            {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            r[col * 4 + row] = sum;
+        }
+    }
+    return r;
+}
+
+mat4 perspectiveMatrix(float fovy, float aspect, float zNear, float zFar)
+{
+    const float f = 1.f / std::tan(fovy * static_cast<float>(M_PI) / 360.f);
+    mat4 m{};
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zFar + zNear) / (zNear - zFar);
+    m[11] = -1.f;
+    m[14] = 2.f * zFar * zNear / (zNear - zFar);
+    return m;
+}
+
+mat4 translationMatrix(float x, float y, float z)
+{
+    mat4 m = identityMatrix();
+    m[12] = x;
+    m[13] = y;
+    m[14] = z;
+    return m;
+}
+
+mat4 scalingMatrix(float s)
+{
+    mat4 m = identityMatrix();
+    m[0] = s;
+    m[5] = s;
+    m[10] = s;
+    return m;
+}
+
+mat4 rotationMatrix(float angle, float x, float y, float z)
+{
+    vec3d axis{x, y, z};
+    axis.normalize();
+    const float rad = angle * static_cast<float>(M_PI) / 180.f;
+    const float c = std::cos(rad);
+    const float s = std::sin(rad);
+    const float t = 1.f - c;
+    mat4 m = identityMatrix();
+    m[0] = axis.x * axis.x * t + c;
+    m[1] = axis.y * axis.x * t + axis.z * s;
+    m[2] = axis.x * axis.z * t - axis.y * s;
+    m[4] = axis.x * axis.y * t - axis.z * s;
+    m[5] = axis.y * axis.y * t + c;
+    m[6] = axis.y * axis.z * t + axis.x * s;
+    m[8] = axis.x * axis.z * t + axis.y * s;
+    m[9] = axis.y * axis.z * t - axis.x * s;
+    m[10] = axis.z * axis.z * t + c;
+    return m;
+}
+
+//************************************ rasterizer ************************************//
+
+/**
+ * A triangle ready to be rasterized: edge functions and attribute planes in window coordinates
+ */
+struct SoftwareRasterizer::Triangle
+{
+    /// edge functions e_k(x, y) = a[k] x + b[k] y + c[k], positive inside
+    float a[3];
+    float b[3];
+    float c[3];
+    /// whether the pixels exactly on the edge belong to the triangle (top-left rule)
+    bool topLeft[3];
+    /// plane of the window depth
+    float z[3];
+    /// plane of 1/w
+    float iw[3];
+    /// planes of the color divided by w, one per channel
+    float r[3];
+    float g[3];
+    float bl[3];
+    /// the nearest depth, for the hierarchical depth test
+    float minZ;
+    /// the bounding box in pixels
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    /// if flat use the constant color
+    bool flat;
+    std::uint32_t flatColor;
+};
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, unsigned numThreads)
+  : _width(std::max(width, 1))
+  , _height(std::max(height, 1))
+  , _stride(((_width + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE)
+  , _rows(((_height + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE)
+  , _tilesX(_stride / TILE_SIZE)
+  , _tilesY(_rows / TILE_SIZE)
+  , _numThreads(resolveThreads(numThreads))
+  , _color(static_cast<std::size_t>(_stride) * static_cast<std::size_t>(_rows), 0xFF000000U)
+  , _depth(_color.size(), 1.f)
+  , _blockMaxDepth(_color.size() / (BLOCK_SIZE * BLOCK_SIZE), 1.f)
+  , _projection(identityMatrix())
+  , _modelView(identityMatrix())
+{
+}
+
+void SoftwareRasterizer::clear(const v3f& color)
+{
+    std::fill(_color.begin(), _color.end(), packColor(color));
+    std::fill(_depth.begin(), _depth.end(), 1.f);
+    std::fill(_blockMaxDepth.begin(), _blockMaxDepth.end(), 1.f);
+}
+
+template<typename Index>
+void SoftwareRasterizer::drawTriangles(Span<const point3d> vertices,
+                                       Span<const basicFace<Index>> mesh,
+                                       Span<const vec3d> normals,
+                                       bool smooth)
+{
+    _stats = RasterStats{};
+    _stats.submitted = mesh.size();
+    if(mesh.empty())
+    {
+        return;
+    }
+
+    //****************************************
+    // vertex stage: transform and light each vertex
+    //****************************************
+    auto start = std::chrono::steady_clock::now();
+    const mat4 mvp = multiply(_projection, _modelView);
+    const auto nmat = normalMatrix(_modelView);
+    std::vector<ClipVertex> clipVerts(vertices.size());
+    std::vector<point3d> eyeVerts(vertices.size());
+    parallelChunks(vertices.size(), _numThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            clipVerts[i].pos = transformPoint(mvp, vertices[i]);
+            eyeVerts[i] = transformAffine(_modelView, vertices[i]);
+            if(smooth)
+            {
+                clipVerts[i].color = shade(_light, _material, eyeVerts[i], transformNormal(nmat, normals[i]));
+            }
+        }
+    });
+    _stats.vertexMs = elapsedMs(start);
+
+    //****************************************
+    // setup and binning, each thread bins a contiguous range of faces in its own bins
+    // so that the submission order is kept
+    //****************************************
+    start = std::chrono::steady_clock::now();
+    const auto numTiles = static_cast<std::size_t>(_tilesX) * static_cast<std::size_t>(_tilesY);
+    std::vector<std::vector<Triangle>> triangles(_numThreads);
+    std::vector<std::vector<std::vector<std::uint32_t>>> bins(_numThreads,
+                                                               std::vector<std::vector<std::uint32_t>>(numTiles));
+    std::vector<std::size_t> culled(_numThreads, 0);
+
+    const float halfW = static_cast<float>(_width) * .5f;
+    const float halfH = static_cast<float>(_height) * .5f;
+
+    parallelChunks(mesh.size(), _numThreads, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        auto& tris = triangles[chunk];
+        auto& chunkBins = bins[chunk];
+        tris.reserve(end - begin);
+
+        for(std::size_t f = begin; f < end; ++f)
+        {
+            const auto& t = mesh[f];
+            ClipVertex in[3] = {clipVerts[t.v1], clipVerts[t.v2], clipVerts[t.v3]};
+
+            // trivial reject when all the vertices are outside the same plane
+            const auto outside = [&in](auto test) { return test(in[0].pos) && test(in[1].pos) && test(in[2].pos); };
+            if(outside([](const v4f& p) { return p.x > p.w; }) || outside([](const v4f& p) { return p.x < -p.w; }) ||
+               outside([](const v4f& p) { return p.y > p.w; }) || outside([](const v4f& p) { return p.y < -p.w; }) ||
+               outside([](const v4f& p) { return p.z > p.w; }) || outside([](const v4f& p) { return p.z < -p.w; }))
+            {
+                ++culled[chunk];
+                continue;
+            }
+
+            std::uint32_t flatColor{0};
+            if(!smooth)
+            {
+                // GL_FLAT: the normal of the face and the color of the last (provoking) vertex
+                const vec3d n = transformNormal(nmat, computeNormal(vertices[t.v1], vertices[t.v2], vertices[t.v3]));
+                flatColor = packColor(shade(_light, _material, eyeVerts[t.v3], n));
+            }
+
+            ClipVertex poly[4];
+            const int numVerts = clipNear(in, 3, poly);
+
+            // triangulate the clipped polygon as a fan
+            for(int k = 1; k + 1 < numVerts; ++k)
+            {
+                const ClipVertex* v[3] = {&poly[0], &poly[k], &poly[k + 1]};
+                float x[3];
+                float y[3];
+                float z[3];
+                float iw[3];
+                for(int i = 0; i < 3; ++i)
+                {
+                    iw[i] = 1.f / v[i]->pos.w;
+                    x[i] = (v[i]->pos.x * iw[i] + 1.f) * halfW;
+                    y[i] = (v[i]->pos.y * iw[i] + 1.f) * halfH;
+                    z[i] = (v[i]->pos.z * iw[i]) * .5f + .5f;
+                }
+
+                // back-face culling, front faces are counter-clockwise
+                const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if(!(area > 0.f))
+                {
+                    ++culled[chunk];
+                    continue;
+                }
+
+                Triangle tri{};
+                const float invArea = 1.f / area;
+                for(int e = 0; e < 3; ++e)
+                {
+                    const int i1 = (e + 1) % 3;
+                    const int i2 = (e + 2) % 3;
+                    tri.a[e] = y[i1] - y[i2];
+                    tri.b[e] = x[i2] - x[i1];
+                    tri.c[e] = -(tri.a[e] * x[i1] + tri.b[e] * y[i1]);
+                    const float dy = y[i2] - y[i1];
+                    const float dx = x[i2] - x[i1];
+                    // left edges go down, top edges are horizontal and go left
+                    tri.topLeft[e] = (dy < 0.f) || (!(dy > 0.f) && (dx < 0.f));
+                }
+                const auto plane = [&tri, invArea](float* p, float f0, float f1, float f2) {
+                    p[0] = (f0 * tri.a[0] + f1 * tri.a[1] + f2 * tri.a[2]) * invArea;
+                    p[1] = (f0 * tri.b[0] + f1 * tri.b[1] + f2 * tri.b[2]) * invArea;
+                    p[2] = (f0 * tri.c[0] + f1 * tri.c[1] + f2 * tri.c[2]) * invArea;
+                };
+                plane(tri.z, z[0], z[1], z[2]);
+                tri.flat = !smooth;
+                tri.flatColor = flatColor;
+                if(smooth)
+                {
+                    plane(tri.iw, iw[0], iw[1], iw[2]);
+                    plane(tri.r, v[0]->color.x * iw[0], v[1]->color.x * iw[1], v[2]->color.x * iw[2]);
+                    plane(tri.g, v[0]->color.y * iw[0], v[1]->color.y * iw[1], v[2]->color.y * iw[2]);
+                    plane(tri.bl, v[0]->color.z * iw[0], v[1]->color.z * iw[1], v[2]->color.z * iw[2]);
+                }
+                tri.minZ = std::min({z[0], z[1], z[2]});
+                tri.minX = std::max(0, static_cast<int>(std::floor(std::min({x[0], x[1], x[2]}))));
+                tri.minY = std::max(0, static_cast<int>(std::floor(std::min({y[0], y[1], y[2]}))));
+                tri.maxX = std::min(_width - 1, static_cast<int>(std::ceil(std::max({x[0], x[1], x[2]}))));
+                tri.maxY = std::min(_height - 1, static_cast<int>(std::ceil(std::max({y[0], y[1], y[2]}))));
+                if(tri.minX > tri.maxX || tri.minY > tri.maxY)
+                {
+                    ++culled[chunk];
+                    continue;
+                }
+
+                const auto idx = static_cast<std::uint32_t>(tris.size());
+                tris.push_back(tri);
+                for(int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ++ty)
+                {
+                    for(int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; ++tx)
+                    {
+                        chunkBins[static_cast<std::size_t>(ty * _tilesX + tx)].push_back(idx);
+                    }
+                }
+            }
+        }
+    });
+
+    for(unsigned c = 0; c < _numThreads; ++c)
+    {
+        _stats.culled += culled[c];
+        _stats.rasterized += triangles[c].size();
+        for(const auto& bin : bins[c])
+        {
+            _stats.binEntries += bin.size();
+        }
+    }
+    _stats.binningMs = elapsedMs(start);
+
+    //****************************************
+    // raster stage: the threads pick the tiles one after the other
+    //****************************************
+    start = std::chrono::steady_clock::now();
+    std::atomic<int> nextTile{0};
+    std::vector<std::size_t> hizRejected(_numThreads, 0);
+    parallelChunks(_numThreads, _numThreads, [&](unsigned chunk, std::size_t, std::size_t) {
+        for(int tile = nextTile++; tile < static_cast<int>(numTiles); tile = nextTile++)
+        {
+            rasterizeTile(tile, triangles, bins, hizRejected[chunk]);
+        }
+    });
+    for(const auto h : hizRejected)
+    {
+        _stats.hizRejected += h;
+    }
+    _stats.rasterMs = elapsedMs(start);
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile,
+                                       const std::vector<std::vector<Triangle>>& triangles,
+                                       const std::vector<std::vector<std::vector<std::uint32_t>>>& bins,
+                                       std::size_t& hizRejected)
+{
+    const int tileX0 = (tile % _tilesX) * TILE_SIZE;
+    const int tileY0 = (tile / _tilesX) * TILE_SIZE;
+
+    for(std::size_t chunk = 0; chunk < bins.size(); ++chunk)
+    {
+        for(const auto idx : bins[chunk][static_cast<std::size_t>(tile)])
+        {
+            const Triangle& tri = triangles[chunk][idx];
+            const int x0 = std::max(tri.minX, tileX0) / BLOCK_SIZE;
+            const int x1 = std::min(tri.maxX, tileX0 + TILE_SIZE - 1) / BLOCK_SIZE;
+            const int y0 = std::max(tri.minY, tileY0) / BLOCK_SIZE;
+            const int y1 = std::min(tri.maxY, tileY0 + TILE_SIZE - 1) / BLOCK_SIZE;
+            for(int by = y0; by <= y1; ++by)
+            {
+                for(int bx = x0; bx <= x1; ++bx)
+                {
+                    rasterizeBlock(tri, bx, by, hizRejected);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeBlock(const Triangle& tri, int bx, int by, std::size_t& hizRejected)
+{
+    const auto blockIdx = static_cast<std::size_t>(by * (_stride / BLOCK_SIZE) + bx);
+
+    // hierarchical depth test: the triangle is behind everything already drawn in the block
+    if(tri.minZ > _blockMaxDepth[blockIdx])
+    {
+        ++hizRejected;
+        return;
+    }
+
+    const int px0 = bx * BLOCK_SIZE;
+    const int py0 = by * BLOCK_SIZE;
+
+    // reject the block if it is completely outside one of the edges
+    const float fx0 = static_cast<float>(px0) + .5f;
+    const float fx1 = fx0 + static_cast<float>(BLOCK_SIZE - 1);
+    const float fy0 = static_cast<float>(py0) + .5f;
+    const float fy1 = fy0 + static_cast<float>(BLOCK_SIZE - 1);
+    for(int e = 0; e < 3; ++e)
+    {
+        const float emax = tri.a[e] * (tri.a[e] > 0.f ? fx1 : fx0) + tri.b[e] * (tri.b[e] > 0.f ? fy1 : fy0) + tri.c[e];
+        if(emax < 0.f)
+        {
+            return;
+        }
+    }
+
+    bool written{false};
+
+#ifdef RASTERIZER_USE_SSE2
+    const __m128 offsets = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 scale = _mm_set1_ps(255.f);
+    const __m128 half = _mm_set1_ps(.5f);
+
+    for(int py = py0; py < py0 + BLOCK_SIZE; ++py)
+    {
+        const __m128 fy = _mm_set1_ps(static_cast<float>(py) + .5f);
+        for(int px = px0; px < px0 + BLOCK_SIZE; px += 4)
+        {
+            const __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), offsets);
+            const auto evalPlane = [&fx, &fy](const float* p) {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), fx), _mm_mul_ps(_mm_set1_ps(p[1]), fy)),
+                                  _mm_set1_ps(p[2]));
+            };
+
+            __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(int e = 0; e < 3; ++e)
+            {
+                const float coeffs[3] = {tri.a[e], tri.b[e], tri.c[e]};
+                const __m128 val = evalPlane(coeffs);
+                mask = _mm_and_ps(mask, tri.topLeft[e] ? _mm_cmpge_ps(val, zero) : _mm_cmpgt_ps(val, zero));
+            }
+            if(_mm_movemask_ps(mask) == 0)
+            {
+                continue;
+            }
+
+            const std::size_t offset = static_cast<std::size_t>(py) * static_cast<std::size_t>(_stride) +
+                                       static_cast<std::size_t>(px);
+            float* depthPtr = &_depth[offset];
+            const __m128 z = evalPlane(tri.z);
+            const __m128 depth = _mm_loadu_ps(depthPtr);
+            mask = _mm_and_ps(mask, _mm_cmple_ps(z, depth));
+            const int bits = _mm_movemask_ps(mask);
+            if(bits == 0)
+            {
+                continue;
+            }
+            _mm_storeu_ps(depthPtr, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, depth)));
+            written = true;
+
+            std::uint32_t* colorPtr = &_color[offset];
+            if(tri.flat)
+            {
+                for(int lane = 0; lane < 4; ++lane)
+                {
+                    if(bits & (1 << lane))
+                    {
+                        colorPtr[lane] = tri.flatColor;
+                    }
+                }
+                continue;
+            }
+
+            // perspective-correct interpolation of the color
+            const __m128 w = _mm_div_ps(one, evalPlane(tri.iw));
+            const auto channel = [&](const float* p) {
+                const __m128 c = _mm_min_ps(_mm_max_ps(_mm_mul_ps(evalPlane(p), w), zero), one);
+                return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, scale), half));
+            };
+            const __m128i r = channel(tri.r);
+            const __m128i g = _mm_slli_epi32(channel(tri.g), 8);
+            const __m128i b = _mm_slli_epi32(channel(tri.bl), 16);
+            alignas(16) std::uint32_t rgba[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(rgba),
+                            _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32(static_cast<int>(0xFF000000U)))));
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if(bits & (1 << lane))
+                {
+                    colorPtr[lane] = rgba[lane];
+                }
+            }
+        }
+    }
+#else
+    for(int py = py0; py < py0 + BLOCK_SIZE; ++py)
+    {
+        const float fy = static_cast<float>(py) + .5f;
+        for(int px = px0; px < px0 + BLOCK_SIZE; ++px)
+        {
+            const float fx = static_cast<float>(px) + .5f;
+            const auto evalPlane = [fx, fy](const float* p) { return p[0] * fx + p[1] * fy + p[2]; };
+
+            bool inside{true};
+            for(int e = 0; e < 3 && inside; ++e)
+            {
+                const float coeffs[3] = {tri.a[e], tri.b[e], tri.c[e]};
+                const float val = evalPlane(coeffs);
+                inside = tri.topLeft[e] ? (val >= 0.f) : (val > 0.f);
+            }
+            if(!inside)
+            {
+                continue;
+            }
+
+            const std::size_t offset = static_cast<std::size_t>(py) * static_cast<std::size_t>(_stride) +
+                                       static_cast<std::size_t>(px);
+            const float z = evalPlane(tri.z);
+            if(z > _depth[offset])
+            {
+                continue;
+            }
+            _depth[offset] = z;
+            written = true;
+
+            if(tri.flat)
+            {
+                _color[offset] = tri.flatColor;
+            }
+            else
+            {
+                const float w = 1.f / evalPlane(tri.iw);
+                _color[offset] = packColor({evalPlane(tri.r) * w, evalPlane(tri.g) * w, evalPlane(tri.bl) * w});
+            }
+        }
+    }
+#endif
+
+    // update the farthest depth of the block
+    if(written)
+    {
+        float maxDepth{0.f};
+        for(int py = py0; py < py0 + BLOCK_SIZE; ++py)
+        {
+            const auto row = _depth.begin() + static_cast<std::ptrdiff_t>(py * _stride + px0);
+            maxDepth = std::max(maxDepth, *std::max_element(row, row + BLOCK_SIZE));
+        }
+        _blockMaxDepth[blockIdx] = maxDepth;
+    }
+}
+
+void SoftwareRasterizer::plot(int x, int y, float depth, std::uint32_t color)
+{
+    if(x < 0 || y < 0 || x >= _width || y >= _height)
+    {
+        return;
+    }
+    // small bias so that the lines are visible on top of the faces they belong to
+    constexpr float bias{1e-4f};
+    const std::size_t offset = static_cast<std::size_t>(y) * static_cast<std::size_t>(_stride) + static_cast<std::size_t>(x);
+    if(depth - bias <= _depth[offset])
+    {
+        // the depth only gets nearer, so the farthest depth of the blocks is still conservative
+        _depth[offset] = std::min(depth, _depth[offset]);
+        _color[offset] = color;
+    }
+}
+
+void SoftwareRasterizer::drawLine(const point3d& a, const point3d& b, const v3f& color, bool thick)
+{
+    const mat4 mvp = multiply(_projection, _modelView);
+    const v4f ca = transformPoint(mvp, a);
+    const v4f cb = transformPoint(mvp, b);
+    // lines crossing the near plane are not clipped, just discarded
+    if(ca.z < -ca.w || cb.z < -cb.w || ca.w <= 0.f || cb.w <= 0.f)
+    {
+        return;
+    }
+    const float halfW = static_cast<float>(_width) * .5f;
+    const float halfH = static_cast<float>(_height) * .5f;
+    const float x0 = (ca.x / ca.w + 1.f) * halfW;
+    const float y0 = (ca.y / ca.w + 1.f) * halfH;
+    const float z0 = (ca.z / ca.w) * .5f + .5f;
+    const float x1 = (cb.x / cb.w + 1.f) * halfW;
+    const float y1 = (cb.y / cb.w + 1.f) * halfH;
+    const float z1 = (cb.z / cb.w) * .5f + .5f;
+
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const bool xMajor = std::fabs(dx) >= std::fabs(dy);
+    const int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::fabs(dx), std::fabs(dy)))));
+    const std::uint32_t packed = packColor(color);
+    for(int i = 0; i <= steps; ++i)
+    {
+        const float t = static_cast<float>(i) / static_cast<float>(steps);
+        const int x = static_cast<int>(std::floor(x0 + t * dx));
+        const int y = static_cast<int>(std::floor(y0 + t * dy));
+        const float z = z0 + t * (z1 - z0);
+        plot(x, y, z, packed);
+        if(thick)
+        {
+            plot(xMajor ? x : x + 1, xMajor ? y + 1 : y, z, packed);
+        }
+    }
+}
+
+template<typename Index>
+void SoftwareRasterizer::drawWireframe(Span<const point3d> vertices,
+                                       Span<const basicFace<Index>> mesh,
+                                       const v3f& color,
+                                       bool thick)
+{
+    for(const auto& f : mesh)
+    {
+        drawLine(vertices[f.v1], vertices[f.v2], color, thick);
+        drawLine(vertices[f.v2], vertices[f.v3], color, thick);
+        drawLine(vertices[f.v3], vertices[f.v1], color, thick);
+    }
+}
+
+template void SoftwareRasterizer::drawTriangles(Span<const point3d>, Span<const face16>, Span<const vec3d>, bool);
+template void SoftwareRasterizer::drawTriangles(Span<const point3d>, Span<const face>, Span<const vec3d>, bool);
+template void SoftwareRasterizer::drawWireframe(Span<const point3d>, Span<const face16>, const v3f&, bool);
+template void SoftwareRasterizer::drawWireframe(Span<const point3d>, Span<const face>, const v3f&, bool);
+
+Image SoftwareRasterizer::image() const
+{
+    Image img{static_cast<unsigned>(_width), static_cast<unsigned>(_height), {}};
+    img.rgb.resize(static_cast<std::size_t>(_width) * static_cast<std::size_t>(_height) * 3);
+    auto out = img.rgb.begin();
+    // the first row of the buffer is the bottom one
+    for(int y = _height - 1; y >= 0; --y)
+    {
+        for(int x = 0; x < _width; ++x)
+        {
+            const std::uint32_t c = _color[static_cast<std::size_t>(y * _stride + x)];
+            *out++ = static_cast<std::uint8_t>(c & 0xFFU);
+            *out++ = static_cast<std::uint8_t>((c >> 8U) & 0xFFU);
+            *out++ = static_cast<std::uint8_t>((c >> 16U) & 0xFFU);
+        }
+    }
+    return img;
+}
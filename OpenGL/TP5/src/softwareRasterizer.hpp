@@ -0,0 +1,239 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+#include "image.hpp"
+#include "span.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A 4x4 matrix stored in column-major order, as OpenGL does
+ */
+using mat4 = std::array<float, 16>;
+
+/**
+ * Return the identity matrix
+ * @return the identity matrix
+ */
+mat4 identityMatrix();
+
+/**
+ * Return the product a * b
+ * @param[in] a the left matrix
+ * @param[in] b the right matrix
+ * @return the product
+ */
+mat4 multiply(const mat4& a, const mat4& b);
+
+/**
+ * Return the projection matrix built by gluPerspective
+ * @param[in] fovy the field of view angle in degrees along y
+ * @param[in] aspect the aspect ratio width / height
+ * @param[in] zNear the distance of the near plane
+ * @param[in] zFar the distance of the far plane
+ * @return the projection matrix
+ */
+mat4 perspectiveMatrix(float fovy, float aspect, float zNear, float zFar);
+
+/**
+ * Return the translation matrix built by glTranslatef
+ * @param[in] x the translation along x
+ * @param[in] y the translation along y
+ * @param[in] z the translation along z
+ * @return the translation matrix
+ */
+mat4 translationMatrix(float x, float y, float z);
+
+/**
+ * Return the scaling matrix built by glScalef with the same factor along the 3 axes
+ * @param[in] s the scale factor
+ * @return the scaling matrix
+ */
+mat4 scalingMatrix(float s);
+
+/**
+ * Return the rotation matrix built by glRotatef
+ * @param[in] angle the angle in degrees
+ * @param[in] x the x coordinate of the rotation axis
+ * @param[in] y the y coordinate of the rotation axis
+ * @param[in] z the z coordinate of the rotation axis
+ * @return the rotation matrix
+ */
+mat4 rotationMatrix(float angle, float x, float y, float z);
+
+/**
+ * A positional light, same parameters as glLightfv for GL_LIGHT0
+ */
+struct Light
+{
+    /// the position of the light in eye coordinates
+    point3d position{0.f, 0.f, 1.f};
+    /// the ambient component
+    v3f ambient{0.f, 0.f, 0.f};
+    /// the diffuse component
+    v3f diffuse{1.f, 1.f, 1.f};
+    /// the specular component
+    v3f specular{1.f, 1.f, 1.f};
+};
+
+/**
+ * A material, same parameters as glMaterialfv for GL_FRONT
+ */
+struct Material
+{
+    /// the ambient component
+    v3f ambient{.2f, .2f, .2f};
+    /// the diffuse component
+    v3f diffuse{.8f, .8f, .8f};
+    /// the specular component
+    v3f specular{0.f, 0.f, 0.f};
+    /// the shininess
+    float shininess{0.f};
+};
+
+/**
+ * Some statistics about the last call to SoftwareRasterizer::drawTriangles
+ */
+struct RasterStats
+{
+    /// the number of submitted triangles
+    std::size_t submitted{0};
+    /// the number of triangles discarded by back-face culling or because outside the view
+    std::size_t culled{0};
+    /// the number of triangles sent to the tiles (after near plane clipping)
+    std::size_t rasterized{0};
+    /// the number of (triangle, tile) pairs
+    std::size_t binEntries{0};
+    /// the number of 8x8 blocks rejected by the hierarchical depth buffer
+    std::size_t hizRejected{0};
+    /// the time spent transforming and lighting the vertices
+    double vertexMs{0};
+    /// the time spent setting up and binning the triangles
+    double binningMs{0};
+    /// the time spent rasterizing the tiles
+    double rasterMs{0};
+};
+
+/**
+ * A multi-threaded tiled rasterizer reproducing the fixed-function pipeline used by the
+ * visualizer (Gouraud or flat lighting with one positional light, back-face culling,
+ * GL_LEQUAL depth test) without any GPU nor OpenGL context.
+ * The triangles are binned into screen tiles which are rasterized in parallel, each tile
+ * processing its triangles in submission order so that the result is deterministic
+ * whatever the number of threads.
+ */
+class SoftwareRasterizer
+{
+public:
+    /// the size in pixels of the (square) tiles
+    static constexpr int TILE_SIZE{64};
+    /// the size in pixels of the (square) blocks of the hierarchical depth buffer
+    static constexpr int BLOCK_SIZE{8};
+
+    /**
+     * Create the rasterizer and its framebuffer
+     * @param[in] width the width of the framebuffer
+     * @param[in] height the height of the framebuffer
+     * @param[in] numThreads the number of threads to use, 0 to use all the cores
+     */
+    SoftwareRasterizer(int width, int height, unsigned numThreads = 0);
+
+    /**
+     * Clear the color buffer to the given color and the depth buffer to 1
+     * @param[in] color the clear color
+     */
+    void clear(const v3f& color);
+
+    void setProjection(const mat4& projection) { _projection = projection; }
+    void setModelView(const mat4& modelView) { _modelView = modelView; }
+    void setLight(const Light& light) { _light = light; }
+    void setMaterial(const Material& material) { _material = material; }
+
+    /**
+     * Draw the lit triangles of the mesh
+     * @param[in] vertices the list of vertices
+     * @param[in] mesh the list of faces
+     * @param[in] normals the normal of each vertex (only used if smooth)
+     * @param[in] smooth if true interpolate the colors lit at each vertex, otherwise use
+     * the normal of the face and the color of the last vertex, as GL_FLAT does
+     */
+    template<typename Index>
+    void drawTriangles(Span<const point3d> vertices,
+                       Span<const basicFace<Index>> mesh,
+                       Span<const vec3d> normals,
+                       bool smooth);
+
+    /**
+     * Draw the edges of each face with a constant color (no lighting)
+     * @param[in] vertices the list of vertices
+     * @param[in] mesh the list of faces
+     * @param[in] color the color of the lines
+     * @param[in] thick if true the lines are two pixels wide
+     */
+    template<typename Index>
+    void drawWireframe(Span<const point3d> vertices,
+                       Span<const basicFace<Index>> mesh,
+                       const v3f& color,
+                       bool thick);
+
+    /**
+     * Draw a segment with a constant color (no lighting)
+     * @param[in] a the first point
+     * @param[in] b the second point
+     * @param[in] color the color of the segment
+     * @param[in] thick if true the line is two pixels wide
+     */
+    void drawLine(const point3d& a, const point3d& b, const v3f& color, bool thick = false);
+
+    /**
+     * Return the content of the color buffer
+     * @return the image, top row first
+     */
+    [[nodiscard]] Image image() const;
+
+    [[nodiscard]] const RasterStats& stats() const { return _stats; }
+    [[nodiscard]] unsigned threads() const { return _numThreads; }
+    [[nodiscard]] int width() const { return _width; }
+    [[nodiscard]] int height() const { return _height; }
+
+private:
+    struct Triangle;
+
+    void rasterizeTile(int tile, const std::vector<std::vector<Triangle>>& triangles,
+                       const std::vector<std::vector<std::vector<std::uint32_t>>>& bins,
+                       std::size_t& hizRejected);
+    void rasterizeBlock(const Triangle& tri, int bx, int by, std::size_t& hizRejected);
+
+    void plot(int x, int y, float depth, std::uint32_t color);
+
+    int _width;
+    int _height;
+    /// the size of the buffers, multiple of the tile size
+    int _stride;
+    int _rows;
+    int _tilesX;
+    int _tilesY;
+    unsigned _numThreads;
+
+    /// RGBA color buffer, first row is the bottom one as in OpenGL
+    std::vector<std::uint32_t> _color;
+    /// window depth buffer, in [0, 1]
+    std::vector<float> _depth;
+    /// the farthest depth of each block
+    std::vector<float> _blockMaxDepth;
+
+    mat4 _projection;
+    mat4 _modelView;
+    Light _light{};
+    Material _material{};
+
+    RasterStats _stats{};
+};
@@ -0,0 +1,80 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A non-owning view of a contiguous array, the subset of C++20 std::span used by the renderer.
+ * The functions reading the meshes take spans, so that they accept any storage (std::vector with
+ * any allocator, arrays...) and do not need a non-const reference.
+ * @tparam T the type of the elements, const T for a read-only view
+ */
+template<typename T>
+class Span
+{
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = std::size_t;
+    using iterator = T*;
+
+    constexpr Span() noexcept = default;
+
+    /**
+     * Constructor
+     * @param[in] data the first element
+     * @param[in] size the number of elements
+     */
+    constexpr Span(T* data, std::size_t size) noexcept : _data(data), _size(size) { }
+
+    /**
+     * View of a vector, a const vector gives a read-only view
+     * @param[in] v the vector
+     */
+    template<typename Allocator>
+    constexpr Span(std::vector<value_type, Allocator>& v) noexcept : _data(v.data()), _size(v.size()) { }
+
+    template<typename Allocator, typename U = T, typename = std::enable_if_t<std::is_const_v<U>>>
+    constexpr Span(const std::vector<value_type, Allocator>& v) noexcept : _data(v.data()), _size(v.size()) { }
+
+    /**
+     * A read-only view of a writable one
+     * @param[in] s the other view
+     */
+    template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    constexpr Span(const Span<U>& s) noexcept : _data(s.data()), _size(s.size()) { }
+
+    [[nodiscard]] constexpr T* data() const noexcept { return _data; }
+    [[nodiscard]] constexpr std::size_t size() const noexcept { return _size; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return _size == 0; }
+
+    [[nodiscard]] constexpr T& operator[](std::size_t i) const
+    {
+        assert(i < _size);
+        return _data[i];
+    }
+
+    [[nodiscard]] constexpr T& front() const { return (*this)[0]; }
+    [[nodiscard]] constexpr T& back() const { return (*this)[_size - 1]; }
+
+    [[nodiscard]] constexpr iterator begin() const noexcept { return _data; }
+    [[nodiscard]] constexpr iterator end() const noexcept { return _data + _size; }
+
+private:
+    T* _data{nullptr};
+    std::size_t _size{0};
+};
+
+template<typename T, typename Allocator>
+Span(std::vector<T, Allocator>&) -> Span<T>;
+
+template<typename T, typename Allocator>
+Span(const std::vector<T, Allocator>&) -> Span<const T>;
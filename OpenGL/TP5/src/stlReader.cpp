@@ -0,0 +1,88 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "stlReader.hpp"
+#include "logger.hpp"
+#include "mappedFile.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "weld.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the binary STL files are little endian");
+#endif
+
+static_assert(sizeof(point3d) == 12, "the vertices of the records are copied directly in the point3d arrays");
+
+bool loadStl(const std::string& filename,
+             std::vector<point3d>& vertices,
+             std::vector<face>& mesh,
+             float weldEpsilon,
+             unsigned numThreads,
+             StlStats* stats)
+{
+    PROFILE_SCOPE("loadStl");
+    MappedFile file;
+    if(!file.open(filename))
+    {
+        return false;
+    }
+    std::uint32_t count{0};
+    if(file.size() >= stl::HEADER_SIZE)
+    {
+        std::memcpy(&count, file.data() + 80, sizeof(count));
+    }
+    // some exporters pad the file, but it must hold all the triangles it announces
+    if(file.size() < stl::HEADER_SIZE || (file.size() - stl::HEADER_SIZE) / stl::RECORD_SIZE < count)
+    {
+        const bool ascii = file.size() >= 5 && std::memcmp(file.data(), "solid", 5) == 0;
+        LOG_ERROR(Loader, filename << (ascii ? " is an ASCII STL file, only the binary ones are supported"
+                                             : " is not a binary STL file or is truncated"));
+        return false;
+    }
+    if(3 * std::size_t{count} > std::size_t{std::numeric_limits<idxtype>::max()})
+    {
+        LOG_ERROR(Loader, filename << " has too many triangles");
+        return false;
+    }
+
+    // the triangle soup: the 3 vertices of each record follow the normal, copied in one go
+    const unsigned threads = resolveThreads(numThreads);
+    std::vector<point3d> soup(3 * std::size_t{count});
+    const char* records = file.data() + stl::HEADER_SIZE;
+    parallelChunks(count, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+        for(std::size_t t = begin; t < end; ++t)
+        {
+            std::memcpy(static_cast<void*>(&soup[3 * t]), records + t * stl::RECORD_SIZE + 12, 3 * sizeof(point3d));
+        }
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<idxtype> remap = weldVertices(soup, weldEpsilon, vertices, threads);
+    mesh.resize(count);
+    for(std::size_t t = 0; t < mesh.size(); ++t)
+    {
+        const auto first = static_cast<idxtype>(3 * t);
+        mesh[t] = face(first, first + 1, first + 2);
+    }
+    const std::size_t degenerate = remapFaces(remap, mesh);
+    const double weldMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    LOG_INFO(Loader, "Welded " << soup.size() << " -> " << vertices.size() << " vertices in " << weldMs << " ms ("
+                               << static_cast<double>(count) / (weldMs * 1e3) << " Mtri/s), " << degenerate
+                               << " degenerate faces removed");
+    LOG_INFO(Loader, "Object loaded with " << vertices.size() << " vertices and " << mesh.size() << " faces");
+    if(stats != nullptr)
+    {
+        *stats = {count, soup.size(), vertices.size(), degenerate, weldMs};
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * The binary STL format: an 80-byte header, the number of triangles (uint32) and one 50-byte record
+ * per triangle (the normal and the 3 vertices as float32, an uint16 attribute), all little endian
+ */
+namespace stl {
+/// the size of the header including the number of triangles
+constexpr std::size_t HEADER_SIZE{84};
+/// the size of the record of a triangle
+constexpr std::size_t RECORD_SIZE{50};
+} // namespace stl
+
+/**
+ * What happened while loading an STL file
+ */
+struct StlStats
+{
+    /// the number of triangles of the file
+    std::size_t triangles{0};
+    /// the number of vertices before welding, 3 per triangle
+    std::size_t soupVertices{0};
+    /// the number of vertices after welding
+    std::size_t weldedVertices{0};
+    /// the number of triangles removed because two of their vertices were merged
+    std::size_t degenerateFaces{0};
+    /// the duration of the welding in milliseconds
+    double weldMs{0};
+};
+
+/**
+ * Load a mesh from a binary STL file. The file is a triangle soup: the triangles are streamed
+ * from the mapped file and their vertices welded (see weldVertices), so that the faces share
+ * their vertices as loopSubdivision expects.
+ *
+ * @param[in] filename the name of the .stl file
+ * @param[out] vertices the list of welded vertices
+ * @param[out] mesh the list of faces
+ * @param[in] weldEpsilon the distance under which the vertices are merged, 0 to merge only the
+ * vertices with the same coordinates
+ * @param[in] numThreads the number of threads to use, 0 to use all the cores
+ * @param[out] stats if not null, the statistics of the loading
+ * @return true if everything went well, false otherwise
+ */
+bool loadStl(const std::string& filename,
+             std::vector<point3d>& vertices,
+             std::vector<face>& mesh,
+             float weldEpsilon = 0.f,
+             unsigned numThreads = 0,
+             StlStats* stats = nullptr);
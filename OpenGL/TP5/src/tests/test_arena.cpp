@@ -0,0 +1,99 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <arena.hpp>
+#include <loop.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(test_arena)
+{
+    Arena arena(1024);
+    BOOST_CHECK_EQUAL(arena.upstreamAllocations(), 1U);
+    BOOST_CHECK_GE(arena.capacity(), 1024U);
+
+    void* a = arena.allocate(3, 1);
+    void* b = arena.allocate(8, 8);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(b) % 8, 0U);
+    BOOST_CHECK_EQUAL(static_cast<std::byte*>(b) - static_cast<std::byte*>(a), 8);
+    BOOST_CHECK_EQUAL(arena.allocations(), 2U);
+    BOOST_CHECK_EQUAL(arena.used(), 16U);
+
+    // the memory is given back all at once and reused
+    arena.reset();
+    BOOST_CHECK_EQUAL(arena.used(), 0U);
+    BOOST_CHECK_EQUAL(arena.allocations(), 0U);
+    BOOST_CHECK_EQUAL(arena.allocate(3, 1), a);
+
+    // a run larger than the block gets more blocks, they are merged by the reset
+    const std::size_t capacity = arena.capacity();
+    void* large = arena.allocate(capacity, 16);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(large) % 16, 0U);
+    BOOST_CHECK_EQUAL(arena.upstreamAllocations(), 2U);
+    arena.reset();
+    BOOST_CHECK_GE(arena.capacity(), 2 * capacity);
+    void* first = arena.allocate(capacity, 16);
+    void* second = arena.allocate(capacity - 64, 16);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(first) % 16, 0U);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(second) % 16, 0U);
+    // both in the merged block
+    BOOST_CHECK_EQUAL(static_cast<std::byte*>(second) - static_cast<std::byte*>(first), static_cast<std::ptrdiff_t>(capacity));
+    BOOST_CHECK_EQUAL(arena.upstreamAllocations(), 3U);
+
+    // the containers using the arena
+    arena.reset();
+    std::pmr::vector<int> v({1, 2, 3}, &arena);
+    BOOST_CHECK_EQUAL(arena.allocations(), 1U);
+    BOOST_CHECK_EQUAL(v[2], 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_loop_scratch)
+{
+    // the tetrahedron
+    const std::vector<point3d> vertices{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    const std::vector<face> mesh{{0, 2, 1}, {0, 1, 3}, {0, 3, 2}, {1, 2, 3}};
+    const auto sizes = loopSubdivisionSizes(vertices.size(), mesh.size());
+    BOOST_CHECK_EQUAL(sizes.edges, 6U);
+    BOOST_CHECK_EQUAL(sizes.vertices, 10U);
+    BOOST_CHECK_EQUAL(sizes.faces, 16U);
+
+    std::vector<point3d> expectedVert;
+    std::vector<face> expectedMesh;
+    std::vector<vec3d> expectedNorm;
+    loopSubdivision(vertices, mesh, expectedVert, expectedMesh, expectedNorm);
+
+    // the same arena for two steps: the scratch data fits in the block reserved by the first one
+    Arena arena;
+    std::vector<point3d> destVert;
+    std::vector<face> destMesh;
+    std::vector<vec3d> destNorm;
+    for(int run = 0; run < 2; ++run)
+    {
+        loopSubdivision(vertices, mesh, destVert, destMesh, destNorm, arena);
+        BOOST_CHECK_EQUAL(arena.upstreamAllocations(), 1U);
+        BOOST_CHECK_LE(arena.used(), sizes.scratchBytes);
+        BOOST_CHECK_EQUAL(destVert.size(), sizes.vertices);
+        BOOST_CHECK_EQUAL(destVert.capacity(), sizes.vertices);
+        BOOST_REQUIRE_EQUAL(destMesh.size(), expectedMesh.size());
+        for(std::size_t i = 0; i < destMesh.size(); ++i)
+        {
+            BOOST_CHECK(destMesh[i] == expectedMesh[i]);
+        }
+        for(std::size_t i = 0; i < destVert.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(destVert[i].x, expectedVert[i].x);
+            BOOST_CHECK_EQUAL(destVert[i].y, expectedVert[i].y);
+            BOOST_CHECK_EQUAL(destVert[i].z, expectedVert[i].z);
+        }
+    }
+}
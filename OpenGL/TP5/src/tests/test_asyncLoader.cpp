@@ -0,0 +1,118 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <asyncLoader.hpp>
+#include <geometry.hpp>
+#include <objReader.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+
+/**
+ * Poll the loader until the end of the loading
+ * @return the final state and the number of polls that returned Loading
+ */
+std::pair<AsyncLoader::State, std::size_t> pollUntilDone(AsyncLoader& loader, MeshModel& model)
+{
+    std::size_t polls{0};
+    auto state = loader.poll(model);
+    while(state == AsyncLoader::State::Loading)
+    {
+        ++polls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        state = loader.poll(model);
+    }
+    return {state, polls};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_asyncLoader)
+
+BOOST_AUTO_TEST_CASE(test_load_batches)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    std::vector<vec3d> normals;
+    BoundingBox bb;
+    BOOST_REQUIRE(load(teapot, vertices, mesh, normals, bb));
+
+    // the normals accumulated batch by batch are the same as the ones of the whole mesh
+    std::vector<point3d> batchVertices;
+    std::vector<face> batchMesh;
+    std::vector<vec3d> batchNormals;
+    std::size_t batches{0};
+    BOOST_REQUIRE(loadBatches(teapot, 1000, [&](std::vector<point3d>& v, std::vector<face>& f) {
+        BOOST_CHECK(!v.empty() || !f.empty());
+        batchVertices.insert(batchVertices.end(), v.begin(), v.end());
+        batchNormals.resize(batchVertices.size(), vec3d{0, 0, 0});
+        const std::size_t first = batchMesh.size();
+        batchMesh.insert(batchMesh.end(), f.begin(), f.end());
+        accumulateVertexNormals(batchVertices, Span(batchMesh.data() + first, f.size()), batchNormals);
+        ++batches;
+    }));
+    BOOST_CHECK_EQUAL(batches, (vertices.size() + mesh.size() + 999) / 1000);
+    BOOST_CHECK(batchMesh == mesh);
+    BOOST_REQUIRE_EQUAL(batchNormals.size(), normals.size());
+    for(std::size_t i = 0; i < normals.size(); i += 37)
+    {
+        BOOST_CHECK_EQUAL(batchNormals[i].x, normals[i].x);
+        BOOST_CHECK_EQUAL(batchNormals[i].y, normals[i].y);
+        BOOST_CHECK_EQUAL(batchNormals[i].z, normals[i].z);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_async_load)
+{
+    MeshModel expected;
+    BOOST_REQUIRE(expected.load(teapot));
+
+    AsyncLoader loader;
+    MeshModel model;
+    BOOST_CHECK(!loader.busy());
+    loader.start(teapot, 0.f, 500);
+    BOOST_CHECK(loader.busy());
+    const auto result = pollUntilDone(loader, model);
+    BOOST_CHECK(result.first == AsyncLoader::State::Loaded);
+    BOOST_CHECK(!loader.busy());
+    BOOST_CHECK(loader.poll(model) == AsyncLoader::State::Idle);
+
+    BOOST_CHECK(!model.empty());
+    const auto u = model.unitization();
+    const auto v = expected.unitization();
+    BOOST_CHECK_EQUAL(u.scale, v.scale);
+    BOOST_CHECK_EQUAL(u.center.x, v.center.x);
+    BOOST_CHECK_EQUAL(u.center.z, v.center.z);
+
+    // the formats other than OBJ arrive in one batch
+    MeshModel ply;
+    loader.start("data/models/teapotmani.ply");
+    loader.wait();
+    BOOST_CHECK(loader.poll(ply) == AsyncLoader::State::Loaded);
+    BOOST_CHECK(!ply.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_async_failure)
+{
+    AsyncLoader loader;
+    MeshModel model;
+    loader.start("data/models/missing.obj");
+    BOOST_CHECK(pollUntilDone(loader, model).first == AsyncLoader::State::Failed);
+    BOOST_CHECK(model.empty());
+    BOOST_CHECK(!loader.busy());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
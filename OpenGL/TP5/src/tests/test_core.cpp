@@ -10,6 +10,8 @@
 
 #include <boost/test/unit_test.hpp>
 #include <core.hpp>
+#include <loop.hpp>
+#include <span.hpp>
 
 #include <map>
 #include <string>
@@ -121,4 +123,143 @@ BOOST_AUTO_TEST_CASE(test_edge_list)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_v3)
+{
+    // the math core can be evaluated at compile time
+    constexpr v3f a(1.f, 2.f, 3.f);
+    constexpr v3f b(4.f, 5.f, 6.f);
+    static_assert(a.dot(b) > 31.f && a.dot(b) < 33.f);
+    constexpr v3f c = a.cross(b);
+    static_assert(c.x > -3.5f && c.x < -2.5f && c.y > 5.5f && c.y < 6.5f && c.z > -3.5f && c.z < -2.5f);
+    constexpr v3f e = 3.f * (a + b) / 8.f + (a - b) / 8.f;
+    static_assert(e.x > 1.49f && e.x < 1.51f);
+    static_assert(face(1, 2, 3) + face(1, 1, 1) == face(2, 3, 4));
+
+    // the double precision, 1e-10 is too short to be normalized in float
+    const v3d ad(a);
+    const v3d bd(b);
+    BOOST_CHECK_CLOSE(ad.dot(bd), 32., 1e-12);
+    v3d n(1e-10, 0., 0.);
+    n.normalize();
+    BOOST_CHECK_CLOSE(n.norm(), 1., 1e-12);
+    v3f nf(1e-7f, 0.f, 0.f);
+    nf.normalize();
+    BOOST_CHECK_CLOSE(nf.x, 1e-7f, 1e-3f);
+    const v3f back(ad * 2.);
+    BOOST_CHECK_CLOSE(back.z, 6.f, 1e-5f);
+}
+
+BOOST_AUTO_TEST_CASE(test_face_list)
+{
+    // a tetrahedron
+    const std::vector<point3d> vertices{{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+    const std::vector<face> mesh{{0, 2, 1}, {0, 1, 3}, {1, 2, 3}, {0, 3, 2}};
+
+    const FaceList small(mesh, vertices.size());
+    BOOST_CHECK(small.is16());
+    BOOST_CHECK_EQUAL(small.size(), mesh.size());
+    BOOST_CHECK_EQUAL(small.bytes(), mesh.size() * 3 * sizeof(idx16type));
+    BOOST_CHECK(!FaceList(mesh, FaceList::MAX_VERTICES_16 + 1).is16());
+
+    // the 16-bit subdivision gives the same mesh as the 32-bit one
+    std::vector<point3d> vert32;
+    std::vector<face> mesh32;
+    std::vector<vec3d> norm32;
+    loopSubdivision(vertices, mesh, vert32, mesh32, norm32);
+
+    std::vector<point3d> vert16;
+    FaceList mesh16;
+    std::vector<vec3d> norm16;
+    loopSubdivision(vertices, small, vert16, mesh16, norm16);
+    BOOST_CHECK(mesh16.is16());
+    BOOST_CHECK_EQUAL(vert16.size(), vert32.size());
+    mesh16.visit([&mesh32](const auto& faces) {
+        BOOST_REQUIRE_EQUAL(faces.size(), mesh32.size());
+        for(std::size_t i = 0; i < faces.size(); ++i)
+        {
+            BOOST_CHECK(face(faces[i]) == mesh32[i]);
+        }
+    });
+
+    // promotion when the subdivided mesh may not fit in 16 bits: the same faces repeated, the bound
+    // on the number of new vertices counts one per edge of each face
+    std::vector<face> repeated;
+    while(loopSubdivisionMaxVertices(vertices.size(), repeated.size()) <= FaceList::MAX_VERTICES_16)
+    {
+        repeated.insert(repeated.end(), mesh.begin(), mesh.end());
+    }
+    const FaceList large(repeated, vertices.size());
+    BOOST_CHECK(large.is16());
+    FaceList promoted;
+    std::vector<point3d> vertPromoted;
+    std::vector<vec3d> normPromoted;
+    loopSubdivision(vertices, large, vertPromoted, promoted, normPromoted);
+    BOOST_CHECK(!promoted.is16());
+    BOOST_CHECK_EQUAL(promoted.size(), 4 * repeated.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_mesh_level)
+{
+    // the tetrahedron
+    const std::vector<point3d> vertices{{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+    const std::vector<face> mesh{{0, 2, 1}, {0, 1, 3}, {1, 2, 3}, {0, 3, 2}};
+
+    // the reference: two steps with the vectors
+    std::vector<point3d> vert1;
+    std::vector<face> mesh1;
+    std::vector<vec3d> norm1;
+    loopSubdivision(vertices, mesh, vert1, mesh1, norm1);
+    std::vector<point3d> vert2;
+    std::vector<face> mesh2;
+    std::vector<vec3d> norm2;
+    loopSubdivision(vert1, mesh1, vert2, mesh2, norm2);
+
+    MeshLevel base;
+    base.vertices = vertices;
+    base.faces.assign(mesh, vertices.size());
+    MeshLevel current;
+    MeshLevel spare;
+    BOOST_CHECK(current.empty());
+    Arena arena;
+    const point3d* levelData{nullptr};
+    for(int run = 0; run < 2; ++run)
+    {
+        // ping-pong between the two levels, the second run writes in the buffers of the first one
+        for(int step = 0; step < 2; ++step)
+        {
+            loopSubdivision((step == 0) ? base : current, spare, arena);
+            std::swap(current, spare);
+        }
+        if(run == 0)
+        {
+            levelData = current.vertices.data();
+        }
+        BOOST_CHECK_EQUAL(current.vertices.data(), levelData);
+
+        BOOST_REQUIRE_EQUAL(current.vertices.size(), vert2.size());
+        for(std::size_t i = 0; i < vert2.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(current.vertices[i].x, vert2[i].x);
+            BOOST_CHECK_EQUAL(current.vertices[i].y, vert2[i].y);
+            BOOST_CHECK_EQUAL(current.vertices[i].z, vert2[i].z);
+        }
+        BOOST_CHECK_EQUAL(current.normals.size(), norm2.size());
+        current.faces.visit([&mesh2](const auto& faces) {
+            BOOST_REQUIRE_EQUAL(faces.size(), mesh2.size());
+            for(std::size_t i = 0; i < faces.size(); ++i)
+            {
+                BOOST_CHECK(face(faces[i]) == mesh2[i]);
+            }
+        });
+    }
+
+    // the spans are read-only views of the levels
+    const Span<const point3d> view(current.vertices);
+    BOOST_CHECK_EQUAL(view.data(), current.vertices.data());
+    BOOST_CHECK_EQUAL(view.size(), current.vertices.size());
+    BOOST_CHECK_EQUAL(&view.back(), &current.vertices.back());
+    BOOST_CHECK_EQUAL(view.end() - view.begin(), static_cast<std::ptrdiff_t>(view.size()));
+    BOOST_CHECK(Span<const point3d>().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,164 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <core.hpp>
+#include <edges.hpp>
+#include <loop.hpp>
+#include <meshGenerator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(test_edges)
+
+BOOST_AUTO_TEST_CASE(test_extract_edges)
+{
+    // a tetrahedron: 6 edges shared by 2 faces, numbered in the order of their vertices
+    const std::vector<face> tetrahedron{{0, 2, 1}, {0, 1, 3}, {0, 3, 2}, {1, 2, 3}};
+    EdgeTable table;
+    extractEdges(tetrahedron, 4, table);
+    BOOST_REQUIRE_EQUAL(table.size(), 6U);
+    BOOST_REQUIRE_EQUAL(table.faceEdges.size(), 12U);
+    const std::pair<idxtype, idxtype> expected[6]{{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+    for(std::size_t e = 0; e < table.size(); ++e)
+    {
+        BOOST_CHECK_EQUAL(table.edges[e].first, expected[e].first);
+        BOOST_CHECK_EQUAL(table.edges[e].second, expected[e].second);
+        BOOST_CHECK_EQUAL(table.edges[e].faces, 2U);
+        BOOST_CHECK(!table.edges[e].boundary());
+    }
+    // the edge 0-2 is in the faces 0 and 2, opposite 1 then 3
+    BOOST_CHECK_EQUAL(table.edges[1].opposite[0], 1U);
+    BOOST_CHECK_EQUAL(table.edges[1].opposite[1], 3U);
+    // the corners of the face 0-2-1: 0-2, 2-1, 1-0
+    BOOST_CHECK_EQUAL(table.faceEdges[0], 1U);
+    BOOST_CHECK_EQUAL(table.faceEdges[1], 3U);
+    BOOST_CHECK_EQUAL(table.faceEdges[2], 0U);
+
+    // a boundary and a non-manifold edge: 0-1 is shared by 3 faces, the first two give the opposite vertices
+    const std::vector<face16> fan{{0, 1, 2}, {1, 0, 3}, {0, 1, 4}};
+    EdgeTable fanTable;
+    extractEdges(fan, 5, fanTable);
+    BOOST_REQUIRE_EQUAL(fanTable.size(), 7U);
+    BOOST_CHECK_EQUAL(fanTable.edges[0].faces, 3U);
+    BOOST_CHECK_EQUAL(fanTable.edges[0].opposite[0], 2U);
+    BOOST_CHECK_EQUAL(fanTable.edges[0].opposite[1], 3U);
+    BOOST_CHECK(fanTable.edges[1].boundary());
+    BOOST_CHECK_EQUAL(fanTable.edges[1].opposite[0], 1U);
+
+    EdgeTable empty;
+    extractEdges(std::vector<face>{}, 0, empty);
+    BOOST_CHECK_EQUAL(empty.size(), 0U);
+
+    // a mesh large enough for the parallel sort: the same table with any number of threads, and
+    // the same edges as the map
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    generateIcosphere(32, sink);
+    EdgeTable single;
+    extractEdges(mesh, vertices.size(), single, 1);
+    EdgeTable parallel;
+    extractEdges(FaceList(mesh, vertices.size()), vertices.size(), parallel, 4);
+    BOOST_REQUIRE_EQUAL(single.size(), parallel.size());
+    BOOST_CHECK(single.faceEdges == parallel.faceEdges);
+    std::map<std::pair<idxtype, idxtype>, std::size_t> map;
+    for(std::size_t c = 0; c < 3 * mesh.size(); ++c)
+    {
+        const idxtype v[3]{mesh[c / 3].v1, mesh[c / 3].v2, mesh[c / 3].v3};
+        const idxtype a = v[c % 3];
+        const idxtype b = v[(c + 1) % 3];
+        const auto e = map.emplace(std::make_pair(std::min(a, b), std::max(a, b)), map.size()).first;
+        BOOST_REQUIRE_EQUAL(single.edges[single.faceEdges[c]].first, e->first.first);
+        BOOST_REQUIRE_EQUAL(single.edges[single.faceEdges[c]].second, e->first.second);
+    }
+    BOOST_CHECK_EQUAL(single.size(), map.size());
+    for(std::size_t e = 0; e < single.size(); ++e)
+    {
+        BOOST_REQUIRE_EQUAL(single.edges[e].faces, 2U);
+        BOOST_CHECK_EQUAL(single.edges[e].opposite[0], parallel.edges[e].opposite[0]);
+        BOOST_CHECK_EQUAL(single.edges[e].opposite[1], parallel.edges[e].opposite[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_loop_edges)
+{
+    // the subdivision with the edge table gives the same triangles as with a map of the edges, the
+    // new vertices being numbered differently
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    generateNoiseGrid(6, 5, .1f, 3, sink);
+    std::vector<point3d> reference(vertices);
+    std::vector<face> referenceMesh;
+    // the new vertex of each edge, computed as the subdivision did before the edge table
+    std::map<edge, idxtype> newVertices;
+    const auto newVertex = [&](idxtype first, idxtype second) {
+        const edge e(first, second);
+        const auto found = newVertices.find({std::min(first, second), std::max(first, second)});
+        if(found != newVertices.end())
+        {
+            return found->second;
+        }
+        const auto index = static_cast<idxtype>(reference.size());
+        newVertices.emplace(std::make_pair(std::min(first, second), std::max(first, second)), index);
+        idxtype oppV1{0};
+        idxtype oppV2{0};
+        if(!isBoundaryEdge(e, mesh, oppV1, oppV2))
+        {
+            reference.push_back(3.0 * (vertices[e.first] + vertices[e.second]) / 8.0 + 1.0 * (vertices[oppV1] + vertices[oppV2]) / 8.0);
+        }
+        else
+        {
+            reference.push_back((vertices[e.first] + vertices[e.second]) / 2.0);
+        }
+        return index;
+    };
+    for(const auto& f : mesh)
+    {
+        const idxtype a = newVertex(f.v1, f.v2);
+        const idxtype b = newVertex(f.v2, f.v3);
+        const idxtype c = newVertex(f.v1, f.v3);
+        referenceMesh.insert(referenceMesh.end(), {face(f.v1, a, c), face(a, f.v2, b), face(b, f.v3, c), face(a, b, c)});
+    }
+
+    std::vector<point3d> destVert;
+    std::vector<face> destMesh;
+    std::vector<vec3d> destNorm;
+    loopSubdivision(vertices, mesh, destVert, destMesh, destNorm);
+    BOOST_REQUIRE_EQUAL(destVert.size(), reference.size());
+    BOOST_REQUIRE_EQUAL(destMesh.size(), referenceMesh.size());
+    // the new vertices of the same face, in the same corners, are at the same positions
+    for(std::size_t i = 0; i < destMesh.size(); ++i)
+    {
+        for(const auto& [v, r] : {std::make_pair(destMesh[i].v1, referenceMesh[i].v1),
+                                  std::make_pair(destMesh[i].v2, referenceMesh[i].v2),
+                                  std::make_pair(destMesh[i].v3, referenceMesh[i].v3)})
+        {
+            if(v >= vertices.size())
+            {
+                BOOST_REQUIRE_GE(r, vertices.size());
+                BOOST_CHECK_EQUAL(destVert[v].x, reference[r].x);
+                BOOST_CHECK_EQUAL(destVert[v].y, reference[r].y);
+                BOOST_CHECK_EQUAL(destVert[v].z, reference[r].z);
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL(v, r);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
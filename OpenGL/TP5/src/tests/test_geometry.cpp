@@ -10,11 +10,14 @@
 
 #include <boost/test/unit_test.hpp>
 #include <geometry.hpp>
+#include <meshGenerator.hpp>
+#include <soaVertices.hpp>
 
 #include <map>
 #include <string>
 #include <optional>
 #include <cmath>
+#include <random>
 
 
 BOOST_AUTO_TEST_SUITE(test_geometry)
@@ -45,5 +48,212 @@ BOOST_AUTO_TEST_CASE(test_angleAtVertex)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_vertex_corners)
+{
+    // the vertex 4 is not used
+    const std::vector<face16> mesh{{0, 1, 2}, {2, 1, 3}, {3, 0, 2}};
+    VertexCorners adjacency;
+    buildVertexCorners(Span(mesh), 5, adjacency);
+    BOOST_REQUIRE_EQUAL(adjacency.vertices(), 5U);
+    BOOST_REQUIRE_EQUAL(adjacency.corners.size(), 9U);
+    const std::vector<std::vector<idxtype>> expected{{0, 7}, {1, 4}, {2, 3, 8}, {5, 6}, {}};
+    for(std::size_t v = 0; v < expected.size(); ++v)
+    {
+        const auto corners = adjacency.of(v);
+        BOOST_CHECK_EQUAL_COLLECTIONS(corners.begin(), corners.end(), expected[v].begin(), expected[v].end());
+    }
+
+    VertexCorners empty;
+    buildVertexCorners(Span<const face>(), 0, empty);
+    BOOST_CHECK_EQUAL(empty.vertices(), 0U);
+    BOOST_CHECK(empty.corners.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_gather_normals)
+{
+    // large enough to be gathered in parallel
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    generateIcosphere(48, sink);
+
+    // the scatter by faces
+    std::vector<vec3d> expected(vertices.size(), vec3d{0, 0, 0});
+    for(const auto& t : mesh)
+    {
+        const vec3d normal = computeNormal(vertices[t.v1], vertices[t.v2], vertices[t.v3]);
+        expected[t.v1] += normal * angleAtVertex(vertices[t.v1], vertices[t.v2], vertices[t.v3]);
+        expected[t.v2] += normal * angleAtVertex(vertices[t.v2], vertices[t.v1], vertices[t.v3]);
+        expected[t.v3] += normal * angleAtVertex(vertices[t.v3], vertices[t.v2], vertices[t.v1]);
+    }
+
+    // the same sums, whatever the number of threads
+    const auto same = [&expected](const std::vector<vec3d>& normals) {
+        BOOST_REQUIRE_EQUAL(normals.size(), expected.size());
+        for(std::size_t i = 0; i < normals.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(normals[i].x, expected[i].x);
+            BOOST_REQUIRE_EQUAL(normals[i].y, expected[i].y);
+            BOOST_REQUIRE_EQUAL(normals[i].z, expected[i].z);
+        }
+    };
+    VertexCorners adjacency;
+    buildVertexCorners(Span<const face>(mesh), vertices.size(), adjacency);
+    for(const unsigned threads : {1U, 4U})
+    {
+        std::vector<vec3d> normals(vertices.size(), vec3d{0, 0, 0});
+        gatherVertexNormals(vertices, Span<const face>(mesh), adjacency, normals, threads);
+        same(normals);
+    }
+    std::vector<vec3d> computed;
+    computeVertexNormals(vertices, mesh, computed);
+    same(computed);
+
+    // the faces added to existing normals, by halves
+    std::vector<vec3d> halves(vertices.size(), vec3d{0, 0, 0});
+    const std::size_t half = mesh.size() / 2;
+    accumulateVertexNormals(vertices, Span(mesh.data(), half), halves);
+    accumulateVertexNormals(vertices, Span(mesh.data() + half, mesh.size() - half), halves);
+    same(halves);
+}
+
+BOOST_AUTO_TEST_CASE(test_angle_weighting_names)
+{
+    for(const auto weighting : {AngleWeighting::Exact, AngleWeighting::Accurate, AngleWeighting::Fast})
+    {
+        AngleWeighting parsed{};
+        BOOST_REQUIRE(parseAngleWeighting(toString(weighting), parsed));
+        BOOST_CHECK(parsed == weighting);
+    }
+    AngleWeighting unchanged{AngleWeighting::Fast};
+    BOOST_CHECK(!parseAngleWeighting("acos", unchanged));
+    BOOST_CHECK(unchanged == AngleWeighting::Fast);
+}
+
+BOOST_AUTO_TEST_CASE(test_edge_angles)
+{
+    // random pairs, plus the angles close to 0, pi/2 and pi, and a null edge at the end; 1003 pairs
+    // leave a tail to the SIMD kernels
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> coordinate(-1.f, 1.f);
+    std::vector<float> a[3];
+    std::vector<float> b[3];
+    const auto push = [&a, &b](const vec3d& u, const vec3d& w) {
+        a[0].push_back(u.x);
+        a[1].push_back(u.y);
+        a[2].push_back(u.z);
+        b[0].push_back(w.x);
+        b[1].push_back(w.y);
+        b[2].push_back(w.z);
+    };
+    for(int i = 0; i < 1000; ++i)
+    {
+        const vec3d u{coordinate(generator), coordinate(generator), coordinate(generator)};
+        const vec3d w{coordinate(generator), coordinate(generator), coordinate(generator)};
+        switch(i % 4)
+        {
+            case 0: push(u, w); break;
+            case 1: push(u, u + w * 1e-3f); break;
+            case 2: push(u, u * -1.f + w * 1e-3f); break;
+            default: push(u, u.cross(w) + u * 1e-3f); break;
+        }
+    }
+    push({1, 0, 0}, {1, 0, 0});
+    push({1, 0, 0}, {0, 1, 0});
+    push({1, 0, 0}, {0, 0, 0});
+    const std::size_t n = a[0].size();
+    const float* const pa[3]{a[0].data(), a[1].data(), a[2].data()};
+    const float* const pb[3]{b[0].data(), b[1].data(), b[2].data()};
+
+    for(const auto& [weighting, tolerance] : {std::pair{AngleWeighting::Accurate, 1e-6}, std::pair{AngleWeighting::Fast, 2e-5}})
+    {
+        std::vector<float> reference;
+        for(int level = 0; level <= static_cast<int>(soa::detectSimdLevel()); ++level)
+        {
+            soa::setSimdLevel(static_cast<soa::SimdLevel>(level));
+            std::vector<float> angles(n);
+            edgeAngles(pa, pb, angles.data(), n, weighting);
+            if(reference.empty())
+            {
+                reference = angles;
+            }
+            // the same results with every instruction set
+            BOOST_CHECK_MESSAGE(angles == reference, toString(weighting) << " " << toString(static_cast<soa::SimdLevel>(level)));
+        }
+        soa::setSimdLevel(soa::detectSimdLevel());
+
+        // the error against the angle computed in double, and the same results one pair at a time
+        double maxError{0};
+        for(std::size_t i = 0; i + 1 < n; ++i)
+        {
+            const double ux = a[0][i], uy = a[1][i], uz = a[2][i];
+            const double wx = b[0][i], wy = b[1][i], wz = b[2][i];
+            const double cx = uy * wz - uz * wy, cy = uz * wx - ux * wz, cz = ux * wy - uy * wx;
+            const double exact = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ux * wx + uy * wy + uz * wz);
+            maxError = std::max(maxError, std::fabs(reference[i] - exact));
+            const point3d base{0, 0, 0};
+            BOOST_REQUIRE_EQUAL(angleAtVertex(base, {-a[0][i], -a[1][i], -a[2][i]}, {-b[0][i], -b[1][i], -b[2][i]}, weighting),
+                                reference[i]);
+        }
+        BOOST_CHECK_MESSAGE(maxError <= tolerance, toString(weighting) << " error " << maxError);
+        BOOST_CHECK_EQUAL(reference[n - 1], 0.f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_corner_angles)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    generateIcosphere(12, sink);
+
+    // more faces than a block, the corners in the order of angleAtVertex
+    std::vector<float> angles(3 * mesh.size());
+    cornerAngles(vertices, Span<const face>(mesh), angles.data(), AngleWeighting::Exact);
+    for(std::size_t f = 0; f < mesh.size(); ++f)
+    {
+        const auto& t = mesh[f];
+        BOOST_REQUIRE_EQUAL(angles[3 * f], angleAtVertex(vertices[t.v1], vertices[t.v2], vertices[t.v3]));
+        BOOST_REQUIRE_EQUAL(angles[3 * f + 1], angleAtVertex(vertices[t.v2], vertices[t.v1], vertices[t.v3]));
+        BOOST_REQUIRE_EQUAL(angles[3 * f + 2], angleAtVertex(vertices[t.v3], vertices[t.v2], vertices[t.v1]));
+    }
+    cornerAngles(vertices, Span<const face>(mesh), angles.data(), AngleWeighting::Fast);
+    for(std::size_t f = 0; f < mesh.size(); ++f)
+    {
+        const auto& t = mesh[f];
+        BOOST_REQUIRE_EQUAL(angles[3 * f], angleAtVertex(vertices[t.v1], vertices[t.v2], vertices[t.v3], AngleWeighting::Fast));
+        BOOST_REQUIRE_EQUAL(angles[3 * f + 1], angleAtVertex(vertices[t.v2], vertices[t.v1], vertices[t.v3], AngleWeighting::Fast));
+        BOOST_REQUIRE_EQUAL(angles[3 * f + 2], angleAtVertex(vertices[t.v3], vertices[t.v2], vertices[t.v1], AngleWeighting::Fast));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_fast_normals)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    generateIcosphere(48, sink);
+
+    std::vector<vec3d> exact;
+    computeVertexNormals(vertices, mesh, exact);
+    std::vector<vec3d> fast;
+    computeVertexNormals(vertices, mesh, fast, AngleWeighting::Fast);
+
+    // the gather gives the same sums as the scatter with the approximated angles too
+    VertexCorners adjacency;
+    buildVertexCorners(Span<const face>(mesh), vertices.size(), adjacency);
+    std::vector<vec3d> gathered(vertices.size(), vec3d{0, 0, 0});
+    gatherVertexNormals(vertices, Span<const face>(mesh), adjacency, gathered, 4, AngleWeighting::Fast);
+    BOOST_REQUIRE_EQUAL(fast.size(), exact.size());
+    for(std::size_t v = 0; v < fast.size(); ++v)
+    {
+        BOOST_REQUIRE_EQUAL(gathered[v].x, fast[v].x);
+        BOOST_REQUIRE_EQUAL(gathered[v].y, fast[v].y);
+        BOOST_REQUIRE_EQUAL(gathered[v].z, fast[v].z);
+        // the directions differ by less than 1e-4 rad
+        BOOST_REQUIRE_LT(fast[v].cross(exact[v]).norm() / (fast[v].norm() * exact[v].norm()), 1e-4f);
+    }
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
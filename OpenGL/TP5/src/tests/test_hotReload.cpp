@@ -0,0 +1,227 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <hotReload.hpp>
+#include <loop.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+
+/**
+ * Generate a mesh in memory
+ * @return the vertices and the faces
+ */
+template<typename Generate>
+MeshBatch generate(Generate&& fn)
+{
+    MeshBatch batch;
+    MemorySink sink(batch.vertices, batch.faces);
+    fn(sink);
+    return batch;
+}
+
+/// move each vertex differently, without changing the faces
+void deform(std::vector<point3d>& vertices)
+{
+    for(auto& v : vertices)
+    {
+        v = point3d{v.x * 1.5f, v.y + .1f * std::sin(3.f * v.x), v.z - .2f};
+    }
+}
+
+/// write a mesh in the OBJ format
+void writeObj(const std::string& filename, const MeshBatch& batch)
+{
+    ObjSink sink(filename);
+    BOOST_REQUIRE(sink.begin(batch.vertices.size(), batch.faces.size()));
+    for(const auto& v : batch.vertices)
+    {
+        sink.vertex(v);
+    }
+    for(const auto& f : batch.faces)
+    {
+        sink.face(f);
+    }
+    BOOST_REQUIRE(sink.end());
+}
+
+/// check that two lists of points are the same up to the rounding
+template<typename Point>
+void checkClose(const std::vector<Point>& a, const std::vector<Point>& b, float tolerance)
+{
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    float maxError{0};
+    for(std::size_t i = 0; i < a.size(); ++i)
+    {
+        maxError = std::max({maxError, std::fabs(a[i].x - b[i].x), std::fabs(a[i].y - b[i].y), std::fabs(a[i].z - b[i].z)});
+    }
+    BOOST_CHECK_LT(maxError, tolerance);
+}
+
+/**
+ * Poll the reloader until it updates the model
+ * @return the first result other than None, None after 10 seconds
+ */
+HotReloader::Result pollUntilReloaded(HotReloader& reloader, MeshModel& model)
+{
+    const auto start = std::chrono::steady_clock::now();
+    while(std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+    {
+        const auto result = reloader.poll(model);
+        if(result != HotReloader::Result::None)
+        {
+            return result;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return HotReloader::Result::None;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_hotReload)
+
+BOOST_AUTO_TEST_CASE(test_loop_stencil)
+{
+    // a closed mesh and a mesh with a boundary
+    for(const auto& batch : {generate([](MeshSink& s) { generateIcosphere(4, s); }),
+                             generate([](MeshSink& s) { generateNoiseGrid(9, 7, .2f, 3, s); })})
+    {
+        MeshLevel orig;
+        orig.vertices = batch.vertices;
+        orig.faces.assign(batch.faces, batch.vertices.size());
+        MeshLevel dest;
+        Arena scratch;
+        loopSubdivision(orig, dest, scratch);
+
+        LoopStencil stencil;
+        loopStencil(orig, dest, stencil);
+        BOOST_CHECK_EQUAL(stencil.rows(), dest.vertices.size());
+        std::vector<point3d> vertices;
+        applyLoopStencil(stencil, orig.vertices, vertices);
+        checkClose(vertices, dest.vertices, 1e-5f);
+
+        // the stencil of the same faces gives the subdivision of the moved vertices
+        deform(orig.vertices);
+        loopSubdivision(orig, dest, scratch);
+        applyLoopStencil(stencil, orig.vertices, vertices);
+        checkClose(vertices, dest.vertices, 1e-5f);
+        std::vector<vec3d> normals;
+        loopNormals(vertices, dest.faces, normals);
+        checkClose(normals, dest.normals, 1e-4f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_update_positions)
+{
+    MeshModel model;
+    BOOST_REQUIRE(model.load(teapot));
+    const std::size_t numFaces = model.level(2).faces.size();
+
+    MeshBatch moved;
+    BOOST_REQUIRE(MeshModel::read(teapot, 0.f, moved.vertices, moved.faces, moved.normals));
+    deform(moved.vertices);
+    moved.normals.clear();
+    MeshModel expected;
+    MeshBatch copy{moved.vertices, moved.faces, {}};
+    expected.append(std::move(copy));
+
+    // the same faces: the subdivision is recomputed from its topology
+    BOOST_CHECK(model.update(std::move(moved)));
+    checkClose(model.level(0).vertices, expected.level(0).vertices, 1e-6f);
+    const MeshLevel& refreshed = model.level(2);
+    const MeshLevel& subdivided = expected.level(2);
+    BOOST_CHECK_EQUAL(refreshed.faces.size(), numFaces);
+    checkClose(refreshed.vertices, subdivided.vertices, 1e-4f);
+    checkClose(refreshed.normals, subdivided.normals, 1e-3f);
+    // going further subdivides the refreshed level
+    BOOST_CHECK_EQUAL(model.level(3).faces.size(), 4 * numFaces);
+
+    // other faces: the model is replaced
+    MeshBatch fewer;
+    BOOST_REQUIRE(MeshModel::read(teapot, 0.f, fewer.vertices, fewer.faces, fewer.normals));
+    fewer.faces.pop_back();
+    const std::size_t numBaseFaces = fewer.faces.size();
+    BOOST_CHECK(!model.update(std::move(fewer)));
+    BOOST_CHECK_EQUAL(model.level(0).faces.size(), numBaseFaces);
+    BOOST_CHECK_EQUAL(model.level(1).faces.size(), 4 * numBaseFaces);
+}
+
+BOOST_AUTO_TEST_CASE(test_file_watcher)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "test_hotReload_watcher";
+    std::filesystem::create_directories(directory);
+    const auto file = directory / "model.obj";
+    std::ofstream(file) << "v 0 0 0\n";
+
+    FileWatcher watcher(file.string());
+    BOOST_CHECK(!watcher.changed());
+    std::ofstream(file) << "v 1 0 0\n";
+    BOOST_CHECK(watcher.changed());
+    BOOST_CHECK(!watcher.changed());
+
+    // replaced by a rename, as many editors do
+    std::ofstream(directory / "model.obj.tmp") << "v 2 0 0\n";
+    std::filesystem::rename(directory / "model.obj.tmp", file);
+    BOOST_CHECK(watcher.changed());
+
+    if(watcher.notified())
+    {
+        // the other files of the directory are ignored, the modification time cannot tell them apart
+        std::ofstream(directory / "other.obj") << "v 0 0 0\n";
+        BOOST_CHECK(!watcher.changed());
+    }
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(test_hot_reloader)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "test_hotReload_reloader";
+    std::filesystem::create_directories(directory);
+    const std::string file = (directory / "sphere.obj").string();
+    MeshBatch sphere = generate([](MeshSink& s) { generateIcosphere(3, s); });
+    writeObj(file, sphere);
+
+    MeshModel model;
+    BOOST_REQUIRE(model.load(file));
+    BOOST_REQUIRE(!model.level(1).empty());
+    HotReloader reloader(file);
+    BOOST_CHECK(reloader.poll(model) == HotReloader::Result::None);
+    BOOST_CHECK(!reloader.busy());
+
+    deform(sphere.vertices);
+    writeObj(file, sphere);
+    BOOST_CHECK(pollUntilReloaded(reloader, model) == HotReloader::Result::Positions);
+    checkClose(model.level(0).vertices, sphere.vertices, 1e-5f);
+
+    writeObj(file, generate([](MeshSink& s) { generateIcosphere(2, s); }));
+    BOOST_CHECK(pollUntilReloaded(reloader, model) == HotReloader::Result::Topology);
+    BOOST_CHECK_EQUAL(model.level(0).faces.size(), 20U * 4U);
+
+    // a broken file keeps the previous version
+    std::ofstream(file) << "f 1 2 3\n";
+    BOOST_CHECK(pollUntilReloaded(reloader, model) == HotReloader::Result::Failed);
+    BOOST_CHECK_EQUAL(model.level(0).faces.size(), 20U * 4U);
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,293 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <MeshModel.hpp>
+#include <meshCache.hpp>
+#include <meshGenerator.hpp>
+#include <pipeline.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+
+/**
+ * Create an empty cache directory for a test
+ * @param[in] name the name of the directory
+ * @return the directory
+ */
+std::filesystem::path emptyDirectory(const std::string& name)
+{
+    const auto directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+
+/**
+ * Generate a level with its normals
+ * @param[in] frequency the frequency of the icosphere
+ * @return the level
+ */
+MeshLevel sphere(std::uint32_t frequency)
+{
+    MeshLevel level;
+    std::vector<face> mesh;
+    MemorySink sink(level.vertices, mesh);
+    generateIcosphere(frequency, sink);
+    level.normals.assign(level.vertices.begin(), level.vertices.end());
+    level.faces.assign(std::move(mesh), level.vertices.size());
+    return level;
+}
+
+/// true if the two arrays have the same points
+bool samePoints(const std::vector<point3d>& a, const std::vector<point3d>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const point3d& p, const point3d& q) {
+        return p.x == q.x && p.y == q.y && p.z == q.z;
+    });
+}
+
+/// true if the two lists have the same faces
+bool sameFaces(const FaceList& a, const FaceList& b)
+{
+    return a.is16() == b.is16() && a.visit([&b](const auto& facesA) {
+        return b.visit([&facesA](const auto& facesB) {
+            if(facesA.size() != facesB.size())
+            {
+                return false;
+            }
+            for(std::size_t i = 0; i < facesA.size(); ++i)
+            {
+                if(facesA[i].v1 != facesB[i].v1 || facesA[i].v2 != facesB[i].v2 || facesA[i].v3 != facesB[i].v3)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+    });
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_meshCache)
+
+BOOST_AUTO_TEST_CASE(test_hash)
+{
+    std::vector<std::uint8_t> bytes(1000);
+    std::iota(bytes.begin(), bytes.end(), std::uint8_t{0});
+    MeshHasher whole;
+    whole.add(bytes.data(), bytes.size());
+    // the result does not depend on the split of the bytes
+    for(const std::size_t chunk : {1U, 3U, 7U, 8U, 13U, 999U})
+    {
+        MeshHasher split;
+        for(std::size_t begin = 0; begin < bytes.size(); begin += chunk)
+        {
+            split.add(bytes.data() + begin, std::min(chunk, bytes.size() - begin));
+        }
+        BOOST_CHECK_EQUAL(split.value(), whole.value());
+    }
+    MeshHasher shorter;
+    shorter.add(bytes.data(), bytes.size() - 1);
+    BOOST_CHECK_NE(shorter.value(), whole.value());
+    MeshHasher seeded(1);
+    seeded.add(bytes.data(), bytes.size());
+    BOOST_CHECK_NE(seeded.value(), whole.value());
+
+    // the width of the indices does not change the hash of a mesh, the geometry does
+    MeshLevel level = sphere(4);
+    BOOST_REQUIRE(level.faces.is16());
+    std::vector<face> wide;
+    level.faces.visit([&wide](const auto& faces) {
+        for(const auto& f : faces)
+        {
+            wide.emplace_back(f.v1, f.v2, f.v3);
+        }
+    });
+    const std::uint64_t hash = hashMesh(level.vertices, level.faces);
+    BOOST_CHECK_EQUAL(hashMesh(level.vertices, wide), hash);
+    level.vertices[5].x += 1e-6f;
+    BOOST_CHECK_NE(hashMesh(level.vertices, level.faces), hash);
+
+    BOOST_CHECK_NE(MeshCache::key(hash, LOOP_CACHE_OPERATION, 1), MeshCache::key(hash, LOOP_CACHE_OPERATION, 2));
+    BOOST_CHECK_NE(MeshCache::key(hash, LOOP_CACHE_OPERATION, 1), MeshCache::key(hash, "other", 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_store_load)
+{
+    const auto directory = emptyDirectory("test_meshCache_store");
+    MeshCache cache(directory.string());
+    BOOST_REQUIRE(std::filesystem::is_directory(directory));
+
+    MeshLevel level = sphere(8);
+    MeshLevel read;
+    BOOST_CHECK(!cache.contains(1));
+    BOOST_CHECK(!cache.load(1, read));
+    BOOST_CHECK(read.empty());
+    BOOST_REQUIRE(cache.store(1, level));
+    BOOST_CHECK(cache.contains(1));
+    BOOST_REQUIRE(cache.load(1, read));
+    BOOST_CHECK(samePoints(read.vertices, level.vertices));
+    BOOST_CHECK(samePoints(read.normals, level.normals));
+    BOOST_CHECK(sameFaces(read.faces, level.faces));
+
+    // 32-bit indices, no normals
+    MeshLevel wide;
+    wide.vertices.assign(70000, point3d{1.f, 2.f, 3.f});
+    wide.faces.assign({face(0, 1, 69999), face(69998, 2, 3)}, wide.vertices.size());
+    BOOST_REQUIRE(!wide.faces.is16());
+    BOOST_REQUIRE(cache.store(2, wide));
+    BOOST_REQUIRE(cache.load(2, read));
+    BOOST_CHECK(samePoints(read.vertices, wide.vertices));
+    BOOST_CHECK(read.normals.empty());
+    BOOST_CHECK(sameFaces(read.faces, wide.faces));
+
+    const MeshCacheStats stats = cache.stats();
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+    BOOST_CHECK_EQUAL(stats.stores, 2U);
+    BOOST_CHECK_EQUAL(stats.evictions, 0U);
+    BOOST_CHECK_EQUAL(stats.bytesRead, stats.bytesWritten);
+    BOOST_CHECK_EQUAL(cache.diskBytes(), stats.bytesWritten);
+
+    // an entry is written once
+    BOOST_CHECK(cache.store(1, level));
+    BOOST_CHECK_EQUAL(cache.stats().stores, 2U);
+
+    // a damaged entry is a miss, the entries are named after their keys
+    const auto entry = directory / "0000000000000001.mcache";
+    BOOST_REQUIRE(std::filesystem::exists(entry));
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 1);
+    BOOST_CHECK(!cache.load(1, read));
+    BOOST_CHECK_EQUAL(cache.stats().misses, 2U);
+
+    // a number of vertices whose size overflows to the size of the file is a miss as well
+    const auto wideEntry = directory / "0000000000000002.mcache";
+    std::uint64_t numVertices{0};
+    std::fstream corrupted(wideEntry, std::ios::in | std::ios::out | std::ios::binary);
+    corrupted.seekg(16);
+    corrupted.read(reinterpret_cast<char*>(&numVertices), sizeof(numVertices));
+    BOOST_REQUIRE_EQUAL(numVertices, wide.vertices.size());
+    numVertices += std::uint64_t{1} << 62U;
+    corrupted.seekp(16);
+    corrupted.write(reinterpret_cast<const char*>(&numVertices), sizeof(numVertices));
+    corrupted.close();
+    BOOST_CHECK(!cache.load(2, read));
+    BOOST_CHECK_EQUAL(cache.stats().misses, 3U);
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(test_eviction)
+{
+    const auto directory = emptyDirectory("test_meshCache_eviction");
+    const MeshLevel level = sphere(8);
+    MeshCache probe(emptyDirectory("test_meshCache_probe").string());
+    BOOST_REQUIRE(probe.store(0, level));
+    const std::uint64_t entryBytes = probe.diskBytes();
+    std::filesystem::remove_all(probe.directory());
+
+    // room for two entries
+    MeshCache cache(directory.string(), 2 * entryBytes + entryBytes / 2);
+    MeshLevel read;
+    BOOST_REQUIRE(cache.store(1, level));
+    BOOST_REQUIRE(cache.store(2, level));
+    // the least recently used entry is 2 once 1 has been read
+    for(const auto& file : std::filesystem::directory_iterator(directory))
+    {
+        std::filesystem::last_write_time(file.path(), std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    }
+    BOOST_REQUIRE(cache.load(1, read));
+    BOOST_REQUIRE(cache.store(3, level));
+    BOOST_CHECK_EQUAL(cache.stats().evictions, 1U);
+    BOOST_CHECK(cache.contains(1));
+    BOOST_CHECK(!cache.contains(2));
+    BOOST_CHECK(cache.contains(3));
+    BOOST_CHECK_LE(cache.diskBytes(), cache.maxBytes());
+
+    // larger than the cache
+    MeshCache small(directory.string(), entryBytes / 2);
+    BOOST_CHECK(!small.store(4, level));
+    BOOST_CHECK(!small.contains(4));
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(test_model_levels)
+{
+    const auto directory = emptyDirectory("test_meshCache_model");
+    auto cache = std::make_shared<MeshCache>(directory.string());
+
+    MeshModel computed;
+    BOOST_REQUIRE(computed.load(teapot));
+    computed.setCache(cache);
+    const MeshLevel& expected = computed.level(2);
+    BOOST_CHECK_EQUAL(cache.get()->stats().stores, 2U);
+    BOOST_CHECK_EQUAL(cache.get()->stats().hits, 0U);
+
+    // only the deepest level is read
+    MeshModel cached;
+    BOOST_REQUIRE(cached.load(teapot));
+    cached.setCache(cache);
+    const MeshLevel& read = cached.level(2);
+    BOOST_CHECK_EQUAL(cache.get()->stats().hits, 1U);
+    BOOST_CHECK_EQUAL(cache.get()->stats().stores, 2U);
+    BOOST_CHECK(samePoints(read.vertices, expected.vertices));
+    BOOST_CHECK(samePoints(read.normals, expected.normals));
+    BOOST_CHECK(sameFaces(read.faces, expected.faces));
+
+    // the next level is subdivided from the cached one
+    const MeshLevel& deeper = cached.level(3);
+    BOOST_CHECK_EQUAL(deeper.faces.size(), 4U * expected.faces.size());
+    BOOST_CHECK_EQUAL(cache.get()->stats().stores, 3U);
+
+    // another geometry has other entries
+    MeshModel unitized;
+    BOOST_REQUIRE(unitized.load(teapot));
+    unitized.unitizeModel();
+    unitized.setCache(cache);
+    unitized.level(1);
+    BOOST_CHECK_EQUAL(cache.get()->stats().hits, 1U);
+    BOOST_CHECK_EQUAL(cache.get()->stats().stores, 4U);
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_subdivide)
+{
+    const auto directory = emptyDirectory("test_meshCache_pipeline");
+    auto cache = std::make_shared<MeshCache>(directory.string());
+    Pipeline pipeline(1);
+    BOOST_REQUIRE(pipeline.parse("repair, subdivide 1"));
+    pipeline.setCache(cache);
+
+    const PipelineStats miss = pipeline.run(teapot);
+    const PipelineStats hit = pipeline.run(teapot);
+    BOOST_REQUIRE(miss.succeeded && hit.succeeded);
+    BOOST_REQUIRE_EQUAL(miss.stages.size(), 3U);
+    BOOST_REQUIRE_EQUAL(hit.stages.size(), 3U);
+    BOOST_REQUIRE_EQUAL(miss.stages[2].values.size(), 1U);
+    BOOST_CHECK_EQUAL(miss.stages[2].values[0].first, "cacheHit");
+    BOOST_CHECK_EQUAL(miss.stages[2].values[0].second, 0.);
+    BOOST_CHECK_EQUAL(hit.stages[2].values[0].second, 1.);
+    BOOST_CHECK_EQUAL(hit.stages[2].vertices, miss.stages[2].vertices);
+    BOOST_CHECK_EQUAL(hit.stages[2].faces, miss.stages[2].faces);
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
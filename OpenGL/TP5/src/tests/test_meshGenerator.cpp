@@ -0,0 +1,260 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <MeshModel.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Check that each edge is shared by exactly two faces traversing it in opposite directions,
+ * ie the mesh is closed, manifold and consistently oriented
+ */
+bool isClosedManifold(const std::vector<face>& mesh)
+{
+    std::map<std::pair<idxtype, idxtype>, int> directed;
+    for(const auto& f : mesh)
+    {
+        ++directed[{f.v1, f.v2}];
+        ++directed[{f.v2, f.v3}];
+        ++directed[{f.v3, f.v1}];
+    }
+    for(const auto& [e, count] : directed)
+    {
+        const auto opposite = directed.find({e.second, e.first});
+        if(count != 1 || opposite == directed.end() || opposite->second != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// the content of a file
+std::string readFile(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+bool indicesInRange(const std::vector<point3d>& vertices, const std::vector<face>& mesh)
+{
+    for(const auto& f : mesh)
+    {
+        if(f.v1 >= vertices.size() || f.v2 >= vertices.size() || f.v3 >= vertices.size())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_meshGenerator)
+
+BOOST_AUTO_TEST_CASE(test_icosphere)
+{
+    for(const std::uint32_t frequency : {1U, 2U, 3U, 7U})
+    {
+        std::vector<point3d> vertices;
+        std::vector<face> mesh;
+        MemorySink sink(vertices, mesh);
+        BOOST_REQUIRE(generateIcosphere(frequency, sink));
+        BOOST_CHECK_EQUAL(vertices.size(), 10 * frequency * frequency + 2);
+        BOOST_CHECK_EQUAL(mesh.size(), 20 * frequency * frequency);
+        BOOST_CHECK(indicesInRange(vertices, mesh));
+        BOOST_CHECK(isClosedManifold(mesh));
+        for(const auto& v : vertices)
+        {
+            BOOST_CHECK_CLOSE(v.norm(), 1.f, 0.001f);
+        }
+        // the faces are counter-clockwise seen from outside
+        for(const auto& f : mesh)
+        {
+            const vec3d n = (vertices[f.v2] - vertices[f.v1]).cross(vertices[f.v3] - vertices[f.v1]);
+            BOOST_CHECK_GT(n.dot(vertices[f.v1] + vertices[f.v2] + vertices[f.v3]), 0.f);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_torus)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    BOOST_REQUIRE(generateTorus(12, 5, 1.f, .25f, sink));
+    BOOST_CHECK_EQUAL(vertices.size(), 60U);
+    BOOST_CHECK_EQUAL(mesh.size(), 120U);
+    BOOST_CHECK(indicesInRange(vertices, mesh));
+    BOOST_CHECK(isClosedManifold(mesh));
+}
+
+BOOST_AUTO_TEST_CASE(test_grid_and_soup_are_deterministic)
+{
+    std::vector<point3d> v1;
+    std::vector<point3d> v2;
+    std::vector<face> m1;
+    std::vector<face> m2;
+    MemorySink s1(v1, m1);
+    MemorySink s2(v2, m2);
+    BOOST_REQUIRE(generateNoiseGrid(8, 5, .3f, 42, s1));
+    BOOST_REQUIRE(generateNoiseGrid(8, 5, .3f, 42, s2));
+    BOOST_CHECK_EQUAL(v1.size(), 54U);
+    BOOST_CHECK_EQUAL(m1.size(), 80U);
+    BOOST_CHECK(indicesInRange(v1, m1));
+    for(std::size_t i = 0; i < v1.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(v1[i].z, v2[i].z);
+        BOOST_CHECK_LE(std::fabs(v1[i].z), .3f);
+    }
+
+    BOOST_REQUIRE(generateSoup(200, 7, s1));
+    BOOST_REQUIRE(generateSoup(200, 7, s2));
+    BOOST_CHECK_EQUAL(v1.size(), 600U);
+    BOOST_CHECK(m1 == m2);
+    BOOST_CHECK(indicesInRange(v1, m1));
+    // the fins make the soup non-manifold
+    BOOST_CHECK(!isClosedManifold(m1));
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_roundtrip)
+{
+    const std::string filename{"test_meshGenerator.bmesh"};
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink memory(vertices, mesh);
+    BOOST_REQUIRE(generateTorus(6, 4, 1.f, .5f, memory));
+
+    BinarySink file(filename);
+    BOOST_REQUIRE(generateTorus(6, 4, 1.f, .5f, file));
+
+    std::vector<point3d> readVertices;
+    std::vector<face> readMesh;
+    std::vector<vec3d> readNormals;
+    BOOST_REQUIRE(loadBinaryMesh(filename, readVertices, readMesh, readNormals));
+    std::remove(filename.c_str());
+    BOOST_CHECK(readMesh == mesh);
+    BOOST_CHECK(readNormals.empty());
+    BOOST_REQUIRE_EQUAL(readVertices.size(), vertices.size());
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(readVertices[i].x, vertices[i].x);
+        BOOST_CHECK_EQUAL(readVertices[i].y, vertices[i].y);
+        BOOST_CHECK_EQUAL(readVertices[i].z, vertices[i].z);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_write_obj)
+{
+    // several blocks of vertices and faces, with 32-bit indices, and a mesh with 16-bit indices
+    for(const std::uint32_t segments : {300U, 8U})
+    {
+        const std::string expected{"test_meshGenerator_sink.obj"};
+        const std::string filename{"test_meshGenerator_blocks.obj"};
+        std::vector<point3d> vertices;
+        std::vector<face> mesh;
+        MemorySink memory(vertices, mesh);
+        BOOST_REQUIRE(generateTorus(segments, 250, 1.f, .5f, memory));
+        ObjSink sink(expected);
+        BOOST_REQUIRE(generateTorus(segments, 250, 1.f, .5f, sink));
+        const std::string text = readFile(expected);
+
+        const FaceList faces(mesh, vertices.size());
+        BOOST_CHECK_EQUAL(faces.is16(), segments == 8U);
+        for(const unsigned threads : {1U, 0U, 3U})
+        {
+            BOOST_REQUIRE(writeObj(filename, vertices, faces, threads));
+            BOOST_CHECK(readFile(filename) == text);
+        }
+        std::remove(expected.c_str());
+        std::remove(filename.c_str());
+    }
+    BOOST_CHECK(!writeObj("missing/directory/mesh.obj", {}, FaceList{}));
+}
+
+BOOST_AUTO_TEST_CASE(test_write_binary_mesh)
+{
+    const std::string filename{"test_meshGenerator_write.bmesh"};
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink memory(vertices, mesh);
+    BOOST_REQUIRE(generateIcosphere(3, memory));
+    std::vector<vec3d> normals(vertices.begin(), vertices.end());
+
+    BOOST_REQUIRE(writeBinaryMesh(filename, vertices, normals, FaceList(mesh, vertices.size())));
+    std::vector<point3d> readVertices;
+    std::vector<face> readMesh;
+    std::vector<vec3d> readNormals;
+    BOOST_REQUIRE(loadBinaryMesh(filename, readVertices, readMesh, readNormals));
+    BOOST_CHECK(readMesh == mesh);
+    BOOST_REQUIRE_EQUAL(readNormals.size(), normals.size());
+    for(std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(readVertices[i].x, vertices[i].x);
+        BOOST_CHECK_EQUAL(readNormals[i].z, normals[i].z);
+    }
+
+    // the normals are optional
+    BOOST_REQUIRE(writeBinaryMesh(filename, vertices, {}, FaceList(mesh, vertices.size())));
+    BOOST_REQUIRE(loadBinaryMesh(filename, readVertices, readMesh, readNormals));
+    BOOST_CHECK(readNormals.empty());
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_save_model)
+{
+    MeshModel model;
+    BOOST_REQUIRE(model.load("data/models/teapot.obj"));
+    model.unitizeModel();
+    const MeshLevel& subdivided = model.level(1);
+    for(const std::string filename : {"test_meshGenerator_model.bmesh", "test_meshGenerator_model.obj",
+                                      "test_meshGenerator_model.ply", "test_meshGenerator_model.stl"})
+    {
+        BOOST_REQUIRE(model.save(filename, 1, 0));
+        std::vector<point3d> vertices;
+        std::vector<face> mesh;
+        std::vector<vec3d> normals;
+        BOOST_REQUIRE(MeshModel::read(filename, 0.f, vertices, mesh, normals));
+        std::remove(filename.c_str());
+        BOOST_CHECK_EQUAL(mesh.size(), subdivided.faces.size());
+        if(filename.find(".stl") != std::string::npos)
+        {
+            // the triangle soup is welded back
+            continue;
+        }
+        BOOST_REQUIRE_EQUAL(vertices.size(), subdivided.vertices.size());
+        BOOST_CHECK(FaceList(mesh, vertices.size()).visit([&subdivided](const auto& read) {
+            return subdivided.faces.visit([&read](const auto& faces) {
+                return std::equal(read.begin(), read.end(), faces.begin(), faces.end(), [](const auto& a, const auto& b) {
+                    return a.v1 == b.v1 && a.v2 == b.v2 && a.v3 == b.v3;
+                });
+            });
+        }));
+        BOOST_CHECK_EQUAL(vertices.back().x, subdivided.vertices.back().x);
+        if(filename.find(".bmesh") != std::string::npos)
+        {
+            // the normals of the subdivision are saved too
+            BOOST_CHECK_EQUAL(normals.back().y, subdivided.normals.back().y);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <decimate.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+#include <pipeline.hpp>
+#include <vertexCache.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+
+/**
+ * Generate a mesh in memory
+ * @return the vertices and the faces
+ */
+template<typename Generate>
+MeshBatch generate(Generate&& fn)
+{
+    MeshBatch batch;
+    MemorySink sink(batch.vertices, batch.faces);
+    fn(sink);
+    return batch;
+}
+
+/// the faces as triangles of positions, starting at the lowest vertex to keep the orientation, sorted
+std::vector<std::tuple<float, float, float, float, float, float, float, float, float>>
+triangles(const std::vector<point3d>& vertices, const std::vector<face>& mesh)
+{
+    std::vector<std::tuple<float, float, float, float, float, float, float, float, float>> result;
+    for(const auto& f : mesh)
+    {
+        idxtype v[3]{f.v1, f.v2, f.v3};
+        std::rotate(v, std::min_element(v, v + 3, [&vertices](idxtype a, idxtype b) {
+                        return std::tie(vertices[a].x, vertices[a].y, vertices[a].z)
+                               < std::tie(vertices[b].x, vertices[b].y, vertices[b].z);
+                    }),
+                    v + 3);
+        result.emplace_back(vertices[v[0]].x, vertices[v[0]].y, vertices[v[0]].z, vertices[v[1]].x, vertices[v[1]].y,
+                            vertices[v[1]].z, vertices[v[2]].x, vertices[v[2]].y, vertices[v[2]].z);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_pipeline)
+
+BOOST_AUTO_TEST_CASE(test_decimate)
+{
+    MeshBatch sphere = generate([](MeshSink& s) { generateIcosphere(32, s); });
+    const std::size_t numFaces = sphere.faces.size();
+
+    // a grid finer than the edges keeps the mesh
+    MeshBatch fine = sphere;
+    DecimateReport report = decimateMesh(fine.vertices, fine.faces, 100000);
+    BOOST_CHECK_EQUAL(report.verticesAfter, sphere.vertices.size());
+    BOOST_CHECK_EQUAL(fine.faces.size(), numFaces);
+
+    report = decimateMesh(sphere.vertices, sphere.faces, 16);
+    BOOST_CHECK_EQUAL(report.facesBefore, numFaces);
+    BOOST_CHECK_EQUAL(report.facesAfter, sphere.faces.size());
+    BOOST_CHECK_EQUAL(report.verticesAfter, sphere.vertices.size());
+    BOOST_CHECK_LT(sphere.faces.size(), numFaces / 4);
+    BOOST_CHECK_GT(sphere.faces.size(), 0U);
+    for(const auto& f : sphere.faces)
+    {
+        BOOST_CHECK(f.v1 != f.v2 && f.v2 != f.v3 && f.v1 != f.v3);
+        BOOST_CHECK_LT(std::max({f.v1, f.v2, f.v3}), sphere.vertices.size());
+    }
+    // the cells are smaller than 2 / 16, the vertices stay close to the unit sphere
+    for(const auto& v : sphere.vertices)
+    {
+        BOOST_CHECK_GT(v.norm(), .85f);
+        BOOST_CHECK_LT(v.norm(), 1.001f);
+    }
+
+    // a single cell
+    MeshBatch single = generate([](MeshSink& s) { generateIcosphere(2, s); });
+    decimateMesh(single.vertices, single.faces, 1);
+    BOOST_CHECK_EQUAL(single.vertices.size(), 0U);
+    BOOST_CHECK(single.faces.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_vertex_cache)
+{
+    std::vector<face> triangle{face(0, 1, 2)};
+    BOOST_CHECK_EQUAL(averageCacheMissRatio(3, triangle), 3.);
+    BOOST_CHECK_EQUAL(averageCacheMissRatio(0, {}), 0.);
+
+    // a grid whose faces are shuffled, so that the cache is useless
+    MeshBatch grid = generate([](MeshSink& s) { generateNoiseGrid(60, 60, .1f, 3, s); });
+    std::mt19937 random(7);
+    std::shuffle(grid.faces.begin(), grid.faces.end(), random);
+    const auto expected = triangles(grid.vertices, grid.faces);
+    const double shuffled = averageCacheMissRatio(grid.vertices.size(), grid.faces);
+    BOOST_CHECK_GT(shuffled, 2.);
+
+    optimizeVertexCache(grid.vertices.size(), grid.faces);
+    const double optimized = averageCacheMissRatio(grid.vertices.size(), grid.faces);
+    BOOST_CHECK_LT(optimized, .8);
+    BOOST_CHECK(triangles(grid.vertices, grid.faces) == expected);
+
+    // the vertices in the order of their first use, the faces unchanged
+    grid.normals.assign(grid.vertices.begin(), grid.vertices.end());
+    grid.vertices.push_back(point3d{5.f, 5.f, 5.f});
+    grid.normals.push_back(point3d{5.f, 5.f, 5.f});
+    optimizeVertexFetch(grid.vertices, grid.normals, grid.faces);
+    idxtype next{0};
+    for(const auto& f : grid.faces)
+    {
+        for(const idxtype v : {f.v1, f.v2, f.v3})
+        {
+            BOOST_REQUIRE_LE(v, next);
+            next = std::max(next, static_cast<idxtype>(v + 1));
+        }
+    }
+    BOOST_CHECK_EQUAL(averageCacheMissRatio(grid.vertices.size(), grid.faces), optimized);
+    BOOST_CHECK(triangles(grid.vertices, grid.faces) == expected);
+    // the unreferenced vertex at the end, the normals follow their vertices
+    BOOST_CHECK_EQUAL(grid.vertices.back().x, 5.f);
+    for(std::size_t v = 0; v + 1 < grid.vertices.size(); ++v)
+    {
+        BOOST_CHECK_EQUAL(grid.normals[v].z, grid.vertices[v].z);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_parse)
+{
+    Pipeline pipeline;
+    BOOST_REQUIRE(pipeline.parse(" weld 1e-5, repair,normals , subdivide 2, decimate 64, optimize, export out/{name}.obj"));
+    const auto& stages = pipeline.stages();
+    BOOST_REQUIRE_EQUAL(stages.size(), 7U);
+    BOOST_CHECK(stages[0].kind == PipelineStage::Kind::Weld);
+    BOOST_CHECK_CLOSE(stages[0].value, 1e-5f, 1e-3);
+    BOOST_CHECK_EQUAL(stages[1].value, 0.f);
+    BOOST_CHECK(stages[3].kind == PipelineStage::Kind::Subdivide);
+    BOOST_CHECK_EQUAL(stages[3].value, 2.f);
+    BOOST_CHECK_EQUAL(stages[4].value, 64.f);
+    BOOST_CHECK(stages[6].kind == PipelineStage::Kind::Export);
+    BOOST_CHECK_EQUAL(stages[6].path, "out/{name}.obj");
+    BOOST_CHECK_EQUAL(Pipeline::name(stages[5].kind), "optimize");
+    BOOST_CHECK(stages[2].weighting == AngleWeighting::Exact);
+
+    Pipeline fast;
+    BOOST_REQUIRE(fast.parse("normals fast"));
+    BOOST_CHECK(fast.stages()[0].weighting == AngleWeighting::Fast);
+
+    for(const std::string invalid : {"smooth", "subdivide", "subdivide two", "decimate 0", "weld -1", "normals 3",
+                                     "normals fast exact", "export", "weld,, normals"})
+    {
+        Pipeline rejected;
+        BOOST_CHECK_MESSAGE(!rejected.parse(invalid), invalid);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_run)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "test_pipeline";
+    Pipeline pipeline(1);
+    BOOST_REQUIRE(pipeline.parse("repair, subdivide 1, optimize, export " + (directory / "{name}.bmesh").string()));
+    const PipelineStats stats = pipeline.run(teapot);
+    BOOST_REQUIRE(stats.succeeded);
+    BOOST_REQUIRE_EQUAL(stats.stages.size(), 5U);
+    BOOST_CHECK_EQUAL(stats.stages[0].name, "load");
+    BOOST_CHECK_EQUAL(stats.stages[0].faces, 6320U);
+    // the texture seams are welded
+    BOOST_CHECK_EQUAL(stats.stages[1].vertices, 3241U);
+    BOOST_CHECK_EQUAL(stats.stages[2].faces, 4U * 6320U);
+    BOOST_CHECK_EQUAL(stats.stages[3].name, "optimize");
+    BOOST_REQUIRE_EQUAL(stats.stages[3].values.size(), 2U);
+    BOOST_CHECK_LE(stats.stages[3].values[1].second, stats.stages[3].values[0].second);
+    for(const auto& stage : stats.stages)
+    {
+        BOOST_CHECK_GE(stage.ms, 0.);
+        BOOST_CHECK_LE(stage.peakBytes, stats.peakBytes);
+    }
+
+    // the exported mesh is the subdivided one, with its normals
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    std::vector<vec3d> normals;
+    BOOST_REQUIRE(loadBinaryMesh((directory / "teapot.bmesh").string(), vertices, mesh, normals));
+    BOOST_CHECK_EQUAL(vertices.size(), stats.stages[2].vertices);
+    BOOST_CHECK_EQUAL(mesh.size(), 4U * 6320U);
+    BOOST_CHECK_EQUAL(normals.size(), vertices.size());
+    std::filesystem::remove_all(directory);
+
+    const PipelineStats missing = pipeline.run("data/models/missing.obj");
+    BOOST_CHECK(!missing.succeeded);
+    BOOST_CHECK_EQUAL(missing.stages.size(), 1U);
+
+    std::ostringstream json;
+    writeStatsJson(json, {stats, missing});
+    BOOST_CHECK_NE(json.str().find("\"name\": \"optimize\""), std::string::npos);
+    BOOST_CHECK_NE(json.str().find("\"succeeded\": false"), std::string::npos);
+    BOOST_CHECK_EQUAL(json.str().front(), '[');
+}
+
+BOOST_AUTO_TEST_CASE(test_peak_memory)
+{
+    if(!resetPeakResident())
+    {
+        BOOST_TEST_MESSAGE("the peak memory cannot be reset on this system");
+        return;
+    }
+    const std::size_t before = peakResidentBytes();
+    BOOST_CHECK_GT(before, 0U);
+    BOOST_CHECK_GE(before, residentBytes() / 2);
+    {
+        // written to be resident
+        std::vector<std::uint8_t> block(64U << 20U, 1);
+        BOOST_CHECK_GE(peakResidentBytes(), before + (48U << 20U));
+    }
+    resetPeakResident();
+    BOOST_CHECK_LT(peakResidentBytes(), before + (48U << 20U));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
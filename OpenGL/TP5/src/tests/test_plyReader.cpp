@@ -0,0 +1,183 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+#include <plyReader.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+
+/**
+ * Append a big endian value to a buffer
+ */
+template<typename T>
+void putBigEndian(std::string& out, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+void writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream out(filename, std::ios::binary);
+    out << content;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_ply)
+
+BOOST_AUTO_TEST_CASE(test_parse_header)
+{
+    const std::string text{"ply\r\nformat binary_big_endian 1.0\r\ncomment a comment\r\nelement vertex 8\r\n"
+                           "property float32 x\r\nproperty double y\r\nproperty uchar red\r\nelement face 2\r\n"
+                           "property list uint8 int vertex_indices\r\nend_header\r\n"};
+    ply::Header header;
+    BOOST_REQUIRE(ply::parseHeader(text.data(), text.size(), header));
+    BOOST_CHECK(header.format == ply::Format::BinaryBigEndian);
+    BOOST_CHECK_EQUAL(header.size, text.size());
+    BOOST_REQUIRE_EQUAL(header.elements.size(), 2U);
+    BOOST_CHECK_EQUAL(header.elements[0].count, 8U);
+    BOOST_CHECK_EQUAL(header.elements[0].stride(), 13U);
+    BOOST_CHECK_EQUAL(header.elements[0].find("red"), 2);
+    BOOST_CHECK_EQUAL(header.elements[0].find("z"), -1);
+    BOOST_CHECK(header.elements[1].properties[0].isList);
+    BOOST_CHECK(header.elements[1].properties[0].type == ply::Type::Int32);
+    BOOST_CHECK_EQUAL(header.elements[1].stride(), 0U);
+
+    BOOST_CHECK(!ply::parseHeader("ply\nformat ascii 1.0\n", 21, header));
+    const std::string unknown{"ply\nformat ascii 1.0\nelement vertex 1\nproperty int128 x\nend_header\n"};
+    BOOST_CHECK(!ply::parseHeader(unknown.data(), unknown.size(), header));
+}
+
+BOOST_AUTO_TEST_CASE(test_roundtrip)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink memory(vertices, mesh);
+    BOOST_REQUIRE(generateTorus(6, 4, 1.f, .5f, memory));
+
+    for(const bool binary : {true, false})
+    {
+        const std::string filename{"test_plyReader.ply"};
+        PlySink file(filename, binary);
+        BOOST_REQUIRE(generateTorus(6, 4, 1.f, .5f, file));
+
+        std::vector<point3d> readVertices;
+        std::vector<face> readMesh;
+        std::vector<vec3d> readNormals;
+        BOOST_REQUIRE(loadPly(filename, readVertices, readMesh, readNormals));
+        std::remove(filename.c_str());
+        BOOST_CHECK(readMesh == mesh);
+        BOOST_CHECK(readNormals.empty());
+        BOOST_REQUIRE_EQUAL(readVertices.size(), vertices.size());
+        for(std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            // the ASCII format writes the shortest representation that reads back to the same float
+            BOOST_CHECK_EQUAL(readVertices[i].x, vertices[i].x);
+            BOOST_CHECK_EQUAL(readVertices[i].y, vertices[i].y);
+            BOOST_CHECK_EQUAL(readVertices[i].z, vertices[i].z);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_big_endian_strided)
+{
+    // double coordinates interleaved with normals and a color, a quad, a face with a flag before
+    // the indices and an element that is skipped
+    std::string content{"ply\nformat binary_big_endian 1.0\nelement vertex 4\nproperty double x\n"
+                        "property double y\nproperty double z\nproperty uchar red\nproperty float nx\n"
+                        "property float ny\nproperty float nz\nelement face 2\nproperty uchar flags\n"
+                        "property list ushort uint vertex_indices\nelement edge 1\nproperty int vertex1\n"
+                        "property int vertex2\nend_header\n"};
+    const double positions[4][3]{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, .5}};
+    for(const auto& p : positions)
+    {
+        putBigEndian(content, p[0]);
+        putBigEndian(content, p[1]);
+        putBigEndian(content, p[2]);
+        putBigEndian(content, std::uint8_t{255});
+        putBigEndian(content, 0.f);
+        putBigEndian(content, 0.f);
+        putBigEndian(content, 1.f);
+    }
+    putBigEndian(content, std::uint8_t{1});
+    putBigEndian(content, std::uint16_t{4});
+    for(const std::uint32_t v : {0U, 1U, 2U, 3U})
+    {
+        putBigEndian(content, v);
+    }
+    putBigEndian(content, std::uint8_t{0});
+    putBigEndian(content, std::uint16_t{3});
+    for(const std::uint32_t v : {0U, 2U, 1U})
+    {
+        putBigEndian(content, v);
+    }
+    putBigEndian(content, std::int32_t{0});
+    putBigEndian(content, std::int32_t{1});
+
+    const std::string filename{"test_plyReader_be.ply"};
+    writeFile(filename, content);
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    std::vector<vec3d> normals;
+    BOOST_REQUIRE(loadPly(filename, vertices, mesh, normals));
+
+    BOOST_REQUIRE_EQUAL(vertices.size(), 4U);
+    BOOST_CHECK_EQUAL(vertices[3].y, 1.f);
+    BOOST_CHECK_EQUAL(vertices[3].z, .5f);
+    BOOST_REQUIRE_EQUAL(normals.size(), 4U);
+    BOOST_CHECK_EQUAL(normals[2].z, 1.f);
+    // the quad is split in 2 triangles
+    const std::vector<face> expected{{0, 1, 2}, {0, 2, 3}, {0, 2, 1}};
+    BOOST_CHECK(mesh == expected);
+
+    // truncated data
+    writeFile(filename, content.substr(0, content.size() - 5));
+    BOOST_CHECK(!loadPly(filename, vertices, mesh, normals));
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_index)
+{
+    const std::string filename{"test_plyReader_invalid.ply"};
+    writeFile(filename, "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+                        "element face 1\nproperty list uchar int vertex_indices\nend_header\n"
+                        "0 0 0\n1 0 0\n0 1 0\n3 0 1 3\n");
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    std::vector<vec3d> normals;
+    BOOST_CHECK(!loadPly(filename, vertices, mesh, normals));
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_teapot)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    std::vector<vec3d> normals;
+    BOOST_REQUIRE(loadPly("data/models/teapotmani.ply", vertices, mesh, normals));
+    BOOST_CHECK_EQUAL(vertices.size(), 3241U);
+    BOOST_CHECK_EQUAL(mesh.size(), 6320U);
+    BOOST_CHECK(normals.empty());
+    BOOST_CHECK_EQUAL(vertices[0].x, -3.f);
+    BOOST_CHECK_EQUAL(vertices[0].y, 1.8f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <quantization.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t SIZE{10000};
+
+/// random points in the box [-1, 3] x [0, 1] x [-2, 2]
+std::vector<point3d> randomPoints(BoundingBox& bb)
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    std::vector<point3d> res;
+    for(std::size_t i = 0; i < SIZE; ++i)
+    {
+        res.emplace_back(-1.f + 4.f * dist(gen), dist(gen), -2.f + 4.f * dist(gen));
+    }
+    // the corners of the box are exactly representable
+    res.emplace_back(-1.f, 0.f, -2.f);
+    res.emplace_back(3.f, 1.f, 2.f);
+    bb.set(res.front());
+    for(const auto& p : res)
+    {
+        bb.add(p);
+    }
+    return res;
+}
+
+/// random unit normals, the axes (where the octahedron is folded) and a null normal
+std::vector<vec3d> randomNormals()
+{
+    std::mt19937 gen(2);
+    std::normal_distribution<float> dist;
+    std::vector<vec3d> res{{1.f, 0.f, 0.f}, {0.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f, -1.f}, {0.f, 0.f, 0.f}};
+    while(res.size() < SIZE + 2)
+    {
+        vec3d n(dist(gen), dist(gen), dist(gen));
+        n.normalize();
+        res.push_back(n);
+    }
+    return res;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_positions)
+{
+    BoundingBox bb;
+    const auto points = randomPoints(bb);
+    const QuantizedPositions q(points, bb);
+    BOOST_CHECK_EQUAL(q.size(), points.size());
+    BOOST_CHECK_EQUAL(q.bytes(), points.size() * 3 * sizeof(std::int16_t));
+
+    std::vector<point3d> decoded;
+    q.decode(decoded);
+    BOOST_REQUIRE_EQUAL(decoded.size(), points.size());
+    // at most half a step on each axis, plus the rounding of the floats
+    const v3f tolerance = q.step() * .51f;
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+        BOOST_CHECK_LE(std::fabs(decoded[i].x - points[i].x), tolerance.x);
+        BOOST_CHECK_LE(std::fabs(decoded[i].y - points[i].y), tolerance.y);
+        BOOST_CHECK_LE(std::fabs(decoded[i].z - points[i].z), tolerance.z);
+        BOOST_CHECK_EQUAL(decoded[i].x, q.at(i).x);
+    }
+    BOOST_CHECK_CLOSE(decoded[SIZE].x, -1.f, 1e-4f);
+    BOOST_CHECK_CLOSE(decoded[SIZE + 1].z, 2.f, 1e-4f);
+}
+
+BOOST_AUTO_TEST_CASE(test_flat_box)
+{
+    // a planar mesh has a null extent along z
+    const std::vector<point3d> points{{0.f, 0.f, 1.f}, {1.f, 0.f, 1.f}, {0.f, 1.f, 1.f}};
+    BoundingBox bb;
+    bb.set(points[0]);
+    for(const auto& p : points)
+    {
+        bb.add(p);
+    }
+    std::vector<point3d> decoded;
+    QuantizedPositions(points, bb).decode(decoded);
+    for(const auto& p : decoded)
+    {
+        BOOST_CHECK_EQUAL(p.z, 1.f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_normals)
+{
+    BoundingBox bb;
+    const auto points = randomPoints(bb);
+    const auto normals = randomNormals();
+
+    const QuantizedMesh mesh8(points, normals, bb, NormalEncoding::Oct8);
+    const QuantizedMesh mesh16(points, normals, bb, NormalEncoding::Oct16);
+    BOOST_CHECK_EQUAL(std::get<OctNormals8>(mesh8.normals).bytes(), 2 * normals.size());
+    BOOST_CHECK_EQUAL(std::get<OctNormals16>(mesh16.normals).bytes(), 4 * normals.size());
+
+    const auto r8 = measureQuantization(points, normals, mesh8);
+    const auto r16 = measureQuantization(points, normals, mesh16);
+    BOOST_TEST_MESSAGE("oct8: " << r8);
+    BOOST_TEST_MESSAGE("oct16: " << r16);
+    BOOST_CHECK_EQUAL(r8.floatBytes, (points.size() + normals.size()) * 12);
+    BOOST_CHECK_EQUAL(r8.quantizedBytes, points.size() * 6 + normals.size() * 2);
+    BOOST_CHECK_EQUAL(r16.quantizedBytes, points.size() * 6 + normals.size() * 4);
+    BOOST_CHECK_LT(r8.maxNormalErrorDegrees, 1.f);
+    BOOST_CHECK_LT(r16.maxNormalErrorDegrees, .01f);
+    BOOST_CHECK_LT(r8.maxPositionError, 1e-4f);
+
+    std::vector<point3d> decodedPoints;
+    std::vector<vec3d> decodedNormals;
+    mesh16.decode(decodedPoints, decodedNormals);
+    BOOST_REQUIRE_EQUAL(decodedNormals.size(), normals.size());
+    for(std::size_t i = 0; i < normals.size(); ++i)
+    {
+        if(normals[i].norm() > 0.f)
+        {
+            BOOST_CHECK_CLOSE(decodedNormals[i].norm(), 1.f, 1e-3f);
+        }
+    }
+    // the poles, on the fold of the octahedron, are decoded exactly
+    BOOST_CHECK_EQUAL(decodedNormals[3].z, -1.f);
+    BOOST_CHECK_EQUAL(decodedNormals[1].y, -1.f);
+}
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+#include <repair.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_repair)
+
+BOOST_AUTO_TEST_CASE(test_count_edges)
+{
+    // a closed tetrahedron
+    std::vector<face> mesh{{0, 1, 2}, {0, 3, 1}, {1, 3, 2}, {2, 3, 0}};
+    EdgeCounts counts = countEdges(4, mesh);
+    BOOST_CHECK_EQUAL(counts.boundary, 0U);
+    BOOST_CHECK_EQUAL(counts.manifold, 6U);
+    BOOST_CHECK_EQUAL(counts.nonManifold, 0U);
+
+    // a fin on the edge 0-1: it has 3 faces, the 2 new edges are on the boundary
+    mesh.emplace_back(1, 0, 4);
+    counts = countEdges(5, mesh);
+    BOOST_CHECK_EQUAL(counts.boundary, 2U);
+    BOOST_CHECK_EQUAL(counts.manifold, 5U);
+    BOOST_CHECK_EQUAL(counts.nonManifold, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(test_repair_quad)
+{
+    // a quad whose 2 triangles do not share their vertices along the diagonal, with an unused vertex
+    std::vector<point3d> vertices{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 0, 0}, {1, 1, 0}, {0, 1, 0}, {.5f, .5f, 0}, {5, 5, 5}};
+    std::vector<face> mesh{{0, 1, 2},
+                           // the same vertices as the first face in the other orientation
+                           {4, 1, 3},
+                           // collapsed once welded
+                           {0, 3, 5},
+                           // aligned vertices
+                           {0, 6, 2},
+                           {3, 4, 5}};
+    const RepairReport report = repairMesh(vertices, mesh);
+    BOOST_CHECK_EQUAL(report.verticesBefore, 8U);
+    BOOST_CHECK_EQUAL(report.verticesAfter, 4U);
+    BOOST_CHECK_EQUAL(report.collapsedFaces, 1U);
+    BOOST_CHECK_EQUAL(report.zeroAreaFaces, 1U);
+    BOOST_CHECK_EQUAL(report.duplicateFaces, 1U);
+    BOOST_CHECK_EQUAL(report.unreferencedVertices, 2U);
+    BOOST_CHECK_EQUAL(report.edges.boundary, 4U);
+    BOOST_CHECK_EQUAL(report.edges.manifold, 1U);
+    BOOST_CHECK_EQUAL(report.edges.nonManifold, 0U);
+
+    BOOST_REQUIRE_EQUAL(vertices.size(), 4U);
+    BOOST_CHECK_EQUAL(vertices[3].y, 1.f);
+    const std::vector<face> expected{{0, 1, 2}, {0, 2, 3}};
+    BOOST_CHECK(mesh == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_repair_soup)
+{
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    BOOST_REQUIRE(generateIcosphere(16, sink));
+
+    // every face with its own vertices: the repair gives back a closed manifold mesh
+    std::vector<point3d> soup;
+    std::vector<face> soupMesh;
+    for(const auto& f : mesh)
+    {
+        const auto first = static_cast<idxtype>(soup.size());
+        soup.push_back(vertices[f.v1]);
+        soup.push_back(vertices[f.v2]);
+        soup.push_back(vertices[f.v3]);
+        soupMesh.emplace_back(first, first + 1, first + 2);
+    }
+    const RepairReport report = repairMesh(soup, soupMesh, 1e-6f, 2);
+    BOOST_CHECK_EQUAL(soup.size(), vertices.size());
+    BOOST_CHECK_EQUAL(soupMesh.size(), mesh.size());
+    BOOST_CHECK_EQUAL(report.edges.boundary, 0U);
+    BOOST_CHECK_EQUAL(report.edges.nonManifold, 0U);
+    BOOST_CHECK_EQUAL(report.edges.manifold, 3 * mesh.size() / 2);
+    // the faces keep their order and their orientation
+    BOOST_CHECK_EQUAL(soup[soupMesh[10].v2].x, vertices[mesh[10].v2].x);
+    BOOST_CHECK_EQUAL(soup[soupMesh[10].v3].z, vertices[mesh[10].v3].z);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
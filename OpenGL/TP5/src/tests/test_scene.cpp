@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <scene.hpp>
+#include <threadPool.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+const std::string suzanne{"data/models/suzanne.obj"};
+
+/**
+ * Write a manifest in the temporary directory
+ * @return its path
+ */
+std::string writeManifest(const std::string& name, const std::string& content)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path) << content;
+    return path.string();
+}
+
+/// the absolute path of a model, for the manifests written elsewhere
+std::string absolute(const std::string& filename) { return std::filesystem::absolute(filename).string(); }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_scene)
+
+BOOST_AUTO_TEST_CASE(test_shared_models)
+{
+    for(ThreadPool* pool : {static_cast<ThreadPool*>(nullptr), &ThreadPool::shared()})
+    {
+        Scene scene;
+        scene.add(teapot);
+        scene.add(suzanne);
+        // the same file through another path
+        scene.add("data/models/../models/teapot.obj", point3d{0.f, 0.f, 2.f}, 2.f);
+        std::size_t prepared{0};
+        const SceneLoadStats stats = scene.load(0.f, pool, [&prepared](MeshModel& m) {
+            m.unitizeModel();
+            ++prepared;
+        });
+        BOOST_CHECK_EQUAL(stats.instances, 3U);
+        BOOST_CHECK_EQUAL(stats.models, 2U);
+        BOOST_CHECK_EQUAL(stats.failed, 0U);
+        BOOST_CHECK_EQUAL(prepared, 2U);
+
+        const auto& instances = scene.instances();
+        BOOST_REQUIRE_EQUAL(instances.size(), 3U);
+        BOOST_CHECK(instances[0].model == instances[2].model);
+        BOOST_CHECK(instances[0].model != instances[1].model);
+        BOOST_CHECK(!instances[1].model->empty());
+
+        // the two instances without position side by side on the grid, the third one untouched
+        BOOST_CHECK_CLOSE(instances[0].position.x, -.5f, 1e-4);
+        BOOST_CHECK_CLOSE(instances[1].position.x, .5f, 1e-4);
+        BOOST_CHECK_EQUAL(instances[0].position.y, instances[1].position.y);
+        BOOST_CHECK_CLOSE(instances[0].scale, .45f, 1e-4);
+        BOOST_CHECK_EQUAL(instances[2].position.z, 2.f);
+        BOOST_CHECK_EQUAL(instances[2].scale, 2.f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_failed_models)
+{
+    Scene scene;
+    scene.add("data/models/missing.obj");
+    scene.add(teapot);
+    scene.add("data/models/missing.obj");
+    const SceneLoadStats stats = scene.load(0.f, &ThreadPool::shared());
+    BOOST_CHECK_EQUAL(stats.instances, 1U);
+    BOOST_CHECK_EQUAL(stats.models, 1U);
+    BOOST_CHECK_EQUAL(stats.failed, 1U);
+    BOOST_REQUIRE_EQUAL(scene.instances().size(), 1U);
+    BOOST_CHECK_EQUAL(scene.instances()[0].filename, teapot);
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest)
+{
+    BOOST_CHECK(Scene::isManifest("dir/models.scene"));
+    BOOST_CHECK(!Scene::isManifest("dir/teapot.obj"));
+
+    Scene scene;
+    const std::string manifest = writeManifest("test_scene.scene", "# two teapots and suzanne\n" + absolute(teapot) +
+                                                                       "\n\n" + absolute(teapot) + " 1 2 3\n" +
+                                                                       absolute(suzanne) + " -1 0 0 .5\n");
+    BOOST_REQUIRE(scene.readManifest(manifest));
+    const auto& instances = scene.instances();
+    BOOST_REQUIRE_EQUAL(instances.size(), 3U);
+    BOOST_CHECK(!instances[0].placed);
+    BOOST_CHECK(instances[1].placed);
+    BOOST_CHECK_EQUAL(instances[1].position.z, 3.f);
+    BOOST_CHECK_EQUAL(instances[1].scale, 1.f);
+    BOOST_CHECK_EQUAL(instances[2].position.x, -1.f);
+    BOOST_CHECK_EQUAL(instances[2].scale, .5f);
+    BOOST_CHECK_EQUAL(scene.load().models, 2U);
+
+    Scene invalid;
+    BOOST_CHECK(!invalid.readManifest(writeManifest("test_scene_invalid.scene", absolute(teapot) + " 1 2\n")));
+    BOOST_CHECK(!invalid.readManifest("data/models/missing.scene"));
+
+    std::filesystem::remove(manifest);
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "test_scene_invalid.scene");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
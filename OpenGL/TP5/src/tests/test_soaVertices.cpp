@@ -0,0 +1,148 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <soaVertices.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// not a multiple of 8, so that the last elements go through the scalar code of the SIMD kernels
+constexpr std::size_t SIZE{1003};
+
+std::vector<v3f> randomVectors(std::size_t n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    std::vector<v3f> res;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        res.emplace_back(dist(gen), dist(gen), dist(gen));
+    }
+    // a vector too short to be normalized
+    res[n / 2] = v3f(1e-7f, 0.f, 0.f);
+    return res;
+}
+
+void checkClose(const SoAVertices& soa, const std::vector<v3f>& expected)
+{
+    BOOST_REQUIRE_EQUAL(soa.size(), expected.size());
+    for(std::size_t i = 0; i < expected.size(); ++i)
+    {
+        const v3f v = soa.get(i);
+        BOOST_CHECK_SMALL(v.x - expected[i].x, 1e-4f);
+        BOOST_CHECK_SMALL(v.y - expected[i].y, 1e-4f);
+        BOOST_CHECK_SMALL(v.z - expected[i].z, 1e-4f);
+    }
+}
+
+/// the instruction sets supported by the processor
+std::vector<soa::SimdLevel> simdLevels()
+{
+    std::vector<soa::SimdLevel> res;
+    for(int level = 0; level <= static_cast<int>(soa::detectSimdLevel()); ++level)
+    {
+        res.push_back(static_cast<soa::SimdLevel>(level));
+    }
+    return res;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_interleaved)
+{
+    const auto a = randomVectors(SIZE, 1);
+    const SoAVertices soa(a);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(soa.x()) % SoAVertices::ALIGNMENT, 0U);
+    std::vector<v3f> back;
+    soa.toInterleaved(back);
+    BOOST_REQUIRE_EQUAL(back.size(), a.size());
+    for(std::size_t i = 0; i < a.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(back[i].x, a[i].x);
+        BOOST_CHECK_EQUAL(back[i].y, a[i].y);
+        BOOST_CHECK_EQUAL(back[i].z, a[i].z);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_kernels)
+{
+    const auto a = randomVectors(SIZE, 1);
+    const auto b = randomVectors(SIZE, 2);
+    for(const auto level : simdLevels())
+    {
+        BOOST_TEST_MESSAGE("kernels " << soa::toString(level));
+        BOOST_CHECK(soa::setSimdLevel(level) == level);
+
+        std::vector<v3f> expected = a;
+        SoAVertices v(a);
+        soa::translate(v, v3f(1.f, -2.f, 3.f));
+        for(auto& e : expected)
+        {
+            e.translate(1.f, -2.f, 3.f);
+        }
+        checkClose(v, expected);
+
+        soa::scale(v, v3f(2.f, .5f, -1.f));
+        for(auto& e : expected)
+        {
+            e.scale(2.f, .5f, -1.f);
+        }
+        checkClose(v, expected);
+
+        v.fromInterleaved(a);
+        soa::normalize(v);
+        expected = a;
+        for(auto& e : expected)
+        {
+            e.normalize();
+        }
+        checkClose(v, expected);
+
+        v.fromInterleaved(a);
+        const SoAVertices w(b);
+        soa::axpy(.25f, w, v);
+        for(std::size_t i = 0; i < a.size(); ++i)
+        {
+            expected[i] = a[i] + b[i] * .25f;
+        }
+        checkClose(v, expected);
+
+        SoAVertices out;
+        soa::blend(.375f, SoAVertices(a), .625f, w, out);
+        for(std::size_t i = 0; i < a.size(); ++i)
+        {
+            expected[i] = a[i] * .375f + b[i] * .625f;
+        }
+        checkClose(out, expected);
+
+        point3d pmin;
+        point3d pmax;
+        soa::bounds(SoAVertices(a), pmin, pmax);
+        point3d emin = a[0];
+        point3d emax = a[0];
+        for(const auto& e : a)
+        {
+            emin = v3f(std::min(emin.x, e.x), std::min(emin.y, e.y), std::min(emin.z, e.z));
+            emax = v3f(std::max(emax.x, e.x), std::max(emax.y, e.y), std::max(emax.z, e.z));
+        }
+        BOOST_CHECK_EQUAL(pmin.x, emin.x);
+        BOOST_CHECK_EQUAL(pmin.y, emin.y);
+        BOOST_CHECK_EQUAL(pmin.z, emin.z);
+        BOOST_CHECK_EQUAL(pmax.x, emax.x);
+        BOOST_CHECK_EQUAL(pmax.y, emax.y);
+        BOOST_CHECK_EQUAL(pmax.z, emax.z);
+    }
+    soa::setSimdLevel(soa::detectSimdLevel());
+}
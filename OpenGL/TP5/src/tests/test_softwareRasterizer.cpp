@@ -0,0 +1,132 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <MeshModel.hpp>
+#include <softwareRasterizer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string teapot{"data/models/teapot.obj"};
+
+/// the number of pixels of an image different from black
+std::size_t coveredPixels(const Image& img)
+{
+    std::size_t covered{0};
+    for(std::size_t i = 0; i < img.rgb.size(); i += 3)
+    {
+        if(img.rgb[i] != 0 || img.rgb[i + 1] != 0 || img.rgb[i + 2] != 0)
+        {
+            ++covered;
+        }
+    }
+    return covered;
+}
+
+/**
+ * Render the teapot with the camera, light and material of the visualizer
+ * @param[in] model the unitized model
+ * @param[in] numThreads the number of threads of the rasterizer
+ * @param[in] params the rendering parameters
+ * @return the image
+ */
+Image renderTeapot(MeshModel& model, unsigned numThreads, const RenderingParameters& params)
+{
+    // not a multiple of the tile size, so that the tiles on the borders are partial
+    SoftwareRasterizer target(300, 200, numThreads);
+    target.clear({.5f, .5f, .75f});
+    target.setProjection(perspectiveMatrix(30.f, 1.5f, .1f, 100.f));
+    target.setLight(Light{{5.f, 5.f, 5.f}, {0.f, 0.f, 0.f}, {1.f, 1.f, 1.f}, {1.f, 1.f, 1.f}});
+    target.setMaterial(Material{{.2f, .2f, .2f}, {.8f, .8f, .8f}, {.3f, .3f, .3f}, 20.f});
+    mat4 modelView = translationMatrix(0.f, 0.f, -3.f);
+    modelView = multiply(modelView, rotationMatrix(30.f, 1.f, 0.f, 0.f));
+    modelView = multiply(modelView, rotationMatrix(45.f, 0.f, 1.f, 0.f));
+    target.setModelView(modelView);
+    model.render(target, params);
+    return target.image();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_softwareRasterizer)
+
+BOOST_AUTO_TEST_CASE(test_triangle_coverage)
+{
+    // the identity matrices map the triangle to the lower left half of the viewport
+    constexpr int size{64};
+    SoftwareRasterizer target(size, size, 1);
+    target.clear({0.f, 0.f, 0.f});
+    target.setProjection(identityMatrix());
+    target.setModelView(identityMatrix());
+    const std::vector<point3d> vertices{{-1.f, -1.f, 0.f}, {1.f, -1.f, 0.f}, {-1.f, 1.f, 0.f}, {1.f, 1.f, 0.f}};
+    const std::vector<vec3d> normals(vertices.size(), vec3d{0.f, 0.f, 1.f});
+    const std::vector<face> lower{{0, 1, 2}};
+    target.drawTriangles(Span(vertices), Span(lower), Span(normals), false);
+    BOOST_CHECK_EQUAL(target.stats().rasterized, 1U);
+
+    // the pixels whose center is strictly inside: the ones centered on the diagonal belong to the other half
+    const Image img = target.image();
+    const std::size_t inside = size * (size - 1) / 2;
+    const std::size_t covered = coveredPixels(img);
+    BOOST_CHECK_EQUAL(covered, inside);
+    const auto pixel = [&img](int x, int y) { return img.rgb[3 * static_cast<std::size_t>(y * size + x)]; };
+    // the image is top row first
+    BOOST_CHECK_NE(pixel(0, size - 1), 0);
+    BOOST_CHECK_NE(pixel(size / 2 - 2, size / 2 + 1), 0);
+    BOOST_CHECK_EQUAL(pixel(size - 1, 0), 0);
+    BOOST_CHECK_EQUAL(pixel(size / 2 + 1, size / 2 - 2), 0);
+
+    // the two halves of the square cover each pixel, without a gap on the shared edge
+    const std::vector<face> upper{{1, 3, 2}};
+    target.drawTriangles(Span(vertices), Span(upper), Span(normals), false);
+    BOOST_CHECK_EQUAL(coveredPixels(target.image()), static_cast<std::size_t>(size * size));
+
+    // a clockwise triangle is culled
+    target.clear({0.f, 0.f, 0.f});
+    const std::vector<face> back{{0, 2, 1}};
+    target.drawTriangles(Span(vertices), Span(back), Span(normals), false);
+    BOOST_CHECK_EQUAL(target.stats().culled, 1U);
+    BOOST_CHECK_EQUAL(coveredPixels(target.image()), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_invariance)
+{
+    MeshModel model;
+    BOOST_REQUIRE(model.load(teapot));
+    model.unitizeModel();
+
+    RenderingParameters flat;
+    RenderingParameters smooth;
+    smooth.smooth = true;
+    smooth.wireframe = false;
+    smooth.subdivision = true;
+    for(const auto& params : {flat, smooth})
+    {
+        const Image reference = renderTeapot(model, 1, params);
+        // the teapot is in the image, not only the background
+        BOOST_REQUIRE(std::any_of(reference.rgb.begin(), reference.rgb.end(), [&reference](std::uint8_t c) { return c != reference.rgb[0]; }));
+        for(const unsigned threads : {2U, 3U, 8U})
+        {
+            const Image img = renderTeapot(model, threads, params);
+            BOOST_REQUIRE_EQUAL(img.width, reference.width);
+            BOOST_REQUIRE_EQUAL(img.height, reference.height);
+            // byte for byte
+            BOOST_CHECK_MESSAGE(img.rgb == reference.rgb, threads << " threads");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
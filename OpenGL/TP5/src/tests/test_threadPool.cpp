@@ -0,0 +1,216 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <parallel.hpp>
+#include <threadPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(test_threadPool)
+
+BOOST_AUTO_TEST_CASE(test_thread_pool)
+{
+    ThreadPool pool(2);
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+
+    std::atomic<int> sum{0};
+    std::vector<std::future<int>> futures;
+    for(int i = 0; i < 100; ++i)
+    {
+        futures.push_back(pool.submit([i, &sum] {
+            sum += i;
+            return 2 * i;
+        }));
+    }
+    for(int i = 0; i < 100; ++i)
+    {
+        BOOST_CHECK_EQUAL(futures[static_cast<std::size_t>(i)].get(), 2 * i);
+    }
+    BOOST_CHECK_EQUAL(sum.load(), 4950);
+
+    // the exceptions reach the caller through the futures
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("job failed"); });
+    BOOST_CHECK_THROW(failing.get(), std::runtime_error);
+    BOOST_CHECK(pool.submit([] { return true; }).get());
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_for)
+{
+    ThreadPool pool(2);
+    pool.resetWorkerStats();
+    // every index is visited once, in sub-ranges of at most the grain
+    std::vector<int> visits(100000, 0);
+    std::atomic<std::size_t> maxRange{0};
+    pool.parallelFor(0, visits.size(), 1000, [&](std::size_t begin, std::size_t end) {
+        std::size_t expected = maxRange.load();
+        while(end - begin > expected && !maxRange.compare_exchange_weak(expected, end - begin))
+        {
+        }
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            ++visits[i];
+        }
+    });
+    BOOST_CHECK(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+    BOOST_CHECK_LE(maxRange.load(), 1000U);
+    pool.parallelFor(5, 5, 1, [](std::size_t, std::size_t) { BOOST_FAIL("empty range"); });
+
+    // nested in the jobs of the pool: the waiting workers run the tasks instead of blocking
+    std::vector<std::future<std::size_t>> sums;
+    for(int job = 0; job < 8; ++job)
+    {
+        sums.push_back(pool.submit([&pool]() {
+            std::atomic<std::size_t> sum{0};
+            pool.parallelFor(0, 10000, 100, [&sum](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; ++i)
+                {
+                    sum += i;
+                }
+            });
+            return sum.load();
+        }));
+    }
+    for(auto& sum : sums)
+    {
+        BOOST_CHECK_EQUAL(sum.get(), 10000U * 9999U / 2U);
+    }
+
+    const std::vector<WorkerStats> stats = pool.workerStats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 2U);
+    std::uint64_t tasks{0};
+    for(const auto& s : stats)
+    {
+        tasks += s.tasks;
+        BOOST_CHECK_GE(s.utilization, 0.);
+        BOOST_CHECK_LE(s.utilization, 1.);
+        BOOST_CHECK_GE(s.busyMs, 0.);
+    }
+    // at least the jobs, the caller of the first loop runs some of its tasks
+    BOOST_CHECK_GE(tasks, 8U);
+    pool.resetWorkerStats();
+    BOOST_CHECK_EQUAL(pool.workerStats()[0].tasks, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(test_task_group)
+{
+    ThreadPool pool(2);
+    std::atomic<int> done{0};
+    {
+        TaskGroup group(pool);
+        for(int i = 0; i < 50; ++i)
+        {
+            group.run([&done]() { ++done; });
+        }
+        group.wait();
+        BOOST_CHECK_EQUAL(done.load(), 50);
+        // a group can be reused after wait
+        group.run([&done]() { ++done; });
+        group.wait();
+        BOOST_CHECK_EQUAL(done.load(), 51);
+    }
+
+    // the first exception is rethrown, the tasks not started yet are skipped
+    {
+        TaskGroup group(pool);
+        group.run([]() { throw std::runtime_error("task failed"); });
+        BOOST_CHECK_THROW(group.wait(), std::runtime_error);
+        BOOST_CHECK(group.cancelled());
+        group.run([&done]() { ++done; });
+        group.wait();
+        BOOST_CHECK_EQUAL(done.load(), 51);
+    }
+
+    // a cancelled token skips the remaining sub-ranges, and only them
+    CancellationToken token;
+    std::atomic<std::size_t> visited{0};
+    pool.parallelFor(
+        0, 100000, 100,
+        [&](std::size_t begin, std::size_t end) {
+            visited += end - begin;
+            if(visited.load() >= 1000)
+            {
+                token.cancel();
+            }
+        },
+        token);
+    BOOST_CHECK(token.cancelled());
+    BOOST_CHECK_GE(visited.load(), 1000U);
+    BOOST_CHECK_LT(visited.load(), 100000U);
+    pool.parallelFor(0, 10, 1, [](std::size_t, std::size_t) { BOOST_FAIL("cancelled"); }, token);
+
+    // the exceptions of parallelFor and parallelChunks reach the caller
+    BOOST_CHECK_THROW(pool.parallelFor(0, 1000, 10,
+                                       [](std::size_t begin, std::size_t) {
+                                           if(begin >= 500)
+                                           {
+                                               throw std::runtime_error("range failed");
+                                           }
+                                       }),
+                      std::runtime_error);
+    std::vector<unsigned> chunks(4, 0);
+    parallelChunks(10, 4, [&chunks](unsigned chunk, std::size_t begin, std::size_t end) {
+        chunks[chunk] = static_cast<unsigned>(end - begin);
+    });
+    BOOST_CHECK_EQUAL(std::accumulate(chunks.begin(), chunks.end(), 0U), 10U);
+    BOOST_CHECK_THROW(parallelChunks(10, 3, [](unsigned chunk, std::size_t, std::size_t) {
+                          if(chunk == 0)
+                          {
+                              throw std::runtime_error("chunk failed");
+                          }
+                      }),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_outside_waiter)
+{
+    // the only worker is held by a job, and an unrelated job is queued behind it
+    ThreadPool pool(1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> started;
+    auto blocker = pool.submit([released, &started]() {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+    auto unrelated = pool.submit([]() { return std::this_thread::get_id(); });
+
+    // a thread outside the pool waiting for its group runs the tasks of the group, and only them
+    std::vector<std::thread::id> runners(8);
+    {
+        TaskGroup group(pool);
+        for(auto& runner : runners)
+        {
+            group.run([&runner]() { runner = std::this_thread::get_id(); });
+        }
+        group.wait();
+    }
+    for(const auto& runner : runners)
+    {
+        BOOST_CHECK(runner == std::this_thread::get_id());
+    }
+    BOOST_CHECK(unrelated.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    release.set_value();
+    blocker.get();
+    BOOST_CHECK(unrelated.get() != std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define BOOST_TEST_MODULE testRenderer
+
+#ifndef BOOST_TEST_DYN_LINK
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <meshGenerator.hpp>
+#include <meshStream.hpp>
+#include <stlReader.hpp>
+#include <weld.hpp>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+/**
+ * Expand a mesh into a triangle soup, 3 vertices per face
+ */
+std::vector<point3d> toSoup(const std::vector<point3d>& vertices, const std::vector<face>& mesh)
+{
+    std::vector<point3d> soup;
+    for(const auto& f : mesh)
+    {
+        soup.push_back(vertices[f.v1]);
+        soup.push_back(vertices[f.v2]);
+        soup.push_back(vertices[f.v3]);
+    }
+    return soup;
+}
+
+std::vector<face> soupFaces(std::size_t numFaces)
+{
+    std::vector<face> mesh;
+    for(std::size_t i = 0; i < numFaces; ++i)
+    {
+        const auto first = static_cast<idxtype>(3 * i);
+        mesh.emplace_back(first, first + 1, first + 2);
+    }
+    return mesh;
+}
+
+void checkSamePoint(const point3d& a, const point3d& b)
+{
+    BOOST_CHECK_EQUAL(a.x, b.x);
+    BOOST_CHECK_EQUAL(a.y, b.y);
+    BOOST_CHECK_EQUAL(a.z, b.z);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_weld)
+
+BOOST_AUTO_TEST_CASE(test_weld_soup)
+{
+    // large enough to be welded in parallel
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink sink(vertices, mesh);
+    BOOST_REQUIRE(generateIcosphere(64, sink));
+    const std::vector<point3d> soup = toSoup(vertices, mesh);
+
+    std::vector<point3d> welded;
+    const std::vector<idxtype> remap = weldVertices(soup, 0.f, welded, 4);
+    BOOST_CHECK_EQUAL(welded.size(), vertices.size());
+    std::vector<face> weldedMesh = soupFaces(mesh.size());
+    BOOST_CHECK_EQUAL(remapFaces(remap, weldedMesh), 0U);
+    BOOST_REQUIRE_EQUAL(weldedMesh.size(), mesh.size());
+    for(std::size_t i = 0; i < mesh.size(); i += 97)
+    {
+        checkSamePoint(welded[weldedMesh[i].v1], vertices[mesh[i].v1]);
+        checkSamePoint(welded[weldedMesh[i].v2], vertices[mesh[i].v2]);
+        checkSamePoint(welded[weldedMesh[i].v3], vertices[mesh[i].v3]);
+    }
+
+    // the result does not depend on the number of threads
+    std::vector<point3d> single;
+    BOOST_CHECK(weldVertices(soup, 0.f, single, 1) == remap);
+    BOOST_CHECK_EQUAL(single.size(), welded.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_weld_epsilon)
+{
+    // the first two are closer than epsilon across a cell border, the third one is too far, the
+    // fourth one is within epsilon of the second one only: it is merged through the chain
+    const std::vector<point3d> vertices{{.099f, 0.f, 0.f}, {.101f, 0.f, 0.f}, {.35f, 0.f, 0.f}, {.2f, 0.f, 0.f},
+                                        {-0.f, 1.f, 1.f}, {0.f, 1.f, 1.f}};
+    std::vector<point3d> welded;
+    const std::vector<idxtype> remap = weldVertices(vertices, .1f, welded);
+    const std::vector<idxtype> expected{0, 0, 1, 0, 2, 2};
+    BOOST_CHECK(remap == expected);
+    BOOST_REQUIRE_EQUAL(welded.size(), 3U);
+    checkSamePoint(welded[0], vertices[0]);
+
+    // without epsilon only the identical coordinates are merged, +0 and -0 are the same
+    const std::vector<idxtype> exact = weldVertices(vertices, 0.f, welded);
+    const std::vector<idxtype> expectedExact{0, 1, 2, 3, 4, 4};
+    BOOST_CHECK(exact == expectedExact);
+
+    // the faces whose vertices are merged are removed
+    std::vector<face> mesh{{0, 1, 2}, {0, 2, 4}, {2, 3, 1}};
+    BOOST_CHECK_EQUAL(remapFaces(remap, mesh), 2U);
+    BOOST_REQUIRE_EQUAL(mesh.size(), 1U);
+    BOOST_CHECK(mesh[0] == face(0, 1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(test_stl_roundtrip)
+{
+    const std::string filename{"test_weld.stl"};
+    std::vector<point3d> vertices;
+    std::vector<face> mesh;
+    MemorySink memory(vertices, mesh);
+    BOOST_REQUIRE(generateTorus(12, 8, 1.f, .3f, memory));
+    StlSink file(filename);
+    BOOST_REQUIRE(generateTorus(12, 8, 1.f, .3f, file));
+
+    std::vector<point3d> readVertices;
+    std::vector<face> readMesh;
+    StlStats stats;
+    BOOST_REQUIRE(loadStl(filename, readVertices, readMesh, 0.f, 0, &stats));
+    BOOST_CHECK_EQUAL(stats.triangles, mesh.size());
+    BOOST_CHECK_EQUAL(stats.soupVertices, 3 * mesh.size());
+    BOOST_CHECK_EQUAL(stats.weldedVertices, vertices.size());
+    BOOST_CHECK_EQUAL(stats.degenerateFaces, 0U);
+    BOOST_CHECK_EQUAL(readVertices.size(), vertices.size());
+    BOOST_CHECK_EQUAL(readMesh.size(), mesh.size());
+
+    // many binary files start with solid like the ASCII ones, the size tells them apart
+    {
+        std::FILE* f = std::fopen(filename.c_str(), "r+b");
+        BOOST_REQUIRE(f != nullptr);
+        const char header[5] = {'s', 'o', 'l', 'i', 'd'};
+        std::fwrite(header, 1, sizeof(header), f);
+        std::fclose(f);
+    }
+    BOOST_CHECK(loadStl(filename, readVertices, readMesh));
+    std::remove(filename.c_str());
+    BOOST_CHECK(!loadStl(filename, readVertices, readMesh));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,302 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "threadPool.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+
+namespace {
+
+/// how long a thread waiting for a group sleeps before looking for pending tasks again
+constexpr std::chrono::microseconds HELP_INTERVAL{100};
+
+/// the pool of the calling thread if it is a worker, nullptr otherwise
+thread_local const ThreadPool* currentPool{nullptr};
+/// the index of the calling thread in currentPool
+thread_local unsigned currentWorker{0};
+/// the number of jobs being executed by the calling thread, more than 1 when a job waits for a group
+thread_local unsigned executionDepth{0};
+
+std::chrono::steady_clock::rep now() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+} // namespace
+
+struct ThreadPool::Worker
+{
+    /// protects the queue
+    std::mutex mutex{};
+    /// the jobs created by the jobs of the worker, the newest at the back
+    std::deque<Job> jobs{};
+    /// the jobs executed
+    std::atomic<std::uint64_t> tasks{0};
+    /// the jobs taken from the other workers
+    std::atomic<std::uint64_t> steals{0};
+    /// the time spent executing jobs, in ticks of steady_clock
+    std::atomic<std::chrono::steady_clock::rep> busy{0};
+};
+
+ThreadPool::ThreadPool(unsigned numThreads)
+{
+    const unsigned n = resolveThreads(numThreads);
+    _queues.reserve(n);
+    for(unsigned i = 0; i < n; ++i)
+    {
+        _queues.push_back(std::make_unique<Worker>());
+    }
+    _statsStart = now();
+    _workers.reserve(n);
+    for(unsigned i = 0; i < n; ++i)
+    {
+        _workers.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _ready.notify_all();
+    for(auto& w : _workers)
+    {
+        w.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::push(std::function<void()> job, const TaskGroup* group)
+{
+    if(currentPool == this)
+    {
+        Worker& worker = *_queues[currentWorker];
+        const std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back({std::move(job), group});
+    }
+    else
+    {
+        const std::lock_guard<std::mutex> lock(_sharedMutex);
+        _shared.push_back({std::move(job), group});
+    }
+    // a worker going to sleep counts itself before checking _pending, one of the two sees the other
+    _pending.fetch_add(1);
+    if(_sleeping.load() > 0)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+        }
+        _ready.notify_one();
+    }
+}
+
+bool ThreadPool::take(unsigned self, Job& job, const TaskGroup* group)
+{
+    if(_pending.load() == 0)
+    {
+        return false;
+    }
+    const auto pop = [this, &job, group](std::mutex& mutex, std::deque<Job>& jobs, bool newest) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if(group != nullptr)
+        {
+            // the jobs of the other groups and the submitted ones are left to the workers
+            const auto it = std::find_if(jobs.begin(), jobs.end(), [group](const Job& j) { return j.group == group; });
+            if(it == jobs.end())
+            {
+                return false;
+            }
+            job = std::move(*it);
+            jobs.erase(it);
+        }
+        else if(jobs.empty())
+        {
+            return false;
+        }
+        else if(newest)
+        {
+            job = std::move(jobs.back());
+            jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        _pending.fetch_sub(1);
+        return true;
+    };
+
+    const auto n = static_cast<unsigned>(_queues.size());
+    if(self < n && pop(_queues[self]->mutex, _queues[self]->jobs, true))
+    {
+        return true;
+    }
+    if(pop(_sharedMutex, _shared, false))
+    {
+        return true;
+    }
+    for(unsigned i = 1; i <= n; ++i)
+    {
+        const unsigned victim = (self + i) % n;
+        if(victim != self && pop(_queues[victim]->mutex, _queues[victim]->jobs, false))
+        {
+            if(self < n)
+            {
+                _queues[self]->steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(unsigned self, const std::function<void()>& job)
+{
+    // the jobs run while another one waits are part of its time
+    const bool timed = self < _queues.size() && executionDepth == 0;
+    const auto start = timed ? now() : 0;
+    ++executionDepth;
+    // the exceptions are stored in the futures by the packaged tasks, and in the groups
+    job();
+    --executionDepth;
+    if(self < _queues.size())
+    {
+        Worker& worker = *_queues[self];
+        worker.tasks.fetch_add(1, std::memory_order_relaxed);
+        if(timed)
+        {
+            worker.busy.fetch_add(now() - start, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ThreadPool::runPending(const TaskGroup& group)
+{
+    const unsigned self = (currentPool == this) ? currentWorker : size();
+    Job job;
+    if(!take(self, job, (self < size()) ? nullptr : &group))
+    {
+        return false;
+    }
+    execute(self, job.run);
+    return true;
+}
+
+void ThreadPool::run(unsigned self)
+{
+    currentPool = this;
+    currentWorker = self;
+    Job job;
+    for(;;)
+    {
+        if(take(self, job))
+        {
+            execute(self, job.run);
+            job.run = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleeping.fetch_add(1);
+        _ready.wait(lock, [this] { return _stopping || _pending.load() > 0; });
+        _sleeping.fetch_sub(1);
+        if(_stopping && _pending.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+std::vector<WorkerStats> ThreadPool::workerStats() const
+{
+    using Ms = std::chrono::duration<double, std::milli>;
+    const double elapsedMs = Ms(std::chrono::steady_clock::duration(now() - _statsStart.load())).count();
+    std::vector<WorkerStats> stats;
+    stats.reserve(_queues.size());
+    for(const auto& worker : _queues)
+    {
+        WorkerStats s;
+        s.tasks = worker->tasks.load(std::memory_order_relaxed);
+        s.steals = worker->steals.load(std::memory_order_relaxed);
+        s.busyMs = Ms(std::chrono::steady_clock::duration(worker->busy.load(std::memory_order_relaxed))).count();
+        s.utilization = (elapsedMs > 0) ? std::min(1., s.busyMs / elapsedMs) : 0.;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void ThreadPool::resetWorkerStats()
+{
+    for(auto& worker : _queues)
+    {
+        worker->tasks = 0;
+        worker->steals = 0;
+        worker->busy = 0;
+    }
+    _statsStart = now();
+}
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch(...)
+    {
+        // the exception of a task is only rethrown by an explicit wait
+    }
+}
+
+void TaskGroup::wait()
+{
+    for(;;)
+    {
+        while(_count.load(std::memory_order_acquire) != 0 && _pool.runPending(*this))
+        {
+        }
+        // the last task notifies under the lock, the group can be destroyed once it is taken
+        std::unique_lock<std::mutex> lock(_mutex);
+        if(_done.wait_for(lock, HELP_INTERVAL, [this] { return _count.load(std::memory_order_acquire) == 0; }))
+        {
+            if(_error)
+            {
+                std::rethrow_exception(std::exchange(_error, nullptr));
+            }
+            return;
+        }
+    }
+}
+
+void TaskGroup::fail(std::exception_ptr error)
+{
+    cancel();
+    const std::lock_guard<std::mutex> lock(_mutex);
+    if(!_error)
+    {
+        _error = std::move(error);
+    }
+}
+
+void TaskGroup::finish()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    if(_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        _done.notify_all();
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const WorkerStats& s)
+{
+    return os << s.tasks << " tasks, " << s.steals << " steals, " << s.busyMs << " ms busy ("
+              << 100. * s.utilization << "%)";
+}
@@ -0,0 +1,341 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A flag shared by the copies of the token, to stop a computation early. The tasks check it between
+ * their steps, cancelling does not interrupt a running task.
+ */
+class CancellationToken
+{
+public:
+    /// ask the computations using the token to stop
+    void cancel() { _cancelled->store(true, std::memory_order_relaxed); }
+
+    /// true if cancel has been called on a copy of the token
+    [[nodiscard]] bool cancelled() const { return _cancelled->load(std::memory_order_relaxed); }
+
+private:
+    /// the flag shared by the copies
+    std::shared_ptr<std::atomic<bool>> _cancelled{std::make_shared<std::atomic<bool>>(false)};
+};
+
+class TaskGroup;
+
+/**
+ * The counters of a worker since the pool has been started or the counters reset
+ */
+struct WorkerStats
+{
+    /// the tasks executed
+    std::uint64_t tasks{0};
+    /// the tasks taken from the queue of another worker
+    std::uint64_t steals{0};
+    /// the time spent executing tasks in milliseconds
+    double busyMs{0};
+    /// the fraction of the time spent executing tasks, in [0, 1]
+    double utilization{0};
+};
+
+/**
+ * A fixed set of worker threads scheduling the tasks by work stealing. Each worker has its own
+ * queue: the tasks created by a task go to the queue of its worker, which runs the newest ones
+ * first, while the idle workers steal the oldest ones, ie the largest parts of a recursive split.
+ * The jobs submitted from outside the pool are queued in order in a shared queue.
+ *
+ * The threads are created once and shared, eg by the models of a scene loaded concurrently, and by
+ * the loops of the mesh algorithms (see parallelFor and TaskGroup). A worker waiting for a task
+ * group runs the pending tasks meanwhile, hence the groups can be nested in the tasks; a job must
+ * however not wait for the future of another job of the same pool, which may be queued behind it.
+ * A thread outside the pool waiting for a group only runs the tasks of this group, so that eg the
+ * thread drawing the frames is not held by the jobs of the loaders.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Start the workers
+     * @param[in] numThreads the number of workers, 0 for one per core
+     */
+    explicit ThreadPool(unsigned numThreads = 0);
+
+    /**
+     * Execute the jobs already submitted, then stop the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Return the pool shared by the application, with one worker per core, started on the first call
+     * @return the pool
+     */
+    static ThreadPool& shared();
+
+    /**
+     * Queue a job
+     * @param[in] f the job, a function without parameters
+     * @return the future of the value returned by the job, it also holds its exception if any
+     */
+    template<typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f)
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // std::function needs a copyable callable, the task is shared with the queue
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        std::future<Result> result = task->get_future();
+        push([task]() { (*task)(); });
+        return result;
+    }
+
+    /**
+     * Run fn(begin, end) on sub-ranges of [begin, end) of at most grain indices, on the workers and
+     * on the calling thread, and wait for all of them. The range is split in halves recursively, so
+     * that the idle workers steal large parts of it.
+     * @param[in] begin the first index
+     * @param[in] end the index after the last one
+     * @param[in] grain the maximum size of a sub-range, at least 1
+     * @param[in] fn the function, called concurrently on disjoint sub-ranges
+     * @param[in] token the sub-ranges not started yet are skipped once the token is cancelled
+     */
+    template<typename Fn>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Fn&& fn, const CancellationToken& token = {});
+
+    /// the number of workers
+    [[nodiscard]] unsigned size() const { return static_cast<unsigned>(_workers.size()); }
+
+    /**
+     * Return the counters of each worker, eg for the profiler
+     * @return the counters, one per worker
+     */
+    [[nodiscard]] std::vector<WorkerStats> workerStats() const;
+
+    /**
+     * Reset the counters of the workers, the utilization is then measured from now
+     */
+    void resetWorkerStats();
+
+private:
+    friend class TaskGroup;
+
+    /// the queue and the counters of a worker
+    struct Worker;
+
+    /// a queued job and the group it belongs to, if any
+    struct Job
+    {
+        std::function<void()> run{};
+        const TaskGroup* group{nullptr};
+    };
+
+    /**
+     * Add a job to the queue of the calling worker, or to the shared queue from another thread, and
+     * wake up a worker if one is sleeping
+     * @param[in] job the job
+     * @param[in] group the group of the job, nullptr for a submitted job
+     */
+    void push(std::function<void()> job, const TaskGroup* group = nullptr);
+
+    /**
+     * Take a job: from the queue of the calling worker, then from the shared queue, then from the
+     * queues of the other workers
+     * @param[in] self the index of the calling worker, size() for another thread
+     * @param[out] job the job
+     * @param[in] group if not nullptr, only the oldest job of this group is taken
+     * @return false if there is no such job
+     */
+    bool take(unsigned self, Job& job, const TaskGroup* group = nullptr);
+
+    /**
+     * Execute a pending job on the calling thread, if any: any job on a worker, only a job of the
+     * waited group on another thread
+     * @param[in] group the group waited for by the calling thread
+     * @return false if there was no job
+     */
+    bool runPending(const TaskGroup& group);
+
+    /**
+     * Execute a job and count it
+     * @param[in] self the index of the calling worker, size() for another thread
+     * @param[in] job the job
+     */
+    void execute(unsigned self, const std::function<void()>& job);
+
+    /**
+     * The loop of the workers
+     * @param[in] self the index of the worker
+     */
+    void run(unsigned self);
+
+    /// the threads
+    std::vector<std::thread> _workers{};
+    /// the queue and the counters of each worker
+    std::vector<std::unique_ptr<Worker>> _queues{};
+    /// protects the shared queue
+    std::mutex _sharedMutex{};
+    /// the jobs submitted from outside the pool
+    std::deque<Job> _shared{};
+    /// the number of jobs queued and not taken yet
+    std::atomic<std::size_t> _pending{0};
+    /// the number of workers waiting for a job
+    std::atomic<unsigned> _sleeping{0};
+    /// protects the sleep of the workers and the stop flag
+    std::mutex _mutex{};
+    /// signaled when a job is queued or the pool stops
+    std::condition_variable _ready{};
+    /// true when the workers have to exit once the queues are empty
+    bool _stopping{false};
+    /// when the counters have been reset
+    std::atomic<std::chrono::steady_clock::rep> _statsStart{0};
+};
+
+/**
+ * A set of tasks run on a pool and waited for together. The first exception thrown by a task
+ * cancels the tasks of the group not started yet and is rethrown by wait.
+ */
+class TaskGroup
+{
+public:
+    /**
+     * Create an empty group
+     * @param[in] pool the pool running the tasks
+     * @param[in] token the tasks not started yet are skipped once the token is cancelled
+     */
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared(), CancellationToken token = {})
+      : _pool(pool), _token(std::move(token))
+    {
+    }
+
+    /**
+     * Wait for the tasks, the exceptions are lost
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * Queue a task of the group
+     * @param[in] f the task, a function without parameters
+     */
+    template<typename F>
+    void run(F&& f)
+    {
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _pool.push([this, task = std::forward<F>(f)]() mutable {
+            if(!cancelled())
+            {
+                try
+                {
+                    task();
+                }
+                catch(...)
+                {
+                    fail(std::current_exception());
+                }
+            }
+            finish();
+        }, this);
+    }
+
+    /**
+     * Wait for all the tasks of the group, running the pending tasks of the pool meanwhile, only the
+     * ones of the group if the calling thread is not a worker of the pool
+     * @throw the first exception thrown by a task, if any
+     */
+    void wait();
+
+    /// cancel the tasks of the group not started yet, without cancelling its token
+    void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+
+    /// true if the group or its token has been cancelled, or a task has thrown an exception
+    [[nodiscard]] bool cancelled() const
+    {
+        return _cancelled.load(std::memory_order_relaxed) || _token.cancelled();
+    }
+
+private:
+    /// keep the first exception and cancel the group
+    void fail(std::exception_ptr error);
+
+    /// count a finished task and wake up wait after the last one
+    void finish();
+
+    /// the pool running the tasks
+    ThreadPool& _pool;
+    /// the cancellation of the tasks, shared with the caller
+    CancellationToken _token;
+    /// true once the group has been cancelled or a task has failed
+    std::atomic<bool> _cancelled{false};
+    /// the number of tasks not finished yet
+    std::atomic<std::size_t> _count{0};
+    /// protects the exception and the end of the wait
+    std::mutex _mutex{};
+    /// signaled by the last task
+    std::condition_variable _done{};
+    /// the first exception thrown by a task
+    std::exception_ptr _error{};
+};
+
+template<typename Fn>
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Fn&& fn, const CancellationToken& token)
+{
+    grain = std::max<std::size_t>(grain, 1);
+    if(end - begin <= grain || _workers.empty())
+    {
+        if(begin < end && !token.cancelled())
+        {
+            fn(begin, end);
+        }
+        return;
+    }
+    // declared before the group, which waits for the tasks using it when an exception is thrown
+    std::function<void(std::size_t, std::size_t)> split;
+    TaskGroup group(*this, token);
+    // keep the left half and queue the right one, until the range is small enough
+    split = [&](std::size_t first, std::size_t last) {
+        while(last - first > grain)
+        {
+            const std::size_t middle = first + (last - first) / 2;
+            group.run([&split, middle, last]() { split(middle, last); });
+            last = middle;
+        }
+        if(!group.cancelled())
+        {
+            fn(first, last);
+        }
+    };
+    split(begin, end);
+    group.wait();
+}
+
+/**
+ * Print the counters of a worker on a stream, eg for the log
+ * @param[in,out] os the stream
+ * @param[in] s the counters
+ * @return the stream
+ */
+std::ostream& operator<<(std::ostream& os, const WorkerStats& s);
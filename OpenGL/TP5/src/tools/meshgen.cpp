@@ -0,0 +1,213 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "logger.hpp"
+#include "meshGenerator.hpp"
+#include "meshStream.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage:\n\t" << program << " <icosphere|torus|grid|soup> [options] -o <file.obj|file.bmesh|file.ply|file.stl>\n\n"
+              << "Options:\n"
+              << "\t--triangles N       approximate number of triangles, the parameters of the shape are\n"
+              << "\t                    derived from it (default 100000)\n"
+              << "\t--frequency N       icosphere: number of segments along each edge of the icosahedron\n"
+              << "\t--segments U V      torus: number of segments along the major and the minor circles\n"
+              << "\t--radii R r         torus: major and minor radii (default 1 0.3)\n"
+              << "\t--cells NX NY       grid: number of cells along x and y\n"
+              << "\t--amplitude A       grid: maximum displacement of the noise (default 0.2)\n"
+              << "\t--seed S            grid and soup: seed of the random values (default 1)\n"
+              << "\t--format obj|bmesh|ply|ply-ascii|stl\n"
+              << "\t                    output format, by default deduced from the extension (binary PLY)\n\n"
+              << "The mesh is streamed to the file: the memory used does not depend on its size." << std::endl;
+}
+
+std::uint32_t toCount(double value)
+{
+    return static_cast<std::uint32_t>(std::max(1., std::round(value)));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const std::string shape{argv[1]};
+    double triangles{100000};
+    std::uint32_t frequency{0};
+    std::uint32_t majorSegments{0};
+    std::uint32_t minorSegments{0};
+    float majorRadius{1.f};
+    float minorRadius{.3f};
+    std::uint32_t nx{0};
+    std::uint32_t ny{0};
+    float amplitude{.2f};
+    std::uint64_t seed{1};
+    std::string format;
+    std::string output;
+
+    try
+    {
+        for(int i = 2; i < argc; ++i)
+        {
+            const std::string arg{argv[i]};
+            const auto next = [&]() -> std::string {
+                if(i + 1 >= argc)
+                {
+                    throw std::invalid_argument(arg);
+                }
+                return argv[++i];
+            };
+            if(arg == "--triangles")
+            {
+                triangles = std::stod(next());
+            }
+            else if(arg == "--frequency")
+            {
+                frequency = static_cast<std::uint32_t>(std::stoul(next()));
+            }
+            else if(arg == "--segments")
+            {
+                majorSegments = static_cast<std::uint32_t>(std::stoul(next()));
+                minorSegments = static_cast<std::uint32_t>(std::stoul(next()));
+            }
+            else if(arg == "--radii")
+            {
+                majorRadius = std::stof(next());
+                minorRadius = std::stof(next());
+            }
+            else if(arg == "--cells")
+            {
+                nx = static_cast<std::uint32_t>(std::stoul(next()));
+                ny = static_cast<std::uint32_t>(std::stoul(next()));
+            }
+            else if(arg == "--amplitude")
+            {
+                amplitude = std::stof(next());
+            }
+            else if(arg == "--seed")
+            {
+                seed = std::stoull(next());
+            }
+            else if(arg == "--format")
+            {
+                format = next();
+            }
+            else if(arg == "-o" || arg == "--output")
+            {
+                output = next();
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return (arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+    }
+    catch(const std::logic_error&)
+    {
+        LOG_ERROR(General, "invalid or missing value in the arguments");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(output.empty())
+    {
+        LOG_ERROR(General, "no output file");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(format.empty())
+    {
+        const auto extension = std::filesystem::path(output).extension();
+        format = (extension == ".bmesh") ? "bmesh" : (extension == ".ply") ? "ply" : (extension == ".stl") ? "stl" : "obj";
+    }
+    std::unique_ptr<MeshSink> sink;
+    if(format == "obj")
+    {
+        sink = std::make_unique<ObjSink>(output);
+    }
+    else if(format == "bmesh")
+    {
+        sink = std::make_unique<BinarySink>(output);
+    }
+    else if(format == "ply" || format == "ply-ascii")
+    {
+        sink = std::make_unique<PlySink>(output, format == "ply");
+    }
+    else if(format == "stl")
+    {
+        sink = std::make_unique<StlSink>(output);
+    }
+    else
+    {
+        LOG_ERROR(General, "unknown format " << format);
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bool ok{false};
+    if(shape == "icosphere")
+    {
+        // 20 n^2 triangles
+        ok = generateIcosphere((frequency > 0) ? frequency : toCount(std::sqrt(triangles / 20)), *sink);
+    }
+    else if(shape == "torus")
+    {
+        // 2 U V triangles, with U = 2 V
+        if(majorSegments == 0)
+        {
+            minorSegments = std::max(3U, toCount(std::sqrt(triangles / 4)));
+            majorSegments = 2 * minorSegments;
+        }
+        ok = generateTorus(majorSegments, minorSegments, majorRadius, minorRadius, *sink);
+    }
+    else if(shape == "grid")
+    {
+        // 2 NX NY triangles
+        if(nx == 0)
+        {
+            nx = ny = toCount(std::sqrt(triangles / 2));
+        }
+        ok = generateNoiseGrid(nx, ny, amplitude, seed, *sink);
+    }
+    else if(shape == "soup")
+    {
+        ok = generateSoup(static_cast<std::uint64_t>(triangles), seed, *sink);
+    }
+    else
+    {
+        LOG_ERROR(General, "unknown shape " << shape);
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(!ok)
+    {
+        return EXIT_FAILURE;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::error_code error;
+    const auto megabytes = static_cast<double>(std::filesystem::file_size(output, error)) / 1e6;
+    std::cout << "wrote " << output << ": " << (error ? 0 : megabytes) << " MB in " << seconds << " s ("
+              << (error ? 0 : megabytes / seconds) << " MB/s)" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "logger.hpp"
+#include "pipeline.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage:\n\t" << program << " -p STAGES [options] INPUT...\n\n"
+              << "Read each model (.obj, .ply, .stl, .bmesh) and run the stages on it, without any window.\n\n"
+              << "Options:\n"
+              << "\t-p, --pipeline STAGES  the stages separated by commas, eg \"repair, subdivide 2, export out/{name}.bmesh\":\n"
+              << "\t                       weld [EPS]      merge the vertices closer than EPS (default 0, identical ones)\n"
+              << "\t                       repair [EPS]    weld, then remove the degenerate and duplicated faces\n"
+              << "\t                       normals         compute the normals from the faces\n"
+              << "\t                       subdivide N     apply N steps of Loop subdivision\n"
+              << "\t                       decimate N      cluster the vertices on a grid of N cells along the longest side\n"
+              << "\t                       optimize        reorder the faces and the vertices for the vertex cache\n"
+              << "\t                       export FILE     write the mesh, {name} is replaced by the name of the input\n"
+              << "\t--list FILE            read the inputs from FILE, one per line, in addition to the arguments\n"
+              << "\t--stats FILE           write the measures of each stage in JSON, - for the standard output\n"
+              << "\t--threads N            number of threads of the stages, 0 for all the cores (default)\n"
+              << "\t--cache DIR            read the results of subdivide from DIR if already computed, and store them there\n"
+              << "\t--cache-size MB        maximum size of the cache, the least recently used results are removed (default 1024)\n\n"
+              << "Each stage is timed with the peak resident memory of the process during it. The exit status is 1\n"
+              << "if an input failed, the other inputs are processed anyway." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string stages;
+    std::string statsFile;
+    unsigned numThreads{0};
+    std::string cacheDirectory;
+    std::uint64_t cacheBytes{DEFAULT_MESH_CACHE_BYTES};
+    std::vector<std::string> inputs;
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string arg{argv[i]};
+            const auto next = [&]() -> std::string {
+                if(i + 1 >= argc)
+                {
+                    throw std::invalid_argument(arg);
+                }
+                return argv[++i];
+            };
+            if(arg == "-p" || arg == "--pipeline")
+            {
+                stages += (stages.empty() ? "" : ",") + next();
+            }
+            else if(arg == "--list")
+            {
+                const std::string listFile = next();
+                std::ifstream list(listFile);
+                if(!list.is_open())
+                {
+                    LOG_ERROR(General, "Unable to open file " << listFile);
+                    return EXIT_FAILURE;
+                }
+                for(std::string line; std::getline(list, line);)
+                {
+                    if(!line.empty() && line[0] != '#')
+                    {
+                        inputs.push_back(line);
+                    }
+                }
+            }
+            else if(arg == "--stats")
+            {
+                statsFile = next();
+            }
+            else if(arg == "--threads")
+            {
+                numThreads = static_cast<unsigned>(std::stoul(next()));
+            }
+            else if(arg == "--cache")
+            {
+                cacheDirectory = next();
+            }
+            else if(arg == "--cache-size")
+            {
+                cacheBytes = std::stoull(next()) << 20U;
+            }
+            else if(arg == "--help" || (!arg.empty() && arg[0] == '-'))
+            {
+                printUsage(argv[0]);
+                return (arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            else
+            {
+                inputs.push_back(arg);
+            }
+        }
+    }
+    catch(const std::logic_error&)
+    {
+        LOG_ERROR(General, "invalid or missing value in the arguments");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Pipeline pipeline(numThreads);
+    if(!stages.empty() && !pipeline.parse(stages))
+    {
+        return EXIT_FAILURE;
+    }
+    std::shared_ptr<MeshCache> cache;
+    if(!cacheDirectory.empty())
+    {
+        cache = std::make_shared<MeshCache>(cacheDirectory, cacheBytes);
+        pipeline.setCache(cache);
+    }
+    if(inputs.empty())
+    {
+        LOG_ERROR(General, "no input file");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the models one after the other, so that the peak memory of each stage is its own
+    std::vector<PipelineStats> stats;
+    stats.reserve(inputs.size());
+    bool succeeded{true};
+    // the measures go to the standard error when the JSON goes to the standard output
+    std::ostream& report = (statsFile == "-") ? std::cerr : std::cout;
+    for(const auto& input : inputs)
+    {
+        stats.push_back(pipeline.run(input));
+        report << stats.back() << std::flush;
+        succeeded = succeeded && stats.back().succeeded;
+    }
+    if(cache)
+    {
+        report << "cache " << cache->directory().string() << ": " << cache->stats() << std::endl;
+    }
+
+    if(statsFile == "-")
+    {
+        writeStatsJson(std::cout, stats);
+    }
+    else if(!statsFile.empty())
+    {
+        std::ofstream json(statsFile);
+        writeStatsJson(json, stats);
+        if(!json.good())
+        {
+            LOG_ERROR(General, "Unable to write the measures in " << statsFile);
+            return EXIT_FAILURE;
+        }
+    }
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,240 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "vertexCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+/// the score of the vertices of the last face drawn, lower than the next ones to avoid strips
+constexpr float LAST_FACE_SCORE{.75f};
+/// how fast the score decreases with the position in the cache
+constexpr float CACHE_DECAY_POWER{1.5f};
+/// the score of the vertices with few faces left, to draw them and avoid leaving isolated faces
+constexpr float VALENCE_BOOST_SCALE{2.f};
+/// how fast the valence boost decreases with the number of faces left
+constexpr float VALENCE_BOOST_POWER{.5f};
+/// not in the cache
+constexpr std::uint32_t NOT_CACHED{std::numeric_limits<std::uint32_t>::max()};
+/// no face found
+constexpr std::size_t NO_FACE{std::numeric_limits<std::size_t>::max()};
+
+/**
+ * Return the score of a vertex
+ * @param[in] position the position of the vertex in the cache, NOT_CACHED if not in the cache
+ * @param[in] remaining the number of faces of the vertex not drawn yet
+ * @param[in] cacheSize the number of vertices in the cache
+ * @return the score, higher to draw the faces of the vertex sooner
+ */
+float vertexScore(std::uint32_t position, std::uint32_t remaining, std::size_t cacheSize)
+{
+    if(remaining == 0)
+    {
+        return -1.f;
+    }
+    float score{0.f};
+    if(position < 3)
+    {
+        score = LAST_FACE_SCORE;
+    }
+    else if(position != NOT_CACHED)
+    {
+        const float scaler = 1.f / static_cast<float>(cacheSize - 3);
+        score = std::pow(1.f - static_cast<float>(position - 3) * scaler, CACHE_DECAY_POWER);
+    }
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+}
+
+} // namespace
+
+double averageCacheMissRatio(std::size_t numVertices, const std::vector<face>& mesh, std::size_t cacheSize)
+{
+    if(mesh.empty())
+    {
+        return 0.;
+    }
+    // a vertex is in the FIFO cache if less than cacheSize vertices have been loaded since it was
+    std::vector<std::size_t> loadedAt(numVertices, 0);
+    std::size_t time{cacheSize + 1};
+    std::size_t misses{0};
+    for(const auto& f : mesh)
+    {
+        for(const idxtype v : {f.v1, f.v2, f.v3})
+        {
+            if(time - loadedAt[v] > cacheSize)
+            {
+                loadedAt[v] = time++;
+                ++misses;
+            }
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(mesh.size());
+}
+
+void optimizeVertexCache(std::size_t numVertices, std::vector<face>& mesh, std::size_t cacheSize)
+{
+    if(mesh.empty() || cacheSize < 4)
+    {
+        return;
+    }
+    // the faces of each vertex, the ones not drawn yet first
+    std::vector<std::uint32_t> offsets(numVertices + 1, 0);
+    for(const auto& f : mesh)
+    {
+        ++offsets[f.v1 + 1];
+        ++offsets[f.v2 + 1];
+        ++offsets[f.v3 + 1];
+    }
+    std::vector<std::uint32_t> remaining(numVertices);
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        remaining[v] = offsets[v + 1];
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<std::uint32_t> faces(offsets.back());
+    {
+        std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for(std::size_t i = 0; i < mesh.size(); ++i)
+        {
+            for(const idxtype v : {mesh[i].v1, mesh[i].v2, mesh[i].v3})
+            {
+                faces[next[v]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> position(numVertices, NOT_CACHED);
+    std::vector<float> score(numVertices);
+    for(std::size_t v = 0; v < numVertices; ++v)
+    {
+        score[v] = vertexScore(NOT_CACHED, remaining[v], cacheSize);
+    }
+    std::vector<float> faceScore(mesh.size());
+    std::size_t best{0};
+    for(std::size_t i = 0; i < mesh.size(); ++i)
+    {
+        faceScore[i] = score[mesh[i].v1] + score[mesh[i].v2] + score[mesh[i].v3];
+        best = (faceScore[i] > faceScore[best]) ? i : best;
+    }
+
+    std::vector<bool> drawn(mesh.size(), false);
+    std::vector<face> ordered;
+    ordered.reserve(mesh.size());
+    // the cache after the last face, and the vertices pushed out of it
+    std::vector<idxtype> cache;
+    std::vector<idxtype> updated;
+    cache.reserve(cacheSize + 3);
+    updated.reserve(cacheSize + 3);
+    std::size_t cursor{0};
+    while(ordered.size() < mesh.size())
+    {
+        if(best == NO_FACE)
+        {
+            // none of the cached vertices has a face left: the next face in the input order
+            while(drawn[cursor])
+            {
+                ++cursor;
+            }
+            best = cursor;
+        }
+        const face& f = mesh[best];
+        ordered.push_back(f);
+        drawn[best] = true;
+
+        updated.assign({f.v1, f.v2, f.v3});
+        for(const idxtype v : {f.v1, f.v2, f.v3})
+        {
+            // the face is moved after the faces of the vertex not drawn yet
+            const auto first = faces.begin() + offsets[v];
+            const auto last = first + remaining[v];
+            std::iter_swap(std::find(first, last, static_cast<std::uint32_t>(best)), last - 1);
+            --remaining[v];
+        }
+        for(const idxtype v : cache)
+        {
+            if(v != f.v1 && v != f.v2 && v != f.v3)
+            {
+                updated.push_back(v);
+            }
+        }
+        for(std::size_t p = 0; p < updated.size(); ++p)
+        {
+            position[updated[p]] = (p < cacheSize) ? static_cast<std::uint32_t>(p) : NOT_CACHED;
+        }
+        cache.assign(updated.begin(), updated.begin() + static_cast<std::ptrdiff_t>(std::min(updated.size(), cacheSize)));
+
+        // the scores of the vertices that moved in or out of the cache, and the best face among theirs
+        for(const idxtype v : updated)
+        {
+            const float newScore = vertexScore(position[v], remaining[v], cacheSize);
+            const float delta = newScore - score[v];
+            score[v] = newScore;
+            for(std::uint32_t k = offsets[v]; k < offsets[v] + remaining[v]; ++k)
+            {
+                faceScore[faces[k]] += delta;
+            }
+        }
+        best = NO_FACE;
+        float bestScore{-1.f};
+        for(const idxtype v : cache)
+        {
+            for(std::uint32_t k = offsets[v]; k < offsets[v] + remaining[v]; ++k)
+            {
+                if(faceScore[faces[k]] > bestScore)
+                {
+                    bestScore = faceScore[faces[k]];
+                    best = faces[k];
+                }
+            }
+        }
+    }
+    mesh.swap(ordered);
+}
+
+void optimizeVertexFetch(std::vector<point3d>& vertices, std::vector<vec3d>& normals, std::vector<face>& mesh)
+{
+    constexpr idxtype UNUSED{std::numeric_limits<idxtype>::max()};
+    std::vector<idxtype> remap(vertices.size(), UNUSED);
+    idxtype next{0};
+    for(auto& f : mesh)
+    {
+        for(idxtype* v : {&f.v1, &f.v2, &f.v3})
+        {
+            if(remap[*v] == UNUSED)
+            {
+                remap[*v] = next++;
+            }
+            *v = remap[*v];
+        }
+    }
+    for(auto& r : remap)
+    {
+        if(r == UNUSED)
+        {
+            r = next++;
+        }
+    }
+
+    std::vector<point3d> reordered(vertices.size());
+    for(std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        reordered[remap[v]] = vertices[v];
+    }
+    vertices.swap(reordered);
+    if(normals.size() == remap.size())
+    {
+        std::vector<vec3d> reorderedNormals(normals.size());
+        for(std::size_t v = 0; v < normals.size(); ++v)
+        {
+            reorderedNormals[remap[v]] = normals[v];
+        }
+        normals.swap(reorderedNormals);
+    }
+}
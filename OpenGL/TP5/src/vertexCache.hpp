@@ -0,0 +1,46 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/// the size of the post-transform vertex cache the faces are ordered for
+constexpr std::size_t VERTEX_CACHE_SIZE{32};
+
+/**
+ * Return the average cache miss ratio (ACMR) of a mesh: the number of vertices transformed per face
+ * with a FIFO cache of the vertices, between 0.5 for a regular grid in the best order and 3
+ * @param[in] numVertices the number of vertices
+ * @param[in] mesh the faces in the order they are drawn
+ * @param[in] cacheSize the number of vertices in the cache
+ * @return the number of cache misses per face, 0 if there is no face
+ */
+[[nodiscard]] double averageCacheMissRatio(std::size_t numVertices, const std::vector<face>& mesh,
+                                           std::size_t cacheSize = VERTEX_CACHE_SIZE);
+
+/**
+ * Reorder the faces so that their vertices are reused from the post-transform cache, with the
+ * linear-speed algorithm of Tom Forsyth: each vertex has a score depending on its position in a
+ * simulated LRU cache and on the number of its faces not drawn yet, and the next face is the face
+ * of the highest score among the faces of the cached vertices. The faces keep their orientation.
+ * @param[in] numVertices the number of vertices
+ * @param[in,out] mesh the faces
+ * @param[in] cacheSize the number of vertices in the cache
+ */
+void optimizeVertexCache(std::size_t numVertices, std::vector<face>& mesh, std::size_t cacheSize = VERTEX_CACHE_SIZE);
+
+/**
+ * Reorder the vertices in the order of their first use by the faces, so that they are fetched
+ * sequentially, and remap the faces. The unreferenced vertices are moved at the end.
+ * @param[in,out] vertices the vertices
+ * @param[in,out] normals the normals of the vertices, or empty
+ * @param[in,out] mesh the faces
+ */
+void optimizeVertexFetch(std::vector<point3d>& vertices, std::vector<vec3d>& normals, std::vector<face>& mesh);
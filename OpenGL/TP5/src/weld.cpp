@@ -0,0 +1,290 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "weld.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+/// under this number of vertices the welding runs on the calling thread only
+constexpr std::size_t MIN_PARALLEL_VERTICES{1U << 15U};
+/// the bound of the cell coordinates, far from the limits of int64 so that the neighbours do not overflow
+constexpr float MAX_CELL{4.6e18f};
+
+/**
+ * The integer coordinates of a cell of the grid
+ */
+struct Cell
+{
+    std::int64_t x{0};
+    std::int64_t y{0};
+    std::int64_t z{0};
+};
+
+/**
+ * The grid of the vertices. With an epsilon, the cells are twice as large: the ball of radius
+ * epsilon around a vertex overlaps at most 2 cells along each axis, the cell of the vertex and the
+ * one on the side of the closest border, so 8 cells are searched instead of 27. With a null epsilon
+ * each cell holds the vertices with the same coordinates.
+ */
+class Grid
+{
+public:
+    explicit Grid(float epsilon) : _inverse((epsilon > 0.f) ? .5f / epsilon : 0.f) { }
+
+    [[nodiscard]] bool exact() const { return !(_inverse > 0.f); }
+
+    [[nodiscard]] Cell cellOf(const point3d& p) const
+    {
+        if(exact())
+        {
+            return {bits(p.x), bits(p.y), bits(p.z)};
+        }
+        return {coordinate(p.x), coordinate(p.y), coordinate(p.z)};
+    }
+
+    /**
+     * Return the cell of a vertex and the direction of the neighbouring cells to search
+     * @param[in] p the vertex
+     * @param[out] side for each axis, -1 if the vertex is in the lower half of its cell, 1 otherwise
+     * @return the cell
+     */
+    [[nodiscard]] Cell cellOf(const point3d& p, Cell& side) const
+    {
+        const auto axis = [this](float v, std::int64_t& s) {
+            const float t = std::clamp(v * _inverse, -MAX_CELL, MAX_CELL);
+            const float c = std::floor(t);
+            s = (t - c < .5f) ? -1 : 1;
+            return static_cast<std::int64_t>(c);
+        };
+        return {axis(p.x, side.x), axis(p.y, side.y), axis(p.z, side.z)};
+    }
+
+private:
+    /// the bits of the float, +0 and -0 are the same coordinate
+    static std::int64_t bits(float v)
+    {
+        const float positiveZero = v + 0.f;
+        std::uint32_t b;
+        std::memcpy(&b, &positiveZero, sizeof(b));
+        return std::int64_t{b};
+    }
+
+    [[nodiscard]] std::int64_t coordinate(float v) const
+    {
+        return static_cast<std::int64_t>(std::floor(std::clamp(v * _inverse, -MAX_CELL, MAX_CELL)));
+    }
+
+    float _inverse;
+};
+
+inline std::uint64_t hashCell(const Cell& c)
+{
+    std::uint64_t h = static_cast<std::uint64_t>(c.x) * 0x9E3779B97F4A7C15ULL;
+    h ^= static_cast<std::uint64_t>(c.y) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= static_cast<std::uint64_t>(c.z) * 0x165667B19E3779F9ULL;
+    return h ^ (h >> 29U);
+}
+
+inline float squaredDistance(const point3d& a, const point3d& b)
+{
+    const point3d d = a - b;
+    return d.dot(d);
+}
+
+/**
+ * Sort the keys on their bits [32, 32 + bits) with a parallel LSD radix sort. It is stable, so the
+ * keys with the same bucket (the high bits) stay sorted by index (the low bits), and the result
+ * does not depend on the number of threads.
+ * @param[in,out] keys the keys
+ * @param[in] bits the number of bits of the buckets
+ * @param[in] threads the number of threads
+ */
+void radixSortBuckets(std::vector<std::uint64_t>& keys, unsigned bits, unsigned threads)
+{
+    constexpr unsigned DIGIT_BITS{8};
+    constexpr std::size_t RADIX{1U << DIGIT_BITS};
+    std::vector<std::uint64_t> tmp(keys.size());
+    std::vector<std::size_t> histograms(threads * RADIX);
+    for(unsigned shift = 32; shift < 32 + bits; shift += DIGIT_BITS)
+    {
+        const auto digit = [shift](std::uint64_t key) { return static_cast<std::size_t>((key >> shift) & (RADIX - 1)); };
+        parallelChunks(keys.size(), threads, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t* h = &histograms[chunk * RADIX];
+            std::fill(h, h + RADIX, 0);
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                ++h[digit(keys[i])];
+            }
+        });
+        // the offsets: by digit, then by chunk to keep the order of the chunks
+        std::size_t sum{0};
+        for(std::size_t d = 0; d < RADIX; ++d)
+        {
+            for(unsigned chunk = 0; chunk < threads; ++chunk)
+            {
+                const std::size_t count = histograms[chunk * RADIX + d];
+                histograms[chunk * RADIX + d] = sum;
+                sum += count;
+            }
+        }
+        parallelChunks(keys.size(), threads, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t* offset = &histograms[chunk * RADIX];
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                tmp[offset[digit(keys[i])]++] = keys[i];
+            }
+        });
+        keys.swap(tmp);
+    }
+}
+
+} // namespace
+
+std::vector<idxtype> weldVertices(const std::vector<point3d>& vertices, float epsilon, std::vector<point3d>& welded,
+                                  unsigned numThreads)
+{
+    const std::size_t n = vertices.size();
+    const unsigned threads = (n < MIN_PARALLEL_VERTICES) ? 1U : resolveThreads(numThreads);
+    const Grid grid(epsilon);
+    const float epsilon2 = epsilon * epsilon;
+
+    // the vertices sorted by bucket of the hash table, as (bucket << 32) | index
+    unsigned bits{0};
+    while((std::size_t{1} << bits) < n)
+    {
+        ++bits;
+    }
+    const std::size_t numBuckets = std::size_t{1} << bits;
+    const std::uint64_t mask = numBuckets - 1;
+    std::vector<std::uint64_t> keys(n);
+    parallelChunks(n, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            keys[i] = ((hashCell(grid.cellOf(vertices[i])) & mask) << 32U) | i;
+        }
+    });
+    radixSortBuckets(keys, bits, threads);
+
+    // start[b] is the position of the first vertex of the bucket b in keys
+    std::vector<std::uint32_t> start(numBuckets + 1);
+    parallelChunks(numBuckets + 1, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+        auto k = static_cast<std::size_t>(std::lower_bound(keys.begin(), keys.end(), std::uint64_t{begin} << 32U) - keys.begin());
+        for(std::size_t b = begin; b < end; ++b)
+        {
+            while(k < n && (keys[k] >> 32U) < b)
+            {
+                ++k;
+            }
+            start[b] = static_cast<std::uint32_t>(k);
+        }
+    });
+    const auto indexAt = [&keys](std::size_t k) { return static_cast<std::uint32_t>(keys[k]); };
+
+    // the vertex of lowest index within epsilon: the vertices are processed bucket by bucket, so
+    // that the vertex and the candidates of its own bucket are read from contiguous memory
+    std::vector<idxtype> remap(n);
+    if(grid.exact())
+    {
+        // the same coordinates are in the same bucket, the distance is 0 only for them
+        parallelChunks(numBuckets, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+            for(std::uint32_t k = start[begin]; k < start[end]; ++k)
+            {
+                const point3d& p = vertices[indexAt(k)];
+                std::uint32_t first = k;
+                while(first > 0 && (keys[first - 1] >> 32U) == (keys[k] >> 32U))
+                {
+                    --first;
+                }
+                std::uint32_t best = indexAt(k);
+                for(std::uint32_t j = first; j < k; ++j)
+                {
+                    if(squaredDistance(p, vertices[indexAt(j)]) <= 0.f)
+                    {
+                        best = indexAt(j);
+                        break;
+                    }
+                }
+                remap[indexAt(k)] = best;
+            }
+        });
+    }
+    else
+    {
+        // the positions in the order of the buckets, so that the searches read contiguous memory
+        std::vector<point3d> sorted(n);
+        parallelChunks(n, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+            for(std::size_t k = begin; k < end; ++k)
+            {
+                sorted[k] = vertices[indexAt(k)];
+            }
+        });
+        parallelChunks(numBuckets, threads, [&](unsigned, std::size_t begin, std::size_t end) {
+            for(std::uint32_t k = start[begin]; k < start[end]; ++k)
+            {
+                const point3d& p = sorted[k];
+                std::uint32_t best = indexAt(k);
+                Cell side;
+                const Cell c = grid.cellOf(p, side);
+                for(unsigned corner = 0; corner < 8; ++corner)
+                {
+                    const Cell neighbour{c.x + (((corner & 1U) != 0) ? side.x : 0),
+                                         c.y + (((corner & 2U) != 0) ? side.y : 0),
+                                         c.z + (((corner & 4U) != 0) ? side.z : 0)};
+                    const std::uint64_t b = hashCell(neighbour) & mask;
+                    // the buckets are sorted by index: stop at the first match or when the indices get larger
+                    for(std::uint32_t j = start[b]; j < start[b + 1] && indexAt(j) < best; ++j)
+                    {
+                        if(squaredDistance(p, sorted[j]) <= epsilon2)
+                        {
+                            best = indexAt(j);
+                            break;
+                        }
+                    }
+                }
+                remap[indexAt(k)] = best;
+            }
+        });
+    }
+
+    // the representatives are before the vertices they represent: follow the chains in one pass,
+    // numbering the welded vertices in the order of their first occurrence
+    welded.clear();
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(remap[i] == i)
+        {
+            remap[i] = static_cast<idxtype>(welded.size());
+            welded.push_back(vertices[i]);
+        }
+        else
+        {
+            remap[i] = remap[remap[i]];
+        }
+    }
+    return remap;
+}
+
+std::size_t remapFaces(const std::vector<idxtype>& remap, std::vector<face>& mesh)
+{
+    const std::size_t before = mesh.size();
+    std::size_t kept{0};
+    for(const auto& f : mesh)
+    {
+        const face g(remap[f.v1], remap[f.v2], remap[f.v3]);
+        if(g.v1 != g.v2 && g.v2 != g.v3 && g.v1 != g.v3)
+        {
+            mesh[kept++] = g;
+        }
+    }
+    mesh.resize(kept);
+    return before - kept;
+}
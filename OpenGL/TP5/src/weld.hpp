@@ -0,0 +1,41 @@
+/**
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Merge the vertices closer than epsilon. Each vertex is merged into the vertex of lowest index
+ * within epsilon of it, and transitively, so a chain of vertices each closer than epsilon to the
+ * previous one is merged into the first vertex of the chain. The welded vertices keep the position and
+ * the order of the first vertex of their group.
+ *
+ * The vertices are hashed in a grid of cells of size epsilon: a vertex is only compared with the
+ * vertices of the 27 cells around it, in parallel. The result does not depend on the number of
+ * threads.
+ *
+ * @param[in] vertices the vertices
+ * @param[in] epsilon the distance under which two vertices are merged, 0 to merge only the vertices
+ * with the same coordinates
+ * @param[out] welded the vertices after welding
+ * @param[in] numThreads the number of threads to use, 0 to use all the cores
+ * @return for each vertex of vertices, the index of the vertex it is merged into in welded
+ */
+std::vector<idxtype> weldVertices(const std::vector<point3d>& vertices, float epsilon, std::vector<point3d>& welded,
+                                  unsigned numThreads = 0);
+
+/**
+ * Replace the indices of the faces by their welded ones and remove the faces that become
+ * degenerate, ie that have at least twice the same vertex
+ * @param[in] remap the new index of each vertex, as returned by weldVertices
+ * @param[in,out] mesh the faces
+ * @return the number of faces removed
+ */
+std::size_t remapFaces(const std::vector<idxtype>& remap, std::vector<face>& mesh);